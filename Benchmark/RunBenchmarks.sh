@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+# Runs the headless benchmark on every benchmark map and collects the JSON reports.
+# Usage: Benchmark/RunBenchmarks.sh <UnrealEditor-Cmd> [<output dir>] [extra arguments...]
+set -euo pipefail
+
+EDITOR_CMD="${1:?usage: $0 <UnrealEditor-Cmd> [<output dir>] [extra arguments...]}"
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+OUTPUT_DIR="${2:-$PROJECT_DIR/Saved/Benchmarks}"
+shift $(( $# > 1 ? 2 : 1 ))
+
+mkdir -p "$OUTPUT_DIR"
+
+STATUS=0
+for MAP in VehicleAdvExampleMap VehicleOffroadExampleMap; do
+	echo "Benchmarking $MAP"
+	"$EDITOR_CMD" "$PROJECT_DIR/SensorSim.uproject" "/Game/VehicleTemplate/Maps/$MAP?game=Benchmark" \
+		-game -nullrhi -nosound -unattended -nopause -nosplash \
+		-BenchmarkReport="$OUTPUT_DIR/$MAP.json" "$@" || STATUS=1
+
+	if [ ! -f "$OUTPUT_DIR/$MAP.json" ]; then
+		echo "No report for $MAP" >&2
+		STATUS=1
+	fi
+done
+
+exit $STATUS
@@ -10,8 +10,8 @@ public class SensorSim : ModuleRules
 			new string[]
 			{
 				"Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput",
-				"ChaosVehicles", "PhysicsCore",
-				"UESensors"
+				"ChaosVehicles", "ChaosVehiclesCore", "Chaos", "PhysicsCore",
+				"Json", "UESensors", "Sockets", "Networking", "RenderCore", "RHI"
 			}
 		);
 	}
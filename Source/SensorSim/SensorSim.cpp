@@ -3,5 +3,29 @@
 #include "SensorSim.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogSensorSim);
+
+UE_TRACE_CHANNEL_DEFINE(SensorSimChannel);
+
+DEFINE_STAT(STAT_SensorSimVehicleTick);
+DEFINE_STAT(STAT_SensorSimPhysicsSensors);
+DEFINE_STAT(STAT_SensorSimRunSensors);
+DEFINE_STAT(STAT_SensorSimSweepDispatch);
+DEFINE_STAT(STAT_SensorSimRayQuery);
+DEFINE_STAT(STAT_SensorSimPointPacking);
+DEFINE_STAT(STAT_SensorSimLidarReturns);
+DEFINE_STAT(STAT_SensorSimCameraCapture);
+DEFINE_STAT(STAT_SensorSimCameraReadback);
+DEFINE_STAT(STAT_SensorSimLabelTable);
+DEFINE_STAT(STAT_SensorSimRecordingIO);
+DEFINE_STAT(STAT_SensorSimPublish);
+DEFINE_STAT(STAT_SensorSimHudUpdate);
+DEFINE_STAT(STAT_SensorSimScenarioReset);
+DEFINE_STAT(STAT_SensorSimTelemetry);
+
+DEFINE_STAT(STAT_SensorSimRays);
+DEFINE_STAT(STAT_SensorSimHits);
+DEFINE_STAT(STAT_SensorSimBytes);
+DEFINE_STAT(STAT_SensorSimHudChanges);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, SensorSim, "SensorSim" );
- 
\ No newline at end of file
@@ -3,3 +3,49 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSensorSim, Log, All);
+
+/**
+ *  Vehicle HUD code. Compiled out of dedicated servers and of the SensorSimBatch target, which never show a HUD.
+ *  The reflected UI widget class and controller properties stay, since UHT cannot compile them out, but nothing creates or updates them
+ */
+#ifndef SENSORSIM_WITH_HUD
+#define SENSORSIM_WITH_HUD !UE_SERVER
+#endif
+
+/** Trace channel of the sensor rays, "SensorRay" in DefaultEngine.ini. Static level meshes answer it through their ray proxies */
+#define ECC_SensorRay ECC_GameTraceChannel1
+
+/** Unreal Insights channel of the SensorSim scopes. Enable with -trace=cpu,SensorSim */
+UE_TRACE_CHANNEL_EXTERN(SensorSimChannel, SENSORSIM_API);
+
+DECLARE_STATS_GROUP(TEXT("SensorSim"), STATGROUP_SensorSim, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Vehicle tick"), STAT_SensorSimVehicleTick, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics sensors"), STAT_SensorSimPhysicsSensors, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Run sensors"), STAT_SensorSimRunSensors, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sweep dispatch"), STAT_SensorSimSweepDispatch, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ray query"), STAT_SensorSimRayQuery, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Point packing"), STAT_SensorSimPointPacking, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("LiDAR returns"), STAT_SensorSimLidarReturns, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Camera capture"), STAT_SensorSimCameraCapture, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Camera readback"), STAT_SensorSimCameraReadback, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Label table"), STAT_SensorSimLabelTable, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Recording I/O"), STAT_SensorSimRecordingIO, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shared memory publish"), STAT_SensorSimPublish, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HUD update"), STAT_SensorSimHudUpdate, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scenario reset"), STAT_SensorSimScenarioReset, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Telemetry encode"), STAT_SensorSimTelemetry, STATGROUP_SensorSim, SENSORSIM_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rays"), STAT_SensorSimRays, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits"), STAT_SensorSimHits, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes produced"), STAT_SensorSimBytes, STATGROUP_SensorSim, SENSORSIM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("HUD changes"), STAT_SensorSimHudChanges, STATGROUP_SensorSim, SENSORSIM_API);
+
+/** Times the enclosing scope in the SensorSim stats group and on the SensorSim trace channel */
+#define SENSORSIM_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, SensorSimChannel)
@@ -0,0 +1,230 @@
+#include "SensorSimBatchGameMode.h"
+#include "SensorSim.h"
+#include "SensorSimBatchPlayerController.h"
+#include "SensorSimInputTrack.h"
+#include "SensorSimPawn.h"
+#include "SensorSimRecording.h"
+#include "SensorSimScenarioSubsystem.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "Engine/Engine.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+ASensorSimBatchGameMode::ASensorSimBatchGameMode()
+{
+	PlayerControllerClass = ASensorSimBatchPlayerController::StaticClass();
+	HUDClass = nullptr;
+
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bTickEvenWhenPaused = false;
+}
+
+double ASensorSimBatchGameMode::GetThroughput() const
+{
+	const double WallSeconds = FPlatformTime::Seconds() - WallStartSeconds;
+	return WallSeconds > 0.0 ? SimSeconds / WallSeconds : 0.0;
+}
+
+void ASensorSimBatchGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	// command line overrides config
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FParse::Value(CommandLine, TEXT("BatchFixedDt="), FixedDeltaTime);
+	FParse::Value(CommandLine, TEXT("BatchDuration="), BatchDuration);
+	FParse::Value(CommandLine, TEXT("BatchEpisode="), EpisodeDuration);
+
+	FString VehicleClassPath;
+	if (FParse::Value(CommandLine, TEXT("BatchVehicle="), VehicleClassPath))
+	{
+		VehicleClass = TSoftClassPtr<ASensorSimPawn>(FSoftObjectPath(VehicleClassPath));
+	}
+
+	if (UClass* LoadedVehicleClass = VehicleClass.LoadSynchronous())
+	{
+		DefaultPawnClass = LoadedVehicleClass;
+	}
+	else
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Batch vehicle class '%s' could not be loaded, keeping %s"), *VehicleClass.ToString(), *GetNameSafe(DefaultPawnClass));
+	}
+
+	FString InputTrackFile;
+	if (FParse::Value(CommandLine, TEXT("InputTrack="), InputTrackFile))
+	{
+		USensorSimInputTrack* LoadedTrack = NewObject<USensorSimInputTrack>(this);
+		if (LoadedTrack->LoadFromCSV(InputTrackFile))
+		{
+			InputTrack = LoadedTrack;
+		}
+	}
+
+	FParse::Value(CommandLine, TEXT("ReplayInputs="), ReplayFile);
+	FParse::Value(CommandLine, TEXT("ReplayStream="), ReplayStream);
+
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	if (FApp::CanEverRender())
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Batch mode is running with a renderer. Pass -nullrhi for full throughput"));
+	}
+
+	// step the world at a fixed delta and never wait on the wall clock
+	FixedDeltaTime = FMath::Max(FixedDeltaTime, 0.001f);
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedDeltaTime);
+
+	if (GEngine)
+	{
+		GEngine->bUseFixedFrameRate = false;
+		GEngine->bSmoothFrameRate = false;
+		GEngine->SetMaxFPS(0.0f);
+	}
+
+	UE_LOG(LogSensorSim, Log, TEXT("Batch mode: dt %.4fs, duration %.1fs, episode %.1fs, vehicle %s, input track %s, replay %s"),
+		FixedDeltaTime, BatchDuration, EpisodeDuration, *GetNameSafe(DefaultPawnClass), *GetNameSafe(InputTrack), ReplayFile.IsEmpty() ? TEXT("None") : *ReplayFile);
+}
+
+void ASensorSimBatchGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	SimSeconds = 0.0;
+	LastReportSimSeconds = 0.0;
+	EpisodeStartSimSeconds = 0.0;
+	NumEpisodes = 0;
+	TotalResetSeconds = 0.0;
+	WallStartSeconds = FPlatformTime::Seconds();
+}
+
+void ASensorSimBatchGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	// a replay overrides the inputs on the physics thread, so the track is not needed
+	if (!ReplayFile.IsEmpty() && StartReplay(Cast<ASensorSimPawn>(NewPlayer->GetPawn())))
+	{
+		return;
+	}
+
+	if (ASensorSimBatchPlayerController* BatchController = Cast<ASensorSimBatchPlayerController>(NewPlayer))
+	{
+		BatchController->SetInputTrack(InputTrack);
+	}
+}
+
+void ASensorSimBatchGameMode::Tick(float Delta)
+{
+	Super::Tick(Delta);
+
+	TickEpisode();
+
+	SimSeconds += Delta;
+
+	if (ReportInterval > 0.0f && SimSeconds - LastReportSimSeconds >= ReportInterval)
+	{
+		LastReportSimSeconds = SimSeconds;
+		ReportThroughput();
+	}
+
+	if (BatchDuration > 0.0f && SimSeconds >= BatchDuration)
+	{
+		FinishBatch();
+		return;
+	}
+
+	// without a duration, replays run to the end of the recording
+	const ASensorSimPawn* Pawn = ReplayPawn.Get();
+	if (BatchDuration <= 0.0f && Pawn && Pawn->GetSensorSimMovement()->IsInputReplayFinished())
+	{
+		FinishBatch();
+	}
+}
+
+void ASensorSimBatchGameMode::TickEpisode()
+{
+	// replayed inputs are indexed by physics step and cannot be restarted
+	if (EpisodeDuration <= 0.0f || ReplayPawn.IsValid())
+	{
+		return;
+	}
+
+	USensorSimScenarioSubsystem* Scenario = GetWorld()->GetSubsystem<USensorSimScenarioSubsystem>();
+	if (!Scenario)
+	{
+		return;
+	}
+
+	// every actor has begun play and simulated once by the first tick
+	if (!Scenario->HasSnapshot())
+	{
+		Scenario->CaptureSnapshot();
+		EpisodeStartSimSeconds = SimSeconds;
+		return;
+	}
+
+	if (SimSeconds - EpisodeStartSimSeconds < EpisodeDuration)
+	{
+		return;
+	}
+
+	Scenario->ResetScenario();
+	TotalResetSeconds += Scenario->GetLastResetSeconds();
+	EpisodeStartSimSeconds = SimSeconds;
+	++NumEpisodes;
+
+	if (ASensorSimBatchPlayerController* BatchController = Cast<ASensorSimBatchPlayerController>(GetWorld()->GetFirstPlayerController()))
+	{
+		BatchController->SetInputTrack(InputTrack);
+	}
+}
+
+bool ASensorSimBatchGameMode::StartReplay(ASensorSimPawn* Pawn)
+{
+	if (!Pawn)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Batch replay has no vehicle to drive"));
+		return false;
+	}
+
+	FSensorSimRecordingReader Reader;
+	TArray<FSensorSimPhysicsInputSample> Inputs;
+	if (!Reader.Open(ReplayFile) || !Reader.ReadAllVehicleInputs(static_cast<uint16>(ReplayStream), Inputs))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("No physics step inputs for stream %d in '%s'"), ReplayStream, *ReplayFile);
+		return false;
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("Replaying %d physics steps of stream %d from '%s', starting at step %u"),
+		Inputs.Num(), ReplayStream, *ReplayFile, Inputs[0].Step);
+
+	Pawn->GetSensorSimMovement()->StartInputReplay(MoveTemp(Inputs));
+	ReplayPawn = Pawn;
+	return true;
+}
+
+void ASensorSimBatchGameMode::FinishBatch()
+{
+	UE_LOG(LogSensorSim, Display, TEXT("Batch run complete"));
+	ReportThroughput();
+
+	if (const ASensorSimPawn* Pawn = ReplayPawn.Get())
+	{
+		const int32 DesyncedSteps = Pawn->GetSensorSimMovement()->GetDesyncedSteps();
+		UE_LOG(LogSensorSim, Display, TEXT("Replay finished with %d desynchronized physics steps"), DesyncedSteps);
+	}
+
+	SetActorTickEnabled(false);
+	FPlatformMisc::RequestExit(false);
+}
+
+void ASensorSimBatchGameMode::ReportThroughput() const
+{
+	UE_LOG(LogSensorSim, Display, TEXT("Batch throughput: %.1f sim s in %.1f wall s (%.2f sim s / wall s)"),
+		SimSeconds, FPlatformTime::Seconds() - WallStartSeconds, GetThroughput());
+
+	if (NumEpisodes > 0)
+	{
+		UE_LOG(LogSensorSim, Display, TEXT("Batch episodes: %d, %.2f ms per reset"), NumEpisodes, TotalResetSeconds * 1000.0 / NumEpisodes);
+	}
+}
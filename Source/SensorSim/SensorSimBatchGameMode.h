@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "SensorSimBatchGameMode.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+class USensorSimInputTrack;
+
+/**
+ *  Batch Game Mode class
+ *  Runs a vehicle headless (-nullrhi) at a fixed time step, as fast as the CPU allows,
+ *  driving it from a scripted input track, or replaying the physics step inputs of a recording.
+ *  Select it with ?game=Batch.
+ *
+ *  Command line overrides:
+ *    -BatchFixedDt=<seconds>     simulation step
+ *    -BatchDuration=<seconds>    simulation time after which the process exits (0 runs forever, or to the end of the replay)
+ *    -BatchEpisode=<seconds>     simulation time after which the scenario is reset and the input track restarted (0 never resets)
+ *    -BatchVehicle=<class path>  vehicle to spawn
+ *    -InputTrack=<file.csv>      input track to drive from
+ *    -ReplayInputs=<file.ssrec>  recording whose physics step inputs are replayed, overriding the input track
+ *    -ReplayStream=<id>          stream of the recording to replay, 0 by default
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API ASensorSimBatchGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	ASensorSimBatchGameMode();
+
+protected:
+	/** Fixed simulation step, in seconds */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Batch, meta = (ClampMin = "0.001"))
+	float FixedDeltaTime{ 1.0f / 60.0f };
+
+	/** Simulation time after which the run ends. Zero runs until the process is stopped */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Batch, meta = (ClampMin = "0.0"))
+	float BatchDuration{ 0.0f };
+
+	/** Simulation time of one episode. The scenario is snapshotted on the first frame and reset every episode. Zero never resets */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Batch, meta = (ClampMin = "0.0"))
+	float EpisodeDuration{ 0.0f };
+
+	/** Interval, in simulation seconds, between throughput reports */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Batch, meta = (ClampMin = "0.0"))
+	float ReportInterval{ 10.0f };
+
+	/** Vehicle to spawn for the player */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Batch)
+	TSoftClassPtr<ASensorSimPawn> VehicleClass;
+
+	/** Track the vehicle is driven from, when none is given on the command line */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Batch)
+	TObjectPtr<USensorSimInputTrack> InputTrack{ nullptr };
+
+	/** Recording to replay the physics step inputs of */
+	FString ReplayFile;
+
+	/** Stream of the recording to replay */
+	int32 ReplayStream{ 0 };
+
+	/** Vehicle replaying the recording */
+	TWeakObjectPtr<ASensorSimPawn> ReplayPawn;
+
+	/** Simulation time elapsed since the match started */
+	double SimSeconds{ 0.0 };
+
+	/** Wall clock time at which the match started */
+	double WallStartSeconds{ 0.0 };
+
+	/** Simulation time of the last throughput report */
+	double LastReportSimSeconds{ 0.0 };
+
+	/** Simulation time the current episode started at */
+	double EpisodeStartSimSeconds{ 0.0 };
+
+	/** Number of episodes completed */
+	int32 NumEpisodes{ 0 };
+
+	/** Wall clock seconds spent resetting scenarios */
+	double TotalResetSeconds{ 0.0 };
+
+public:
+	/** Returns the simulated seconds advanced per wall clock second since the match started */
+	double GetThroughput() const;
+
+	// Begin GameModeBase interface
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	// End GameModeBase interface
+
+	// Begin Actor interface
+	virtual void Tick(float Delta) override;
+	// End Actor interface
+
+protected:
+	/** Logs the current throughput */
+	void ReportThroughput() const;
+
+	/** Snapshots the scenario on the first frame, then resets it and restarts the input track every episode */
+	void TickEpisode();
+
+	/** Loads the recorded inputs and hands them to the vehicle */
+	bool StartReplay(ASensorSimPawn* Pawn);
+
+	/** Ends the run */
+	virtual void FinishBatch();
+};
@@ -0,0 +1,47 @@
+#include "SensorSimBatchPlayerController.h"
+#include "SensorSimPawn.h"
+#include "SensorSimInputTrack.h"
+
+ASensorSimBatchPlayerController::ASensorSimBatchPlayerController()
+{
+	// inputs must be set before the vehicle movement reads them
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bShowMouseCursor = false;
+}
+
+void ASensorSimBatchPlayerController::SetInputTrack(USensorSimInputTrack* InInputTrack)
+{
+	InputTrack = InInputTrack;
+	TrackTime = 0.0f;
+}
+
+void ASensorSimBatchPlayerController::Tick(float Delta)
+{
+	Super::Tick(Delta);
+
+	if (!IsValid(VehiclePawn) || !IsValid(InputTrack))
+	{
+		return;
+	}
+
+	VehiclePawn->ApplyVehicleInput(InputTrack->Evaluate(TrackTime));
+
+	TrackTime += Delta;
+}
+
+void ASensorSimBatchPlayerController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	// get a pointer to the controlled pawn
+	VehiclePawn = Cast<ASensorSimPawn>(InPawn);
+	TrackTime = 0.0f;
+}
+
+void ASensorSimBatchPlayerController::OnUnPossess()
+{
+	Super::OnUnPossess();
+
+	VehiclePawn = nullptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "SensorSimBatchPlayerController.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+class USensorSimInputTrack;
+
+/**
+ *  Batch Player Controller class
+ *  Drives the possessed vehicle from a scripted input track.
+ *  Creates no UI and registers no input mappings, so it is safe to use on render-less runs.
+ */
+UCLASS()
+class SENSORSIM_API ASensorSimBatchPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	ASensorSimBatchPlayerController();
+
+	/** Sets the track to drive from and restarts it */
+	void SetInputTrack(USensorSimInputTrack* InInputTrack);
+
+protected:
+	/** Track the vehicle is driven from */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Input)
+	TObjectPtr<USensorSimInputTrack> InputTrack{ nullptr };
+
+	/** Pointer to the controlled vehicle pawn */
+	TObjectPtr<ASensorSimPawn> VehiclePawn{ nullptr };
+
+	/** Simulation time elapsed since the track was started */
+	float TrackTime{ 0.0f };
+
+	// Begin Actor interface
+public:
+	virtual void Tick(float Delta) override;
+	// End Actor interface
+
+	// Begin PlayerController interface
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+	// End PlayerController interface
+};
@@ -0,0 +1,214 @@
+#include "SensorSimBenchmarkGameMode.h"
+#include "SensorSim.h"
+#include "SensorSimInputTrack.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimPawn.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace SensorSimBenchmark
+{
+	/** Adds the distribution of a series of wall clock seconds, in milliseconds */
+	void AddPercentiles(FJsonObject& Report, const FString& Name, TArray<float> Seconds)
+	{
+		TSharedRef<FJsonObject> Distribution = MakeShared<FJsonObject>();
+		Distribution->SetNumberField(TEXT("count"), Seconds.Num());
+
+		if (!Seconds.IsEmpty())
+		{
+			Seconds.Sort();
+
+			auto Percentile = [&Seconds](float Fraction)
+			{
+				return Seconds[FMath::Min(FMath::FloorToInt32(Fraction * Seconds.Num()), Seconds.Num() - 1)] * 1000.0;
+			};
+
+			double Sum = 0.0;
+			for (float Value : Seconds)
+			{
+				Sum += Value;
+			}
+
+			Distribution->SetNumberField(TEXT("mean_ms"), Sum / Seconds.Num() * 1000.0);
+			Distribution->SetNumberField(TEXT("p50_ms"), Percentile(0.5f));
+			Distribution->SetNumberField(TEXT("p90_ms"), Percentile(0.9f));
+			Distribution->SetNumberField(TEXT("p99_ms"), Percentile(0.99f));
+			Distribution->SetNumberField(TEXT("max_ms"), Seconds.Last() * 1000.0);
+		}
+
+		Report.SetObjectField(Name, Distribution);
+	}
+}
+
+void ASensorSimBenchmarkGameMode::InitGame(const FString& InMapName, const FString& Options, FString& ErrorMessage)
+{
+	MapName = FPackageName::GetShortName(InMapName);
+
+	// the route's vehicle and track are the defaults; the batch command line may still override them
+	if (const FSensorSimBenchmarkRoute* Route = Routes.FindByPredicate([this](const FSensorSimBenchmarkRoute& Candidate) { return Candidate.Map == MapName; }))
+	{
+		VehicleClass = Route->Vehicle;
+
+		USensorSimInputTrack* RouteTrack = NewObject<USensorSimInputTrack>(this);
+		if (RouteTrack->LoadFromCSV(FPaths::ProjectDir() / Route->InputTrack))
+		{
+			InputTrack = RouteTrack;
+		}
+	}
+	else
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("No benchmark route configured for map '%s'"), *MapName);
+	}
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("BenchmarkReport="), ReportFile))
+	{
+		ReportFile = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / MapName + TEXT(".json");
+	}
+
+	Super::InitGame(InMapName, Options, ErrorMessage);
+
+	// a benchmark without an end would never report
+	if (BatchDuration <= 0.0f)
+	{
+		BatchDuration = WarmUpSeconds + 60.0f;
+	}
+}
+
+void ASensorSimBenchmarkGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	if (FPhysScene* PhysicsScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsPreTickHandle = PhysicsScene->OnPhysScenePreTick.AddUObject(this, &ASensorSimBenchmarkGameMode::OnPhysicsPreTick);
+		PhysicsPostTickHandle = PhysicsScene->OnPhysScenePostTick.AddUObject(this, &ASensorSimBenchmarkGameMode::OnPhysicsPostTick);
+	}
+
+	LastFrameWallSeconds = FPlatformTime::Seconds();
+}
+
+void ASensorSimBenchmarkGameMode::Tick(float Delta)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (bMeasuring)
+	{
+		FrameSeconds.Add(static_cast<float>(Now - LastFrameWallSeconds));
+	}
+	else if (SimSeconds >= WarmUpSeconds)
+	{
+		StartMeasuring();
+	}
+
+	LastFrameWallSeconds = Now;
+
+	// may finish the run
+	Super::Tick(Delta);
+}
+
+void ASensorSimBenchmarkGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (FPhysScene* PhysicsScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsScene->OnPhysScenePreTick.Remove(PhysicsPreTickHandle);
+		PhysicsScene->OnPhysScenePostTick.Remove(PhysicsPostTickHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASensorSimBenchmarkGameMode::FinishBatch()
+{
+	WriteReport();
+
+	Super::FinishBatch();
+}
+
+void ASensorSimBenchmarkGameMode::StartMeasuring()
+{
+	bMeasuring = true;
+	MeasureStartWallSeconds = FPlatformTime::Seconds();
+
+	if (ASensorSimPawn* Vehicle = GetVehicle())
+	{
+		USensorSimLidarComponent* Lidar = Vehicle->GetLidarScanner();
+		StartRays = Lidar->GetTotalRays();
+
+		SweepHandle = Lidar->OnSweep.AddWeakLambda(this, [this, Lidar](const FSensorSimPointCloudRef& Frame)
+		{
+			SweepSeconds.Add(static_cast<float>(Lidar->GetLastSweepSeconds()));
+		});
+	}
+}
+
+void ASensorSimBenchmarkGameMode::WriteReport() const
+{
+	const double MeasuredWallSeconds = FPlatformTime::Seconds() - MeasureStartWallSeconds;
+	const ASensorSimPawn* Vehicle = GetVehicle();
+	const uint64 Rays = Vehicle ? Vehicle->GetLidarScanner()->GetTotalRays() - StartRays : 0;
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("map"), MapName);
+	Report->SetStringField(TEXT("vehicle"), GetNameSafe(Vehicle ? Vehicle->GetClass() : nullptr));
+	Report->SetStringField(TEXT("input_track"), GetNameSafe(InputTrack));
+	Report->SetStringField(TEXT("build"), FApp::GetBuildVersion());
+	Report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	Report->SetNumberField(TEXT("fixed_dt"), FixedDeltaTime);
+	Report->SetNumberField(TEXT("sim_seconds"), SimSeconds - WarmUpSeconds);
+	Report->SetNumberField(TEXT("wall_seconds"), MeasuredWallSeconds);
+
+	SensorSimBenchmark::AddPercentiles(*Report, TEXT("frame_time"), FrameSeconds);
+	SensorSimBenchmark::AddPercentiles(*Report, TEXT("physics_time"), PhysicsSeconds);
+	SensorSimBenchmark::AddPercentiles(*Report, TEXT("lidar_sweep_time"), SweepSeconds);
+
+	Report->SetNumberField(TEXT("rays"), static_cast<double>(Rays));
+	Report->SetNumberField(TEXT("rays_per_second"), MeasuredWallSeconds > 0.0 ? Rays / MeasuredWallSeconds : 0.0);
+	Report->SetNumberField(TEXT("dropped_sweeps"), Vehicle ? Vehicle->GetLidarScanner()->GetDroppedSweeps() : 0);
+
+	TSharedRef<FJsonObject> Memory = MakeShared<FJsonObject>();
+	Memory->SetNumberField(TEXT("peak_used_physical_mb"), MemoryStats.PeakUsedPhysical / (1024.0 * 1024.0));
+	Memory->SetNumberField(TEXT("peak_used_virtual_mb"), MemoryStats.PeakUsedVirtual / (1024.0 * 1024.0));
+	Memory->SetNumberField(TEXT("used_physical_mb"), MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+	Report->SetObjectField(TEXT("memory"), Memory);
+
+	FString Json;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&Json));
+
+	if (FFileHelper::SaveStringToFile(Json, *ReportFile))
+	{
+		UE_LOG(LogSensorSim, Display, TEXT("Benchmark report written to '%s'"), *ReportFile);
+	}
+	else
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to write benchmark report '%s'"), *ReportFile);
+	}
+}
+
+ASensorSimPawn* ASensorSimBenchmarkGameMode::GetVehicle() const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return PlayerController ? Cast<ASensorSimPawn>(PlayerController->GetPawn()) : nullptr;
+}
+
+void ASensorSimBenchmarkGameMode::OnPhysicsPreTick(FChaosScene* PhysicsScene, float DeltaTime)
+{
+	PhysicsStartWallSeconds = FPlatformTime::Seconds();
+}
+
+void ASensorSimBenchmarkGameMode::OnPhysicsPostTick(FChaosScene* PhysicsScene)
+{
+	if (bMeasuring)
+	{
+		PhysicsSeconds.Add(static_cast<float>(FPlatformTime::Seconds() - PhysicsStartWallSeconds));
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimBatchGameMode.h"
+#include "SensorSimBenchmarkGameMode.generated.h"
+
+// Forward declarations
+class FChaosScene;
+
+/**
+ *  Benchmark route
+ *  The vehicle and input track a map is benchmarked with.
+ */
+USTRUCT()
+struct FSensorSimBenchmarkRoute
+{
+	GENERATED_BODY()
+
+	/** Short name of the map the route runs on */
+	UPROPERTY(Config)
+	FString Map;
+
+	/** Vehicle driven along the route */
+	UPROPERTY(Config)
+	TSoftClassPtr<ASensorSimPawn> Vehicle;
+
+	/** Input track CSV, relative to the project directory */
+	UPROPERTY(Config)
+	FString InputTrack;
+};
+
+/**
+ *  Benchmark Game Mode class
+ *  A batch run that drives the map's configured vehicle along a fixed route, measures frame, physics
+ *  and LiDAR timings, ray throughput and memory high-water marks, and writes them as JSON when the run ends.
+ *  Select it with ?game=Benchmark. Batch mode command line overrides still apply.
+ *
+ *  Command line:
+ *    -BenchmarkReport=<file.json>    report file, Saved/Benchmarks/<Map>.json by default
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API ASensorSimBenchmarkGameMode : public ASensorSimBatchGameMode
+{
+	GENERATED_BODY()
+
+protected:
+	/** Routes, by map */
+	UPROPERTY(Config)
+	TArray<FSensorSimBenchmarkRoute> Routes;
+
+	/** Simulation seconds before measuring, to let the vehicle and the streaming settle */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Benchmark, meta = (ClampMin = "0.0"))
+	float WarmUpSeconds{ 2.0f };
+
+	/** Short name of the benchmarked map */
+	FString MapName;
+
+	/** Report file */
+	FString ReportFile;
+
+	/** Wall clock seconds of every measured frame */
+	TArray<float> FrameSeconds;
+
+	/** Wall clock seconds the physics scene took on every measured frame */
+	TArray<float> PhysicsSeconds;
+
+	/** Wall clock seconds every measured LiDAR sweep spent tracing */
+	TArray<float> SweepSeconds;
+
+	/** Wall clock time of the last frame, and of the start of the physics scene tick */
+	double LastFrameWallSeconds{ 0.0 };
+	double PhysicsStartWallSeconds{ 0.0 };
+
+	/** Rays cast, and wall clock time, when measuring started */
+	uint64 StartRays{ 0 };
+	double MeasureStartWallSeconds{ 0.0 };
+
+	/** True once the warm up is over */
+	bool bMeasuring{ false };
+
+	FDelegateHandle PhysicsPreTickHandle;
+	FDelegateHandle PhysicsPostTickHandle;
+	FDelegateHandle SweepHandle;
+
+public:
+	// Begin GameModeBase interface
+	virtual void InitGame(const FString& InMapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	// End GameModeBase interface
+
+	// Begin Actor interface
+	virtual void Tick(float Delta) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End Actor interface
+
+protected:
+	// Begin SensorSimBatchGameMode interface
+	virtual void FinishBatch() override;
+	// End SensorSimBatchGameMode interface
+
+	/** Starts measuring, once the warm up is over */
+	void StartMeasuring();
+
+	/** Writes the report */
+	void WriteReport() const;
+
+	/** Returns the benchmarked vehicle */
+	ASensorSimPawn* GetVehicle() const;
+
+	void OnPhysicsPreTick(FChaosScene* PhysicsScene, float DeltaTime);
+	void OnPhysicsPostTick(FChaosScene* PhysicsScene);
+};
@@ -0,0 +1,586 @@
+#include "SensorSimCameraComponent.h"
+#include "SensorSim.h"
+#include "SensorSimRayProxySubsystem.h"
+#include "SensorSimSensorSubsystem.h"
+#include "SensorSimStaticScene.h"
+#include "Async/ParallelFor.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "Containers/Queue.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/App.h"
+#include "RHI.h"
+#include "RHIGPUReadback.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+
+namespace SensorSimCamera
+{
+	/** Number of image kinds */
+	constexpr int32 NumImageTypes = 3;
+
+	/** Returns the name of an image kind */
+	const TCHAR* GetImageTypeName(ESensorSimImageType Type)
+	{
+		switch (Type)
+		{
+		case ESensorSimImageType::Depth:
+			return TEXT("Depth");
+		case ESensorSimImageType::Semantic:
+			return TEXT("Semantic");
+		default:
+			return TEXT("Color");
+		}
+	}
+}
+
+/**
+ *  Ring of GPU readback buffers of a camera
+ *  Slots are claimed in order on the game thread and released in the same order on the render thread,
+ *  once the GPU has copied every image of their capture. Shared with the render commands, so it outlives the camera if needed.
+ */
+class FSensorSimCameraReadbackRing
+{
+public:
+	/** One capture in flight */
+	struct FSlot
+	{
+		/** Readback of each image kind captured, null for the others */
+		TUniquePtr<FRHIGPUTextureReadback> Readbacks[SensorSimCamera::NumImageTypes];
+
+		/** Capture metadata, written on the game thread before the copy is queued */
+		double Time = 0.0;
+		uint32 Sequence = 0;
+		FTransform Transform;
+
+		/** Set on the game thread when claimed, cleared on the render thread once read back */
+		std::atomic<bool> bInFlight{ false };
+	};
+
+	FSensorSimCameraReadbackRing(int32 NumSlots, uint8 InCamera, int32 InWidth, int32 InHeight, const bool bCaptured[SensorSimCamera::NumImageTypes])
+		: Camera(InCamera)
+		, Width(InWidth)
+		, Height(InHeight)
+	{
+		for (int32 Index = 0; Index < NumSlots; ++Index)
+		{
+			TUniquePtr<FSlot>& Slot = Slots.Add_GetRef(MakeUnique<FSlot>());
+			for (int32 Type = 0; Type < SensorSimCamera::NumImageTypes; ++Type)
+			{
+				if (bCaptured[Type])
+				{
+					Slot->Readbacks[Type] = MakeUnique<FRHIGPUTextureReadback>(TEXT("SensorSimCamera"));
+				}
+			}
+		}
+	}
+
+	/** Claims the next slot. Returns nullptr if every slot is in flight. Game thread only */
+	FSlot* Claim()
+	{
+		FSlot& Slot = *Slots[WriteIndex];
+		if (Slot.bInFlight.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		WriteIndex = (WriteIndex + 1) % Slots.Num();
+		Slot.bInFlight.store(true, std::memory_order_relaxed);
+		NumInFlight.fetch_add(1, std::memory_order_relaxed);
+		return &Slot;
+	}
+
+	/** Queues the copy of the captured render targets into a slot. Render thread only */
+	void EnqueueCopies(FRHICommandListImmediate& RHICmdList, FSlot& Slot, TConstArrayView<FTextureRenderTargetResource*> Targets)
+	{
+		for (int32 Type = 0; Type < SensorSimCamera::NumImageTypes; ++Type)
+		{
+			if (Slot.Readbacks[Type] && Targets[Type])
+			{
+				Slot.Readbacks[Type]->EnqueueCopy(RHICmdList, Targets[Type]->GetRenderTargetTexture());
+			}
+		}
+	}
+
+	/** Reads back every capture the GPU is done with, in order, never waiting on one that is not. Render thread only */
+	void Poll()
+	{
+		SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimCameraReadback);
+
+		bPollQueued.store(false, std::memory_order_relaxed);
+
+		while (NumInFlight.load(std::memory_order_relaxed) > 0)
+		{
+			FSlot& Slot = *Slots[ReadIndex];
+			for (const TUniquePtr<FRHIGPUTextureReadback>& Readback : Slot.Readbacks)
+			{
+				if (Readback && !Readback->IsReady())
+				{
+					return;
+				}
+			}
+
+			for (int32 Type = 0; Type < SensorSimCamera::NumImageTypes; ++Type)
+			{
+				if (Slot.Readbacks[Type])
+				{
+					ReadImage(Slot, static_cast<ESensorSimImageType>(Type));
+				}
+			}
+
+			ReadIndex = (ReadIndex + 1) % Slots.Num();
+			NumInFlight.fetch_sub(1, std::memory_order_relaxed);
+			Slot.bInFlight.store(false, std::memory_order_release);
+		}
+	}
+
+	/** Returns true if a poll should be queued: captures are in flight and no poll is queued yet. Game thread only */
+	bool ShouldQueuePoll()
+	{
+		return NumInFlight.load(std::memory_order_relaxed) > 0 && !bPollQueued.exchange(true, std::memory_order_relaxed);
+	}
+
+	/** Images read back, waiting for the game thread */
+	TQueue<TSharedPtr<const FSensorSimImage, ESPMode::ThreadSafe>, EQueueMode::Spsc> Completed;
+
+private:
+	/** Copies one image of a slot out of its readback buffer */
+	void ReadImage(FSlot& Slot, ESensorSimImageType Type)
+	{
+		FRHIGPUTextureReadback& Readback = *Slot.Readbacks[static_cast<int32>(Type)];
+
+		int32 RowPitch = 0;
+		const uint8* Data = static_cast<const uint8*>(Readback.Lock(RowPitch));
+		if (!Data)
+		{
+			return;
+		}
+
+		TSharedRef<FSensorSimImage, ESPMode::ThreadSafe> Image = MakeShared<FSensorSimImage, ESPMode::ThreadSafe>();
+		Image->Init(Type, Width, Height);
+		Image->Camera = Camera;
+		Image->Time = Slot.Time;
+		Image->Sequence = Slot.Sequence;
+		Image->SensorTransform = Slot.Transform;
+
+		// every render target has 4 byte pixels: BGRA8, or R32F for depth. The semantic stencil is in the red channel
+		const SIZE_T SourceRowBytes = RowPitch * 4;
+		for (int32 Row = 0; Row < Height; ++Row)
+		{
+			const uint8* Source = Data + Row * SourceRowBytes;
+			uint8* Destination = Image->Pixels.GetData() + Row * Image->GetRowBytes();
+
+			if (Type == ESensorSimImageType::Semantic)
+			{
+				for (int32 Column = 0; Column < Width; ++Column)
+				{
+					Destination[Column] = Source[Column * 4 + 2];
+				}
+			}
+			else
+			{
+				FMemory::Memcpy(Destination, Source, Image->GetRowBytes());
+			}
+		}
+
+		Readback.Unlock();
+
+		Completed.Enqueue(Image);
+	}
+
+	TArray<TUniquePtr<FSlot>> Slots;
+
+	/** Next slot to claim. Game thread only */
+	int32 WriteIndex = 0;
+
+	/** Next slot to read back. Render thread only */
+	int32 ReadIndex = 0;
+
+	std::atomic<int32> NumInFlight{ 0 };
+	std::atomic<bool> bPollQueued{ false };
+
+	uint8 Camera = 0;
+	int32 Width = 0;
+	int32 Height = 0;
+};
+
+void USensorSimCameraComponent::SetMount(USceneComponent* InMount)
+{
+	Mount = InMount;
+}
+
+bool USensorSimCameraComponent::IsCapturing() const
+{
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	return !bPlayerOnly || (Pawn && Pawn->IsPlayerControlled());
+}
+
+int32 USensorSimCameraComponent::RunSchedule(double WorldTime)
+{
+	// idle cameras keep their schedule current, so they start on time once they capture
+	if (!IsCapturing())
+	{
+		StartSchedule(WorldTime, SchedulePhase);
+		return 0;
+	}
+
+	return Super::RunSchedule(WorldTime);
+}
+
+bool USensorSimCameraComponent::TakeSample(double SampleTime)
+{
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimCameraCapture);
+
+	const USceneComponent* Origin = Mount ? Mount.Get() : GetOwner()->GetRootComponent();
+	FTransform CameraTransform = Origin->GetComponentTransform();
+	CameraTransform.SetScale3D(FVector::OneVector);
+
+	return bSoftware ? TakeSoftwareSample(SampleTime, CameraTransform) : TakeRenderedSample(SampleTime, CameraTransform);
+}
+
+bool USensorSimCameraComponent::TakeRenderedSample(double SampleTime, const FTransform& CameraTransform)
+{
+	if (Captures.IsEmpty())
+	{
+		CreateCaptures();
+	}
+
+	if (!Captures.ContainsByPredicate([](const USceneCaptureComponent2D* Capture) { return Capture != nullptr; }))
+	{
+		return false;
+	}
+
+	// never wait on the GPU: skip the sample while every readback buffer is in flight
+	FSensorSimCameraReadbackRing::FSlot* Slot = ReadbackRing->Claim();
+	if (!Slot)
+	{
+		return false;
+	}
+
+	Slot->Time = SampleTime;
+	Slot->Sequence = CaptureSequence++;
+	Slot->Transform = CameraTransform;
+
+	TArray<FTextureRenderTargetResource*, TInlineAllocator<SensorSimCamera::NumImageTypes>> Targets;
+	for (USceneCaptureComponent2D* Capture : Captures)
+	{
+		Targets.Add(Capture ? Capture->TextureTarget->GameThread_GetRenderTargetResource() : nullptr);
+		if (Capture)
+		{
+			Capture->CaptureScene();
+		}
+	}
+
+	// the copies are queued behind the captures on the render thread, and only complete on the GPU later
+	ENQUEUE_RENDER_COMMAND(SensorSimCameraCopy)([Ring = ReadbackRing, Slot, Targets](FRHICommandListImmediate& RHICmdList)
+	{
+		Ring->EnqueueCopies(RHICmdList, *Slot, Targets);
+	});
+
+	return true;
+}
+
+bool USensorSimCameraComponent::TakeSoftwareSample(double SampleTime, const FTransform& CameraTransform)
+{
+	// never wait on a capture that is still tracing
+	if (SoftwareTask.IsValid() && !SoftwareTask.IsCompleted())
+	{
+		return false;
+	}
+
+	const int32 ImageWidth = FMath::Max(FMath::RoundToInt32(Width * SoftwareScale), 1);
+	const int32 ImageHeight = FMath::Max(FMath::RoundToInt32(Height * SoftwareScale), 1);
+
+	// images are handed out by reference, so every capture gets its own
+	SoftwareImages.Reset();
+	const bool bCaptured[] = { bCaptureColor, bCaptureDepth, bCaptureSemantic };
+	for (int32 Type = 0; Type < SensorSimCamera::NumImageTypes; ++Type)
+	{
+		if (bCaptured[Type])
+		{
+			TSharedRef<FSensorSimImage, ESPMode::ThreadSafe>& Image = SoftwareImages.Add_GetRef(MakeShared<FSensorSimImage, ESPMode::ThreadSafe>());
+			Image->Init(static_cast<ESensorSimImageType>(Type), ImageWidth, ImageHeight);
+			Image->Camera = CameraId;
+			Image->Time = SampleTime;
+			Image->Sequence = CaptureSequence;
+			Image->SensorTransform = CameraTransform;
+		}
+	}
+
+	if (SoftwareImages.IsEmpty())
+	{
+		return false;
+	}
+
+	++CaptureSequence;
+	SoftwareTransform = CameraTransform;
+
+	// same scenes as the LiDAR rays, never hitting the vehicle carrying the camera
+	QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(SensorSimCameraCapture), false, GetOwner());
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	const USensorSimRayProxySubsystem* RayProxies = GetWorld()->GetSubsystem<USensorSimRayProxySubsystem>();
+	StaticScene = RayProxies ? RayProxies->GetStaticScene() : nullptr;
+	QueryParams.MobilityType = RayProxies && RayProxies->IsStaticSceneComplete() ? EQueryMobilityType::Dynamic : EQueryMobilityType::Any;
+
+	SoftwareTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() { ExecuteSoftwareCapture(); });
+	return true;
+}
+
+void USensorSimCameraComponent::ExecuteSoftwareCapture()
+{
+	const UWorld* World = GetWorld();
+
+	const FSensorSimImage& First = *SoftwareImages[0];
+	const int32 ImageWidth = First.Width;
+	const int32 ImageHeight = First.Height;
+
+	FSensorSimImage* Images[SensorSimCamera::NumImageTypes] = {};
+	for (const TSharedRef<FSensorSimImage, ESPMode::ThreadSafe>& Image : SoftwareImages)
+	{
+		Images[static_cast<int32>(Image->Type)] = &Image.Get();
+	}
+
+	// pinhole camera looking along +X, rows top to bottom
+	const float TanHalfFov = FMath::Tan(FMath::DegreesToRadians(0.5f * FieldOfView));
+	const float TanHalfVerticalFov = TanHalfFov * ImageHeight / ImageWidth;
+	const FVector Origin = SoftwareTransform.GetLocation();
+	const double MaxRange = SoftwareMaxRange;
+
+	ParallelFor(ImageHeight, [&](int32 Row)
+	{
+		SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimCameraReadback);
+
+		FHitResult Hit;
+		for (int32 Column = 0; Column < ImageWidth; ++Column)
+		{
+			const FVector3f CameraRay(1.0f, (2.0f * (Column + 0.5f) / ImageWidth - 1.0f) * TanHalfFov, (1.0f - 2.0f * (Row + 0.5f) / ImageHeight) * TanHalfVerticalFov);
+			const float RayLength = CameraRay.Size();
+			const FVector Direction = SoftwareTransform.TransformVectorNoScale(FVector(CameraRay / RayLength));
+
+			double Range = MaxRange;
+			bool bHit = false;
+			float Cosine = 0.0f;
+			float Reflectivity = 0.0f;
+			uint8 Stencil = 0;
+
+			float StaticRange;
+			int32 StaticTriangle;
+			if (StaticScene && StaticScene->Raycast(Origin, FVector3f(Direction), 0.0f, MaxRange, StaticRange, StaticTriangle))
+			{
+				Range = StaticRange;
+				bHit = true;
+
+				const FSensorSimStaticSource& Source = StaticScene->GetTriangleSource(StaticTriangle);
+				Cosine = FMath::Abs(StaticScene->GetTriangleNormal(StaticTriangle) | FVector3f(Direction));
+				Reflectivity = Source.Reflectivity;
+				Stencil = Source.Stencil;
+			}
+
+			// a dynamic actor can only be seen in front of the static hit
+			if (World->LineTraceSingleByChannel(Hit, Origin, Origin + Direction * Range, ECC_SensorRay, QueryParams))
+			{
+				Range = Hit.Distance;
+				bHit = true;
+
+				const UPrimitiveComponent* Component = Hit.GetComponent();
+				Cosine = static_cast<float>(FMath::Abs(Hit.ImpactNormal | Direction));
+				Reflectivity = SensorSubsystem ? SensorSubsystem->GetReflectivity(Hit.PhysMaterial.Get()) : FSensorSimStaticSource().Reflectivity;
+				Stencil = Component && Component->bRenderCustomDepth ? static_cast<uint8>(Component->CustomDepthStencilValue) : 0;
+			}
+
+			const int32 Pixel = Row * ImageWidth + Column;
+
+			if (FSensorSimImage* Color = Images[static_cast<int32>(ESensorSimImageType::Color)])
+			{
+				const uint8 Shade = bHit ? static_cast<uint8>(FMath::Clamp(FMath::RoundToInt32(Reflectivity * Cosine * 255.0f), 0, 255)) : 0;
+				uint8* Bgra = Color->Pixels.GetData() + Pixel * 4;
+				Bgra[0] = Shade;
+				Bgra[1] = Shade;
+				Bgra[2] = Shade;
+				Bgra[3] = 255;
+			}
+
+			if (FSensorSimImage* Depth = Images[static_cast<int32>(ESensorSimImageType::Depth)])
+			{
+				// planar depth, as the scene depth the renderer writes
+				const float PlanarDepth = bHit ? static_cast<float>(Range) / RayLength : 0.0f;
+				FMemory::Memcpy(Depth->Pixels.GetData() + Pixel * sizeof(float), &PlanarDepth, sizeof(float));
+			}
+
+			if (FSensorSimImage* Semantic = Images[static_cast<int32>(ESensorSimImageType::Semantic)])
+			{
+				Semantic->Pixels[Pixel] = Stencil;
+			}
+		}
+	});
+}
+
+bool USensorSimCameraComponent::CollectSamples()
+{
+	bool bCollected = false;
+
+	if (ReadbackRing)
+	{
+		// one poll per frame at most; it never blocks the render thread either
+		if (ReadbackRing->ShouldQueuePoll())
+		{
+			ENQUEUE_RENDER_COMMAND(SensorSimCameraPoll)([Ring = ReadbackRing](FRHICommandListImmediate& RHICmdList)
+			{
+				Ring->Poll();
+			});
+		}
+
+		TSharedPtr<const FSensorSimImage, ESPMode::ThreadSafe> Image;
+		while (ReadbackRing->Completed.Dequeue(Image))
+		{
+			if (Image->Sequence >= ResetSequence)
+			{
+				PublishImage(Image.ToSharedRef());
+				bCollected = true;
+			}
+		}
+	}
+
+	if (SoftwareTask.IsValid() && SoftwareTask.IsCompleted())
+	{
+		SoftwareTask = UE::Tasks::FTask();
+
+		for (const TSharedRef<FSensorSimImage, ESPMode::ThreadSafe>& Image : SoftwareImages)
+		{
+			PublishImage(Image);
+		}
+
+		SoftwareImages.Reset();
+		bCollected = true;
+	}
+
+	return bCollected;
+}
+
+void USensorSimCameraComponent::PublishImage(const FSensorSimImageRef& Image)
+{
+	Counters.Samples++;
+	Counters.Bytes += Image->Pixels.Num();
+	INC_DWORD_STAT_BY(STAT_SensorSimBytes, Image->Pixels.Num());
+
+	OnImage.Broadcast(Image);
+}
+
+void USensorSimCameraComponent::ResetSensor()
+{
+	// captures in flight were taken before the reset, drop them unpublished
+	SoftwareTask.Wait();
+	SoftwareTask = UE::Tasks::FTask();
+	SoftwareImages.Reset();
+	ResetSequence = CaptureSequence;
+
+	Super::ResetSensor();
+}
+
+void USensorSimCameraComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// nothing renders without an RHI, so trace the images on the CPU instead
+	bSoftware = !FApp::CanEverRender() || GUsingNullRHI;
+
+	SensorSubsystem = GetWorld()->GetSubsystem<USensorSimSensorSubsystem>();
+
+	if (bSoftware)
+	{
+		UE_LOG(LogSensorSim, Log, TEXT("%s: no RHI to render with, ray tracing %dx%d camera images"), *GetPathName(),
+			FMath::Max(FMath::RoundToInt32(Width * SoftwareScale), 1), FMath::Max(FMath::RoundToInt32(Height * SoftwareScale), 1));
+	}
+}
+
+void USensorSimCameraComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// the software capture in flight references this component
+	SoftwareTask.Wait();
+	SoftwareTask = UE::Tasks::FTask();
+	SoftwareImages.Reset();
+	StaticScene.Reset();
+
+	// queued render commands hold the ring until they have run
+	ReadbackRing.Reset();
+
+	for (USceneCaptureComponent2D* Capture : Captures)
+	{
+		if (Capture)
+		{
+			Capture->DestroyComponent();
+		}
+	}
+
+	Captures.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void USensorSimCameraComponent::CreateCaptures()
+{
+	using namespace SensorSimCamera;
+
+	USceneComponent* Origin = Mount ? Mount.Get() : GetOwner()->GetRootComponent();
+
+	if (bCaptureSemantic && !SemanticMaterial)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("%s: no semantic material, semantic images are not rendered"), *GetPathName());
+	}
+
+	bool bCaptured[NumImageTypes] = { bCaptureColor, bCaptureDepth, bCaptureSemantic && SemanticMaterial };
+	Captures.SetNumZeroed(NumImageTypes);
+
+	for (int32 Type = 0; Type < NumImageTypes; ++Type)
+	{
+		if (!bCaptured[Type])
+		{
+			continue;
+		}
+
+		const ESensorSimImageType ImageType = static_cast<ESensorSimImageType>(Type);
+
+		UTextureRenderTarget2D* Target = NewObject<UTextureRenderTarget2D>(this, *FString::Printf(TEXT("%sTarget"), GetImageTypeName(ImageType)));
+		Target->RenderTargetFormat = ImageType == ESensorSimImageType::Depth ? RTF_R32f : RTF_RGBA8;
+		Target->ClearColor = FLinearColor::Black;
+		Target->InitAutoFormat(Width, Height);
+		Target->UpdateResourceImmediate(true);
+
+		USceneCaptureComponent2D* Capture = NewObject<USceneCaptureComponent2D>(GetOwner(), *FString::Printf(TEXT("%s%sCapture"), *GetName(), GetImageTypeName(ImageType)));
+		Capture->SetupAttachment(Origin);
+		Capture->bCaptureEveryFrame = false;
+		Capture->bCaptureOnMovement = false;
+		Capture->FOVAngle = FieldOfView;
+		Capture->TextureTarget = Target;
+		Capture->HiddenActors.Add(GetOwner());
+
+		switch (ImageType)
+		{
+		case ESensorSimImageType::Depth:
+			Capture->CaptureSource = SCS_SceneDepth;
+			break;
+
+		case ESensorSimImageType::Semantic:
+			// stencil values must come out exactly as written, so nothing may blend neighbouring pixels
+			Capture->CaptureSource = SCS_FinalColorLDR;
+			Capture->PostProcessSettings.AddBlendable(SemanticMaterial, 1.0f);
+			Capture->ShowFlags.SetAntiAliasing(false);
+			Capture->ShowFlags.SetTemporalAA(false);
+			Capture->ShowFlags.SetMotionBlur(false);
+			Capture->ShowFlags.SetBloom(false);
+			break;
+
+		default:
+			Capture->CaptureSource = SCS_FinalColorLDR;
+			break;
+		}
+
+		Capture->RegisterComponent();
+		Captures[Type] = Capture;
+	}
+
+	ReadbackRing = MakeShared<FSensorSimCameraReadbackRing, ESPMode::ThreadSafe>(ReadbackBuffers, CameraId, Width, Height, bCaptured);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimSensorComponent.h"
+#include "SensorSim.h"
+#include "SensorSimImage.h"
+#include "CollisionQueryParams.h"
+#include "Tasks/Task.h"
+#include "SensorSimCameraComponent.generated.h"
+
+// Forward declarations
+class USceneCaptureComponent2D;
+class UMaterialInterface;
+class USensorSimSensorSubsystem;
+class FSensorSimStaticScene;
+class FSensorSimCameraReadbackRing;
+
+/** Broadcast on the game thread with every image read back */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSensorSimCameraImage, const FSensorSimImageRef& /*Image*/);
+
+/**
+ *  Camera Component
+ *  Captures color, depth and semantic images from a mount component, typically one of the vehicle's cameras.
+ *  Each image kind has its own scene capture, rendered on demand at the sample rate. The captured render targets
+ *  are copied into a ring of GPU readback buffers and read back on the render thread once the GPU is done with them,
+ *  so neither the game thread nor the render thread ever waits on the GPU. Samples are skipped while every buffer is in flight.
+ *
+ *  The semantic image is the CustomDepth stencil of the visible surfaces, written by SemanticMaterial,
+ *  a post process material replacing the tonemapper with CustomStencil / 255.
+ *
+ *  Without an RHI to render with, as with -nullrhi on CPU-only machines, images are ray traced instead on the task graph
+ *  through the sensor rays' static scene and the physics scene: depth is exact, color is the shaded surface reflectivity,
+ *  and the semantic image holds the stencil of the component hit.
+ */
+UCLASS(ClassGroup = (SensorSim), meta = (BlueprintSpawnableComponent))
+class SENSORSIM_API USensorSimCameraComponent : public USensorSimSensorComponent
+{
+	GENERATED_BODY()
+
+protected:
+	/** Camera of the vehicle, identifying its images in recordings */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	uint8 CameraId{ 0 };
+
+	/** Image size, in pixels */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "16", ClampMax = "8192"))
+	int32 Width{ 640 };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "16", ClampMax = "8192"))
+	int32 Height{ 360 };
+
+	/** Horizontal field of view, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "5.0", ClampMax = "170.0"))
+	float FieldOfView{ 90.0f };
+
+	/** Image kinds captured */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	bool bCaptureColor{ true };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	bool bCaptureDepth{ true };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	bool bCaptureSemantic{ true };
+
+	/** Post process material writing the CustomDepth stencil to the semantic image. Semantic images are only rendered with one */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (EditCondition = "bCaptureSemantic"))
+	TObjectPtr<UMaterialInterface> SemanticMaterial{ nullptr };
+
+	/** Only captures on the player's vehicle, so that traffic does not multiply the rendering cost */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera)
+	bool bPlayerOnly{ true };
+
+	/** Number of captures that may be in flight between the GPU and the CPU */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "2", ClampMax = "8"))
+	int32 ReadbackBuffers{ 3 };
+
+	/** Fraction of the image size ray traced without an RHI */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "0.05", ClampMax = "1.0"))
+	float SoftwareScale{ 0.25f };
+
+	/** Farthest surface ray traced without an RHI, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Camera, meta = (ClampMin = "100.0"))
+	float SoftwareMaxRange{ 20000.0f };
+
+	/** Component the images are captured from. Falls back to the owner's root component */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+	TObjectPtr<USceneComponent> Mount{ nullptr };
+
+	/** Scene capture of each image kind, null for kinds not captured. Created on the first capture */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USceneCaptureComponent2D>> Captures;
+
+	/** Readback buffers shared with the render thread */
+	TSharedPtr<FSensorSimCameraReadbackRing, ESPMode::ThreadSafe> ReadbackRing;
+
+	/** True when images are ray traced rather than rendered */
+	bool bSoftware{ false };
+
+	/** Software capture in flight, if any */
+	UE::Tasks::FTask SoftwareTask;
+
+	/** Images of the software capture in flight. Owned by the task until it completes */
+	TArray<TSharedRef<FSensorSimImage, ESPMode::ThreadSafe>> SoftwareImages;
+
+	/** Camera transform of the software capture in flight */
+	FTransform SoftwareTransform;
+
+	/** Query parameters of the software capture in flight */
+	FCollisionQueryParams QueryParams;
+
+	/** Static level geometry the software capture in flight traces, if built */
+	TSharedPtr<const FSensorSimStaticScene, ESPMode::ThreadSafe> StaticScene;
+
+	/** Subsystem looking up the reflectivity of the physical materials hit */
+	UPROPERTY(Transient)
+	TObjectPtr<const USensorSimSensorSubsystem> SensorSubsystem{ nullptr };
+
+	/** Number of captures since BeginPlay */
+	uint32 CaptureSequence{ 0 };
+
+	/** Captures before this one were taken before the last reset, and are dropped */
+	uint32 ResetSequence{ 0 };
+
+public:
+	/** Broadcast on the game thread with every image read back */
+	FOnSensorSimCameraImage OnImage;
+
+	/** Sets the component the images are captured from */
+	void SetMount(USceneComponent* InMount);
+
+	/** Sets the camera of the vehicle identifying the images */
+	void SetCameraId(uint8 InCameraId) { CameraId = InCameraId; }
+
+	/** Returns the camera of the vehicle identifying the images */
+	uint8 GetCameraId() const { return CameraId; }
+
+	/** Returns true if images are ray traced on the CPU rather than rendered */
+	bool IsSoftware() const { return bSoftware; }
+
+	/** Returns true while the camera captures: always, or only on the player's vehicle */
+	bool IsCapturing() const;
+
+	// Begin SensorSimSensorComponent interface
+	virtual int32 RunSchedule(double WorldTime) override;
+	virtual bool CollectSamples() override;
+	virtual void ResetSensor() override;
+protected:
+	virtual bool TakeSample(double SampleTime) override;
+	virtual bool CatchesUp() const override { return false; }
+	// End SensorSimSensorComponent interface
+
+	// Begin ActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End ActorComponent interface
+
+	/** Creates the scene capture and render target of every image kind captured */
+	void CreateCaptures();
+
+	/** Renders and queues the readback of one capture */
+	bool TakeRenderedSample(double SampleTime, const FTransform& CameraTransform);
+
+	/** Launches the ray tracing of one capture */
+	bool TakeSoftwareSample(double SampleTime, const FTransform& CameraTransform);
+
+	/** Ray traces the images of the software capture in flight. Runs on the task graph */
+	void ExecuteSoftwareCapture();
+
+	/** Hands an image to consumers */
+	void PublishImage(const FSensorSimImageRef& Image);
+};
@@ -0,0 +1,651 @@
+#include "SensorSimDatasetCommandlet.h"
+#include "SensorSim.h"
+#include "SensorSimRecording.h"
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace SensorSimDataset
+{
+	/** Bytes read from a worker per call, so that one busy worker cannot starve the others */
+	constexpr int32 MaxReadPerPoll = 16 * 1024 * 1024;
+
+	/** Largest chunk a worker may send, well above any sweep or image, so that a corrupt header cannot stall or overflow the buffer */
+	constexpr uint32 MaxChunkSize = 256 * 1024 * 1024;
+
+	/** Wall clock seconds between progress reports */
+	constexpr double ReportInterval = 10.0;
+
+	enum class EJobStatus : uint8
+	{
+		Pending,
+		Running,
+		Done,
+		Failed,
+	};
+
+	const TCHAR* GetStatusName(EJobStatus Status)
+	{
+		switch (Status)
+		{
+		case EJobStatus::Running:
+			return TEXT("Running");
+		case EJobStatus::Done:
+			return TEXT("Done");
+		case EJobStatus::Failed:
+			return TEXT("Failed");
+		default:
+			return TEXT("Pending");
+		}
+	}
+
+	/** One scenario run with one seed */
+	struct FJob
+	{
+		FString Name;
+		FString Map;
+		FString Vehicle;
+		FString InputTrack;
+		float Seconds = 0.0f;
+		int32 Seed = 0;
+
+		/** Attempts started so far */
+		int32 Attempts = 0;
+
+		EJobStatus Status = EJobStatus::Pending;
+
+		/** Global streams, chunks and bytes of the attempt that completed */
+		TArray<uint16> Streams;
+		int32 NumChunks = 0;
+		uint64 Bytes = 0;
+	};
+
+	/** Recording stream of a worker */
+	struct FConnection
+	{
+		FSocket* Socket = nullptr;
+
+		/** Bytes received and not yet parsed, from ReadOffset on */
+		TArray<uint8> Received;
+		int32 ReadOffset = 0;
+
+		/** Set once the stream header has been read */
+		TOptional<FSensorSimRecordingStreamHeader> Header;
+
+		/** True once the end marker has been read */
+		bool bEnded = false;
+
+		/** True once the worker closed the connection, or it failed */
+		bool bClosed = false;
+
+		/** Global stream of each of the worker's streams */
+		TMap<uint16, uint16> Streams;
+
+		int32 NumChunks = 0;
+		uint64 Bytes = 0;
+	};
+
+	/** Worker process slot */
+	struct FWorker
+	{
+		/** Job run by the worker, INDEX_NONE while idle */
+		int32 Job = INDEX_NONE;
+		int32 Attempt = 0;
+
+		FProcHandle Process;
+		FString LogFile;
+
+		/** Wall clock time the worker was launched at, or last sent data */
+		double LastProgressSeconds = 0.0;
+
+		FConnection Connection;
+	};
+
+	/** Reads the scenarios of a CSV file. Returns false if the file is not valid */
+	bool LoadScenarios(const FString& Filename, TArray<FJob>& OutScenarios)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("Failed to read scenarios '%s'"), *Filename);
+			return false;
+		}
+
+		TArray<FString> Columns;
+		bool bHeader = false;
+
+		for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			const FString Line = Lines[LineIndex].TrimStartAndEnd();
+
+			// skip blanks and comments
+			if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+			{
+				continue;
+			}
+
+			Line.ParseIntoArray(Columns, TEXT(","), false);
+			for (FString& Column : Columns)
+			{
+				Column.TrimStartAndEndInline();
+			}
+
+			if (!bHeader)
+			{
+				if (Columns.Num() != 5 || Columns[0] != TEXT("Name") || Columns[1] != TEXT("Map") || Columns[2] != TEXT("Vehicle")
+					|| Columns[3] != TEXT("InputTrack") || Columns[4] != TEXT("Seconds"))
+				{
+					UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected a Name,Map,Vehicle,InputTrack,Seconds header"), *Filename, LineIndex + 1);
+					return false;
+				}
+
+				bHeader = true;
+				continue;
+			}
+
+			if (Columns.Num() != 5 || Columns[0].IsEmpty() || Columns[1].IsEmpty())
+			{
+				UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected a name, a map and 5 columns"), *Filename, LineIndex + 1);
+				return false;
+			}
+
+			FJob& Scenario = OutScenarios.AddDefaulted_GetRef();
+			Scenario.Name = Columns[0];
+			Scenario.Map = Columns[1];
+			Scenario.Vehicle = Columns[2];
+			Scenario.InputTrack = Columns[3].IsEmpty() || !FPaths::IsRelative(Columns[3]) ? Columns[3] : FPaths::ConvertRelativePathToFull(FPaths::ProjectDir() / Columns[3]);
+			Scenario.Seconds = FCString::Atof(*Columns[4]);
+
+			// workers run until stopped without a duration
+			if (Scenario.Seconds <= 0.0f)
+			{
+				UE_LOG(LogSensorSim, Error, TEXT("%s(%d): scenario '%s' has no duration"), *Filename, LineIndex + 1, *Scenario.Name);
+				return false;
+			}
+		}
+
+		if (OutScenarios.IsEmpty())
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("Scenarios '%s' list no scenario"), *Filename);
+			return false;
+		}
+
+		return true;
+	}
+
+	/** Reads what a worker has sent so far. Marks the connection closed once the worker has closed it */
+	void ReadConnection(FConnection& Connection)
+	{
+		uint8 Buffer[64 * 1024];
+		int32 BytesRead = 0;
+		int32 TotalRead = 0;
+
+		// a graceful close reads as a failure
+		do
+		{
+			if (!Connection.Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+			{
+				Connection.bClosed = true;
+				return;
+			}
+
+			Connection.Received.Append(Buffer, BytesRead);
+			TotalRead += BytesRead;
+		}
+		while (BytesRead == sizeof(Buffer) && TotalRead < MaxReadPerPoll);
+	}
+
+	/** Reads the stream header of a connection. Returns false if the connection is not a recording stream */
+	bool ReadHeader(FConnection& Connection)
+	{
+		if (Connection.Header.IsSet() || Connection.Received.Num() < int32(sizeof(FSensorSimRecordingStreamHeader)))
+		{
+			return true;
+		}
+
+		FSensorSimRecordingStreamHeader Header;
+		FMemory::Memcpy(&Header, Connection.Received.GetData(), sizeof(Header));
+		Connection.ReadOffset = sizeof(Header);
+
+		if (Header.Magic != SensorSimRecording::StreamMagic || Header.Version != SensorSimRecording::Version)
+		{
+			return false;
+		}
+
+		Connection.Header = Header;
+		return true;
+	}
+
+	/** Closes a connection's socket */
+	void CloseConnection(FConnection& Connection)
+	{
+		if (Connection.Socket)
+		{
+			Connection.Socket->Close();
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection.Socket);
+		}
+
+		Connection = FConnection();
+	}
+}
+
+USensorSimDatasetCommandlet::USensorSimDatasetCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Generates a dataset with many headless worker processes and merges their recordings into one indexed recording");
+	HelpUsage = TEXT("-run=SensorSimDataset -Scenarios=<file.csv> [-Seeds=1] [-Workers=8] [-Port=8788] [-Output=<file.ssrec>]");
+}
+
+int32 USensorSimDatasetCommandlet::Main(const FString& Params)
+{
+	using namespace SensorSimDataset;
+
+	FString ScenariosFile;
+	int32 NumSeeds = 1;
+	FString Output = FPaths::ProjectSavedDir() / TEXT("Datasets") / TEXT("Dataset.ssrec");
+
+	FParse::Value(*Params, TEXT("Scenarios="), ScenariosFile);
+	FParse::Value(*Params, TEXT("Seeds="), NumSeeds);
+	FParse::Value(*Params, TEXT("Workers="), Workers);
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Output="), Output);
+
+	if (FPaths::IsRelative(ScenariosFile) && !ScenariosFile.IsEmpty())
+	{
+		ScenariosFile = FPaths::ProjectDir() / ScenariosFile;
+	}
+
+	TArray<FJob> Scenarios;
+	if (ScenariosFile.IsEmpty() || !LoadScenarios(ScenariosFile, Scenarios))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Usage: %s"), *HelpUsage);
+		return 1;
+	}
+
+	// every scenario once per seed
+	TArray<FJob> Jobs;
+	for (const FJob& Scenario : Scenarios)
+	{
+		for (int32 Seed = 0; Seed < FMath::Max(NumSeeds, 1); ++Seed)
+		{
+			FJob& Job = Jobs.Add_GetRef(Scenario);
+			Job.Seed = Seed;
+		}
+	}
+
+	// taken from the back, so that retried jobs run next
+	TArray<int32> Pending;
+	for (int32 JobIndex = Jobs.Num() - 1; JobIndex >= 0; --JobIndex)
+	{
+		Pending.Add(JobIndex);
+	}
+
+	// loopback only: workers run on the coordinator's host
+	FSocket* Listener = FTcpSocketBuilder(TEXT("SensorSimDataset"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address(127, 0, 0, 1), static_cast<uint16>(Port)))
+		.Listening(64)
+		.Build();
+
+	if (!Listener)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to listen on 127.0.0.1:%d for worker recordings"), Port);
+		return 1;
+	}
+
+	FSensorSimRecordingWriter Writer;
+	if (!Writer.Open(Output, ESensorSimRecordingCompression::None))
+	{
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+		return 1;
+	}
+
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString LogDirectory = FPaths::ConvertRelativePathToFull(FPaths::GetPath(Output) / TEXT("Logs"));
+	const FString BaseName = FPaths::GetBaseFilename(Output);
+
+	TArray<FWorker> Slots;
+	Slots.SetNum(FMath::Clamp(Workers, 1, Jobs.Num()));
+
+	TArray<FConnection> Unidentified;
+	uint32 NextStream = 0;
+	int32 NumRunning = 0;
+
+	UE_LOG(LogSensorSim, Display, TEXT("Generating %d jobs (%d scenarios x %d seeds) with %d workers into '%s'"),
+		Jobs.Num(), Scenarios.Num(), FMath::Max(NumSeeds, 1), Slots.Num(), *Output);
+
+	// ends an attempt that did not complete, and queues the job again if it has attempts left
+	auto FailAttempt = [&](FWorker& Worker, const TCHAR* Reason)
+	{
+		FJob& Job = Jobs[Worker.Job];
+
+		if (Worker.Process.IsValid())
+		{
+			if (FPlatformProcess::IsProcRunning(Worker.Process))
+			{
+				FPlatformProcess::TerminateProc(Worker.Process, true);
+				FPlatformProcess::WaitForProc(Worker.Process);
+			}
+			FPlatformProcess::CloseProc(Worker.Process);
+		}
+
+		for (const TPair<uint16, uint16>& Stream : Worker.Connection.Streams)
+		{
+			Writer.DiscardStream(Stream.Value);
+		}
+
+		const bool bRetry = Job.Attempts < MaxAttempts;
+		Job.Status = bRetry ? EJobStatus::Pending : EJobStatus::Failed;
+		if (bRetry)
+		{
+			Pending.Add(Worker.Job);
+		}
+
+		UE_LOG(LogSensorSim, Warning, TEXT("Job %d (%s, seed %d) attempt %d %s%s, see '%s'"), Worker.Job, *Job.Name, Job.Seed, Worker.Attempt + 1,
+			Reason, bRetry ? TEXT(", retrying") : TEXT(", giving up"), *Worker.LogFile);
+
+		CloseConnection(Worker.Connection);
+		Worker = FWorker();
+		--NumRunning;
+	};
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	double LastReportSeconds = StartSeconds;
+	int32 NumDone = 0;
+	bool bStreamsExhausted = false;
+
+	while ((NumRunning > 0 || !Pending.IsEmpty()) && !IsEngineExitRequested() && !bStreamsExhausted)
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		// idle slots take the next pending jobs
+		for (FWorker& Worker : Slots)
+		{
+			if (Worker.Job != INDEX_NONE || Pending.IsEmpty())
+			{
+				continue;
+			}
+
+			Worker.Job = Pending.Pop(EAllowShrinking::No);
+			FJob& Job = Jobs[Worker.Job];
+			Worker.Attempt = Job.Attempts++;
+			Worker.LogFile = LogDirectory / FString::Printf(TEXT("%s_Job%d_%d.log"), *BaseName, Worker.Job, Worker.Attempt);
+			Worker.LastProgressSeconds = Now;
+			Job.Status = EJobStatus::Running;
+			++NumRunning;
+
+			FString WorkerParams = FString::Printf(TEXT("\"%s\" %s?game=Batch -game -nullrhi -nosound -nosplash -unattended -BatchDuration=%g -SensorSimSeed=%d")
+				TEXT(" -SensorSimRecordStream=127.0.0.1:%d -SensorSimJob=%d -SensorSimAttempt=%d -abslog=\"%s\""),
+				*ProjectFile, *Job.Map, Job.Seconds, Job.Seed, Port, Worker.Job, Worker.Attempt, *Worker.LogFile);
+
+			if (!Job.Vehicle.IsEmpty())
+			{
+				WorkerParams += FString::Printf(TEXT(" -BatchVehicle=%s"), *Job.Vehicle);
+			}
+
+			if (!Job.InputTrack.IsEmpty())
+			{
+				WorkerParams += FString::Printf(TEXT(" -InputTrack=\"%s\""), *Job.InputTrack);
+			}
+
+			if (!WorkerArguments.IsEmpty())
+			{
+				WorkerParams += TEXT(" ") + WorkerArguments;
+			}
+
+			Worker.Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *WorkerParams, false, true, true, nullptr, 0, nullptr, nullptr);
+			if (!Worker.Process.IsValid())
+			{
+				FailAttempt(Worker, TEXT("failed to launch"));
+			}
+		}
+
+		// workers identify their job in the stream header
+		bool bPendingConnection = false;
+		while (Listener->HasPendingConnection(bPendingConnection) && bPendingConnection)
+		{
+			if (FSocket* Socket = Listener->Accept(TEXT("SensorSimDatasetWorker")))
+			{
+				Socket->SetNonBlocking(true);
+				Unidentified.AddDefaulted_GetRef().Socket = Socket;
+			}
+		}
+
+		for (int32 Index = Unidentified.Num() - 1; Index >= 0; --Index)
+		{
+			FConnection& Connection = Unidentified[Index];
+			ReadConnection(Connection);
+
+			if (!ReadHeader(Connection) || (Connection.bClosed && !Connection.Header.IsSet()))
+			{
+				CloseConnection(Connection);
+				Unidentified.RemoveAtSwap(Index);
+				continue;
+			}
+
+			if (!Connection.Header.IsSet())
+			{
+				continue;
+			}
+
+			// a worker of an attempt that was already given up on is turned away
+			FWorker* Owner = Slots.FindByPredicate([&Connection](const FWorker& Worker)
+			{
+				return Worker.Job == int32(Connection.Header->Job) && Worker.Attempt == int32(Connection.Header->Attempt) && !Worker.Connection.Socket;
+			});
+
+			if (Owner)
+			{
+				Owner->Connection = MoveTemp(Connection);
+			}
+			else
+			{
+				CloseConnection(Connection);
+			}
+			Unidentified.RemoveAtSwap(Index);
+		}
+
+		// forward every complete chunk, as stored, under its global stream
+		bool bReceived = false;
+		for (FWorker& Worker : Slots)
+		{
+			FConnection& Connection = Worker.Connection;
+			if (Worker.Job == INDEX_NONE || !Connection.Socket)
+			{
+				continue;
+			}
+
+			const int32 PreviousSize = Connection.Received.Num();
+			ReadConnection(Connection);
+			if (Connection.Received.Num() != PreviousSize)
+			{
+				Worker.LastProgressSeconds = Now;
+				bReceived = true;
+			}
+
+			while (!Connection.bEnded && Connection.Received.Num() - Connection.ReadOffset >= int32(sizeof(FSensorSimChunkHeader)))
+			{
+				FSensorSimChunkHeader Header;
+				FMemory::Memcpy(&Header, Connection.Received.GetData() + Connection.ReadOffset, sizeof(Header));
+
+				if (Header.Type == SensorSimRecording::EndOfStream)
+				{
+					Connection.ReadOffset += sizeof(Header);
+					Connection.bEnded = true;
+					break;
+				}
+
+				if (Header.Type > static_cast<uint8>(ESensorSimChunkType::CameraImage) || Header.StoredSize > MaxChunkSize || Header.RawSize > MaxChunkSize)
+				{
+					FailAttempt(Worker, TEXT("sent a corrupt chunk"));
+					break;
+				}
+
+				if (int64(Connection.Received.Num()) - Connection.ReadOffset < int64(sizeof(Header)) + Header.StoredSize)
+				{
+					break;
+				}
+
+				uint16* GlobalStream = Connection.Streams.Find(Header.StreamId);
+				if (!GlobalStream)
+				{
+					if (NextStream > MAX_uint16)
+					{
+						UE_LOG(LogSensorSim, Error, TEXT("The dataset holds at most %d streams"), MAX_uint16 + 1);
+						bStreamsExhausted = true;
+						break;
+					}
+
+					GlobalStream = &Connection.Streams.Add(Header.StreamId, static_cast<uint16>(NextStream++));
+				}
+
+				const uint8* Payload = Connection.Received.GetData() + Connection.ReadOffset + sizeof(Header);
+				Writer.AddStoredChunk(*GlobalStream, Header, TArray<uint8>(Payload, Header.StoredSize));
+
+				Connection.ReadOffset += sizeof(Header) + Header.StoredSize;
+				Connection.NumChunks++;
+				Connection.Bytes += sizeof(Header) + Header.StoredSize;
+			}
+
+			// drop what has been parsed once it is the bulk of the buffer
+			if (Connection.ReadOffset > 0 && Connection.ReadOffset >= Connection.Received.Num() / 2)
+			{
+				Connection.Received.RemoveAt(0, Connection.ReadOffset, EAllowShrinking::No);
+				Connection.ReadOffset = 0;
+			}
+		}
+
+		// completed, crashed and hung workers
+		for (FWorker& Worker : Slots)
+		{
+			if (Worker.Job == INDEX_NONE)
+			{
+				continue;
+			}
+
+			FConnection& Connection = Worker.Connection;
+			FJob& Job = Jobs[Worker.Job];
+
+			if (Connection.bClosed && !Connection.bEnded)
+			{
+				FailAttempt(Worker, TEXT("ended its stream early"));
+				continue;
+			}
+
+			if (!FPlatformProcess::IsProcRunning(Worker.Process))
+			{
+				int32 ReturnCode = 0;
+				FPlatformProcess::GetProcReturnCode(Worker.Process, &ReturnCode);
+
+				// the end marker may still be in flight when the process exits; it is read on a later pass
+				if (ReturnCode == 0 && !Connection.bEnded && Connection.Socket && Now - Worker.LastProgressSeconds < StallSeconds)
+				{
+					continue;
+				}
+
+				if (ReturnCode != 0 || !Connection.bEnded)
+				{
+					FailAttempt(Worker, *FString::Printf(TEXT("exited with code %d"), ReturnCode));
+					continue;
+				}
+
+				TArray<uint16> Streams;
+				Connection.Streams.GenerateValueArray(Streams);
+				Streams.Sort();
+
+				Job.Status = EJobStatus::Done;
+				Job.Streams = MoveTemp(Streams);
+				Job.NumChunks = Connection.NumChunks;
+				Job.Bytes = Connection.Bytes;
+
+				FPlatformProcess::CloseProc(Worker.Process);
+				CloseConnection(Connection);
+				Worker = FWorker();
+				--NumRunning;
+				++NumDone;
+				continue;
+			}
+
+			if (Now - Worker.LastProgressSeconds > StallSeconds)
+			{
+				FailAttempt(Worker, *FString::Printf(TEXT("stalled for %.0fs"), StallSeconds));
+			}
+		}
+
+		if (Now - LastReportSeconds >= ReportInterval)
+		{
+			LastReportSeconds = Now;
+			UE_LOG(LogSensorSim, Display, TEXT("Dataset: %d/%d jobs done, %d running, %.1f MiB written, %d chunks queued"),
+				NumDone, Jobs.Num(), NumRunning, Writer.GetBytesWritten() / (1024.0 * 1024.0), Writer.GetNumPendingChunks());
+		}
+
+		if (!bReceived)
+		{
+			FPlatformProcess::Sleep(0.005f);
+		}
+	}
+
+	// workers still running when the run is stopped leave their jobs pending
+	for (FWorker& Worker : Slots)
+	{
+		if (Worker.Job != INDEX_NONE)
+		{
+			Jobs[Worker.Job].Status = EJobStatus::Pending;
+			for (const TPair<uint16, uint16>& Stream : Worker.Connection.Streams)
+			{
+				Writer.DiscardStream(Stream.Value);
+			}
+
+			FPlatformProcess::TerminateProc(Worker.Process, true);
+			FPlatformProcess::WaitForProc(Worker.Process);
+			FPlatformProcess::CloseProc(Worker.Process);
+			CloseConnection(Worker.Connection);
+		}
+	}
+
+	for (FConnection& Connection : Unidentified)
+	{
+		CloseConnection(Connection);
+	}
+
+	Listener->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+
+	Writer.Close();
+
+	// the manifest maps the dataset's streams back to their jobs
+	FString Manifest = TEXT("Job,Name,Map,Vehicle,InputTrack,Seconds,Seed,Attempts,Status,Streams,Chunks,Bytes\n");
+	double SimSeconds = 0.0;
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		const FJob& Job = Jobs[JobIndex];
+		const FString Streams = FString::JoinBy(Job.Streams, TEXT(" "), [](uint16 Stream) { return FString::FromInt(Stream); });
+
+		Manifest += FString::Printf(TEXT("%d,%s,%s,%s,%s,%g,%d,%d,%s,%s,%d,%llu\n"), JobIndex, *Job.Name, *Job.Map, *Job.Vehicle, *Job.InputTrack,
+			Job.Seconds, Job.Seed, Job.Attempts, GetStatusName(Job.Status), *Streams, Job.NumChunks, Job.Bytes);
+
+		SimSeconds += Job.Status == EJobStatus::Done ? Job.Seconds : 0.0;
+	}
+
+	const FString ManifestFile = FPaths::ChangeExtension(Output, TEXT("csv"));
+	if (!FFileHelper::SaveStringToFile(Manifest, *ManifestFile))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to write dataset manifest '%s'"), *ManifestFile);
+		return 1;
+	}
+
+	const double Elapsed = FMath::Max(FPlatformTime::Seconds() - StartSeconds, UE_SMALL_NUMBER);
+	UE_LOG(LogSensorSim, Display, TEXT("Dataset complete: %d/%d jobs, %d streams, %.1f MiB in %.1fs (%.1f sim s / wall s), manifest '%s'"),
+		NumDone, Jobs.Num(), NextStream, Writer.GetBytesWritten() / (1024.0 * 1024.0), Elapsed, SimSeconds / Elapsed, *ManifestFile);
+
+	return NumDone == Jobs.Num() ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SensorSimDatasetCommandlet.generated.h"
+
+/**
+ *  Dataset Commandlet
+ *  Generates a dataset with many headless worker processes on one host, since one process cannot keep every core busy.
+ *
+ *  Jobs are the scenarios of a CSV file, each run once per seed. Up to Workers batch mode processes run at once, each
+ *  taking the next pending job when one finishes, and stream their recordings over local TCP connections. Every chunk
+ *  is forwarded, as stored, into one recording with a global stream id per job and vehicle, and one index.
+ *  A manifest CSV next to it lists the streams of every job.
+ *
+ *  A worker that crashes, exits with an error, ends its stream early, sends a corrupt chunk or stalls for StallSeconds
+ *  is stopped, and its job is run again, up to MaxAttempts times. The chunks it had streamed stay in the file but are
+ *  left out of the index.
+ *  Batch runs are deterministic at a fixed step, so the new attempt records the same data.
+ *
+ *  Scenario files are CSV with a Name,Map,Vehicle,InputTrack,Seconds header, e.g.
+ *    Name,Map,Vehicle,InputTrack,Seconds
+ *    Adv,/Game/VehicleTemplate/Maps/VehicleAdvExampleMap,,Benchmark/Routes/SportsCar.csv,60
+ *  An empty Vehicle keeps the batch mode's vehicle. Input tracks are relative to the project directory.
+ *
+ *  Usage:
+ *    UnrealEditor-Cmd SensorSim.uproject -run=SensorSimDataset -Scenarios=<file.csv> [-Seeds=1] [-Workers=8]
+ *      [-Port=8788] [-Output=<file.ssrec>]
+ *
+ *  Returns non-zero if the scenarios could not be loaded, or any job failed every attempt.
+ */
+UCLASS(Config = Game)
+class USensorSimDatasetCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimDatasetCommandlet();
+
+protected:
+	/** Worker processes run at once */
+	UPROPERTY(Config)
+	int32 Workers{ 8 };
+
+	/** Loopback port the workers stream to */
+	UPROPERTY(Config)
+	int32 Port{ 8788 };
+
+	/** Runs of a job before it is given up */
+	UPROPERTY(Config)
+	int32 MaxAttempts{ 3 };
+
+	/** Wall clock seconds without data after which a worker is taken to have hung */
+	UPROPERTY(Config)
+	float StallSeconds{ 120.0f };
+
+	/** Extra arguments of every worker, such as -BatchFixedDt */
+	UPROPERTY(Config)
+	FString WorkerArguments;
+
+public:
+	// Begin Commandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End Commandlet interface
+};
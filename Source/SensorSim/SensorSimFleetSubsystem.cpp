@@ -0,0 +1,329 @@
+#include "SensorSimFleetSubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimPawn.h"
+#include "SensorSimInputTrack.h"
+#include "SensorSimSensorSubsystem.h"
+#include "SensorSimRecordingSubsystem.h"
+#include "SensorSimPublisherSubsystem.h"
+#include "SensorSimScenarioSubsystem.h"
+#include "SensorSimVehicleCatalog.h"
+#include "ChaosWheeledVehicleMovementComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdFleetSpawn(
+	TEXT("SensorSim.Fleet.Spawn"),
+	TEXT("Spawns <Count> AI-driven vehicles with their own LiDAR"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimFleetSubsystem* Fleet = World ? World->GetSubsystem<USensorSimFleetSubsystem>() : nullptr)
+		{
+			const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1;
+			Fleet->SpawnFleet(Count, FVector::ZeroVector);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdFleetClear(
+	TEXT("SensorSim.Fleet.Clear"),
+	TEXT("Returns every fleet vehicle to the vehicle pool"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimFleetSubsystem* Fleet = World ? World->GetSubsystem<USensorSimFleetSubsystem>() : nullptr)
+		{
+			Fleet->ClearFleet();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdFleetBenchmark(
+	TEXT("SensorSim.Fleet.Benchmark"),
+	TEXT("Measures LiDAR rays/sec against fleet size. Usage: SensorSim.Fleet.Benchmark <SecondsPerStage> <Count> [<Count> ...]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		USensorSimFleetSubsystem* Fleet = World ? World->GetSubsystem<USensorSimFleetSubsystem>() : nullptr;
+		if (!Fleet || Args.Num() < 2)
+		{
+			UE_LOG(LogSensorSim, Warning, TEXT("Usage: SensorSim.Fleet.Benchmark <SecondsPerStage> <Count> [<Count> ...]"));
+			return;
+		}
+
+		TArray<int32> Counts;
+		for (int32 ArgIndex = 1; ArgIndex < Args.Num(); ++ArgIndex)
+		{
+			Counts.Add(FCString::Atoi(*Args[ArgIndex]));
+		}
+
+		Fleet->StartBenchmark(Counts, FCString::Atof(*Args[0]));
+	}));
+
+namespace SensorSimFleet
+{
+	/** Simulation seconds each benchmark stage runs before measuring, to let vehicles settle */
+	constexpr float BenchmarkWarmUpSeconds = 2.0f;
+
+	/** Height above ground at which vehicles are spawned, in cm */
+	constexpr float SpawnHeight = 50.0f;
+
+	/** Angle ahead on the orbit the vehicles steer towards, in radians */
+	constexpr float LookAheadAngle = 0.25f;
+}
+
+void USensorSimFleetSubsystem::SpawnFleet(int32 Count, const FVector& Center)
+{
+	UWorld* World = GetWorld();
+	USensorSimRecordingSubsystem* Recording = World->GetSubsystem<USensorSimRecordingSubsystem>();
+	USensorSimPublisherSubsystem* Publisher = World->GetSubsystem<USensorSimPublisherSubsystem>();
+	USensorSimScenarioSubsystem* Scenario = World->GetSubsystem<USensorSimScenarioSubsystem>();
+
+	if (VehicleClasses.IsEmpty())
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("No fleet vehicle classes configured"));
+		return;
+	}
+
+	// fleet vehicles come from the pool, which only game worlds have
+	if (!Scenario)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("No vehicle pool to spawn the fleet from"));
+		return;
+	}
+
+	if (Vehicles.IsEmpty())
+	{
+		FleetCenter = Center.IsZero() ? FindFleetCenter() : Center;
+	}
+
+	const FSensorSimVehicleCatalog& Catalog = FSensorSimVehicleCatalog::Get();
+	const bool bUseCatalog = bSpawnCatalogArchetypes || FParse::Param(FCommandLine::Get(), TEXT("FleetCatalog"));
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		// fill the orbits from the inside out, spreading vehicles evenly on each one
+		const int32 Slot = Vehicles.Num();
+		const int32 Orbit = Slot / VehiclesPerOrbit;
+		const float OrbitRadius = MinOrbitRadius + Orbit * OrbitSpacing;
+		const float Angle = UE_TWO_PI * (Slot % VehiclesPerOrbit) / VehiclesPerOrbit;
+
+		// variants only differ by archetype index; the class is picked by the body they are built on
+		const int32 ArchetypeIndex = bUseCatalog ? Slot % Catalog.Num() : INDEX_NONE;
+		const int32 ClassIndex = bUseCatalog ? static_cast<int32>(Catalog.GetArchetype(ArchetypeIndex).Body) % VehicleClasses.Num() : Slot % VehicleClasses.Num();
+
+		UClass* VehicleClass = VehicleClasses[ClassIndex].LoadSynchronous();
+		if (!VehicleClass)
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("Failed to load fleet vehicle class %s"), *VehicleClasses[ClassIndex].ToString());
+			return;
+		}
+
+		// face along the orbit, counter-clockwise
+		const FVector Location = FleetCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * OrbitRadius + FVector(0.0f, 0.0f, SensorSimFleet::SpawnHeight);
+		const FRotator Rotation(0.0f, FMath::RadiansToDegrees(Angle) + 90.0f, 0.0f);
+
+		// pooled vehicles are reused across stages and scenario resets rather than spawned anew
+		ASensorSimPawn* Pawn = Scenario->AcquireVehicle(VehicleClass, FTransform(Rotation, Location), ArchetypeIndex);
+		if (!Pawn)
+		{
+			continue;
+		}
+
+		// fleet vehicles are driven without a controller
+		Pawn->GetChaosVehicleMovement()->bRequiresControllerForInputs = false;
+
+		FSensorSimFleetVehicle& Vehicle = Vehicles.AddDefaulted_GetRef();
+		Vehicle.Pawn = Pawn;
+		Vehicle.OrbitRadius = OrbitRadius;
+		Vehicle.CruiseSpeed = CruiseSpeed;
+
+		if (Recording)
+		{
+			Recording->RecordVehicle(Pawn);
+		}
+
+		if (Publisher)
+		{
+			Publisher->PublishVehicle(Pawn);
+		}
+	}
+
+	UE_LOG(LogSensorSim, Log, TEXT("Fleet: %d vehicles"), Vehicles.Num());
+}
+
+void USensorSimFleetSubsystem::ClearFleet()
+{
+	USensorSimScenarioSubsystem* Scenario = GetWorld()->GetSubsystem<USensorSimScenarioSubsystem>();
+
+	for (const FSensorSimFleetVehicle& Vehicle : Vehicles)
+	{
+		if (Scenario && IsValid(Vehicle.Pawn) && !Vehicle.Pawn->IsParked())
+		{
+			Scenario->ReleaseVehicle(Vehicle.Pawn);
+		}
+	}
+
+	Vehicles.Reset();
+}
+
+void USensorSimFleetSubsystem::StartBenchmark(const TArray<int32>& Counts, float SecondsPerStage)
+{
+	BenchmarkCounts = Counts;
+	BenchmarkStageSeconds = FMath::Max(SecondsPerStage, 1.0f);
+	BenchmarkResults.Reset();
+
+	UE_LOG(LogSensorSim, Display, TEXT("Fleet benchmark: %d stages of %.1fs on %d logical cores"),
+		BenchmarkCounts.Num(), BenchmarkStageSeconds, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+
+	StartBenchmarkStage();
+}
+
+void USensorSimFleetSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	DriveFleet();
+	TickBenchmark(DeltaTime);
+}
+
+void USensorSimFleetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (USensorSimScenarioSubsystem* Scenario = InWorld.GetSubsystem<USensorSimScenarioSubsystem>())
+	{
+		Scenario->OnSnapshotCaptured.AddUObject(this, &USensorSimFleetSubsystem::OnSnapshotCaptured);
+		Scenario->OnScenarioReset.AddUObject(this, &USensorSimFleetSubsystem::OnScenarioReset);
+	}
+}
+
+TStatId USensorSimFleetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USensorSimFleetSubsystem, STATGROUP_Tickables);
+}
+
+bool USensorSimFleetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USensorSimFleetSubsystem::OnSnapshotCaptured()
+{
+	SnapshotVehicles = Vehicles;
+}
+
+void USensorSimFleetSubsystem::OnScenarioReset()
+{
+	// the reset restores the vehicles in play at the snapshot, released ones included, and parks those acquired since
+	Vehicles = SnapshotVehicles;
+	Vehicles.RemoveAllSwap([](const FSensorSimFleetVehicle& Vehicle) { return !IsValid(Vehicle.Pawn) || Vehicle.Pawn->IsParked(); });
+}
+
+void USensorSimFleetSubsystem::DriveFleet()
+{
+	// vehicles parked by a scenario reset have left the fleet
+	Vehicles.RemoveAllSwap([](const FSensorSimFleetVehicle& Vehicle) { return !IsValid(Vehicle.Pawn) || Vehicle.Pawn->IsParked(); });
+
+	for (const FSensorSimFleetVehicle& Vehicle : Vehicles)
+	{
+		const FVector Location = Vehicle.Pawn->GetActorLocation();
+		const FVector Offset = Location - FleetCenter;
+
+		// steer towards a point slightly ahead on the orbit
+		const float Angle = FMath::Atan2(Offset.Y, Offset.X) + SensorSimFleet::LookAheadAngle;
+		const FVector Target = FleetCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Vehicle.OrbitRadius;
+		const FVector LocalTarget = Vehicle.Pawn->GetActorTransform().InverseTransformPosition(Target);
+		const float HeadingError = FMath::Atan2(LocalTarget.Y, LocalTarget.X);
+
+		// proportional speed control
+		const float SpeedError = Vehicle.CruiseSpeed - Vehicle.Pawn->GetChaosVehicleMovement()->GetForwardSpeed();
+
+		FSensorSimVehicleInput Input;
+		Input.Steering = FMath::Clamp(HeadingError / FMath::DegreesToRadians(30.0f), -1.0f, 1.0f);
+		Input.Throttle = FMath::Clamp(SpeedError / 500.0f, 0.0f, 1.0f);
+		Input.Brake = FMath::Clamp(-SpeedError / 500.0f, 0.0f, 1.0f);
+
+		Vehicle.Pawn->ApplyVehicleInput(Input);
+	}
+}
+
+void USensorSimFleetSubsystem::TickBenchmark(float DeltaTime)
+{
+	if (BenchmarkCounts.IsEmpty())
+	{
+		return;
+	}
+
+	USensorSimSensorSubsystem* Sensors = GetWorld()->GetSubsystem<USensorSimSensorSubsystem>();
+	BenchmarkStageElapsed += DeltaTime;
+
+	// start measuring once the vehicles have settled
+	if (!bBenchmarkMeasuring)
+	{
+		if (BenchmarkStageElapsed >= SensorSimFleet::BenchmarkWarmUpSeconds)
+		{
+			bBenchmarkMeasuring = true;
+			BenchmarkStageElapsed = 0.0f;
+			BenchmarkWallStart = FPlatformTime::Seconds();
+			Sensors->ResetCounters();
+		}
+		return;
+	}
+
+	if (BenchmarkStageElapsed < BenchmarkStageSeconds)
+	{
+		return;
+	}
+
+	const double WallSeconds = FPlatformTime::Seconds() - BenchmarkWallStart;
+	const double SweepSeconds = Sensors->GetTotalSweepSeconds();
+	const double Rays = static_cast<double>(Sensors->GetTotalRays());
+
+	// rays per wall second overall, and per second spent inside the sweep tasks
+	const FString Result = FString::Printf(TEXT("%d,%d,%.0f,%.0f,%.3f"),
+		BenchmarkCounts[0], Sensors->GetNumLidars(),
+		WallSeconds > 0.0 ? Rays / WallSeconds : 0.0,
+		SweepSeconds > 0.0 ? Rays / SweepSeconds : 0.0,
+		WallSeconds > 0.0 ? BenchmarkStageElapsed / WallSeconds : 0.0);
+
+	BenchmarkResults.Add(Result);
+	UE_LOG(LogSensorSim, Display, TEXT("Fleet benchmark stage: %s"), *Result);
+
+	BenchmarkCounts.RemoveAt(0);
+	if (!BenchmarkCounts.IsEmpty())
+	{
+		StartBenchmarkStage();
+		return;
+	}
+
+	ClearFleet();
+
+	UE_LOG(LogSensorSim, Display, TEXT("Fleet benchmark results:"));
+	UE_LOG(LogSensorSim, Display, TEXT("Vehicles,Lidars,RaysPerWallSecond,RaysPerSweepTaskSecond,SimSecondsPerWallSecond"));
+	for (const FString& Line : BenchmarkResults)
+	{
+		UE_LOG(LogSensorSim, Display, TEXT("%s"), *Line);
+	}
+}
+
+void USensorSimFleetSubsystem::StartBenchmarkStage()
+{
+	ClearFleet();
+	SpawnFleet(BenchmarkCounts[0], FVector::ZeroVector);
+
+	BenchmarkStageElapsed = 0.0f;
+	bBenchmarkMeasuring = false;
+}
+
+FVector USensorSimFleetSubsystem::FindFleetCenter() const
+{
+	// center the fleet on the player's vehicle, when there is one
+	if (const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+	{
+		if (const APawn* PlayerPawn = PlayerController->GetPawn())
+		{
+			return PlayerPawn->GetActorLocation();
+		}
+	}
+
+	return FVector::ZeroVector;
+}
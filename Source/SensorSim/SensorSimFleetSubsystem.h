@@ -0,0 +1,144 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SensorSimFleetSubsystem.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+
+/**
+ *  Fleet vehicle bookkeeping
+ *  Fleet vehicles circle the fleet center on their own orbit at a cruise speed.
+ */
+USTRUCT()
+struct FSensorSimFleetVehicle
+{
+	GENERATED_BODY()
+
+	/** Spawned vehicle */
+	UPROPERTY()
+	TObjectPtr<ASensorSimPawn> Pawn{ nullptr };
+
+	/** Radius of the circle driven around the fleet center, in cm */
+	float OrbitRadius{ 0.0f };
+
+	/** Target forward speed, in cm/s */
+	float CruiseSpeed{ 0.0f };
+};
+
+/**
+ *  Fleet Subsystem
+ *  Spawns and drives any number of uncontrolled vehicles, each carrying its own LiDAR.
+ *  Vehicles are driven directly through their movement component, no controller is spawned for them.
+ *  They are acquired from the scenario subsystem's pool, and returned to it when the fleet is cleared.
+ *  A scenario reset gives the fleet back the vehicles it had at the snapshot.
+ *  Vehicles may be set up from the vehicle catalog, one archetype per vehicle, to drive many variants at once.
+ *  Sweeps are run in parallel by the sensor subsystem.
+ *
+ *  Console commands:
+ *    SensorSim.Fleet.Spawn <Count>
+ *    SensorSim.Fleet.Clear
+ *    SensorSim.Fleet.Benchmark <SecondsPerStage> <Count> [<Count> ...]
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimFleetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Vehicle classes to spawn, cycled through. With catalog archetypes, indexed by archetype body instead */
+	UPROPERTY(Config)
+	TArray<TSoftClassPtr<ASensorSimPawn>> VehicleClasses;
+
+	/** If true, vehicles cycle through every vehicle catalog archetype rather than the class defaults. Also set by -FleetCatalog */
+	UPROPERTY(Config)
+	bool bSpawnCatalogArchetypes{ false };
+
+	/** Radius of the innermost orbit, in cm */
+	UPROPERTY(Config)
+	float MinOrbitRadius{ 2000.0f };
+
+	/** Distance between neighbouring orbits, in cm */
+	UPROPERTY(Config)
+	float OrbitSpacing{ 600.0f };
+
+	/** Number of vehicles sharing one orbit */
+	UPROPERTY(Config)
+	int32 VehiclesPerOrbit{ 8 };
+
+	/** Target forward speed of fleet vehicles, in cm/s */
+	UPROPERTY(Config)
+	float CruiseSpeed{ 1500.0f };
+
+	/** Spawned vehicles */
+	UPROPERTY(Transient)
+	TArray<FSensorSimFleetVehicle> Vehicles;
+
+	/** Fleet vehicles when the scenario snapshot was captured, taken back on a scenario reset */
+	UPROPERTY(Transient)
+	TArray<FSensorSimFleetVehicle> SnapshotVehicles;
+
+	/** Center the fleet drives around */
+	FVector FleetCenter{ FVector::ZeroVector };
+
+	/** Pending benchmark stages, in vehicle counts */
+	TArray<int32> BenchmarkCounts;
+
+	/** Benchmark results, one line per stage */
+	TArray<FString> BenchmarkResults;
+
+	/** Simulation seconds measured per benchmark stage */
+	float BenchmarkStageSeconds{ 0.0f };
+
+	/** Simulation seconds elapsed in the current stage, including warm-up */
+	float BenchmarkStageElapsed{ 0.0f };
+
+	/** Wall clock time at which the current stage started measuring */
+	double BenchmarkWallStart{ 0.0 };
+
+	/** True once the current stage is past its warm-up */
+	bool bBenchmarkMeasuring{ false };
+
+public:
+	/** Spawns Count vehicles around Center, in addition to the existing ones */
+	void SpawnFleet(int32 Count, const FVector& Center);
+
+	/** Returns every fleet vehicle to the pool */
+	void ClearFleet();
+
+	/** Returns the number of fleet vehicles */
+	int32 GetNumVehicles() const { return Vehicles.Num(); }
+
+	/** Runs one benchmark stage per vehicle count and logs rays per second for each */
+	void StartBenchmark(const TArray<int32>& Counts, float SecondsPerStage);
+
+	// Begin TickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End TickableWorldSubsystem interface
+
+	// Begin WorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Remembers the fleet in play at a scenario snapshot */
+	void OnSnapshotCaptured();
+
+	/** Takes back the fleet vehicles the scenario reset restored */
+	void OnScenarioReset();
+
+	/** Updates the inputs of every fleet vehicle */
+	void DriveFleet();
+
+	/** Advances the running benchmark, if any */
+	void TickBenchmark(float DeltaTime);
+
+	/** Clears the fleet and spawns the next benchmark stage */
+	void StartBenchmarkStage();
+
+	/** Returns the point the fleet should be centered on */
+	FVector FindFleetCenter() const;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+
+/** Kind of image a camera produces */
+enum class ESensorSimImageType : uint8
+{
+	/** 8 bit BGRA color */
+	Color = 0,
+
+	/** Planar depth along the camera axis, float, in cm. 0 where nothing was hit */
+	Depth = 1,
+
+	/** CustomDepth stencil value of the visible surface, 8 bit. 0 for unlabeled surfaces */
+	Semantic = 2,
+};
+
+/**
+ *  One camera image
+ *  Pixels are row-major and tightly packed, top row first.
+ */
+struct FSensorSimImage
+{
+	/** Kind of image */
+	ESensorSimImageType Type = ESensorSimImageType::Color;
+
+	/** Camera of the vehicle the image was taken by */
+	uint8 Camera = 0;
+
+	/** Size, in pixels */
+	int32 Width = 0;
+	int32 Height = 0;
+
+	/** World time at which the image was captured */
+	double Time = 0.0;
+
+	/** Capture counter of the producing camera */
+	uint32 Sequence = 0;
+
+	/** Camera pose at capture time */
+	FTransform SensorTransform;
+
+	/** Pixel data */
+	TArray<uint8> Pixels;
+
+	/** Returns the bytes per pixel of a kind of image */
+	static int32 GetBytesPerPixel(ESensorSimImageType InType)
+	{
+		return InType == ESensorSimImageType::Semantic ? 1 : 4;
+	}
+
+	/** Sets the kind and size of the image, and allocates its pixels */
+	void Init(ESensorSimImageType InType, int32 InWidth, int32 InHeight)
+	{
+		Type = InType;
+		Width = InWidth;
+		Height = InHeight;
+		Pixels.SetNumUninitialized(Width * Height * GetBytesPerPixel(Type));
+	}
+
+	/** Returns the bytes of one row */
+	int32 GetRowBytes() const { return Width * GetBytesPerPixel(Type); }
+};
+
+/** Read-only, ref-counted view of a published image */
+using FSensorSimImageRef = TSharedRef<const FSensorSimImage, ESPMode::ThreadSafe>;
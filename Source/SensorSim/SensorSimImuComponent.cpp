@@ -0,0 +1,192 @@
+#include "SensorSimImuComponent.h"
+#include "SensorSim.h"
+#include "SensorSimPhysicsSensor.h"
+#include "SensorSimSpscRing.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+/**
+ *  Physics thread side of the IMU
+ *  Differentiates the body velocities between steps and pushes samples, stamped in physics time, into a ring.
+ */
+class FSensorSimImuSimulation : public ISensorSimPhysicsSensor
+{
+public:
+	FSensorSimImuSimulation(uint32 RingCapacity, float InPeriod, float InPhase, const FTransform& InMountTransform, const FVector& InGravity)
+		: Ring{ RingCapacity }
+		, Period{ InPeriod }
+		, Phase{ InPhase }
+		, MountTransform{ InMountTransform }
+		, Gravity{ InGravity }
+	{
+	}
+
+	/** Samples waiting for the game thread, in physics time */
+	TSensorSimSpscRing<FSensorSimImuSample> Ring;
+
+	virtual void OnPhysicsStep(const FSensorSimPhysicsStepContext& Context) override
+	{
+		const FVector Velocity = Context.Body->V();
+		const FVector AngularVelocity = Context.Body->W();
+		const FQuat BodyRotation = Context.Body->R();
+
+		// accelerations need a previous step to differentiate against
+		if (!bHasPreviousStep)
+		{
+			bHasPreviousStep = true;
+			NextSampleTime = Context.Time + Phase * Period;
+		}
+		else if (PreviousDeltaTime > 0.0f)
+		{
+			const FVector Acceleration = (Velocity - PreviousVelocity) / PreviousDeltaTime;
+			const FVector AngularAcceleration = (AngularVelocity - PreviousAngularVelocity) / PreviousDeltaTime;
+
+			// the IMU is off the body origin, so it also sees the tangential and centripetal accelerations
+			const FVector Arm = BodyRotation.RotateVector(MountTransform.GetLocation());
+			const FVector MountAcceleration = Acceleration + (AngularAcceleration ^ Arm) + (AngularVelocity ^ (AngularVelocity ^ Arm));
+
+			const FQuat SensorRotation = BodyRotation * MountTransform.GetRotation();
+
+			FSensorSimImuSample Sample;
+			Sample.LinearAcceleration = FVector3f(SensorRotation.UnrotateVector(MountAcceleration - Gravity) * 0.01);
+			Sample.AngularVelocity = FVector3f(SensorRotation.UnrotateVector(AngularVelocity));
+			Sample.Orientation = FQuat4f(SensorRotation);
+
+			// every sample due during the step reads the step's state
+			while (NextSampleTime <= Context.Time)
+			{
+				Sample.Time = NextSampleTime;
+				Ring.Push(Sample);
+
+				NextSampleTime += Period;
+			}
+		}
+
+		PreviousVelocity = Velocity;
+		PreviousAngularVelocity = AngularVelocity;
+		PreviousDeltaTime = Context.DeltaTime;
+	}
+
+	virtual void OnReset() override
+	{
+		// differentiating across a teleport would report a spike, so start over from the next step
+		bHasPreviousStep = false;
+		PreviousDeltaTime = 0.0f;
+	}
+
+private:
+	/** Seconds between samples */
+	const double Period;
+
+	/** Fraction of a period the schedule is offset by */
+	const float Phase;
+
+	/** IMU transform relative to the body */
+	const FTransform MountTransform;
+
+	/** World gravity, in cm/s^2 */
+	const FVector Gravity;
+
+	/** Physics time at which the next sample is due */
+	double NextSampleTime = 0.0;
+
+	FVector PreviousVelocity = FVector::ZeroVector;
+	FVector PreviousAngularVelocity = FVector::ZeroVector;
+	float PreviousDeltaTime = 0.0f;
+	bool bHasPreviousStep = false;
+};
+
+USensorSimImuComponent::USensorSimImuComponent()
+{
+	SampleRate = 200.0f;
+}
+
+void USensorSimImuComponent::SetMount(USceneComponent* InMount)
+{
+	Mount = InMount;
+}
+
+int32 USensorSimImuComponent::RunSchedule(double WorldTime)
+{
+	// sampled on the physics thread
+	return 0;
+}
+
+bool USensorSimImuComponent::CollectSamples()
+{
+	if (!Simulation)
+	{
+		return false;
+	}
+
+	// anchor the physics clock to the world clock, so that the samples line up with the LiDAR sweeps
+	PhysicsSource->UpdatePoseHistory(GetWorld()->GetTimeSeconds());
+
+	CollectedSamples.Reset();
+	if (Simulation->Ring.PopAll(CollectedSamples) == 0)
+	{
+		return false;
+	}
+
+	for (FSensorSimImuSample& Sample : CollectedSamples)
+	{
+		Sample.Time = PhysicsSource->PhysicsToWorldTime(Sample.Time);
+	}
+
+	LatestSample = CollectedSamples.Last();
+
+	Counters.Samples += CollectedSamples.Num();
+	Counters.Bytes += CollectedSamples.NumBytes();
+	INC_DWORD_STAT_BY(STAT_SensorSimBytes, CollectedSamples.NumBytes());
+	SkippedSamples = Simulation->Ring.GetNumOverflows();
+
+	OnSamples.Broadcast(CollectedSamples);
+
+	return true;
+}
+
+void USensorSimImuComponent::ResetSensor()
+{
+	// samples already queued were taken before the reset. The simulation drops its own state on the next step
+	if (Simulation)
+	{
+		CollectedSamples.Reset();
+		Simulation->Ring.PopAll(CollectedSamples);
+		CollectedSamples.Reset();
+	}
+
+	LatestSample = FSensorSimImuSample();
+
+	Super::ResetSensor();
+}
+
+void USensorSimImuComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PhysicsSource = GetOwner()->FindComponentByClass<USensorSimVehicleMovementComponent>();
+	if (!PhysicsSource)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("IMU '%s' has no SensorSim vehicle movement to sample"), *GetPathName());
+		return;
+	}
+
+	const FTransform MountTransform = Mount ? Mount->GetComponentTransform().GetRelativeTransform(GetOwner()->GetActorTransform()) : FTransform::Identity;
+
+	Simulation = MakeShared<FSensorSimImuSimulation, ESPMode::ThreadSafe>(RingCapacity, 1.0f / GetSampleRate(), SchedulePhase, MountTransform, FVector(0.0, 0.0, GetWorld()->GetGravityZ()));
+	PhysicsSource->AddPhysicsSensor(Simulation.ToSharedRef());
+}
+
+void USensorSimImuComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (PhysicsSource && Simulation)
+	{
+		PhysicsSource->RemovePhysicsSensor(Simulation.ToSharedRef());
+	}
+
+	Simulation.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
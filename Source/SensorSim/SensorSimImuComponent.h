@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimSensorComponent.h"
+#include "SensorSimRecording.h"
+#include "SensorSimImuComponent.generated.h"
+
+// Forward declarations
+class USensorSimVehicleMovementComponent;
+class FSensorSimImuSimulation;
+
+/** Broadcast on the game thread with the IMU samples collected since the last broadcast, oldest first */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSensorSimImuSamples, TConstArrayView<FSensorSimImuSample> /*Samples*/);
+
+/**
+ *  IMU Component
+ *  Accelerometer and gyroscope sampled from the vehicle body on the physics thread, at SampleRate.
+ *  Samples are stamped in world time, on the same clock as the LiDAR sweeps.
+ *  The rate is bounded by the physics substep rate; faster sample rates repeat the last step.
+ */
+UCLASS(ClassGroup = (SensorSim), meta = (BlueprintSpawnableComponent))
+class SENSORSIM_API USensorSimImuComponent : public USensorSimSensorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimImuComponent();
+
+protected:
+	/** Component the IMU is mounted on. Falls back to the owner's root component */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = IMU)
+	TObjectPtr<USceneComponent> Mount{ nullptr };
+
+	/** Number of samples buffered between the physics and game threads */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = IMU, meta = (ClampMin = "16"))
+	int32 RingCapacity{ 1024 };
+
+	/** Movement component sampling the IMU */
+	UPROPERTY(Transient)
+	TObjectPtr<USensorSimVehicleMovementComponent> PhysicsSource{ nullptr };
+
+	/** Physics thread side of the IMU */
+	TSharedPtr<FSensorSimImuSimulation, ESPMode::ThreadSafe> Simulation;
+
+	/** Samples collected on the last update */
+	TArray<FSensorSimImuSample> CollectedSamples;
+
+	/** Last collected sample */
+	FSensorSimImuSample LatestSample;
+
+public:
+	/** Broadcast on the game thread with every batch of collected samples */
+	FOnSensorSimImuSamples OnSamples;
+
+	/** Sets the component the IMU is mounted on. Takes effect on BeginPlay */
+	void SetMount(USceneComponent* InMount);
+
+	/** Returns the last collected sample */
+	const FSensorSimImuSample& GetLatestSample() const { return LatestSample; }
+
+	// Begin SensorSimSensorComponent interface
+	virtual int32 RunSchedule(double WorldTime) override;
+	virtual bool CollectSamples() override;
+	virtual void ResetSensor() override;
+protected:
+	virtual bool TakeSample(double SampleTime) override { return false; }
+	// End SensorSimSensorComponent interface
+
+	// Begin ActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End ActorComponent interface
+};
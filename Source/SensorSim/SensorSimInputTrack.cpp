@@ -0,0 +1,100 @@
+#include "SensorSimInputTrack.h"
+#include "SensorSim.h"
+#include "Algo/IsSorted.h"
+#include "Algo/UpperBound.h"
+#include "Misc/FileHelper.h"
+
+FSensorSimVehicleInput USensorSimInputTrack::Evaluate(float Time) const
+{
+	if (Keys.IsEmpty())
+	{
+		return FSensorSimVehicleInput();
+	}
+
+	// wrap the time around when looping
+	const float Duration = GetDuration();
+	if (bLoop && Duration > 0.0f)
+	{
+		Time = FMath::Fmod(Time, Duration);
+	}
+
+	// find the first key after the requested time
+	const int32 NextIndex = Algo::UpperBoundBy(Keys, Time, &FSensorSimInputKey::Time);
+
+	if (NextIndex == 0)
+	{
+		return Keys[0].Input;
+	}
+
+	const FSensorSimInputKey& Key = Keys[NextIndex - 1];
+	if (!bInterpolate || NextIndex == Keys.Num())
+	{
+		return Key.Input;
+	}
+
+	// blend the analog axes towards the next key. The handbrake is held
+	const FSensorSimInputKey& NextKey = Keys[NextIndex];
+	const float Alpha = FMath::GetRangePct(Key.Time, NextKey.Time, Time);
+
+	FSensorSimVehicleInput Input = Key.Input;
+	Input.Steering = FMath::Lerp(Key.Input.Steering, NextKey.Input.Steering, Alpha);
+	Input.Throttle = FMath::Lerp(Key.Input.Throttle, NextKey.Input.Throttle, Alpha);
+	Input.Brake = FMath::Lerp(Key.Input.Brake, NextKey.Input.Brake, Alpha);
+
+	return Input;
+}
+
+float USensorSimInputTrack::GetDuration() const
+{
+	return Keys.IsEmpty() ? 0.0f : Keys.Last().Time;
+}
+
+bool USensorSimInputTrack::LoadFromCSV(const FString& Filename)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to read input track '%s'"), *Filename);
+		return false;
+	}
+
+	TArray<FSensorSimInputKey> NewKeys;
+	NewKeys.Reserve(Lines.Num());
+
+	TArray<FString> Columns;
+	for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+	{
+		const FString Line = Lines[LineIndex].TrimStartAndEnd();
+
+		// skip blanks, comments and the header
+		if (Line.IsEmpty() || Line.StartsWith(TEXT("#")) || !FChar::IsDigit(Line[0]))
+		{
+			continue;
+		}
+
+		Line.ParseIntoArray(Columns, TEXT(","), false);
+		if (Columns.Num() < 5)
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected 5 columns, got %d"), *Filename, LineIndex + 1, Columns.Num());
+			return false;
+		}
+
+		FSensorSimInputKey& Key = NewKeys.AddDefaulted_GetRef();
+		Key.Time = FCString::Atof(*Columns[0]);
+		Key.Input.Steering = FMath::Clamp(FCString::Atof(*Columns[1]), -1.0f, 1.0f);
+		Key.Input.Throttle = FMath::Clamp(FCString::Atof(*Columns[2]), 0.0f, 1.0f);
+		Key.Input.Brake = FMath::Clamp(FCString::Atof(*Columns[3]), 0.0f, 1.0f);
+		Key.Input.bHandbrake = FCString::Atoi(*Columns[4]) != 0;
+	}
+
+	if (!Algo::IsSortedBy(NewKeys, &FSensorSimInputKey::Time))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Input track '%s' is not sorted by time"), *Filename);
+		return false;
+	}
+
+	Keys = MoveTemp(NewKeys);
+
+	UE_LOG(LogSensorSim, Log, TEXT("Loaded input track '%s': %d keys, %.1fs"), *Filename, Keys.Num(), GetDuration());
+	return true;
+}
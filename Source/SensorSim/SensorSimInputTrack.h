@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SensorSimInputTrack.generated.h"
+
+/**
+ *  One set of driver inputs, as fed to the Chaos vehicle movement component
+ */
+USTRUCT(BlueprintType)
+struct SENSORSIM_API FSensorSimVehicleInput
+{
+	GENERATED_BODY()
+
+	/** Steering input, -1 (full left) to 1 (full right) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input, meta = (ClampMin = "-1.0", ClampMax = "1.0"))
+	float Steering = 0.0f;
+
+	/** Throttle input, 0 to 1 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Throttle = 0.0f;
+
+	/** Brake input, 0 to 1 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Brake = 0.0f;
+
+	/** Handbrake engaged */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input)
+	bool bHandbrake = false;
+};
+
+/**
+ *  Input track key
+ *  The input takes effect at Time and blends towards the next key.
+ */
+USTRUCT(BlueprintType)
+struct SENSORSIM_API FSensorSimInputKey
+{
+	GENERATED_BODY()
+
+	/** Simulation time in seconds, relative to the start of the track */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input, meta = (ClampMin = "0.0"))
+	float Time = 0.0f;
+
+	/** Driver inputs at this key */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Input)
+	FSensorSimVehicleInput Input;
+};
+
+/**
+ *  Scripted Input Track
+ *  A time-keyed list of driver inputs used to drive a vehicle without a human,
+ *  e.g. on render-less batch runs. Can be authored as an asset or loaded from CSV.
+ */
+UCLASS(BlueprintType)
+class SENSORSIM_API USensorSimInputTrack : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Keys, sorted by time */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Track)
+	TArray<FSensorSimInputKey> Keys;
+
+	/** If true, analog inputs are linearly blended between keys. Otherwise each key is held until the next one */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Track)
+	bool bInterpolate = true;
+
+	/** If true, the track restarts from the first key once it runs out */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Track)
+	bool bLoop = false;
+
+	/** Returns the driver inputs at the given track time */
+	FSensorSimVehicleInput Evaluate(float Time) const;
+
+	/** Returns the time of the last key */
+	float GetDuration() const;
+
+	/**
+	 *  Replaces the keys with the contents of a CSV file.
+	 *  Expected columns: Time,Steering,Throttle,Brake,Handbrake. Lines starting with '#' are skipped.
+	 */
+	bool LoadFromCSV(const FString& Filename);
+};
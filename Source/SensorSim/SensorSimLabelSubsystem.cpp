@@ -0,0 +1,244 @@
+#include "SensorSimLabelSubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimPawn.h"
+#include "SensorSimRayProxyComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+namespace SensorSimLabels
+{
+	/** Returns true if a class is, or derives from, a class of the given name. Avoids depending on the modules defining it */
+	bool IsChildOfClassNamed(const UClass* Class, FName ClassName)
+	{
+		for (; Class; Class = Class->GetSuperClass())
+		{
+			if (Class->GetFName() == ClassName)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/** Returns a page of the labels, padded with empty ones */
+	FSensorSimLabelTable::FPage MakePage(const TArray<FSensorSimLabel>& Labels, int32 PageIndex)
+	{
+		const int32 First = PageIndex * FSensorSimLabelTable::PageSize;
+		const int32 Count = FMath::Min(Labels.Num() - First, FSensorSimLabelTable::PageSize);
+
+		TArray<FSensorSimLabel> Page;
+		Page.Reserve(FSensorSimLabelTable::PageSize);
+		Page.Append(Labels.GetData() + First, Count);
+		Page.AddDefaulted(FSensorSimLabelTable::PageSize - Count);
+
+		return MakeShared<const TArray<FSensorSimLabel>, ESPMode::ThreadSafe>(MoveTemp(Page));
+	}
+}
+
+FSensorSimLabel USensorSimLabelSubsystem::LabelComponent(const UPrimitiveComponent* Component)
+{
+	AActor* Owner = Component ? Component->GetOwner() : nullptr;
+	if (!Owner)
+	{
+		return FSensorSimLabel();
+	}
+
+	const int32 Index = Component->GetUniqueID();
+	if (Labels.IsValidIndex(Index) && Labels[Index].Instance != 0)
+	{
+		return Labels[Index];
+	}
+
+	uint32* Instance = Instances.Find(Owner);
+	if (!Instance)
+	{
+		Instance = &Instances.Add(Owner, ++LastInstance);
+		Owner->OnEndPlay.AddUniqueDynamic(this, &USensorSimLabelSubsystem::OnActorEndPlay);
+	}
+
+	FSensorSimLabel Label;
+	Label.Instance = *Instance;
+	Label.Class = static_cast<uint8>(ClassifyComponent(Component));
+
+	SetLabel(Index, Label);
+	return Label;
+}
+
+void USensorSimLabelSubsystem::LabelActor(AActor* Actor)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	// only components with collision can be hit, and only they are cleared when unregistered
+	Actor->ForEachComponent<UPrimitiveComponent>(false, [this](UPrimitiveComponent* Component)
+	{
+		if (Component->IsPhysicsStateCreated())
+		{
+			LabelComponent(Component);
+		}
+	});
+}
+
+FSensorSimLabel USensorSimLabelSubsystem::GetLabel(const UPrimitiveComponent* Component) const
+{
+	const int32 Index = Component ? Component->GetUniqueID() : INDEX_NONE;
+	return Labels.IsValidIndex(Index) ? Labels[Index] : FSensorSimLabel();
+}
+
+TSharedPtr<const FSensorSimLabelTable, ESPMode::ThreadSafe> USensorSimLabelSubsystem::GetLabelTable() const
+{
+	// sweeps in flight keep the snapshot they were dispatched with
+	if (!Table)
+	{
+		SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimLabelTable);
+
+		// copy the pages that changed or are new, and share the others with the previous table
+		const int32 NumPages = FMath::DivideAndRoundUp(Labels.Num(), FSensorSimLabelTable::PageSize);
+		for (int32 PageIndex = 0; PageIndex < NumPages; ++PageIndex)
+		{
+			if (PageIndex >= Pages.Num())
+			{
+				Pages.Add(SensorSimLabels::MakePage(Labels, PageIndex));
+			}
+			else if (DirtyPages.IsValidIndex(PageIndex) && DirtyPages[PageIndex])
+			{
+				Pages[PageIndex] = SensorSimLabels::MakePage(Labels, PageIndex);
+			}
+		}
+
+		DirtyPages.Reset();
+
+		TArray<FSensorSimLabelTable::FPage> Snapshot = Pages;
+		Table = MakeShared<const FSensorSimLabelTable, ESPMode::ThreadSafe>(MoveTemp(Snapshot));
+	}
+
+	return Table;
+}
+
+void USensorSimLabelSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		LabelActor(*It);
+	}
+
+	// spawned and streamed actors, and components added to any actor, are labeled as their collision is created
+	CreatePhysicsHandle = UActorComponent::GlobalCreatePhysicsDelegate.AddUObject(this, &USensorSimLabelSubsystem::OnCreatePhysicsState);
+	DestroyPhysicsHandle = UActorComponent::GlobalDestroyPhysicsDelegate.AddUObject(this, &USensorSimLabelSubsystem::OnDestroyPhysicsState);
+
+	UE_LOG(LogSensorSim, Log, TEXT("Labeled %d actors in %.1f ms, %.1f MB label table"),
+		Instances.Num(), (FPlatformTime::Seconds() - StartSeconds) * 1000.0, Labels.GetAllocatedSize() / (1024.0 * 1024.0));
+}
+
+void USensorSimLabelSubsystem::Deinitialize()
+{
+	UActorComponent::GlobalCreatePhysicsDelegate.Remove(CreatePhysicsHandle);
+	UActorComponent::GlobalDestroyPhysicsDelegate.Remove(DestroyPhysicsHandle);
+
+	CreatePhysicsHandle.Reset();
+	DestroyPhysicsHandle.Reset();
+	Labels.Empty();
+	Pages.Empty();
+	DirtyPages.Empty();
+	Instances.Empty();
+	Table.Reset();
+
+	Super::Deinitialize();
+}
+
+bool USensorSimLabelSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+ESensorSimSemanticClass USensorSimLabelSubsystem::ClassifyComponent(const UPrimitiveComponent* Component) const
+{
+	if (const USensorSimRayProxyComponent* Proxy = Cast<USensorSimRayProxyComponent>(Component))
+	{
+		return Proxy->GetSemanticClass();
+	}
+
+	const AActor* Owner = Component->GetOwner();
+	if (Owner->IsA<ASensorSimPawn>())
+	{
+		return ESensorSimSemanticClass::Vehicle;
+	}
+
+	if (SensorSimLabels::IsChildOfClassNamed(Owner->GetClass(), TEXT("InstancedFoliageActor")))
+	{
+		return ESensorSimSemanticClass::Foliage;
+	}
+
+	if (SensorSimLabels::IsChildOfClassNamed(Owner->GetClass(), TEXT("LandscapeProxy")))
+	{
+		return ESensorSimSemanticClass::Terrain;
+	}
+
+	const UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component);
+	const UStaticMesh* Mesh = MeshComponent ? MeshComponent->GetStaticMesh() : nullptr;
+	const FString MeshPath = Mesh ? Mesh->GetPathName() : FString();
+	const FString ClassPath = Owner->GetClass()->GetPathName();
+
+	for (const FSensorSimLabelRule& Rule : MeshRules)
+	{
+		if (!Rule.Prefix.IsEmpty() && (MeshPath.StartsWith(Rule.Prefix) || ClassPath.StartsWith(Rule.Prefix)))
+		{
+			return Rule.Class;
+		}
+	}
+
+	return ESensorSimSemanticClass::None;
+}
+
+void USensorSimLabelSubsystem::SetLabel(int32 Index, const FSensorSimLabel& Label)
+{
+	if (Index >= Labels.Num())
+	{
+		Labels.AddDefaulted(Index + 1 - Labels.Num());
+	}
+
+	Labels[Index] = Label;
+
+	const int32 PageIndex = Index >> FSensorSimLabelTable::PageBits;
+	if (PageIndex >= DirtyPages.Num())
+	{
+		DirtyPages.Add(false, PageIndex + 1 - DirtyPages.Num());
+	}
+
+	DirtyPages[PageIndex] = true;
+	Table.Reset();
+}
+
+void USensorSimLabelSubsystem::OnCreatePhysicsState(UActorComponent* Component)
+{
+	if (Component->GetWorld() == GetWorld())
+	{
+		LabelComponent(Cast<UPrimitiveComponent>(Component));
+	}
+}
+
+void USensorSimLabelSubsystem::OnDestroyPhysicsState(UActorComponent* Component)
+{
+	const int32 Index = Component->GetUniqueID();
+	if (Component->GetWorld() == GetWorld() && Labels.IsValidIndex(Index) && Labels[Index].Instance != 0)
+	{
+		SetLabel(Index, FSensorSimLabel());
+	}
+}
+
+void USensorSimLabelSubsystem::OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	// instances are never reused, so that a label always refers to the same actor within a run.
+	// Its components are cleared as they are unregistered
+	Instances.Remove(Actor);
+}
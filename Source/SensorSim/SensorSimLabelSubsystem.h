@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SensorSimLabels.h"
+#include "SensorSimLabelSubsystem.generated.h"
+
+// Forward declarations
+class UActorComponent;
+class UPrimitiveComponent;
+
+/** Semantic class of the static meshes or actors under an asset path */
+USTRUCT()
+struct FSensorSimLabelRule
+{
+	GENERATED_BODY()
+
+	/** Path prefix of the static mesh asset or actor class, such as /Game/Track/ */
+	UPROPERTY(Config)
+	FString Prefix;
+
+	/** Class of the components matched */
+	UPROPERTY(Config)
+	ESensorSimSemanticClass Class{ ESensorSimSemanticClass::None };
+};
+
+/**
+ *  Label Subsystem
+ *  Assigns every primitive component of the level a semantic class and an instance at level load, then every
+ *  component that gets collision afterwards: spawned and streamed actors, and components added at runtime.
+ *  A component losing its collision, when it is unregistered, loses its label before its object index can be reused.
+ *  Every component of an actor shares its instance; instances are numbered from 1 in the order actors are labeled,
+ *  so they are stable across runs of the same level and scenario.
+ *
+ *  Vehicles, foliage and landscapes are recognized by their class; other components by the first MeshRules entry
+ *  matching their static mesh or their actor's class. All string matching happens here, when a component is labeled:
+ *  sensors look labels up per hit in a paged table indexed by object, shared with their worker threads. Only the
+ *  pages whose labels changed are copied when the table is next requested.
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimLabelSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Classes of the components matched by asset path, first match wins */
+	UPROPERTY(Config)
+	TArray<FSensorSimLabelRule> MeshRules;
+
+	/** Label of every object index, empty for objects that are not labeled components */
+	TArray<FSensorSimLabel> Labels;
+
+	/** Pages of Labels as last shared with the sensors, and the pages changed since */
+	mutable TArray<FSensorSimLabelTable::FPage> Pages;
+	mutable TBitArray<> DirtyPages;
+
+	/** Instance of every labeled actor */
+	TMap<TObjectKey<AActor>, uint32> Instances;
+
+	/** Last instance assigned */
+	uint32 LastInstance{ 0 };
+
+	/** Snapshot of the labels shared with the sensors. Rebuilt on the next request once labels changed */
+	mutable TSharedPtr<const FSensorSimLabelTable, ESPMode::ThreadSafe> Table;
+
+	/** Bindings to every component's physics state */
+	FDelegateHandle CreatePhysicsHandle;
+	FDelegateHandle DestroyPhysicsHandle;
+
+public:
+	/** Labels a component if it is not already, and returns its label */
+	FSensorSimLabel LabelComponent(const UPrimitiveComponent* Component);
+
+	/** Labels every primitive component of an actor */
+	void LabelActor(AActor* Actor);
+
+	/** Returns the label of a component, or an empty one. Game thread */
+	FSensorSimLabel GetLabel(const UPrimitiveComponent* Component) const;
+
+	/** Returns the labels of every component, as an immutable table any thread may read */
+	TSharedPtr<const FSensorSimLabelTable, ESPMode::ThreadSafe> GetLabelTable() const;
+
+	/** Returns the number of labeled actors */
+	int32 GetNumInstances() const { return Instances.Num(); }
+
+	// Begin WorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Returns the class of a component, from its actor's class or the mesh rules */
+	ESensorSimSemanticClass ClassifyComponent(const UPrimitiveComponent* Component) const;
+
+	/** Sets the label of an object index, marking its page for the next table */
+	void SetLabel(int32 Index, const FSensorSimLabel& Label);
+
+	/** Labels a component of this world as it gets collision */
+	void OnCreatePhysicsState(UActorComponent* Component);
+
+	/** Clears the label of a component of this world as it loses collision, before its object index gets reused */
+	void OnDestroyPhysicsState(UActorComponent* Component);
+
+	/** Forgets the instance of an actor leaving play */
+	UFUNCTION()
+	void OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+};
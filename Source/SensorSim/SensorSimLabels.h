@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+#include "UObject/Object.h"
+#include "SensorSimLabels.generated.h"
+
+/** Semantic class of the surfaces sensors hit */
+UENUM(BlueprintType)
+enum class ESensorSimSemanticClass : uint8
+{
+	/** Not labeled */
+	None = 0,
+
+	/** Track pieces */
+	Track = 1,
+
+	/** Vehicles */
+	Vehicle = 2,
+
+	/** Props placed along the track */
+	Prop = 3,
+
+	/** Foliage */
+	Foliage = 4,
+
+	/** Landscape */
+	Terrain = 5,
+
+	/** Walls, floors and other level architecture */
+	Structure = 6,
+};
+
+/** Ground truth label of a component */
+struct FSensorSimLabel
+{
+	/** Actor the component belongs to, unique in the world. 0 for unlabeled components */
+	uint32 Instance = 0;
+
+	/** ESensorSimSemanticClass */
+	uint8 Class = 0;
+};
+
+/**
+ *  Label Table
+ *  Table of the component labels, indexed by the components' object index in fixed size pages, so that a hit is labeled
+ *  with one bounds check and two loads. Immutable once built, so any number of worker threads may read it at once.
+ *  Pages are shared between tables, so a new table only copies the pages whose labels changed.
+ */
+class FSensorSimLabelTable
+{
+public:
+	/** Labels per page */
+	static constexpr int32 PageBits = 12;
+	static constexpr int32 PageSize = 1 << PageBits;
+
+	/** PageSize labels, never modified once shared */
+	using FPage = TSharedRef<const TArray<FSensorSimLabel>, ESPMode::ThreadSafe>;
+
+	explicit FSensorSimLabelTable(TArray<FPage>&& InPages)
+		: Pages(MoveTemp(InPages))
+	{
+	}
+
+	/** Returns the label of a component, or an empty one if it was never labeled */
+	FORCEINLINE FSensorSimLabel Find(const UObject* Component) const
+	{
+		const uint32 Index = Component ? Component->GetUniqueID() : MAX_uint32;
+		const uint32 Page = Index >> PageBits;
+		return Page < uint32(Pages.Num()) ? (*Pages[Page])[Index & (PageSize - 1)] : FSensorSimLabel();
+	}
+
+	/** Returns the number of entries, a page past the highest labeled object index */
+	int32 Num() const { return Pages.Num() * PageSize; }
+
+private:
+	/** Pages of the labels of every object index, empty for objects that are not labeled components */
+	TArray<FPage> Pages;
+};
@@ -0,0 +1,435 @@
+#include "SensorSimLidarComponent.h"
+#include "SensorSim.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "SensorSimRayProxySubsystem.h"
+#include "SensorSimSensorSubsystem.h"
+#include "SensorSimLabelSubsystem.h"
+#include "SensorSimStaticScene.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+namespace SensorSimLidar
+{
+	/** Golden ratio conjugate. Offsets the columns of thinned channels so that they do not all fire together */
+	constexpr double ChannelPhaseStep = 0.6180339887498949;
+
+	/** Fixed point unit of the channel densities */
+	constexpr uint32 DensityOne = 1u << 16;
+
+	/** Returns true if a thinned channel fires in a column */
+	FORCEINLINE bool IsColumnCast(uint32 Column, uint32 Density, uint32 Phase)
+	{
+		return ((Column + 1) * Density + Phase) >> 16 != (Column * Density + Phase) >> 16;
+	}
+}
+
+void USensorSimLidarComponent::SetMount(USceneComponent* InMount)
+{
+	Mount = InMount;
+}
+
+void USensorSimLidarComponent::SetPattern(const FSensorSimLidarPattern& InPattern)
+{
+	Pattern = InPattern;
+
+	if (HasBegunPlay())
+	{
+		// the sweep in flight reads the ray directions
+		SweepTask.Wait();
+
+		BuildRayDirections();
+	}
+}
+
+bool USensorSimLidarComponent::TakeSample(double SampleTime)
+{
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimSweepDispatch);
+
+	// never wait on a sweep that is still tracing
+	if (IsSweepInFlight())
+	{
+		return false;
+	}
+
+	// consumers are holding on to every frame, skip this revolution
+	PendingFrame = FramePool->Acquire();
+	if (!PendingFrame)
+	{
+		return false;
+	}
+
+	const USceneComponent* Origin = Mount ? Mount.Get() : GetOwner()->GetRootComponent();
+	SweepTransform = Origin->GetComponentTransform();
+	SweepTransform.SetScale3D(FVector::OneVector);
+	SweepStartTime = SampleTime;
+	SweepPoses.Reset();
+
+	// cast from the poses the vehicle went through, rather than its pose on this frame.
+	// With a rolling shutter, the sweep covers the revolution that ends at the sample time
+	if (PoseSource)
+	{
+		if (bRollingShutter)
+		{
+			SweepStartTime = SampleTime - 1.0 / Pattern.RotationRate;
+		}
+
+		PoseSource->UpdatePoseHistory(GetWorld()->GetTimeSeconds());
+		PoseSource->GetPoseHistory(SweepStartTime, SampleTime, SweepPoses);
+
+		if (!SweepPoses.IsEmpty())
+		{
+			MountTransform = SweepTransform.GetRelativeTransform(GetOwner()->GetActorTransform());
+			SweepTransform = GetColumnTransform(0, 0.0f);
+		}
+
+		if (!bRollingShutter)
+		{
+			SweepPoses.Reset();
+		}
+	}
+
+	// never hit the vehicle carrying the sensor. Ignored actors are rejected in the broadphase, before any narrowphase test
+	QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(SensorSimLidarSweep), false, GetOwner());
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	// static geometry gathered into the static scene is traced there; physics only has to hold what moves
+	const USensorSimRayProxySubsystem* RayProxies = TraceChannel == ECC_SensorRay ? GetWorld()->GetSubsystem<USensorSimRayProxySubsystem>() : nullptr;
+	StaticScene = RayProxies ? RayProxies->GetStaticScene() : nullptr;
+	QueryParams.MobilityType = RayProxies && RayProxies->IsStaticSceneComplete() ? EQueryMobilityType::Dynamic : EQueryMobilityType::Any;
+
+	// physics hits are labeled through a snapshot of the table, so that spawns during the sweep do not race it
+	const USensorSimLabelSubsystem* LabelSubsystem = GetWorld()->GetSubsystem<USensorSimLabelSubsystem>();
+	LabelTable = LabelSubsystem ? LabelSubsystem->GetLabelTable() : nullptr;
+
+	SweepRays = BuildChannelDensity();
+
+	PendingFrame->SweepTime = SweepStartTime;
+	PendingFrame->Sequence = SweepSequence++;
+	PendingFrame->SensorTransform = SweepTransform;
+
+	SweepTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() { ExecuteSweep(); });
+	return true;
+}
+
+bool USensorSimLidarComponent::CollectSamples()
+{
+	if (!SweepTask.IsValid() || !SweepTask.IsCompleted())
+	{
+		return false;
+	}
+
+	SweepTask = UE::Tasks::FTask();
+
+	// hand the frame over as read-only from here on
+	FSensorSimPointCloudRef Frame = PendingFrame.ToSharedRef();
+	PendingFrame.Reset();
+	LatestFrame = Frame;
+
+	LastSweepRays = SweepRays;
+
+	Counters.Samples++;
+	Counters.Rays += LastSweepRays;
+	Counters.Hits += Frame->Num();
+	Counters.Bytes += Frame->GetPointBytes();
+
+	INC_DWORD_STAT_BY(STAT_SensorSimRays, LastSweepRays);
+	INC_DWORD_STAT_BY(STAT_SensorSimHits, Frame->Num());
+	INC_DWORD_STAT_BY(STAT_SensorSimBytes, Frame->GetPointBytes());
+
+	OnSweep.Broadcast(Frame);
+
+	return true;
+}
+
+void USensorSimLidarComponent::ExecuteSweep()
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const UWorld* World = GetWorld();
+
+	const double MinRange = Pattern.MinRange;
+	const double MaxRange = Pattern.MaxRange;
+	const int32 Channels = Pattern.Channels;
+	const float ColumnPeriod = 1.0f / (Pattern.RotationRate * Pattern.Columns);
+
+	RayRanges.SetNumUninitialized(RayDirections.Num());
+	RayCosines.SetNumUninitialized(RayDirections.Num());
+	RayReflectivity.SetNumUninitialized(RayDirections.Num());
+	RayLabels.SetNumUninitialized(RayDirections.Num());
+
+	// with a reduced ray budget, thinned channels only fire in some of the columns
+	const bool bThinned = !SweepChannelDensity.IsEmpty();
+
+	// trace the columns in blocks, each block writing its own slice of the ranges
+	constexpr int32 ColumnsPerBlock = 32;
+	const int32 NumBlocks = FMath::DivideAndRoundUp(Pattern.Columns, ColumnsPerBlock);
+
+	ParallelFor(NumBlocks, [&](int32 Block)
+	{
+		SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimRayQuery);
+
+		const int32 FirstColumn = Block * ColumnsPerBlock;
+		const int32 EndColumn = FMath::Min(FirstColumn + ColumnsPerBlock, Pattern.Columns);
+
+		FHitResult Hit;
+		for (int32 Column = FirstColumn; Column < EndColumn; ++Column)
+		{
+			// the pose is interpolated once per column and shared by all of its channels
+			const FTransform ColumnTransform = SweepPoses.IsEmpty() ? SweepTransform : GetColumnTransform(Column, ColumnPeriod);
+			const FVector Origin = ColumnTransform.GetLocation();
+
+			const int32 FirstRay = Column * Channels;
+			for (int32 RayIndex = FirstRay; RayIndex < FirstRay + Channels; ++RayIndex)
+			{
+				const int32 Channel = RayIndex - FirstRay;
+				if (bThinned && !SensorSimLidar::IsColumnCast(Column, SweepChannelDensity[Channel], SweepChannelPhase[Channel]))
+				{
+					RayRanges[RayIndex] = 0.0f;
+					continue;
+				}
+
+				const FVector Direction = ColumnTransform.TransformVectorNoScale(FVector(RayDirections[RayIndex]));
+
+				double Range = MaxRange;
+				bool bHit = false;
+
+				float StaticRange;
+				int32 StaticTriangle;
+				if (StaticScene && StaticScene->Raycast(Origin, FVector3f(Direction), MinRange, MaxRange, StaticRange, StaticTriangle))
+				{
+					Range = StaticRange;
+					bHit = true;
+
+					const FSensorSimStaticSource& Source = StaticScene->GetTriangleSource(StaticTriangle);
+					RayCosines[RayIndex] = FMath::Abs(StaticScene->GetTriangleNormal(StaticTriangle) | FVector3f(Direction));
+					RayReflectivity[RayIndex] = Source.Reflectivity;
+					RayLabels[RayIndex] = Source.Label;
+				}
+
+				// a dynamic actor can only be seen in front of the static hit
+				if (Range > MinRange && World->LineTraceSingleByChannel(Hit, Origin + Direction * MinRange, Origin + Direction * Range, TraceChannel, QueryParams))
+				{
+					Range = MinRange + Hit.Distance;
+					bHit = true;
+
+					RayCosines[RayIndex] = static_cast<float>(FMath::Abs(Hit.ImpactNormal | Direction));
+					RayReflectivity[RayIndex] = SensorSubsystem ? SensorSubsystem->GetReflectivity(Hit.PhysMaterial.Get()) : FSensorSimStaticSource().Reflectivity;
+					RayLabels[RayIndex] = LabelTable ? LabelTable->Find(Hit.GetComponent()) : FSensorSimLabel();
+				}
+
+				RayRanges[RayIndex] = bHit ? static_cast<float>(Range) : 0.0f;
+			}
+		}
+	});
+
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimPointPacking);
+
+	FSensorSimPointCloudFrame& Frame = *PendingFrame;
+
+	// gather the hits, each with the hit of the next column of its channel, and run them through the return model
+	const int32 NumRays = RayRanges.Num();
+	Hits.Num = 0;
+	for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+	{
+		if (RayRanges[RayIndex] <= 0.0f)
+		{
+			continue;
+		}
+
+		const int32 NextRay = RayIndex + Channels;
+		const bool bNextHit = NextRay < NumRays && RayRanges[NextRay] > 0.0f;
+		Hits.Add(RayIndex, RayRanges[RayIndex], RayCosines[RayIndex], RayReflectivity[RayIndex],
+			bNextHit ? RayRanges[NextRay] : 0.0f, bNextHit ? RayCosines[NextRay] : 0.0f, bNextHit ? RayReflectivity[NextRay] : 0.0f);
+	}
+
+	SensorSimLidarReturns::ApplyReturnModel(ReturnModel, SensorSimLidarReturns::GetSweepKey(ReturnModel.Seed, SensorKey, Frame.Sequence), Pattern.MinRange, Hits);
+
+	// compact the returns into the frame, a second return right after its first so that timestamps stay ordered
+	const int32 Capacity = Frame.GetCapacity();
+	int32 NumPoints = 0;
+
+	// a second return comes from the surface the next column of the channel hit, and carries its label
+	auto AddPoint = [&](int32 RayIndex, int32 SurfaceRay, float Range, float Intensity)
+	{
+		const FVector3f Point = RayDirections[RayIndex] * Range;
+		Frame.X[NumPoints] = Point.X;
+		Frame.Y[NumPoints] = Point.Y;
+		Frame.Z[NumPoints] = Point.Z;
+		Frame.Intensity[NumPoints] = Intensity;
+		Frame.Ring[NumPoints] = static_cast<uint16>(RayIndex % Channels);
+		Frame.Timestamp[NumPoints] = (RayIndex / Channels) * ColumnPeriod;
+		Frame.SemanticClass[NumPoints] = RayLabels[SurfaceRay].Class;
+		Frame.Instance[NumPoints] = RayLabels[SurfaceRay].Instance;
+		++NumPoints;
+	};
+
+	for (int32 Index = 0; Index < Hits.Num && NumPoints < Capacity; ++Index)
+	{
+		if (Hits.Intensity[Index] > 0.0f)
+		{
+			AddPoint(Hits.Ray[Index], Hits.Ray[Index], Hits.Range[Index], Hits.Intensity[Index]);
+		}
+
+		// frames only have room for second returns if the pool was built with multi-return on
+		if (Hits.SecondIntensity[Index] > 0.0f && NumPoints < Capacity)
+		{
+			AddPoint(Hits.Ray[Index], Hits.Ray[Index] + Channels, Hits.SecondRange[Index], Hits.SecondIntensity[Index]);
+		}
+	}
+
+	Frame.NumPoints = NumPoints;
+	LastSweepSeconds = FPlatformTime::Seconds() - StartSeconds;
+}
+
+FTransform USensorSimLidarComponent::GetColumnTransform(int32 Column, float ColumnPeriod) const
+{
+	const double Time = SweepStartTime + Column * ColumnPeriod;
+
+	// poses are sorted by time; clamp to the ends of the history
+	const int32 Next = Algo::UpperBoundBy(SweepPoses, Time, &FSensorSimPhysicsPose::Time);
+	const FSensorSimPhysicsPose& From = SweepPoses[FMath::Max(Next - 1, 0)];
+	const FSensorSimPhysicsPose& To = SweepPoses[FMath::Min(Next, SweepPoses.Num() - 1)];
+
+	const double Span = To.Time - From.Time;
+	const double Alpha = Span > 0.0 ? FMath::Clamp((Time - From.Time) / Span, 0.0, 1.0) : 0.0;
+
+	const FTransform VehicleTransform(FQuat::Slerp(From.Rotation, To.Rotation, Alpha), FMath::Lerp(From.Location, To.Location, Alpha));
+	return MountTransform * VehicleTransform;
+}
+
+void USensorSimLidarComponent::ResetSensor()
+{
+	// the sweep in flight was cast from before the reset, drop it unpublished
+	SweepTask.Wait();
+	SweepTask = UE::Tasks::FTask();
+	PendingFrame.Reset();
+	LatestFrame.Reset();
+	SweepPoses.Reset();
+
+	Super::ResetSensor();
+}
+
+void USensorSimLidarComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	BuildRayDirections();
+
+	PoseSource = GetOwner()->FindComponentByClass<USensorSimVehicleMovementComponent>();
+	SensorSubsystem = GetWorld()->GetSubsystem<USensorSimSensorSubsystem>();
+
+	// name text rather than object addresses or name indices, so that the noise replays in any process
+	SensorKey = SensorSimLidarReturns::GetSensorKey(GetOwner()->GetName(), GetName());
+
+	// dataset jobs vary the noise of a scenario by seed
+	FParse::Value(FCommandLine::Get(), TEXT("SensorSimSeed="), ReturnModel.Seed);
+}
+
+void USensorSimLidarComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// the sweep in flight references this component
+	SweepTask.Wait();
+	SweepTask = UE::Tasks::FTask();
+	PendingFrame.Reset();
+	StaticScene.Reset();
+	LabelTable.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void USensorSimLidarComponent::BuildRayDirections()
+{
+	RayDirections.SetNumUninitialized(Pattern.GetRaysPerSweep());
+
+	// every ray may hit, and return twice with multi-return, so frames hold a full sweep. Frames still referenced by consumers are freed when released
+	LatestFrame.Reset();
+	FramePool = FSensorSimPointCloudPool::Create(FramePoolSize, GetMaxPointsPerSweep());
+	Hits.Reserve(RayDirections.Num());
+
+	// a full revolution does not repeat its first column
+	const bool bFullRevolution = Pattern.HorizontalFov >= 360.0f;
+	const float ColumnStep = Pattern.HorizontalFov / (bFullRevolution ? Pattern.Columns : FMath::Max(Pattern.Columns - 1, 1));
+	const float ChannelStep = Pattern.Channels > 1 ? (Pattern.VerticalFovMax - Pattern.VerticalFovMin) / (Pattern.Channels - 1) : 0.0f;
+	const float FirstAzimuth = bFullRevolution ? 0.0f : -0.5f * Pattern.HorizontalFov;
+
+	int32 RayIndex = 0;
+	for (int32 Column = 0; Column < Pattern.Columns; ++Column)
+	{
+		float SinAzimuth, CosAzimuth;
+		FMath::SinCos(&SinAzimuth, &CosAzimuth, FMath::DegreesToRadians(FirstAzimuth + Column * ColumnStep));
+
+		for (int32 Channel = 0; Channel < Pattern.Channels; ++Channel)
+		{
+			float SinElevation, CosElevation;
+			FMath::SinCos(&SinElevation, &CosElevation, FMath::DegreesToRadians(Pattern.VerticalFovMin + Channel * ChannelStep));
+
+			RayDirections[RayIndex++] = FVector3f(CosElevation * CosAzimuth, CosElevation * SinAzimuth, SinElevation);
+		}
+	}
+}
+
+int32 USensorSimLidarComponent::BuildChannelDensity()
+{
+	SweepChannelDensity.Reset();
+	SweepChannelPhase.Reset();
+
+	if (RayFraction >= 1.0f)
+	{
+		return RayDirections.Num();
+	}
+
+	const int32 Channels = Pattern.Channels;
+	const float ChannelStep = Channels > 1 ? (Pattern.VerticalFovMax - Pattern.VerticalFovMin) / (Channels - 1) : 0.0f;
+
+	// channels are weighted by their elevation, falling off away from the horizon
+	TArray<float, TInlineAllocator<256>> Weights;
+	Weights.SetNumUninitialized(Channels);
+
+	float MinWeight = 1.0f;
+	for (int32 Channel = 0; Channel < Channels; ++Channel)
+	{
+		const float Elevation = Pattern.VerticalFovMin + Channel * ChannelStep;
+		Weights[Channel] = FMath::Lerp(MinChannelDensity, 1.0f, FMath::Exp(-FMath::Square(Elevation / HorizonWidth)));
+		MinWeight = FMath::Min(MinWeight, Weights[Channel]);
+	}
+
+	// scale the weights so that the densities, capped at one ray per column, add up to the ray fraction
+	const float TargetDensity = RayFraction * Channels;
+	float LowScale = 0.0f;
+	float HighScale = 1.0f / FMath::Max(MinWeight, UE_KINDA_SMALL_NUMBER);
+
+	for (int32 Iteration = 0; Iteration < 24; ++Iteration)
+	{
+		const float Scale = 0.5f * (LowScale + HighScale);
+
+		float Density = 0.0f;
+		for (const float Weight : Weights)
+		{
+			Density += FMath::Min(Scale * Weight, 1.0f);
+		}
+
+		(Density < TargetDensity ? LowScale : HighScale) = Scale;
+	}
+
+	SweepChannelDensity.SetNumUninitialized(Channels);
+	SweepChannelPhase.SetNumUninitialized(Channels);
+
+	int32 NumRays = 0;
+	for (int32 Channel = 0; Channel < Channels; ++Channel)
+	{
+		const uint32 Density = static_cast<uint32>(FMath::RoundToInt32(FMath::Min(LowScale * Weights[Channel], 1.0f) * SensorSimLidar::DensityOne));
+		const uint32 Phase = static_cast<uint32>(FMath::Frac(Channel * SensorSimLidar::ChannelPhaseStep) * SensorSimLidar::DensityOne);
+
+		SweepChannelDensity[Channel] = Density;
+		SweepChannelPhase[Channel] = Phase;
+
+		// columns the channel fires in, as counted by IsColumnCast
+		NumRays += static_cast<int32>(((Pattern.Columns * Density + Phase) >> 16) - (Phase >> 16));
+	}
+
+	return NumRays;
+}
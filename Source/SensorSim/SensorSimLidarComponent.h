@@ -0,0 +1,282 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimSensorComponent.h"
+#include "SensorSim.h"
+#include "CollisionQueryParams.h"
+#include "Tasks/Task.h"
+#include "SensorSimPointCloud.h"
+#include "SensorSimLidarReturns.h"
+#include "SensorSimLabels.h"
+#include "SensorSimLidarComponent.generated.h"
+
+// Forward declarations
+class USensorSimVehicleMovementComponent;
+class USensorSimSensorSubsystem;
+class FSensorSimStaticScene;
+struct FSensorSimPhysicsPose;
+
+/**
+ *  Scan pattern of a spinning LiDAR
+ *  Channels are spread evenly over the vertical field of view, columns over the horizontal one.
+ */
+USTRUCT(BlueprintType)
+struct SENSORSIM_API FSensorSimLidarPattern
+{
+	GENERATED_BODY()
+
+	/** Number of vertical channels (lasers) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "1", ClampMax = "256"))
+	int32 Channels = 32;
+
+	/** Number of horizontal firing positions per revolution */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "1", ClampMax = "8192"))
+	int32 Columns = 1024;
+
+	/** Elevation of the lowest channel, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "-90.0", ClampMax = "90.0"))
+	float VerticalFovMin = -25.0f;
+
+	/** Elevation of the highest channel, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "-90.0", ClampMax = "90.0"))
+	float VerticalFovMax = 15.0f;
+
+	/** Horizontal field of view, in degrees, centered on the sensor's forward axis */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "1.0", ClampMax = "360.0"))
+	float HorizontalFov = 360.0f;
+
+	/** Closest detectable range, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "0.0"))
+	float MinRange = 50.0f;
+
+	/** Farthest detectable range, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "1.0"))
+	float MaxRange = 12000.0f;
+
+	/** Revolutions per second. One sweep is produced per revolution */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pattern, meta = (ClampMin = "0.1", ClampMax = "100.0"))
+	float RotationRate = 10.0f;
+
+	/** Returns the number of rays cast per sweep */
+	int32 GetRaysPerSweep() const { return Channels * Columns; }
+};
+
+/** Broadcast on the game thread with every collected sweep */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSensorSimLidarSweep, const FSensorSimPointCloudRef& /*Frame*/);
+
+/**
+ *  LiDAR Component
+ *  Casts the rays of a spinning LiDAR from a mount component, typically the UESensors ULidarSensor.
+ *  One sweep is scheduled per revolution. A sweep is captured on the game thread, traced as one batch on the task graph
+ *  and collected on a later frame, so the game thread never waits on ray queries.
+ *  Sweeps are written into pooled point cloud frames and handed to consumers as read-only references.
+ *  Rays first traverse the static scene of the level, if one was built, then the physics scene up to the static hit,
+ *  which then only holds dynamic actors.
+ *
+ *  With a rolling shutter, a sweep is traced once its revolution has completed, and every column is cast
+ *  from the vehicle pose at its own firing time, interpolated between physics step poses.
+ *  Points stay in the sensor frame at their firing time, stamped relative to the start of the revolution.
+ *
+ *  Hits then go through the return model, which sets their intensity from the surface reflectivity, incidence angle
+ *  and range, adds range noise, drops weak returns and adds second returns at edges.
+ *  Every point carries the semantic class and instance of the component it hit, from the static scene's sources
+ *  or, for physics hits, the label subsystem's table.
+ */
+UCLASS(ClassGroup = (SensorSim), meta = (BlueprintSpawnableComponent))
+class SENSORSIM_API USensorSimLidarComponent : public USensorSimSensorComponent
+{
+	GENERATED_BODY()
+
+protected:
+	/** Scan pattern */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LiDAR)
+	FSensorSimLidarPattern Pattern;
+
+	/** Collision channel the rays are traced on */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LiDAR)
+	TEnumAsByte<ECollisionChannel> TraceChannel{ ECC_SensorRay };
+
+	/** Component the rays are cast from. Falls back to the owner's root component */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = LiDAR)
+	TObjectPtr<USceneComponent> Mount{ nullptr };
+
+	/** Casts every column from the pose at its firing time, rather than the whole sweep from one pose */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LiDAR)
+	bool bRollingShutter{ true };
+
+	/** Intensity, noise, dropout and multi-return of the hits */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LiDAR)
+	FSensorSimLidarReturnModel ReturnModel;
+
+	/** Number of point cloud frames in the pool. Bounds how many sweeps consumers may hold on to */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LiDAR, meta = (ClampMin = "2", ClampMax = "32"))
+	int32 FramePoolSize{ 4 };
+
+	/** Elevation, in degrees, over which a reduced ray budget thins channels away from the horizon */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LiDAR|Ray Budget", meta = (ClampMin = "1.0", ClampMax = "90.0"))
+	float HorizonWidth{ 10.0f };
+
+	/** Density of the channels farthest from the horizon, mostly the ground, relative to the horizon ones */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LiDAR|Ray Budget", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MinChannelDensity{ 0.2f };
+
+	/** Fraction of the pattern's rays the next sweep casts, set by the sensor subsystem's ray budget */
+	float RayFraction{ 1.0f };
+
+	/**
+	 *  Per-channel column density of the sweep in flight, in 16.16 fixed point, and the phase each channel's columns
+	 *  are offset by. Empty when every ray is cast. Owned by the sweep task until it completes
+	 */
+	TArray<uint32> SweepChannelDensity;
+	TArray<uint32> SweepChannelPhase;
+
+	/** Number of rays the sweep in flight casts */
+	int32 SweepRays{ 0 };
+
+	/** Unit ray directions in the sensor frame, column-major */
+	TArray<FVector3f> RayDirections;
+
+	/** Pool the sweeps are written into */
+	TSharedPtr<FSensorSimPointCloudPool, ESPMode::ThreadSafe> FramePool;
+
+	/** Frame of the sweep in flight. Owned by the sweep task until it completes */
+	FSensorSimPointCloudFramePtr PendingFrame;
+
+	/** Last collected sweep */
+	TSharedPtr<const FSensorSimPointCloudFrame, ESPMode::ThreadSafe> LatestFrame;
+
+	/** Per-ray hit range of the sweep in flight, zero on a miss. Owned by the sweep task until it completes */
+	TArray<float> RayRanges;
+
+	/** Per-ray cosine of the incidence angle and surface reflectivity of the sweep in flight. Owned by the sweep task until it completes */
+	TArray<float> RayCosines;
+	TArray<float> RayReflectivity;
+
+	/** Per-ray ground truth label of the surface hit by the sweep in flight. Owned by the sweep task until it completes */
+	TArray<FSensorSimLabel> RayLabels;
+
+	/** Hits of the sweep in flight, run through the return model. Owned by the sweep task until it completes */
+	FSensorSimLidarHits Hits;
+
+	/** Identifies the sensor in the return model's noise. Hashed from its actor's and its own name text, so it is the same in every process */
+	uint32 SensorKey{ 0 };
+
+	/** Sweep in flight, if any */
+	UE::Tasks::FTask SweepTask;
+
+	/** Sensor transform the current sweep is cast from, or that of its first column with a rolling shutter */
+	FTransform SweepTransform;
+
+	/** Vehicle poses spanning the revolution of the current sweep, in world time. Empty for a rigid sweep */
+	TArray<FSensorSimPhysicsPose> SweepPoses;
+
+	/** Sensor transform relative to the vehicle, for a rolling shutter sweep */
+	FTransform MountTransform;
+
+	/** World time at which the first column of the current sweep fired */
+	double SweepStartTime{ 0.0 };
+
+	/** Movement component providing the physics step poses, if the owner has one */
+	UPROPERTY(Transient)
+	TObjectPtr<USensorSimVehicleMovementComponent> PoseSource{ nullptr };
+
+	/** Subsystem looking up the reflectivity of the physical materials hit */
+	UPROPERTY(Transient)
+	TObjectPtr<const USensorSimSensorSubsystem> SensorSubsystem{ nullptr };
+
+	/** Query parameters of the current sweep */
+	FCollisionQueryParams QueryParams;
+
+	/** Static level geometry the current sweep traces outside of the physics scene, if built */
+	TSharedPtr<const FSensorSimStaticScene, ESPMode::ThreadSafe> StaticScene;
+
+	/** Labels of the components the current sweep may hit in the physics scene, if the world labels them */
+	TSharedPtr<const FSensorSimLabelTable, ESPMode::ThreadSafe> LabelTable;
+
+	/** Number of sweeps dispatched since BeginPlay */
+	uint32 SweepSequence{ 0 };
+
+	/** Number of rays cast by the last sweep */
+	int32 LastSweepRays{ 0 };
+
+	/** Wall clock seconds the last sweep spent tracing */
+	double LastSweepSeconds{ 0.0 };
+
+public:
+	/** Broadcast on the game thread with every collected sweep */
+	FOnSensorSimLidarSweep OnSweep;
+
+	/** Sets the component the rays are cast from */
+	void SetMount(USceneComponent* InMount);
+
+	/** Replaces the scan pattern */
+	void SetPattern(const FSensorSimLidarPattern& InPattern);
+
+	/** Returns the scan pattern */
+	const FSensorSimLidarPattern& GetPattern() const { return Pattern; }
+
+	/** Returns true while a sweep is being traced */
+	bool IsSweepInFlight() const { return SweepTask.IsValid() && !SweepTask.IsCompleted(); }
+
+	/** Returns the last collected sweep, if any */
+	TSharedPtr<const FSensorSimPointCloudFrame, ESPMode::ThreadSafe> GetLatestFrame() const { return LatestFrame; }
+
+	/** Returns the number of rays cast by the last collected sweep */
+	int32 GetLastSweepRays() const { return LastSweepRays; }
+
+	/** Returns the number of rays in the scan pattern */
+	int32 GetPatternRays() const { return RayDirections.Num(); }
+
+	/** Returns the most points a sweep can hold: every ray of the pattern, twice with multi-return */
+	int32 GetMaxPointsPerSweep() const { return Pattern.GetRaysPerSweep() * (ReturnModel.bMultiReturn ? 2 : 1); }
+
+	/**
+	 *  Casts only a fraction of the pattern's rays from the next sweep on. Channels near the horizon keep their
+	 *  full column resolution longest; those far from it are thinned first, down to MinChannelDensity relative to the horizon
+	 */
+	void SetRayFraction(float InFraction) { RayFraction = FMath::Clamp(InFraction, 0.0f, 1.0f); }
+
+	/** Returns the fraction of the pattern's rays cast from the next sweep on */
+	float GetRayFraction() const { return RayFraction; }
+
+	/** Returns the movement component of the vehicle carrying the sensor, if any */
+	USensorSimVehicleMovementComponent* GetVehicleMovement() const { return PoseSource; }
+
+	/** Returns the wall clock seconds the last collected sweep spent tracing */
+	double GetLastSweepSeconds() const { return LastSweepSeconds; }
+
+	/** Returns the number of sweeps skipped because the previous one was still in flight or no frame was free */
+	uint32 GetDroppedSweeps() const { return SkippedSamples; }
+
+	/** Returns the number of rays cast since BeginPlay */
+	uint64 GetTotalRays() const { return Counters.Rays; }
+
+	/** Returns the number of hits since BeginPlay */
+	uint64 GetTotalHits() const { return Counters.Hits; }
+
+	// Begin SensorSimSensorComponent interface
+	virtual float GetSampleRate() const override { return Pattern.RotationRate; }
+	virtual bool CollectSamples() override;
+	virtual void ResetSensor() override;
+protected:
+	virtual bool TakeSample(double SampleTime) override;
+	virtual bool CatchesUp() const override { return false; }
+	// End SensorSimSensorComponent interface
+
+	// Begin ActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End ActorComponent interface
+
+	/** Rebuilds the ray directions and the frame pool from the pattern */
+	void BuildRayDirections();
+
+	/** Spreads the ray fraction over the channels of the next sweep, denser near the horizon. Returns the rays it casts */
+	int32 BuildChannelDensity();
+
+	/** Traces all rays of the sweep in flight. Runs on the task graph */
+	void ExecuteSweep();
+
+	/** Returns the sensor transform a column of the sweep in flight is cast from */
+	FTransform GetColumnTransform(int32 Column, float ColumnPeriod) const;
+};
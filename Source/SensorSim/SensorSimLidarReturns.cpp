@@ -0,0 +1,137 @@
+#include "SensorSimLidarReturns.h"
+#include "SensorSim.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+namespace SensorSimLidarReturns
+{
+	/** Lanes of a SIMD register */
+	constexpr int32 Lanes = 4;
+
+	/** Hits per parallel block, a multiple of Lanes */
+	constexpr int32 BlockSize = 512;
+
+	/** Uniform numbers drawn per ray: four for the range noise, one for the dropout, one for the second return */
+	constexpr int32 DrawsPerRay = 6;
+
+	/** Scales a sum of four centered uniforms to unit variance */
+	constexpr float IrwinHallScale = 1.7320508f;
+
+	/** Computes the returns of the hits of one block, four at a time */
+	void ApplyBlock(const FSensorSimLidarReturnModel& Model, uint32 SweepKey, float MinRange, FSensorSimLidarHits& Hits, int32 First, int32 End)
+	{
+		// the draws only depend on the ray, so the noise of a ray is the same whatever block it falls in
+		float Draws[DrawsPerRay][BlockSize];
+		for (int32 Index = First; Index < End; ++Index)
+		{
+			const uint32 Counter = static_cast<uint32>(Hits.Ray[Index]) * DrawsPerRay;
+			for (int32 Draw = 0; Draw < DrawsPerRay; ++Draw)
+			{
+				Draws[Draw][Index - First] = Uniform(SweepKey, Counter + Draw);
+			}
+		}
+
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float Two = VectorSetFloat1(2.0f);
+		const VectorRegister4Float NoiseScale = VectorSetFloat1(IrwinHallScale);
+		const VectorRegister4Float RangeNoise = VectorSetFloat1(Model.RangeNoise);
+		const VectorRegister4Float RangeNoisePerRange = VectorSetFloat1(Model.RangeNoisePerRange);
+		const VectorRegister4Float ReferenceRangeSquared = VectorSetFloat1(FMath::Square(Model.ReferenceRange));
+		const VectorRegister4Float Dropout = VectorSetFloat1(Model.DropoutProbability);
+		const VectorRegister4Float MinIntensity = VectorSetFloat1(Model.MinReturnIntensity);
+		const VectorRegister4Float MinRangeVector = VectorSetFloat1(MinRange);
+		const VectorRegister4Float Separation = VectorSetFloat1(Model.MultiReturnSeparation);
+		const float MultiReturnProbability = Model.bMultiReturn ? Model.MultiReturnProbability : 0.0f;
+		const VectorRegister4Float SecondProbability = VectorSetFloat1(MultiReturnProbability);
+		const VectorRegister4Float InvSecondProbability = VectorSetFloat1(MultiReturnProbability > 0.0f ? 1.0f / MultiReturnProbability : 0.0f);
+
+		for (int32 Index = First; Index < End; Index += Lanes)
+		{
+			const int32 Lane = Index - First;
+			const VectorRegister4Float U0 = VectorLoad(&Draws[0][Lane]);
+			const VectorRegister4Float U1 = VectorLoad(&Draws[1][Lane]);
+			const VectorRegister4Float U2 = VectorLoad(&Draws[2][Lane]);
+			const VectorRegister4Float U3 = VectorLoad(&Draws[3][Lane]);
+			const VectorRegister4Float UDropout = VectorLoad(&Draws[4][Lane]);
+			const VectorRegister4Float USecond = VectorLoad(&Draws[5][Lane]);
+
+			// two uncorrelated, nearly normal deviates from the same four uniforms
+			const VectorRegister4Float Noise = VectorMultiply(VectorSubtract(VectorAdd(VectorAdd(U0, U1), VectorAdd(U2, U3)), Two), NoiseScale);
+			const VectorRegister4Float SecondNoise = VectorMultiply(VectorAdd(VectorSubtract(U0, U1), VectorSubtract(U2, U3)), NoiseScale);
+
+			const VectorRegister4Float Range = VectorMax(VectorLoad(&Hits.Range[Index]), MinRangeVector);
+			const VectorRegister4Float NextRange = VectorLoad(&Hits.NextRange[Index]);
+
+			// received power falls off with the square of the range beyond the reference one, and with the incidence angle
+			const VectorRegister4Float Power = VectorMultiply(VectorMultiply(VectorLoad(&Hits.Reflectivity[Index]), VectorLoad(&Hits.Cosine[Index])),
+				VectorDivide(ReferenceRangeSquared, VectorMax(VectorMultiply(Range, Range), ReferenceRangeSquared)));
+			const VectorRegister4Float NextPower = VectorMultiply(VectorMultiply(VectorLoad(&Hits.NextReflectivity[Index]), VectorLoad(&Hits.NextCosine[Index])),
+				VectorDivide(ReferenceRangeSquared, VectorMax(VectorMultiply(NextRange, NextRange), ReferenceRangeSquared)));
+
+			// a beam straddling an edge splits its power between the near surface and the one behind it
+			const VectorRegister4Float Coverage = VectorMultiply(USecond, InvSecondProbability);
+			const VectorRegister4Float SecondPower = VectorMultiply(NextPower, VectorSubtract(One, Coverage));
+			const VectorRegister4Float SecondMask = VectorBitwiseAnd(
+				VectorBitwiseAnd(VectorCompareGT(VectorSubtract(NextRange, Range), Separation), VectorCompareLT(USecond, SecondProbability)),
+				VectorCompareGE(SecondPower, MinIntensity));
+			const VectorRegister4Float FirstPower = VectorSelect(SecondMask, VectorMultiply(Power, Coverage), Power);
+
+			const VectorRegister4Float KeepMask = VectorBitwiseAnd(VectorCompareGE(UDropout, Dropout), VectorCompareGE(FirstPower, MinIntensity));
+
+			const VectorRegister4Float Measured = VectorMax(VectorMultiplyAdd(VectorMultiplyAdd(Range, RangeNoisePerRange, RangeNoise), Noise, Range), MinRangeVector);
+			const VectorRegister4Float SecondMeasured = VectorMax(VectorMultiplyAdd(VectorMultiplyAdd(NextRange, RangeNoisePerRange, RangeNoise), SecondNoise, NextRange), MinRangeVector);
+
+			VectorStore(Measured, &Hits.Range[Index]);
+			VectorStore(VectorSelect(KeepMask, VectorMin(FirstPower, One), Zero), &Hits.Intensity[Index]);
+			VectorStore(VectorSelect(SecondMask, SecondMeasured, Zero), &Hits.SecondRange[Index]);
+			VectorStore(VectorSelect(SecondMask, VectorMin(SecondPower, One), Zero), &Hits.SecondIntensity[Index]);
+		}
+	}
+}
+
+void FSensorSimLidarHits::Reserve(int32 Capacity)
+{
+	// whole registers, so the last one can be loaded past the last hit
+	const int32 Padded = Align(FMath::Max(Capacity, 1), SensorSimLidarReturns::Lanes);
+
+	for (TArray<float>* Array : { &Range, &Cosine, &Reflectivity, &NextRange, &NextCosine, &NextReflectivity, &Intensity, &SecondRange, &SecondIntensity })
+	{
+		Array->SetNumZeroed(Padded);
+	}
+
+	Ray.SetNumZeroed(Padded);
+	Num = 0;
+}
+
+uint32 SensorSimLidarReturns::GetSensorKey(const FString& OwnerName, const FString& SensorName)
+{
+	// name hashes follow the name pool's creation order, which differs between processes
+	return HashCombine(FCrc::StrCrc32(*OwnerName), FCrc::StrCrc32(*SensorName));
+}
+
+uint32 SensorSimLidarReturns::GetSweepKey(int32 Seed, uint32 SensorKey, uint32 Sequence)
+{
+	return HashCombine(HashCombine(GetTypeHash(Seed), SensorKey), GetTypeHash(Sequence));
+}
+
+void SensorSimLidarReturns::ApplyReturnModel(const FSensorSimLidarReturnModel& Model, uint32 SweepKey, float MinRange, FSensorSimLidarHits& Hits)
+{
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimLidarReturns);
+
+	// padding lanes past the last hit are processed too; give them no next hit so they never produce a second return
+	const int32 Padded = Align(Hits.Num, Lanes);
+	for (int32 Index = Hits.Num; Index < Padded; ++Index)
+	{
+		Hits.Ray[Index] = 0;
+		Hits.Range[Index] = MinRange;
+		Hits.NextRange[Index] = 0.0f;
+	}
+
+	const int32 NumBlocks = FMath::DivideAndRoundUp(Padded, BlockSize);
+	ParallelFor(NumBlocks, [&](int32 Block)
+	{
+		const int32 First = Block * BlockSize;
+		ApplyBlock(Model, SweepKey, MinRange, Hits, First, FMath::Min(First + BlockSize, Padded));
+	});
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimLidarReturns.generated.h"
+
+/**
+ *  Return model of a LiDAR
+ *  Turns the geometric hits of a sweep into the returns a real sensor reports: an intensity from the surface
+ *  reflectivity, incidence angle and range, range noise, dropped weak or random returns, and a second return
+ *  where a beam straddles an edge in front of a farther surface.
+ */
+USTRUCT(BlueprintType)
+struct SENSORSIM_API FSensorSimLidarReturnModel
+{
+	GENERATED_BODY()
+
+	/** Noise seed. Sweeps are reproducible for a seed, sensor and sweep sequence, whatever the threads they run on */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns)
+	int32 Seed = 0;
+
+	/** Range at which a perpendicular white surface returns a full intensity, in cm. Closer surfaces saturate */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "1.0"))
+	float ReferenceRange = 1000.0f;
+
+	/** Standard deviation of the range noise, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "0.0"))
+	float RangeNoise = 1.5f;
+
+	/** Standard deviation of the range noise added per cm of range */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "0.0"))
+	float RangeNoisePerRange = 0.0002f;
+
+	/** Probability that any return is lost */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float DropoutProbability = 0.005f;
+
+	/** Returns weaker than this, in the intensity scale before saturation, are lost */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "0.0"))
+	float MinReturnIntensity = 0.002f;
+
+	/** Reports a second return where the next column of the channel hits a farther surface */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns)
+	bool bMultiReturn = true;
+
+	/** Range step between neighbouring rays, in cm, beyond which a beam is taken to straddle an edge */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "0.0", EditCondition = "bMultiReturn"))
+	float MultiReturnSeparation = 100.0f;
+
+	/** Probability that a beam straddling an edge reports its second return */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Returns, meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "bMultiReturn"))
+	float MultiReturnProbability = 0.5f;
+};
+
+/**
+ *  Hits of one sweep, as a structure of arrays padded to whole SIMD registers
+ *  Filled in ray order by the sweep, then transformed in place by SensorSimLidarReturns::ApplyReturnModel.
+ */
+struct SENSORSIM_API FSensorSimLidarHits
+{
+	/** Ray of each hit */
+	TArray<int32> Ray;
+
+	/** Hit range, in cm, replaced by the measured one */
+	TArray<float> Range;
+
+	/** Cosine of the incidence angle, and surface reflectivity */
+	TArray<float> Cosine;
+	TArray<float> Reflectivity;
+
+	/** Same, of the next column of the channel, or a range of 0 if it missed */
+	TArray<float> NextRange;
+	TArray<float> NextCosine;
+	TArray<float> NextReflectivity;
+
+	/** Outputs: intensity of the first return, 0 if it was lost, and measured range and intensity of the second, 0 if none */
+	TArray<float> Intensity;
+	TArray<float> SecondRange;
+	TArray<float> SecondIntensity;
+
+	/** Number of hits */
+	int32 Num = 0;
+
+	/** Sizes every array for up to Capacity hits */
+	void Reserve(int32 Capacity);
+
+	/** Appends a hit, with the hit of the next column of its channel */
+	FORCEINLINE void Add(int32 InRay, float InRange, float InCosine, float InReflectivity, float InNextRange, float InNextCosine, float InNextReflectivity)
+	{
+		Ray[Num] = InRay;
+		Range[Num] = InRange;
+		Cosine[Num] = InCosine;
+		Reflectivity[Num] = InReflectivity;
+		NextRange[Num] = InNextRange;
+		NextCosine[Num] = InNextCosine;
+		NextReflectivity[Num] = InNextReflectivity;
+		++Num;
+	}
+};
+
+namespace SensorSimLidarReturns
+{
+	/** Returns a uniform number in [0, 1) that only depends on its inputs: a counter-based generator */
+	FORCEINLINE float Uniform(uint32 Key, uint32 Counter)
+	{
+		// murmur3 finalizer over a Weyl sequence
+		uint32 Hash = Key ^ (Counter * 0x9E3779B9u);
+		Hash ^= Hash >> 16;
+		Hash *= 0x85EBCA6Bu;
+		Hash ^= Hash >> 13;
+		Hash *= 0xC2B2AE35u;
+		Hash ^= Hash >> 16;
+		return (Hash >> 8) * (1.0f / 16777216.0f);
+	}
+
+	/** Returns the key of a sensor in the noise, from the text of its actor's and its own names, so that it is the same in every process */
+	SENSORSIM_API uint32 GetSensorKey(const FString& OwnerName, const FString& SensorName);
+
+	/** Returns the key of a sweep's noise, from the model seed, the sensor and the sweep sequence */
+	SENSORSIM_API uint32 GetSweepKey(int32 Seed, uint32 SensorKey, uint32 Sequence);
+
+	/** Computes the returns of every hit, in place. Blocks of hits run in parallel; the result does not depend on how */
+	SENSORSIM_API void ApplyReturnModel(const FSensorSimLidarReturnModel& Model, uint32 SweepKey, float MinRange, FSensorSimLidarHits& Hits);
+}
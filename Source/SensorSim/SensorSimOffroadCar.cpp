@@ -4,9 +4,14 @@
 #include "SensorSimOffroadCar.h"
 #include "SensorSimOffroadWheelFront.h"
 #include "SensorSimOffroadWheelRear.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimVehicleCatalog.h"
 #include "ChaosWheeledVehicleMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 
+// UESensors
+#include "Sensors/LiDAR/LidarSensor.h"
+
 ASensorSimOffroadCar::ASensorSimOffroadCar()
 {
 	// construct the mesh components
@@ -32,18 +37,21 @@ ASensorSimOffroadCar::ASensorSimOffroadCar()
 	TireRearRight->SetCollisionProfileName(FName("NoCollision"));
 	TireRearRight->SetRelativeRotation(FRotator(0.0f, 180.0f, 0.0f));
 
+	// construct the LiDAR sensor on the roof and cast the LiDAR rays from it
+	Lidar = CreateDefaultSubobject<ULidarSensor>(TEXT("LiDAR"));
+	Lidar->SetupAttachment(GetMesh());
+	Lidar->SetRelativeLocation(FVector(0.0f, 0.0f, 200.0f));
+
+	GetLidarScanner()->SetMount(Lidar);
+
 	// adjust the cameras
 	GetFrontSpringArm()->SetRelativeLocation(FVector(-5.0f, -30.0f, 135.0f));
 	GetBackSpringArm()->SetRelativeLocation(FVector(0.0f, 0.0f, 75.0f));
 
 	// Note: for faster iteration times, the vehicle setup can be tweaked in the Blueprint instead
 
-	// Set up the chassis
-	GetChaosVehicleMovement()->ChassisHeight = 160.0f;
-	GetChaosVehicleMovement()->DragCoefficient = 0.1f;
-	GetChaosVehicleMovement()->DownforceCoefficient = 0.1f;
-	GetChaosVehicleMovement()->CenterOfMassOverride = FVector(0.0f, 0.0f, 75.0f);
-	GetChaosVehicleMovement()->bEnableCenterOfMassOverride = true;
+	// Set up the chassis, engine, transmission, differential and steering from the shipped archetype
+	SensorSimVehicleCatalog::OffroadCar.ApplyTo(*GetChaosVehicleMovement());
 
 	// Set up the wheels
 	GetChaosVehicleMovement()->bLegacyWheelFrictionPosition = true;
@@ -64,22 +72,4 @@ ASensorSimOffroadCar::ASensorSimOffroadCar()
 	GetChaosVehicleMovement()->WheelSetups[3].WheelClass = USensorSimOffroadWheelRear::StaticClass();
 	GetChaosVehicleMovement()->WheelSetups[3].BoneName = FName("PhysWheel_BR");
 	GetChaosVehicleMovement()->WheelSetups[3].AdditionalOffset = FVector(0.0f, 0.0f, 0.0f);
-
-	// Set up the engine
-	// NOTE: Check the Blueprint asset for the Torque Curve
-	GetChaosVehicleMovement()->EngineSetup.MaxTorque = 600.0f;
-	GetChaosVehicleMovement()->EngineSetup.MaxRPM = 5000.0f;
-	GetChaosVehicleMovement()->EngineSetup.EngineIdleRPM = 1200.0f;
-	GetChaosVehicleMovement()->EngineSetup.EngineBrakeEffect = 0.05f;
-	GetChaosVehicleMovement()->EngineSetup.EngineRevUpMOI = 5.0f;
-	GetChaosVehicleMovement()->EngineSetup.EngineRevDownRate = 600.0f;
-
-	// Set up the differential
-	GetChaosVehicleMovement()->DifferentialSetup.DifferentialType = EVehicleDifferential::AllWheelDrive;
-	GetChaosVehicleMovement()->DifferentialSetup.FrontRearSplit = 0.5f;
-
-	// Set up the steering
-	// NOTE: Check the Blueprint asset for the Steering Curve
-	GetChaosVehicleMovement()->SteeringSetup.SteeringType = ESteeringType::AngleRatio;
-	GetChaosVehicleMovement()->SteeringSetup.AngleRatio = 0.7f;
 }
\ No newline at end of file
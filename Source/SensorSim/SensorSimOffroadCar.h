@@ -6,6 +6,8 @@
 #include "SensorSimPawn.h"
 #include "SensorSimOffroadCar.generated.h"
 
+class ULidarSensor;
+
 /**
  *  Offroad car wheeled vehicle implementation
  */
@@ -34,6 +36,10 @@ class SENSORSIM_API ASensorSimOffroadCar : public ASensorSimPawn
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Meshes, meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* TireRearRight;
 
+	/** LiDAR sensor */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sensors, meta = (AllowPrivateAccess = "true"))
+	TObjectPtr<ULidarSensor> Lidar;
+
 public:
 
 	ASensorSimOffroadCar();
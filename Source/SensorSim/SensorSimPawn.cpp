@@ -1,8 +1,19 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SensorSimPawn.h"
+#include "SensorSim.h"
 #include "SensorSimWheelFront.h"
 #include "SensorSimWheelRear.h"
+#include "SensorSimInputTrack.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimCameraComponent.h"
+#include "SensorSimImuComponent.h"
+#include "SensorSimWheelEncoderComponent.h"
+#include "SensorSimRecording.h"
+#include "SensorSimSensorComponent.h"
+#include "SensorSimPhysicsState.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "SensorSimVehicleCatalog.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Camera/CameraComponent.h"
@@ -10,12 +21,14 @@
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
 #include "ChaosWheeledVehicleMovementComponent.h"
+#include "ChaosVehicleWheel.h"
 
 #define LOCTEXT_NAMESPACE "VehiclePawn"
 
 DEFINE_LOG_CATEGORY(LogTemplateVehicle);
 
 ASensorSimPawn::ASensorSimPawn()
+	: Super(FObjectInitializer::Get().SetDefaultSubobjectClass<USensorSimVehicleMovementComponent>(VehicleMovementComponentName))
 {
 	// construct the front camera boom
 	FrontSpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("Front Spring Arm"));
@@ -45,12 +58,29 @@ ASensorSimPawn::ASensorSimPawn()
 	BackCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("Back Camera"));
 	BackCamera->SetupAttachment(BackSpringArm);
 
+	// construct the LiDAR ray caster
+	LidarScanner = CreateDefaultSubobject<USensorSimLidarComponent>(TEXT("LiDAR Scanner"));
+
+	// construct the camera sensors, capturing from the front and back cameras whether or not they are viewed
+	FrontCameraSensor = CreateDefaultSubobject<USensorSimCameraComponent>(TEXT("Front Camera Sensor"));
+	FrontCameraSensor->SetMount(FrontCamera);
+	FrontCameraSensor->SetCameraId(0);
+
+	BackCameraSensor = CreateDefaultSubobject<USensorSimCameraComponent>(TEXT("Back Camera Sensor"));
+	BackCameraSensor->SetMount(BackCamera);
+	BackCameraSensor->SetCameraId(1);
+
+	// construct the physics rate sensors, the IMU at the body origin unless a subclass mounts it
+	Imu = CreateDefaultSubobject<USensorSimImuComponent>(TEXT("IMU"));
+	WheelEncoders = CreateDefaultSubobject<USensorSimWheelEncoderComponent>(TEXT("Wheel Encoders"));
+
 	// Configure the car mesh
 	GetMesh()->SetSimulatePhysics(true);
 	GetMesh()->SetCollisionProfileName(FName("Vehicle"));
 
 	// get the Chaos Wheeled movement component
 	ChaosVehicleMovement = CastChecked<UChaosWheeledVehicleMovementComponent>(GetVehicleMovement());
+	SensorSimMovement = CastChecked<USensorSimVehicleMovementComponent>(GetVehicleMovement());
 
 }
 
@@ -92,14 +122,38 @@ void ASensorSimPawn::SetupPlayerInputComponent(class UInputComponent* PlayerInpu
 	}
 }
 
+void ASensorSimPawn::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// render-less runs have no viewport, so keep the cameras and their booms idle
+	bHeadless = !FApp::CanEverRender();
+
+	if (bHeadless)
+	{
+		FrontCamera->Deactivate();
+		BackCamera->Deactivate();
+
+		FrontSpringArm->SetComponentTickEnabled(false);
+		BackSpringArm->SetComponentTickEnabled(false);
+	}
+}
+
 void ASensorSimPawn::Tick(float Delta)
 {
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimVehicleTick);
+
 	Super::Tick(Delta);
 
 	// add some angular damping if the vehicle is in midair
 	bool bMovingOnGround = ChaosVehicleMovement->IsMovingOnGround();
 	GetMesh()->SetAngularDamping(bMovingOnGround ? 0.0f : 3.0f);
 
+	if (bHeadless)
+	{
+		return;
+	}
+
 	// realign the camera yaw to face front
 	float CameraYaw = BackSpringArm->GetRelativeRotation().Yaw;
 	CameraYaw = FMath::FInterpTo(CameraYaw, 0.0f, Delta, 1.0f);
@@ -107,6 +161,175 @@ void ASensorSimPawn::Tick(float Delta)
 	BackSpringArm->SetRelativeRotation(FRotator(0.0f, CameraYaw, 0.0f));
 }
 
+void ASensorSimPawn::ApplyVehicleInput(const FSensorSimVehicleInput& Input)
+{
+	ChaosVehicleMovement->SetSteeringInput(Input.Steering);
+	ChaosVehicleMovement->SetThrottleInput(Input.Throttle);
+	ChaosVehicleMovement->SetBrakeInput(Input.Brake);
+	ChaosVehicleMovement->SetHandbrakeInput(Input.bHandbrake);
+
+	// only call the Blueprint hook for the brake lights when they change
+	const bool bBraking = Input.Brake > 0.0f || Input.bHandbrake;
+	if (bBraking != bBrakeLightsOn)
+	{
+		bBrakeLightsOn = bBraking;
+		BrakeLights(bBraking);
+	}
+}
+
+void ASensorSimPawn::SampleState(double Time, FSensorSimVehicleStateSample& OutSample) const
+{
+	const FTransform& Transform = GetActorTransform();
+
+	OutSample.Time = Time;
+	OutSample.Location = Transform.GetLocation();
+	OutSample.Rotation = FQuat4f(Transform.GetRotation());
+	OutSample.LinearVelocity = FVector3f(GetMesh()->GetPhysicsLinearVelocity());
+	OutSample.AngularVelocity = FVector3f(GetMesh()->GetPhysicsAngularVelocityInDegrees());
+
+	OutSample.ForwardSpeed = ChaosVehicleMovement->GetForwardSpeed();
+	OutSample.EngineRPM = ChaosVehicleMovement->GetEngineRotationSpeed();
+	OutSample.Gear = ChaosVehicleMovement->GetCurrentGear();
+
+	OutSample.Steering = ChaosVehicleMovement->GetSteeringInput();
+	OutSample.Throttle = ChaosVehicleMovement->GetThrottleInput();
+	OutSample.Brake = ChaosVehicleMovement->GetBrakeInput();
+	OutSample.Handbrake = ChaosVehicleMovement->GetHandbrakeInput();
+
+	OutSample.NumWheels = static_cast<uint8>(FMath::Min(ChaosVehicleMovement->Wheels.Num(), SensorSimRecording::MaxWheels));
+	OutSample.WheelContactMask = 0;
+
+	for (int32 WheelIndex = 0; WheelIndex < OutSample.NumWheels; ++WheelIndex)
+	{
+		const UChaosVehicleWheel* Wheel = ChaosVehicleMovement->Wheels[WheelIndex];
+		const FWheelStatus& Status = ChaosVehicleMovement->GetWheelState(WheelIndex);
+
+		FSensorSimWheelStateSample& WheelSample = OutSample.Wheels[WheelIndex];
+		WheelSample.AngularVelocity = Wheel->GetRotationAngularVelocity();
+		WheelSample.RotationAngle = Wheel->GetRotationAngle();
+		WheelSample.SuspensionOffset = Wheel->GetSuspensionOffset();
+		WheelSample.NormalizedSuspensionLength = Status.NormalizedSuspensionLength;
+		WheelSample.SlipAngle = Status.SlipAngle;
+		WheelSample.SkidMagnitude = Status.SkidMagnitude;
+
+		if (Status.bInContact)
+		{
+			OutSample.WheelContactMask |= 1 << WheelIndex;
+		}
+	}
+}
+
+void ASensorSimPawn::RestartVehicle(const FTransform& Transform)
+{
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+
+	GetMesh()->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+	GetMesh()->SetPhysicsLinearVelocity(FVector::ZeroVector);
+
+	// inputs, gear and wheel state, applied on the next physics step
+	ChaosVehicleMovement->ResetVehicleState();
+
+	if (bBrakeLightsOn)
+	{
+		bBrakeLightsOn = false;
+		BrakeLights(false);
+	}
+
+	ResetSensors();
+}
+
+bool ASensorSimPawn::SavePhysicsState(TArray<uint8>& OutBlob) const
+{
+	FSensorSimVehiclePhysicsState State;
+	if (!SensorSimMovement->GetLatestPhysicsState(State))
+	{
+		return false;
+	}
+
+	// the body as the solver left it, at the same step end as the vehicle state
+	const FTransform& Transform = GetActorTransform();
+	State.Location = Transform.GetLocation();
+	State.Rotation = FQuat4f(Transform.GetRotation());
+	State.LinearVelocity = FVector3f(GetMesh()->GetPhysicsLinearVelocity());
+	State.AngularVelocity = FVector3f(GetMesh()->GetPhysicsAngularVelocityInRadians());
+
+	OutBlob.SetNumUninitialized(sizeof(State));
+	FMemory::Memcpy(OutBlob.GetData(), &State, sizeof(State));
+	return true;
+}
+
+bool ASensorSimPawn::RestorePhysicsState(TConstArrayView<uint8> Blob)
+{
+	FSensorSimVehiclePhysicsState State;
+	if (Blob.Num() != sizeof(State))
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&State, Blob.GetData(), sizeof(State));
+	if (State.Version != SensorSimPhysicsState::Version)
+	{
+		return false;
+	}
+
+	SetActorTransform(FTransform(FQuat(State.Rotation), State.Location), false, nullptr, ETeleportType::TeleportPhysics);
+	GetMesh()->SetPhysicsLinearVelocity(FVector(State.LinearVelocity));
+	GetMesh()->SetPhysicsAngularVelocityInRadians(FVector(State.AngularVelocity));
+
+	SensorSimMovement->QueuePhysicsState(State);
+
+	ResetSensors();
+	return true;
+}
+
+void ASensorSimPawn::ResetSensors()
+{
+	SensorSimMovement->ResetHistory();
+
+	TInlineComponentArray<USensorSimSensorComponent*> Sensors(this);
+	for (USensorSimSensorComponent* Sensor : Sensors)
+	{
+		Sensor->ResetSensor();
+	}
+}
+
+void ASensorSimPawn::SetParked(bool bInParked)
+{
+	if (bParked == bInParked)
+	{
+		return;
+	}
+
+	bParked = bInParked;
+
+	// the body keeps its physics state: it stops simulating, which leaves it kinematic, and loses its collision
+	SetActorHiddenInGame(bParked);
+	SetActorEnableCollision(!bParked);
+	GetMesh()->SetSimulatePhysics(!bParked);
+
+	SetActorTickEnabled(!bParked);
+	ChaosVehicleMovement->SetComponentTickEnabled(!bParked);
+
+	TInlineComponentArray<USensorSimSensorComponent*> Sensors(this);
+	for (USensorSimSensorComponent* Sensor : Sensors)
+	{
+		Sensor->SetSamplingEnabled(!bParked);
+	}
+}
+
+void ASensorSimPawn::SetArchetype(int32 InArchetypeIndex)
+{
+	const FSensorSimVehicleCatalog& Catalog = FSensorSimVehicleCatalog::Get();
+	if (!Catalog.IsValidIndex(InArchetypeIndex))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("%s: no vehicle archetype %d"), *GetName(), InArchetypeIndex);
+		return;
+	}
+
+	ArchetypeIndex = InArchetypeIndex;
+	SensorSimMovement->ApplyArchetype(Catalog.GetArchetype(ArchetypeIndex));
+}
+
 void ASensorSimPawn::Steering(const FInputActionValue& Value)
 {
 	// get the input magnitude for steering
@@ -10,7 +10,14 @@ class UCameraComponent;
 class USpringArmComponent;
 class UInputAction;
 class UChaosWheeledVehicleMovementComponent;
+class USensorSimVehicleMovementComponent;
+class USensorSimLidarComponent;
+class USensorSimCameraComponent;
+class USensorSimImuComponent;
+class USensorSimWheelEncoderComponent;
 struct FInputActionValue;
+struct FSensorSimVehicleInput;
+struct FSensorSimVehicleStateSample;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateVehicle, Log, All);
 
@@ -42,9 +49,32 @@ class ASensorSimPawn : public AWheeledVehiclePawn
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* BackCamera;
 
+	/** LiDAR ray caster. Mounted on the vehicle's LiDAR sensor by subclasses */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sensors, meta = (AllowPrivateAccess = "true"))
+	USensorSimLidarComponent* LidarScanner;
+
+	/** Camera sensor capturing from the front camera */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sensors, meta = (AllowPrivateAccess = "true"))
+	USensorSimCameraComponent* FrontCameraSensor;
+
+	/** Camera sensor capturing from the back camera */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sensors, meta = (AllowPrivateAccess = "true"))
+	USensorSimCameraComponent* BackCameraSensor;
+
+	/** IMU, sampled from the body on the physics thread */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sensors, meta = (AllowPrivateAccess = "true"))
+	USensorSimImuComponent* Imu;
+
+	/** Wheel encoders, sampled from the wheels on the physics thread */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sensors, meta = (AllowPrivateAccess = "true"))
+	USensorSimWheelEncoderComponent* WheelEncoders;
+
 	/** Cast pointer to the Chaos Vehicle movement component */
 	TObjectPtr<UChaosWheeledVehicleMovementComponent> ChaosVehicleMovement;
 
+	/** Cast pointer to the recordable movement component */
+	TObjectPtr<USensorSimVehicleMovementComponent> SensorSimMovement;
+
 protected:
 
 	/** Steering Action */
@@ -78,6 +108,18 @@ protected:
 	/** Keeps track of which camera is active */
 	bool bFrontCameraActive = false;
 
+	/** Keeps track of the brake lights state for scripted input */
+	bool bBrakeLightsOn = false;
+
+	/** True when running without a viewport. Cameras are left inactive */
+	bool bHeadless = false;
+
+	/** True while the vehicle is held out of the simulation in a pool */
+	bool bParked = false;
+
+	/** Vehicle catalog archetype the vehicle was set up from, or INDEX_NONE for the class defaults */
+	int32 ArchetypeIndex = INDEX_NONE;
+
 public:
 	ASensorSimPawn();
 
@@ -89,10 +131,51 @@ public:
 
 	// Begin Actor interface
 
+	virtual void BeginPlay() override;
 	virtual void Tick(float Delta) override;
 
 	// End Actor interface
 
+	/** Applies a full set of driver inputs, bypassing Enhanced Input. Used for scripted and replayed driving */
+	void ApplyVehicleInput(const FSensorSimVehicleInput& Input);
+
+	/** Captures the pose and Chaos movement state of the vehicle */
+	void SampleState(double Time, FSensorSimVehicleStateSample& OutSample) const;
+
+	/** Teleports the vehicle to rest at a transform, clearing its inputs, drivetrain state and sensor buffers */
+	void RestartVehicle(const FTransform& Transform);
+
+	/**
+	 *  Saves the full simulation state of the vehicle into a compact blob: body pose and velocities, wheel spin,
+	 *  suspension, engine speed, gear and gear change timer, as of the end of the last physics step.
+	 *  Exact with synchronous physics. Returns false before the vehicle's first physics step
+	 */
+	bool SavePhysicsState(TArray<uint8>& OutBlob) const;
+
+	/**
+	 *  Returns the vehicle to a state saved by SavePhysicsState, and clears its sensor buffers. The body is teleported
+	 *  at once, the wheels and drivetrain are restored before the next physics step. Returns false if the blob is not a valid state
+	 */
+	bool RestorePhysicsState(TConstArrayView<uint8> Blob);
+
+	/** Drops every sensor sample in flight or buffered, and restarts the sensor schedules */
+	void ResetSensors();
+
+	/**
+	 *  Takes the vehicle out of the simulation, or puts it back. A parked vehicle keeps its mesh, Chaos simulation
+	 *  and sensors, but is hidden, has no collision, does not simulate or tick, and its sensors do not sample
+	 */
+	void SetParked(bool bInParked);
+
+	/** Returns true while the vehicle is parked */
+	bool IsParked() const { return bParked; }
+
+	/** Sets the vehicle up from a vehicle catalog archetype. Call between a deferred spawn and FinishSpawning, so that BeginPlay sees it */
+	void SetArchetype(int32 InArchetypeIndex);
+
+	/** Returns the vehicle catalog archetype the vehicle was set up from, or INDEX_NONE */
+	int32 GetArchetypeIndex() const { return ArchetypeIndex; }
+
 protected:
 
 	/** Handles steering input */
@@ -134,6 +217,18 @@ public:
 	FORCEINLINE USpringArmComponent* GetBackSpringArm() const { return BackSpringArm; }
 	/** Returns the back camera subobject */
 	FORCEINLINE UCameraComponent* GetBackCamera() const { return BackCamera; }
+	/** Returns the LiDAR ray caster subobject */
+	FORCEINLINE USensorSimLidarComponent* GetLidarScanner() const { return LidarScanner; }
+	/** Returns the front camera sensor subobject */
+	FORCEINLINE USensorSimCameraComponent* GetFrontCameraSensor() const { return FrontCameraSensor; }
+	/** Returns the back camera sensor subobject */
+	FORCEINLINE USensorSimCameraComponent* GetBackCameraSensor() const { return BackCameraSensor; }
+	/** Returns the IMU subobject */
+	FORCEINLINE USensorSimImuComponent* GetImu() const { return Imu; }
+	/** Returns the wheel encoders subobject */
+	FORCEINLINE USensorSimWheelEncoderComponent* GetWheelEncoders() const { return WheelEncoders; }
 	/** Returns the cast Chaos Vehicle Movement subobject */
 	FORCEINLINE const TObjectPtr<UChaosWheeledVehicleMovementComponent>& GetChaosVehicleMovement() const { return ChaosVehicleMovement; }
+	/** Returns the movement subobject, with physics step input record and replay */
+	FORCEINLINE const TObjectPtr<USensorSimVehicleMovementComponent>& GetSensorSimMovement() const { return SensorSimMovement; }
 };
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Forward declarations
+namespace Chaos
+{
+	class FRigidBodyHandle_Internal;
+	class FSimpleWheeledVehicle;
+}
+
+/** State of a vehicle at the start of one physics step */
+struct FSensorSimPhysicsStepContext
+{
+	/** Physics time at the start of the step, in seconds */
+	double Time = 0.0;
+
+	/** Step length, in seconds */
+	float DeltaTime = 0.0f;
+
+	/** Vehicle body */
+	const Chaos::FRigidBodyHandle_Internal* Body = nullptr;
+
+	/** Chaos vehicle, with its wheel states */
+	const Chaos::FSimpleWheeledVehicle* Vehicle = nullptr;
+};
+
+/**
+ *  Physics Sensor
+ *  Sampled by the vehicle simulation on the physics thread, once per physics step.
+ *  Implementations hand their samples to the game thread through a lock-free ring.
+ */
+class ISensorSimPhysicsSensor
+{
+public:
+	virtual ~ISensorSimPhysicsSensor() = default;
+
+	/** Samples the vehicle. Physics thread only */
+	virtual void OnPhysicsStep(const FSensorSimPhysicsStepContext& Context) = 0;
+
+	/** Drops the state carried over from previous steps, after the vehicle was teleported. Physics thread only */
+	virtual void OnReset() {}
+};
@@ -0,0 +1,82 @@
+#include "SensorSimPhysicsState.h"
+#include "SimpleVehicle.h"
+
+namespace SensorSimPhysicsState
+{
+	/** Names the gear change timer, which Chaos keeps protected. Never instantiated */
+	struct FTransmissionAccess : public Chaos::FSimpleTransmissionSim
+	{
+		static float Chaos::FSimpleTransmissionSim::* GearChangeTimeMember() { return &FTransmissionAccess::CurrentGearChangeTime; }
+	};
+}
+
+void FSensorSimVehiclePhysicsState::CaptureVehicle(const Chaos::FSimpleWheeledVehicle& Vehicle)
+{
+	NumWheels = static_cast<uint8>(FMath::Min(Vehicle.Wheels.Num(), SensorSimRecording::MaxWheels));
+
+	for (int32 WheelIndex = 0; WheelIndex < NumWheels; ++WheelIndex)
+	{
+		const Chaos::FSimpleWheelSim& Wheel = Vehicle.Wheels[WheelIndex];
+
+		FSensorSimWheelPhysicsState& WheelState = Wheels[WheelIndex];
+		WheelState.AngularPosition = Wheel.GetAngularPosition();
+		WheelState.AngularVelocity = Wheel.GetAngularVelocity();
+		WheelState.SteeringAngle = Wheel.GetSteeringAngle();
+		WheelState.SpringLength = Vehicle.Suspension.IsValidIndex(WheelIndex) ? Vehicle.Suspension[WheelIndex].GetSpringLength() : 0.0f;
+	}
+
+	if (!Vehicle.Engine.IsEmpty())
+	{
+		EngineRPM = Vehicle.Engine[0].GetEngineRPM();
+	}
+
+	if (!Vehicle.Transmission.IsEmpty())
+	{
+		const Chaos::FSimpleTransmissionSim& Transmission = Vehicle.Transmission[0];
+		CurrentGear = static_cast<int8>(Transmission.GetCurrentGear());
+		TargetGear = static_cast<int8>(Transmission.GetTargetGear());
+		GearChangeTime = Transmission.*SensorSimPhysicsState::FTransmissionAccess::GearChangeTimeMember();
+	}
+}
+
+void FSensorSimVehiclePhysicsState::ApplyVehicle(Chaos::FSimpleWheeledVehicle& Vehicle) const
+{
+	const int32 NumApplied = FMath::Min<int32>(NumWheels, Vehicle.Wheels.Num());
+
+	for (int32 WheelIndex = 0; WheelIndex < NumApplied; ++WheelIndex)
+	{
+		Chaos::FSimpleWheelSim& Wheel = Vehicle.Wheels[WheelIndex];
+
+		const FSensorSimWheelPhysicsState& WheelState = Wheels[WheelIndex];
+		Wheel.SetAngularPosition(WheelState.AngularPosition);
+		Wheel.SetAngularVelocity(WheelState.AngularVelocity);
+		Wheel.SetSteeringAngle(WheelState.SteeringAngle);
+
+		// the suspension is set from the distance to the contact point, the spring plus the wheel
+		if (Vehicle.Suspension.IsValidIndex(WheelIndex))
+		{
+			const float WheelRadius = Wheel.GetEffectiveRadius();
+			Vehicle.Suspension[WheelIndex].SetSuspensionLength(WheelState.SpringLength + WheelRadius, WheelRadius);
+		}
+	}
+
+	bool bOutOfGear = false;
+	if (!Vehicle.Transmission.IsEmpty())
+	{
+		// engage the current gear outright, then resume the change in progress where it was
+		Chaos::FSimpleTransmissionSim& Transmission = Vehicle.Transmission[0];
+		Transmission.SetGear(CurrentGear, true);
+		if (TargetGear != CurrentGear)
+		{
+			Transmission.SetGear(TargetGear, false);
+		}
+		Transmission.*SensorSimPhysicsState::FTransmissionAccess::GearChangeTimeMember() = GearChangeTime;
+
+		bOutOfGear = Transmission.IsOutOfGear();
+	}
+
+	if (!Vehicle.Engine.IsEmpty())
+	{
+		Vehicle.Engine[0].SetEngineRPM(bOutOfGear, EngineRPM);
+	}
+}
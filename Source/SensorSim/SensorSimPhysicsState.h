@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimRecording.h"
+
+// Forward declarations
+namespace Chaos
+{
+	class FSimpleWheeledVehicle;
+}
+
+namespace SensorSimPhysicsState
+{
+	/** Bumped whenever FSensorSimVehiclePhysicsState changes, so that stale blobs are rejected */
+	constexpr uint16 Version = 1;
+}
+
+/** Chaos state of one wheel and its suspension */
+struct FSensorSimWheelPhysicsState
+{
+	/** Wheel rotation, in radians */
+	float AngularPosition = 0.0f;
+
+	/** Wheel spin, in rad/s */
+	float AngularVelocity = 0.0f;
+
+	/** Suspension spring length, in cm */
+	float SpringLength = 0.0f;
+
+	/** Steering angle, in degrees */
+	float SteeringAngle = 0.0f;
+};
+
+/**
+ *  Full simulation state of a vehicle at the end of a physics step
+ *  Stored as a compact blob of this exact layout, so that saving and restoring are plain copies.
+ *  The body is captured on the game thread; wheels, suspension, engine and transmission on the physics thread.
+ */
+struct FSensorSimVehiclePhysicsState
+{
+	uint16 Version = SensorSimPhysicsState::Version;
+
+	/** Number of valid wheel entries */
+	uint8 NumWheels = 0;
+
+	/** Gear engaged, negative for reverse */
+	int8 CurrentGear = 0;
+
+	/** Gear being changed to */
+	int8 TargetGear = 0;
+
+	uint8 Reserved0 = 0;
+	uint16 Reserved1 = 0;
+
+	/** Seconds left of the gear change in progress, during which no torque reaches the wheels */
+	float GearChangeTime = 0.0f;
+
+	/** Engine speed, in RPM */
+	float EngineRPM = 0.0f;
+
+	/** Body world location, in cm */
+	FVector3d Location = FVector3d::ZeroVector;
+
+	/** Pads Rotation to its 16 byte alignment */
+	uint64 Reserved2 = 0;
+
+	/** Body world rotation */
+	FQuat4f Rotation = FQuat4f::Identity;
+
+	/** Body linear velocity, in cm/s */
+	FVector3f LinearVelocity = FVector3f::ZeroVector;
+
+	/** Body angular velocity, in rad/s */
+	FVector3f AngularVelocity = FVector3f::ZeroVector;
+
+	/** Wheel states, front left first */
+	FSensorSimWheelPhysicsState Wheels[SensorSimRecording::MaxWheels];
+
+	/** Pads the state to a multiple of the Rotation alignment */
+	uint64 Reserved3 = 0;
+
+	/** Copies the wheel, suspension, engine and transmission state out of a Chaos vehicle. Physics thread only */
+	void CaptureVehicle(const Chaos::FSimpleWheeledVehicle& Vehicle);
+
+	/** Writes the wheel, suspension, engine and transmission state into a Chaos vehicle. Physics thread only */
+	void ApplyVehicle(Chaos::FSimpleWheeledVehicle& Vehicle) const;
+};
+
+static_assert(offsetof(FSensorSimVehiclePhysicsState, Location) == 16 && offsetof(FSensorSimVehiclePhysicsState, Rotation) == 48
+	&& offsetof(FSensorSimVehiclePhysicsState, Wheels) == 88 && sizeof(FSensorSimVehiclePhysicsState) == 160, "Vehicle physics state layout changed");
+static_assert(TIsTriviallyCopyAssignable<FSensorSimVehiclePhysicsState>::Value, "Vehicle physics states are saved with memcpy");
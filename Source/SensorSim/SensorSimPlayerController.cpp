@@ -2,14 +2,23 @@
 
 
 #include "SensorSimPlayerController.h"
+#include "SensorSim.h"
 #include "SensorSimPawn.h"
 #include "SensorSimUI.h"
 #include "EnhancedInputSubsystems.h"
 #include "ChaosWheeledVehicleMovementComponent.h"
+#include "TimerManager.h"
 
 void ASensorSimPlayerController::BeginPlay()
 {
 	Super::BeginPlay();
+
+#if SENSORSIM_WITH_HUD
+	// there is no viewport to add the UI to on render-less runs
+	if (!FApp::CanEverRender())
+	{
+		return;
+	}
 	
 	// spawn the UI widget and add it to the viewport
 	VehicleUI = CreateWidget<USensorSimUI>(this, VehicleUIClass);
@@ -17,6 +26,10 @@ void ASensorSimPlayerController::BeginPlay()
 	check(VehicleUI);
 
 	VehicleUI->AddToViewport();
+
+	// sample the vehicle on a timer rather than every frame
+	GetWorldTimerManager().SetTimer(HudUpdateTimer, this, &ASensorSimPlayerController::UpdateHud, 1.0f / FMath::Max(HudUpdateRate, 1.0f), true);
+#endif
 }
 
 void ASensorSimPlayerController::SetupInputComponent()
@@ -37,21 +50,32 @@ void ASensorSimPlayerController::SetupInputComponent()
 	}
 }
 
-void ASensorSimPlayerController::Tick(float Delta)
+void ASensorSimPlayerController::OnPossess(APawn* InPawn)
 {
-	Super::Tick(Delta);
+	Super::OnPossess(InPawn);
 
-	if (IsValid(VehiclePawn) && IsValid(VehicleUI))
+	// get a pointer to the controlled pawn
+	VehiclePawn = CastChecked<ASensorSimPawn>(InPawn);
+
+#if SENSORSIM_WITH_HUD
+	// show the new vehicle's values right away
+	if (IsValid(VehicleUI))
 	{
-		VehicleUI->UpdateSpeed(VehiclePawn->GetChaosVehicleMovement()->GetForwardSpeed());
-		VehicleUI->UpdateGear(VehiclePawn->GetChaosVehicleMovement()->GetCurrentGear());
+		VehicleUI->ResetDisplay();
+		UpdateHud();
 	}
+#endif
 }
 
-void ASensorSimPlayerController::OnPossess(APawn* InPawn)
+void ASensorSimPlayerController::UpdateHud()
 {
-	Super::OnPossess(InPawn);
+#if SENSORSIM_WITH_HUD
+	if (IsValid(VehiclePawn) && IsValid(VehicleUI))
+	{
+		SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimHudUpdate);
 
-	// get a pointer to the controlled pawn
-	VehiclePawn = CastChecked<ASensorSimPawn>(InPawn);
+		VehicleUI->UpdateSpeed(VehiclePawn->GetChaosVehicleMovement()->GetForwardSpeed());
+		VehicleUI->UpdateGear(VehiclePawn->GetChaosVehicleMovement()->GetCurrentGear());
+	}
+#endif
 }
@@ -46,7 +46,12 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = UI)
 	TObjectPtr<USensorSimUI> VehicleUI;
 
-	
+	/** Times per second the UI samples the vehicle. The widget itself only updates when a displayed value changes */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = UI, meta = (ClampMin = "1.0"))
+	float HudUpdateRate = 10.0f;
+
+	/** Samples the vehicle for the UI at HudUpdateRate */
+	FTimerHandle HudUpdateTimer;
 
 	// Begin Actor interface
 protected:
@@ -54,10 +59,6 @@ protected:
 	virtual void BeginPlay() override;
 	virtual void SetupInputComponent() override;
 
-public:
-
-	virtual void Tick(float Delta) override;
-
 	// End Actor interface
 
 	// Begin PlayerController interface
@@ -66,4 +67,7 @@ protected:
 	virtual void OnPossess(APawn* InPawn) override;
 
 	// End PlayerController interface
+
+	/** Passes the vehicle speed and gear on to the UI */
+	void UpdateHud();
 };
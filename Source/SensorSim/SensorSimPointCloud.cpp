@@ -0,0 +1,73 @@
+#include "SensorSimPointCloud.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+FSensorSimPointCloudFrame::FSensorSimPointCloudFrame(int32 InCapacity)
+{
+	X.SetNumUninitialized(InCapacity);
+	Y.SetNumUninitialized(InCapacity);
+	Z.SetNumUninitialized(InCapacity);
+	Intensity.SetNumUninitialized(InCapacity);
+	Ring.SetNumUninitialized(InCapacity);
+	Timestamp.SetNumUninitialized(InCapacity);
+	SemanticClass.SetNumUninitialized(InCapacity);
+	Instance.SetNumUninitialized(InCapacity);
+}
+
+SIZE_T FSensorSimPointCloudFrame::GetPointBytes() const
+{
+	return NumPoints * SensorSimPointBytes;
+}
+
+TSharedRef<FSensorSimPointCloudPool, ESPMode::ThreadSafe> FSensorSimPointCloudPool::Create(int32 NumFrames, int32 Capacity)
+{
+	TSharedRef<FSensorSimPointCloudPool, ESPMode::ThreadSafe> Pool = MakeShareable(new FSensorSimPointCloudPool(Capacity));
+
+	Pool->Frames.Reserve(NumFrames);
+	for (int32 Index = 0; Index < NumFrames; ++Index)
+	{
+		Pool->Frames.Add(MakeShared<FSensorSimPointCloudFrame, ESPMode::ThreadSafe>(Capacity));
+	}
+
+	return Pool;
+}
+
+FSensorSimPointCloudPool::FSensorSimPointCloudPool(int32 InCapacity)
+	: Capacity{ InCapacity }
+{
+}
+
+FSensorSimPointCloudFramePtr FSensorSimPointCloudPool::Acquire()
+{
+	FScopeLock Lock(&AcquireLock);
+
+	// cycle the frames as a ring, skipping the ones consumers still hold
+	for (int32 Step = 0; Step < Frames.Num(); ++Step)
+	{
+		const int32 Index = (NextFrame + Step) % Frames.Num();
+		const FSensorSimPointCloudFramePtr& Frame = Frames[Index];
+
+		// only the pool can hand out new references, so a frame it holds alone stays free
+		if (Frame.IsUnique())
+		{
+			// the last consumer may have let go on another thread; its reads come before the frame is refilled
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			NextFrame = (Index + 1) % Frames.Num();
+			Frame->NumPoints = 0;
+			return Frame;
+		}
+	}
+
+	return nullptr;
+}
+
+int32 FSensorSimPointCloudPool::GetNumFree() const
+{
+	int32 NumFree = 0;
+	for (const FSensorSimPointCloudFramePtr& Frame : Frames)
+	{
+		NumFree += Frame.IsUnique() ? 1 : 0;
+	}
+	return NumFree;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+
+/** Bytes stored per point across the arrays of a frame */
+constexpr SIZE_T SensorSimPointBytes = 5 * sizeof(float) + sizeof(uint16) + sizeof(uint8) + sizeof(uint32);
+
+/**
+ *  One LiDAR sweep, stored as a structure of arrays
+ *  The arrays are allocated once to the frame's capacity and never grow;
+ *  only the first NumPoints entries of each are valid.
+ */
+struct SENSORSIM_API FSensorSimPointCloudFrame
+{
+	/** Point coordinates in the sensor frame, in cm */
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+
+	/** Return intensity, 0 to 1 */
+	TArray<float> Intensity;
+
+	/** Channel (laser) index of each point */
+	TArray<uint16> Ring;
+
+	/** Firing time of each point, in seconds relative to SweepTime */
+	TArray<float> Timestamp;
+
+	/** Ground truth ESensorSimSemanticClass of the surface each point hit */
+	TArray<uint8> SemanticClass;
+
+	/** Ground truth instance of the actor each point hit, 0 if unlabeled */
+	TArray<uint32> Instance;
+
+	/** Number of valid points */
+	int32 NumPoints = 0;
+
+	/** World time at which the sweep started */
+	double SweepTime = 0.0;
+
+	/** Sweep counter of the producing sensor */
+	uint32 Sequence = 0;
+
+	/** Sensor pose at the start of the sweep */
+	FTransform SensorTransform;
+
+	/** Allocates every array to the given capacity */
+	explicit FSensorSimPointCloudFrame(int32 InCapacity);
+
+	/** Returns the number of points the frame can hold */
+	int32 GetCapacity() const { return X.Num(); }
+
+	/** Returns the number of valid points */
+	int32 Num() const { return NumPoints; }
+
+	/** Returns the position of a point in the sensor frame */
+	FVector3f GetPoint(int32 Index) const { return FVector3f(X[Index], Y[Index], Z[Index]); }
+
+	/** Returns the bytes produced by the valid points */
+	SIZE_T GetPointBytes() const;
+};
+
+/** Writable frame, held by the producing sensor while it fills it */
+using FSensorSimPointCloudFramePtr = TSharedPtr<FSensorSimPointCloudFrame, ESPMode::ThreadSafe>;
+
+/** Read-only, ref-counted view of a published frame. The frame returns to its pool once the last view is released */
+using FSensorSimPointCloudRef = TSharedRef<const FSensorSimPointCloudFrame, ESPMode::ThreadSafe>;
+
+/**
+ *  Point Cloud Frame Pool
+ *  A fixed ring of preallocated frames shared by one sensor and its consumers.
+ *  The pool keeps a reference to every frame; a frame is free again once the pool's reference is the last one,
+ *  whichever thread released the others. Frames and their reference counts are allocated once, by Create,
+ *  so Acquire never allocates; it fails when every frame is still referenced.
+ */
+class SENSORSIM_API FSensorSimPointCloudPool
+{
+public:
+	/** Creates a pool of NumFrames frames of the given capacity */
+	static TSharedRef<FSensorSimPointCloudPool, ESPMode::ThreadSafe> Create(int32 NumFrames, int32 Capacity);
+
+	/** Takes a free frame out of the pool, or returns null if all of them are in use */
+	FSensorSimPointCloudFramePtr Acquire();
+
+	/** Returns the capacity of the pooled frames */
+	int32 GetCapacity() const { return Capacity; }
+
+	/** Returns the number of frames currently free */
+	int32 GetNumFree() const;
+
+private:
+	FSensorSimPointCloudPool(int32 InCapacity);
+
+	/** Guards the ring cursor, so that two threads never take the same free frame */
+	mutable FCriticalSection AcquireLock;
+
+	/** Every frame of the pool, fixed after Create */
+	TArray<FSensorSimPointCloudFramePtr> Frames;
+
+	/** Frame the next Acquire looks at first, so that frames are reused in ring order */
+	int32 NextFrame = 0;
+
+	/** Capacity of the pooled frames */
+	int32 Capacity = 0;
+};
@@ -0,0 +1,273 @@
+#include "SensorSimPublisherSubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimPawn.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimImuComponent.h"
+#include "SensorSimSharedMemory.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdPublishStart(
+	TEXT("SensorSim.Publish.Start"),
+	TEXT("Publishes every vehicle's point clouds, IMU and odometry to shared memory"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimPublisherSubsystem* Publisher = World ? World->GetSubsystem<USensorSimPublisherSubsystem>() : nullptr)
+		{
+			Publisher->StartPublishing();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdPublishStop(
+	TEXT("SensorSim.Publish.Stop"),
+	TEXT("Stops publishing and removes the shared memory segments"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimPublisherSubsystem* Publisher = World ? World->GetSubsystem<USensorSimPublisherSubsystem>() : nullptr)
+		{
+			Publisher->StopPublishing();
+		}
+	}));
+
+/**
+ *  Unreal to ROS conversions
+ *  Unreal is left handed, x forward, y right, z up, in cm. ROS is right handed, x forward, y left, z up, in m.
+ *  Mirroring y flips positions and directions along y, and rotations about x and z.
+ */
+namespace SensorSimRos
+{
+	template<typename VectorType>
+	void ConvertDirection(const VectorType& Vector, double Out[3], double Scale = 1.0)
+	{
+		Out[0] = Vector.X * Scale;
+		Out[1] = -Vector.Y * Scale;
+		Out[2] = Vector.Z * Scale;
+	}
+
+	template<typename VectorType>
+	void ConvertAngularVelocity(const VectorType& AngularVelocity, double Out[3])
+	{
+		Out[0] = -AngularVelocity.X;
+		Out[1] = AngularVelocity.Y;
+		Out[2] = -AngularVelocity.Z;
+	}
+
+	template<typename QuatType>
+	void ConvertRotation(const QuatType& Rotation, double Out[4])
+	{
+		Out[0] = -Rotation.X;
+		Out[1] = Rotation.Y;
+		Out[2] = -Rotation.Z;
+		Out[3] = Rotation.W;
+	}
+
+	/** Point cloud fields, laid out as FSensorSimShmPoint */
+	TArray<FSensorSimShmPointField, TFixedAllocator<SensorSimSharedMemory::MaxPointFields>> MakePointFields()
+	{
+		TArray<FSensorSimShmPointField, TFixedAllocator<SensorSimSharedMemory::MaxPointFields>> Fields;
+
+		auto AddField = [&Fields](const ANSICHAR* Name, uint32 Offset, uint8 Datatype)
+		{
+			FSensorSimShmPointField& Field = Fields.AddDefaulted_GetRef();
+			FCStringAnsi::Strncpy(Field.Name, Name, UE_ARRAY_COUNT(Field.Name));
+			Field.Offset = Offset;
+			Field.Datatype = Datatype;
+		};
+
+		AddField("x", STRUCT_OFFSET(FSensorSimShmPoint, X), SensorSimSharedMemory::Float32);
+		AddField("y", STRUCT_OFFSET(FSensorSimShmPoint, Y), SensorSimSharedMemory::Float32);
+		AddField("z", STRUCT_OFFSET(FSensorSimShmPoint, Z), SensorSimSharedMemory::Float32);
+		AddField("intensity", STRUCT_OFFSET(FSensorSimShmPoint, Intensity), SensorSimSharedMemory::Float32);
+		AddField("ring", STRUCT_OFFSET(FSensorSimShmPoint, Ring), SensorSimSharedMemory::UInt16);
+		AddField("time", STRUCT_OFFSET(FSensorSimShmPoint, Time), SensorSimSharedMemory::Float32);
+		AddField("label", STRUCT_OFFSET(FSensorSimShmPoint, Label), SensorSimSharedMemory::UInt8);
+		AddField("instance", STRUCT_OFFSET(FSensorSimShmPoint, Instance), SensorSimSharedMemory::UInt32);
+
+		return Fields;
+	}
+
+	/** Writes a sweep into the next slot of a point cloud segment, one pass over the frame */
+	void WritePointCloud(FSensorSimShmWriter& Writer, const FSensorSimPointCloudFrame& Frame)
+	{
+		SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimPublish);
+
+		FSensorSimShmPoint* Points = reinterpret_cast<FSensorSimShmPoint*>(Writer.BeginWrite());
+		const int32 NumPoints = FMath::Min<int32>(Frame.Num(), Writer.GetDataCapacity() / sizeof(FSensorSimShmPoint));
+
+		for (int32 Index = 0; Index < NumPoints; ++Index)
+		{
+			FSensorSimShmPoint& Point = Points[Index];
+			Point.X = Frame.X[Index] * 0.01f;
+			Point.Y = -Frame.Y[Index] * 0.01f;
+			Point.Z = Frame.Z[Index] * 0.01f;
+			Point.Intensity = Frame.Intensity[Index];
+			Point.Ring = Frame.Ring[Index];
+			Point.Time = Frame.Timestamp[Index];
+			Point.Label = Frame.SemanticClass[Index];
+			Point.Instance = Frame.Instance[Index];
+		}
+
+		Writer.EndWrite(Frame.SweepTime, NumPoints * sizeof(FSensorSimShmPoint), NumPoints);
+	}
+}
+
+void USensorSimPublisherSubsystem::StartPublishing()
+{
+	if (IsPublishing())
+	{
+		return;
+	}
+
+	bPublishing = true;
+
+	for (TActorIterator<ASensorSimPawn> It(GetWorld()); It; ++It)
+	{
+		PublishVehicle(*It);
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("Publishing %d vehicles to shared memory as %s_<Stream>_*"), Vehicles.Num(), *SegmentPrefix);
+}
+
+void USensorSimPublisherSubsystem::StopPublishing()
+{
+	if (!IsPublishing())
+	{
+		return;
+	}
+
+	for (FSensorSimPublishedVehicle& Vehicle : Vehicles)
+	{
+		if (ASensorSimPawn* Pawn = Vehicle.Pawn.Get())
+		{
+			Pawn->GetLidarScanner()->OnSweep.Remove(Vehicle.SweepHandle);
+			Pawn->GetImu()->OnSamples.Remove(Vehicle.ImuHandle);
+		}
+
+		// the writers are closed by whichever of the subsystem and the last write lets go of them last
+		Vehicle.PointsTask.Wait();
+	}
+
+	Vehicles.Reset();
+	bPublishing = false;
+}
+
+void USensorSimPublisherSubsystem::PublishVehicle(ASensorSimPawn* Pawn)
+{
+	if (!IsPublishing() || !Pawn || Vehicles.ContainsByPredicate([Pawn](const FSensorSimPublishedVehicle& Vehicle) { return Vehicle.Pawn == Pawn; }))
+	{
+		return;
+	}
+
+	// vehicles stay listed until publishing stops, so segment names are never reused by another vehicle
+	const uint16 StreamId = static_cast<uint16>(Vehicles.Num());
+	const FString FrameId = FString::Printf(TEXT("%s_%d"), *SegmentPrefix, StreamId);
+
+	FSensorSimPublishedVehicle& Vehicle = Vehicles.AddDefaulted_GetRef();
+	Vehicle.Pawn = Pawn;
+	Vehicle.StreamId = StreamId;
+
+	Vehicle.Points = MakeShared<FSensorSimShmWriter, ESPMode::ThreadSafe>();
+	Vehicle.Imu = MakeShared<FSensorSimShmWriter, ESPMode::ThreadSafe>();
+	Vehicle.Odometry = MakeShared<FSensorSimShmWriter, ESPMode::ThreadSafe>();
+
+	// slots hold as many points as a pooled frame, second returns included
+	const uint32 PointCapacity = Pawn->GetLidarScanner()->GetMaxPointsPerSweep() * sizeof(FSensorSimShmPoint);
+
+	if (!Vehicle.Points->Open(GetSegmentName(SegmentPrefix, StreamId, TEXT("points")), ESensorSimShmKind::PointCloud2, PointCloudSlots, PointCapacity,
+			FrameId + TEXT("/lidar"), SensorSimRos::MakePointFields(), sizeof(FSensorSimShmPoint))
+		|| !Vehicle.Imu->Open(GetSegmentName(SegmentPrefix, StreamId, TEXT("imu")), ESensorSimShmKind::Imu, ImuSlots, sizeof(FSensorSimShmImu), FrameId + TEXT("/imu"))
+		|| !Vehicle.Odometry->Open(GetSegmentName(SegmentPrefix, StreamId, TEXT("odom")), ESensorSimShmKind::Odometry, OdometrySlots, sizeof(FSensorSimShmOdometry), TEXT("map")))
+	{
+		Vehicles.Pop();
+		return;
+	}
+
+	// sweeps are converted on the task graph, in order, while the published frame is held by reference
+	Vehicle.SweepHandle = Pawn->GetLidarScanner()->OnSweep.AddWeakLambda(this, [this, StreamId](const FSensorSimPointCloudRef& Frame)
+	{
+		FSensorSimPublishedVehicle& PublishedVehicle = Vehicles[StreamId];
+		PublishedVehicle.PointsTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Writer = PublishedVehicle.Points, Frame]()
+		{
+			SensorSimRos::WritePointCloud(*Writer, *Frame);
+		}, UE::Tasks::Prerequisites(PublishedVehicle.PointsTask));
+	});
+
+	Vehicle.ImuHandle = Pawn->GetImu()->OnSamples.AddWeakLambda(this, [Writer = Vehicle.Imu](TConstArrayView<FSensorSimImuSample> Samples)
+	{
+		for (const FSensorSimImuSample& Sample : Samples)
+		{
+			FSensorSimShmImu Message;
+			SensorSimRos::ConvertRotation(Sample.Orientation, Message.Orientation);
+			SensorSimRos::ConvertAngularVelocity(Sample.AngularVelocity, Message.AngularVelocity);
+			SensorSimRos::ConvertDirection(Sample.LinearAcceleration, Message.LinearAcceleration);
+
+			Writer->Write(Sample.Time, Message);
+		}
+	});
+}
+
+FString USensorSimPublisherSubsystem::GetSegmentName(const FString& Prefix, int32 StreamId, const TCHAR* Topic)
+{
+	return FString::Printf(TEXT("%s_%d_%s"), *Prefix, StreamId, Topic);
+}
+
+void USensorSimPublisherSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bCheckedCommandLine)
+	{
+		bCheckedCommandLine = true;
+
+		// start once every level actor has begun play
+		if (FParse::Param(FCommandLine::Get(), TEXT("SensorSimPublish")))
+		{
+			StartPublishing();
+		}
+	}
+
+	if (!IsPublishing())
+	{
+		return;
+	}
+
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+
+	// odometry is published once per frame, from the same state the recordings sample
+	for (const FSensorSimPublishedVehicle& Vehicle : Vehicles)
+	{
+		const ASensorSimPawn* Pawn = Vehicle.Pawn.Get();
+		if (Pawn && !Pawn->IsParked())
+		{
+			FSensorSimVehicleStateSample State;
+			Pawn->SampleState(WorldTime, State);
+
+			FSensorSimShmOdometry Message;
+			SensorSimRos::ConvertDirection(State.Location, Message.Position, 0.01);
+			SensorSimRos::ConvertRotation(State.Rotation, Message.Orientation);
+			SensorSimRos::ConvertDirection(State.Rotation.UnrotateVector(State.LinearVelocity), Message.LinearVelocity, 0.01);
+			SensorSimRos::ConvertAngularVelocity(FMath::DegreesToRadians(State.Rotation.UnrotateVector(State.AngularVelocity)), Message.AngularVelocity);
+
+			Vehicle.Odometry->Write(WorldTime, Message);
+		}
+	}
+}
+
+TStatId USensorSimPublisherSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USensorSimPublisherSubsystem, STATGROUP_Tickables);
+}
+
+void USensorSimPublisherSubsystem::Deinitialize()
+{
+	StopPublishing();
+
+	Super::Deinitialize();
+}
+
+bool USensorSimPublisherSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
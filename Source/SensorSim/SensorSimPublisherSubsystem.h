@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "SensorSimPublisherSubsystem.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+class FSensorSimShmWriter;
+
+/**
+ *  Published vehicle bookkeeping
+ *  One set of shared memory segments per vehicle: point clouds, IMU and odometry.
+ */
+USTRUCT()
+struct FSensorSimPublishedVehicle
+{
+	GENERATED_BODY()
+
+	/** Published vehicle */
+	TWeakObjectPtr<ASensorSimPawn> Pawn;
+
+	/** Stream the vehicle's segments are named after */
+	uint16 StreamId{ 0 };
+
+	/** Binding to the vehicle's LiDAR sweeps */
+	FDelegateHandle SweepHandle;
+
+	/** Binding to the vehicle's IMU samples */
+	FDelegateHandle ImuHandle;
+
+	/** Point cloud segment, written from the task graph */
+	TSharedPtr<FSensorSimShmWriter, ESPMode::ThreadSafe> Points;
+
+	/** IMU segment, written on the game thread */
+	TSharedPtr<FSensorSimShmWriter, ESPMode::ThreadSafe> Imu;
+
+	/** Odometry segment, written on the game thread */
+	TSharedPtr<FSensorSimShmWriter, ESPMode::ThreadSafe> Odometry;
+
+	/** Last point cloud write, which the next one waits on */
+	UE::Tasks::FTask PointsTask;
+};
+
+/**
+ *  Publisher Subsystem
+ *  Publishes every vehicle's point clouds, IMU samples and odometry to co-located processes
+ *  through named shared memory segments (see SensorSimSharedMemory.h), in ROS message layouts.
+ *  Sweeps are written straight from the pooled frames into the segment slots on the task graph;
+ *  readers map the slots and read them in place, with no serialization on either side.
+ *
+ *  Segments are named <SegmentPrefix>_<Stream>_points, _imu and _odom.
+ *
+ *  Console commands:
+ *    SensorSim.Publish.Start
+ *    SensorSim.Publish.Stop
+ *
+ *  Command line:
+ *    -SensorSimPublish    publishes from the first frame
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimPublisherSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Prefix of the segment names */
+	UPROPERTY(Config)
+	FString SegmentPrefix{ TEXT("SensorSim") };
+
+	/** Point clouds a reader may fall behind by */
+	UPROPERTY(Config)
+	int32 PointCloudSlots{ 4 };
+
+	/** IMU samples a reader may fall behind by */
+	UPROPERTY(Config)
+	int32 ImuSlots{ 256 };
+
+	/** Odometry messages a reader may fall behind by */
+	UPROPERTY(Config)
+	int32 OdometrySlots{ 64 };
+
+	/** Published vehicles */
+	UPROPERTY(Transient)
+	TArray<FSensorSimPublishedVehicle> Vehicles;
+
+	/** True between StartPublishing and StopPublishing */
+	bool bPublishing{ false };
+
+	/** True once the command line has been checked for -SensorSimPublish */
+	bool bCheckedCommandLine{ false };
+
+public:
+	/** Starts publishing every vehicle in the world */
+	void StartPublishing();
+
+	/** Waits for the writes in flight and removes every segment */
+	void StopPublishing();
+
+	/** Returns true while publishing */
+	bool IsPublishing() const { return bPublishing; }
+
+	/** Adds a vehicle spawned after publishing started */
+	void PublishVehicle(ASensorSimPawn* Pawn);
+
+	/** Returns the name of one of a stream's segments */
+	static FString GetSegmentName(const FString& Prefix, int32 StreamId, const TCHAR* Topic);
+
+	// Begin TickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End TickableWorldSubsystem interface
+
+	// Begin WorldSubsystem interface
+	virtual void Deinitialize() override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+};
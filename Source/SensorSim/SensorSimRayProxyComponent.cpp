@@ -0,0 +1,67 @@
+#include "SensorSimRayProxyComponent.h"
+#include "SensorSim.h"
+#include "PhysicsEngine/BodySetup.h"
+
+USensorSimRayProxyComponent::USensorSimRayProxyComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// never drawn, never simulated; only sensor rays see the proxy
+	SetMobility(EComponentMobility::Static);
+	SetHiddenInGame(true);
+	SetCastShadow(false);
+	SetCanEverAffectNavigation(false);
+	SetGenerateOverlapEvents(false);
+
+	SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	SetCollisionObjectType(ECC_WorldStatic);
+	SetCollisionResponseToAllChannels(ECR_Ignore);
+	SetCollisionResponseToChannel(ECC_SensorRay, ECR_Block);
+}
+
+void USensorSimRayProxyComponent::SetGeometry(TArray<FVector3f>&& InVertices, TArray<FTriIndices>&& InTriangles)
+{
+	Vertices = MoveTemp(InVertices);
+	Triangles = MoveTemp(InTriangles);
+
+	LocalBounds = FBox(ForceInit);
+	for (const FVector3f& Vertex : Vertices)
+	{
+		LocalBounds += FVector(Vertex);
+	}
+
+	// the triangles are the collision: rays test them directly, both sides
+	ProxyBodySetup = NewObject<UBodySetup>(this, NAME_None, RF_Transient);
+	ProxyBodySetup->BodySetupGuid = FGuid::NewGuid();
+	ProxyBodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
+	ProxyBodySetup->bDoubleSidedGeometry = true;
+	ProxyBodySetup->bGenerateMirroredCollision = false;
+	ProxyBodySetup->CreatePhysicsMeshes();
+
+	UpdateBounds();
+}
+
+bool USensorSimRayProxyComponent::GetPhysicsTriMeshData(FTriMeshCollisionData* CollisionData, bool InUseAllTriData)
+{
+	CollisionData->Vertices = Vertices;
+	CollisionData->Indices = Triangles;
+	CollisionData->bFlipNormals = false;
+	CollisionData->bDeformableMesh = false;
+
+	return !Triangles.IsEmpty();
+}
+
+bool USensorSimRayProxyComponent::ContainsPhysicsTriMeshData(bool InUseAllTriData) const
+{
+	return !Triangles.IsEmpty();
+}
+
+FBoxSphereBounds USensorSimRayProxyComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if (!LocalBounds.IsValid)
+	{
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0);
+	}
+
+	return FBoxSphereBounds(LocalBounds).TransformBy(LocalToWorld);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "SensorSimLabels.h"
+#include "SensorSimRayProxyComponent.generated.h"
+
+// Forward declarations
+class UBodySetup;
+
+/**
+ *  Ray Proxy Component
+ *  Invisible, query-only triangle mesh answering the SensorRay trace channel in place of static level geometry.
+ *  Its collision is cooked at runtime from the merged, simplified triangles of a region of the level,
+ *  so sensor rays test one compact mesh per region instead of every piece's full complex collision.
+ */
+UCLASS(ClassGroup = (SensorSim), NotBlueprintable)
+class SENSORSIM_API USensorSimRayProxyComponent : public UPrimitiveComponent, public IInterface_CollisionDataProvider
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimRayProxyComponent();
+
+protected:
+	/** Collision cooked from the proxy triangles */
+	UPROPERTY(Transient)
+	TObjectPtr<UBodySetup> ProxyBodySetup{ nullptr };
+
+	/** Vertices, relative to the component */
+	TArray<FVector3f> Vertices;
+
+	/** Triangles, indexing Vertices */
+	TArray<FTriIndices> Triangles;
+
+	/** Bounds of the vertices, relative to the component */
+	FBox LocalBounds{ ForceInit };
+
+	/** Class shared by every mesh the proxy stands in for, None if they differ */
+	ESensorSimSemanticClass SemanticClass{ ESensorSimSemanticClass::None };
+
+public:
+	/** Replaces the proxy geometry and cooks its collision. Call before registering the component */
+	void SetGeometry(TArray<FVector3f>&& InVertices, TArray<FTriIndices>&& InTriangles);
+
+	/** Returns the number of proxy triangles */
+	int32 GetNumTriangles() const { return Triangles.Num(); }
+
+	/** Sets the class hits on the proxy are labeled with. Call before registering the component */
+	void SetSemanticClass(ESensorSimSemanticClass InClass) { SemanticClass = InClass; }
+
+	/** Returns the class hits on the proxy are labeled with */
+	ESensorSimSemanticClass GetSemanticClass() const { return SemanticClass; }
+
+	// Begin Interface_CollisionDataProvider interface
+	virtual bool GetPhysicsTriMeshData(FTriMeshCollisionData* CollisionData, bool InUseAllTriData) override;
+	virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override;
+	virtual bool WantsNegXTriMesh() override { return false; }
+	// End Interface_CollisionDataProvider interface
+
+	// Begin PrimitiveComponent interface
+	virtual UBodySetup* GetBodySetup() override { return ProxyBodySetup; }
+	// End PrimitiveComponent interface
+
+	// Begin SceneComponent interface
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+	// End SceneComponent interface
+};
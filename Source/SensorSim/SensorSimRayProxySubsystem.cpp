@@ -0,0 +1,451 @@
+#include "SensorSimRayProxySubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimRayProxyComponent.h"
+#include "SensorSimLabelSubsystem.h"
+#include "SensorSimSensorSubsystem.h"
+#include "SensorSimStaticScene.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Chaos/TriangleMeshImplicitObject.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Templates/Function.h"
+#include "TimerManager.h"
+
+namespace SensorSimRayProxy
+{
+	/** Simplified triangles of one grid cell, before cooking */
+	struct FCellBuilder
+	{
+		/** World position the cell's vertices are relative to */
+		FVector Origin = FVector::ZeroVector;
+
+		/** Vertex of every occupied cluster */
+		TMap<FIntVector, int32> ClusterVertices;
+
+		TArray<FVector3f> Vertices;
+		TArray<FTriIndices> Triangles;
+
+		/** Static scene source of each triangle, and of the triangles being added */
+		TArray<int32> TriangleSources;
+		int32 Source = INDEX_NONE;
+
+		/** Returns the vertex the cluster of a world position collapses to */
+		int32 AddVertex(const FVector& Position, float ClusterSize)
+		{
+			const FIntVector Cluster(
+				FMath::RoundToInt(Position.X / ClusterSize),
+				FMath::RoundToInt(Position.Y / ClusterSize),
+				FMath::RoundToInt(Position.Z / ClusterSize));
+
+			if (const int32* Existing = ClusterVertices.Find(Cluster))
+			{
+				return *Existing;
+			}
+
+			const int32 Index = Vertices.Add(FVector3f(FVector(Cluster) * ClusterSize - Origin));
+			ClusterVertices.Add(Cluster, Index);
+			return Index;
+		}
+
+		/** Adds a triangle between three vertices, unless it collapsed to a line or a point */
+		void AddTriangle(int32 V0, int32 V1, int32 V2)
+		{
+			if (V0 != V1 && V1 != V2 && V2 != V0)
+			{
+				FTriIndices& Triangle = Triangles.AddDefaulted_GetRef();
+				Triangle.v0 = V0;
+				Triangle.v1 = V1;
+				Triangle.v2 = V2;
+
+				TriangleSources.Add(Source);
+			}
+		}
+
+		/** Adds the triangles of a Chaos triangle mesh placed in the world. Returns the number of source triangles */
+		template<typename IndexType>
+		int32 AddTriangles(const Chaos::FTriangleMeshImplicitObject::ParticlesType& Particles, const TArray<Chaos::TVec3<IndexType>>& Elements,
+			const FTransform& Transform, float ClusterSize)
+		{
+			for (const Chaos::TVec3<IndexType>& Element : Elements)
+			{
+				// triangles smaller than a cluster collapse away
+				AddTriangle(
+					AddVertex(Transform.TransformPosition(FVector(Particles.GetX(Element[0]))), ClusterSize),
+					AddVertex(Transform.TransformPosition(FVector(Particles.GetX(Element[1]))), ClusterSize),
+					AddVertex(Transform.TransformPosition(FVector(Particles.GetX(Element[2]))), ClusterSize));
+			}
+
+			return Elements.Num();
+		}
+
+		/** Adds every triangle mesh of a body placed in the world. Returns the number of source triangles */
+		int32 AddBody(const UBodySetup& BodySetup, const FTransform& Transform, float ClusterSize)
+		{
+			int32 NumSourceTriangles = 0;
+			for (const Chaos::FTriangleMeshImplicitObjectPtr& TriMesh : BodySetup.TriMeshGeometries)
+			{
+				const Chaos::FTrimeshIndexBuffer& Elements = TriMesh->Elements();
+				NumSourceTriangles += Elements.RequiresLargeIndices()
+					? AddTriangles(TriMesh->Particles(), Elements.GetLargeIndexBuffer(), Transform, ClusterSize)
+					: AddTriangles(TriMesh->Particles(), Elements.GetSmallIndexBuffer(), Transform, ClusterSize);
+			}
+
+			return NumSourceTriangles;
+		}
+
+		/** Adds the boxes and convex hulls of a body placed in the world, as triangles. Returns the number of source triangles */
+		int32 AddSimpleShapes(const FKAggregateGeom& AggGeom, const FTransform& Transform, float ClusterSize)
+		{
+			// corners are numbered by their bits: x, y, z set on the positive side
+			static constexpr int32 BoxTriangles[12][3] =
+			{
+				{ 0, 4, 6 }, { 0, 6, 2 }, { 1, 3, 7 }, { 1, 7, 5 },
+				{ 0, 1, 5 }, { 0, 5, 4 }, { 2, 6, 7 }, { 2, 7, 3 },
+				{ 0, 2, 3 }, { 0, 3, 1 }, { 4, 5, 7 }, { 4, 7, 6 },
+			};
+
+			int32 NumSourceTriangles = 0;
+
+			for (const FKBoxElem& Box : AggGeom.BoxElems)
+			{
+				const FTransform BoxTransform = Box.GetTransform() * Transform;
+				const FVector Extent(0.5 * Box.X, 0.5 * Box.Y, 0.5 * Box.Z);
+
+				int32 Corners[8];
+				for (int32 Corner = 0; Corner < 8; ++Corner)
+				{
+					const FVector Local((Corner & 1) ? Extent.X : -Extent.X, (Corner & 2) ? Extent.Y : -Extent.Y, (Corner & 4) ? Extent.Z : -Extent.Z);
+					Corners[Corner] = AddVertex(BoxTransform.TransformPosition(Local), ClusterSize);
+				}
+
+				for (const int32 (&Triangle)[3] : BoxTriangles)
+				{
+					AddTriangle(Corners[Triangle[0]], Corners[Triangle[1]], Corners[Triangle[2]]);
+				}
+
+				NumSourceTriangles += UE_ARRAY_COUNT(BoxTriangles);
+			}
+
+			for (const FKConvexElem& Convex : AggGeom.ConvexElems)
+			{
+				const FTransform ConvexTransform = Convex.GetTransform() * Transform;
+
+				TArray<int32, TInlineAllocator<64>> ConvexVertices;
+				for (const FVector& Vertex : Convex.VertexData)
+				{
+					ConvexVertices.Add(AddVertex(ConvexTransform.TransformPosition(Vertex), ClusterSize));
+				}
+
+				for (int32 Index = 0; Index + 2 < Convex.IndexData.Num(); Index += 3)
+				{
+					AddTriangle(ConvexVertices[Convex.IndexData[Index]], ConvexVertices[Convex.IndexData[Index + 1]], ConvexVertices[Convex.IndexData[Index + 2]]);
+				}
+
+				NumSourceTriangles += Convex.IndexData.Num() / 3;
+			}
+
+			return NumSourceTriangles;
+		}
+	};
+
+	/** Returns the physical material rays see on a component: that of its render material for complex collision */
+	const UPhysicalMaterial* GetSurfaceMaterial(UStaticMeshComponent* Component, bool bComplex)
+	{
+		const UMaterialInterface* Material = bComplex ? Component->GetMaterial(0) : nullptr;
+		return Material ? Material->GetPhysicalMaterial() : Component->GetBodyInstance()->GetSimplePhysicalMaterial();
+	}
+
+	/** Returns the class shared by the sources of every triangle of a cell, or None if they differ */
+	ESensorSimSemanticClass GetCommonClass(const FCellBuilder& Cell, const TArray<FSensorSimStaticSource>& Sources)
+	{
+		TOptional<uint8> Class;
+		for (const int32 Source : Cell.TriangleSources)
+		{
+			const uint8 SourceClass = Sources.IsValidIndex(Source) ? Sources[Source].Label.Class : 0;
+			if (Class.IsSet() && Class.GetValue() != SourceClass)
+			{
+				return ESensorSimSemanticClass::None;
+			}
+
+			Class = SourceClass;
+		}
+
+		return static_cast<ESensorSimSemanticClass>(Class.Get(0));
+	}
+
+	/** Calls Visit with the world transform of every placement of a static mesh component, one per instance if it is instanced */
+	void ForEachPlacement(const UStaticMeshComponent* Component, TFunctionRef<void(const FTransform&)> Visit)
+	{
+		if (const UInstancedStaticMeshComponent* Instanced = Cast<UInstancedStaticMeshComponent>(Component))
+		{
+			for (int32 InstanceIndex = 0; InstanceIndex < Instanced->GetInstanceCount(); ++InstanceIndex)
+			{
+				FTransform InstanceTransform;
+				Instanced->GetInstanceTransform(InstanceIndex, InstanceTransform, true);
+				Visit(InstanceTransform);
+			}
+			return;
+		}
+
+		Visit(Component->GetComponentTransform());
+	}
+}
+
+void USensorSimRayProxySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	if (bBuildProxies && !FParse::Param(CommandLine, TEXT("NoSensorRayProxies")))
+	{
+		bProxiesBuilt = true;
+		bStaticSceneBuilt = bBuildStaticScene && !FParse::Param(CommandLine, TEXT("NoSensorRayStaticScene"));
+		BuildProxies(InWorld, bStaticSceneBuilt);
+
+		LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &USensorSimRayProxySubsystem::OnLevelChanged);
+		LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &USensorSimRayProxySubsystem::OnLevelChanged);
+	}
+}
+
+void USensorSimRayProxySubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	Super::Deinitialize();
+}
+
+void USensorSimRayProxySubsystem::OnLevelChanged(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld != GetWorld() || bRebuildPending)
+	{
+		return;
+	}
+
+	// levels often stream in several per frame, so they share one rebuild. Sensors trace every mobility meanwhile
+	bRebuildPending = true;
+	InWorld->GetTimerManager().SetTimerForNextTick(this, &USensorSimRayProxySubsystem::RebuildProxies);
+}
+
+void USensorSimRayProxySubsystem::RebuildProxies()
+{
+	UWorld* World = GetWorld();
+	bRebuildPending = false;
+
+	for (const TWeakObjectPtr<UPrimitiveComponent>& Component : SourceComponents)
+	{
+		if (Component.IsValid())
+		{
+			Component->SetCollisionResponseToChannel(ECC_SensorRay, ECR_Block);
+		}
+	}
+
+	if (ProxyActor)
+	{
+		ProxyActor->Destroy();
+	}
+
+	SourceComponents.Reset();
+	ProxyActor = nullptr;
+	Proxies.Reset();
+
+	// sweeps in flight keep the scene they started with
+	StaticScene.Reset();
+
+	// components of unloaded levels are unregistered by now, so they drop out
+	BuildProxies(*World, bStaticSceneBuilt);
+}
+
+bool USensorSimRayProxySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USensorSimRayProxySubsystem::BuildProxies(UWorld& InWorld, bool bStaticScene)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const float ClusterSize = FMath::Max(VertexClusterSize, 0.1f);
+	const float GridSize = FMath::Max(CellSize, 100.0f);
+
+	TMap<FIntVector, SensorSimRayProxy::FCellBuilder> Cells;
+	TArray<FSensorSimStaticSource> Sources;
+	int32 NumSourceComponents = 0;
+	int32 NumSourceTriangles = 0;
+	NumPhysicsStaticComponents = 0;
+
+	const USensorSimSensorSubsystem* SensorSubsystem = InWorld.GetSubsystem<USensorSimSensorSubsystem>();
+	USensorSimLabelSubsystem* LabelSubsystem = InWorld.GetSubsystem<USensorSimLabelSubsystem>();
+
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		It->ForEachComponent<UPrimitiveComponent>(false, [&](UPrimitiveComponent* Component)
+		{
+			if (!IsSensorRayStatic(Component))
+			{
+				return;
+			}
+
+			// simple collision is cheap enough for the physics scene, so only the static scene takes it over
+			UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component);
+			const bool bComplex = MeshComponent && HasComplexCollision(MeshComponent);
+			const bool bSimple = bStaticScene && MeshComponent && !bComplex && HasTriangulableCollision(MeshComponent);
+
+			if (!bComplex && !bSimple)
+			{
+				++NumPhysicsStaticComponents;
+				return;
+			}
+
+			// a component goes to the cell its center falls in, so it is never split across proxies
+			const FVector Center = Component->Bounds.Origin;
+			const FIntVector CellKey(FMath::FloorToInt(Center.X / GridSize), FMath::FloorToInt(Center.Y / GridSize), FMath::FloorToInt(Center.Z / GridSize));
+
+			SensorSimRayProxy::FCellBuilder* Cell = Cells.Find(CellKey);
+			if (!Cell)
+			{
+				Cell = &Cells.Add(CellKey);
+				Cell->Origin = (FVector(CellKey) + 0.5) * GridSize;
+			}
+
+			// every triangle remembers the component it came from, for the sensors' surface models
+			FSensorSimStaticSource& Source = Sources.AddDefaulted_GetRef();
+			Source.Reflectivity = SensorSubsystem ? SensorSubsystem->GetReflectivity(SensorSimRayProxy::GetSurfaceMaterial(MeshComponent, bComplex)) : Source.Reflectivity;
+			Source.Stencil = MeshComponent->bRenderCustomDepth ? static_cast<uint8>(MeshComponent->CustomDepthStencilValue) : 0;
+			Source.Label = LabelSubsystem ? LabelSubsystem->LabelComponent(MeshComponent) : Source.Label;
+			Cell->Source = Sources.Num() - 1;
+
+			const UBodySetup& BodySetup = *MeshComponent->GetBodySetup();
+			SensorSimRayProxy::ForEachPlacement(MeshComponent, [&](const FTransform& Transform)
+			{
+				NumSourceTriangles += bComplex ? Cell->AddBody(BodySetup, Transform, ClusterSize) : Cell->AddSimpleShapes(BodySetup.AggGeom, Transform, ClusterSize);
+			});
+
+			// rays now skip the source mesh in the broadphase and hit its simplified geometry instead
+			Component->SetCollisionResponseToChannel(ECC_SensorRay, ECR_Ignore);
+			SourceComponents.Add(Component);
+			++NumSourceComponents;
+		});
+	}
+
+	if (Cells.IsEmpty())
+	{
+		return;
+	}
+
+	if (bStaticScene)
+	{
+		// one scene over every cell, its vertices relative to the middle of the level
+		FBox CellOrigins(ForceInit);
+		for (const TPair<FIntVector, SensorSimRayProxy::FCellBuilder>& Cell : Cells)
+		{
+			CellOrigins += Cell.Value.Origin;
+		}
+
+		const FVector SceneOrigin = CellOrigins.GetCenter();
+
+		TArray<FVector3f> Vertices;
+		TArray<FTriIndices> Triangles;
+		TArray<int32> TriangleSources;
+		for (const TPair<FIntVector, SensorSimRayProxy::FCellBuilder>& Cell : Cells)
+		{
+			TriangleSources.Append(Cell.Value.TriangleSources);
+
+			const FVector3f Offset(Cell.Value.Origin - SceneOrigin);
+			const int32 FirstVertex = Vertices.Num();
+
+			for (const FVector3f& Vertex : Cell.Value.Vertices)
+			{
+				Vertices.Add(Vertex + Offset);
+			}
+
+			for (const FTriIndices& Triangle : Cell.Value.Triangles)
+			{
+				FTriIndices& SceneTriangle = Triangles.AddDefaulted_GetRef();
+				SceneTriangle.v0 = Triangle.v0 + FirstVertex;
+				SceneTriangle.v1 = Triangle.v1 + FirstVertex;
+				SceneTriangle.v2 = Triangle.v2 + FirstVertex;
+			}
+		}
+
+		TSharedRef<FSensorSimStaticScene, ESPMode::ThreadSafe> Scene = MakeShared<FSensorSimStaticScene, ESPMode::ThreadSafe>();
+		Scene->Build(SceneOrigin, Vertices, Triangles);
+		Scene->SetSources(MoveTemp(Sources), MoveTemp(TriangleSources));
+		StaticScene = Scene;
+
+		UE_LOG(LogSensorSim, Log, TEXT("Built the sensor ray static scene from %d static meshes in %.1f ms: %d triangles simplified to %d, %d nodes, %.1f MB. %d static components left to the physics scene"),
+			NumSourceComponents, (FPlatformTime::Seconds() - StartSeconds) * 1000.0, NumSourceTriangles, Scene->GetNumTriangles(), Scene->GetNumNodes(),
+			Scene->GetAllocatedSize() / (1024.0 * 1024.0), NumPhysicsStaticComponents);
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = TEXT("SensorRayProxies");
+	SpawnParams.ObjectFlags = RF_Transient;
+	ProxyActor = InWorld.SpawnActor<AActor>(SpawnParams);
+
+	int32 NumProxyTriangles = 0;
+	for (TPair<FIntVector, SensorSimRayProxy::FCellBuilder>& Cell : Cells)
+	{
+		if (Cell.Value.Triangles.IsEmpty())
+		{
+			continue;
+		}
+
+		USensorSimRayProxyComponent* Proxy = NewObject<USensorSimRayProxyComponent>(ProxyActor);
+		Proxy->SetWorldLocation(Cell.Value.Origin);
+		Proxy->SetSemanticClass(SensorSimRayProxy::GetCommonClass(Cell.Value, Sources));
+		Proxy->SetGeometry(MoveTemp(Cell.Value.Vertices), MoveTemp(Cell.Value.Triangles));
+		Proxy->RegisterComponent();
+
+		NumProxyTriangles += Proxy->GetNumTriangles();
+		Proxies.Add(Proxy);
+	}
+
+	UE_LOG(LogSensorSim, Log, TEXT("Built %d sensor ray proxies for %d static meshes in %.1f ms: %d triangles simplified to %d"),
+		Proxies.Num(), NumSourceComponents, (FPlatformTime::Seconds() - StartSeconds) * 1000.0, NumSourceTriangles, NumProxyTriangles);
+}
+
+bool USensorSimRayProxySubsystem::IsSensorRayStatic(const UPrimitiveComponent* Component)
+{
+	return Component->IsRegistered() && Component->Mobility == EComponentMobility::Static && Component->IsQueryCollisionEnabled()
+		&& Component->GetCollisionResponseToChannel(ECC_SensorRay) == ECR_Block;
+}
+
+bool USensorSimRayProxySubsystem::HasComplexCollision(const UStaticMeshComponent* Component)
+{
+	const UBodySetup* BodySetup = const_cast<UStaticMeshComponent*>(Component)->GetBodySetup();
+	return BodySetup && BodySetup->GetCollisionTraceFlag() == CTF_UseComplexAsSimple && !BodySetup->TriMeshGeometries.IsEmpty();
+}
+
+bool USensorSimRayProxySubsystem::HasTriangulableCollision(const UStaticMeshComponent* Component)
+{
+	const UBodySetup* BodySetup = const_cast<UStaticMeshComponent*>(Component)->GetBodySetup();
+	if (!BodySetup)
+	{
+		return false;
+	}
+
+	// spheres, capsules and level sets stay in the physics scene
+	const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+	if (!AggGeom.SphereElems.IsEmpty() || !AggGeom.SphylElems.IsEmpty() || !AggGeom.TaperedCapsuleElems.IsEmpty()
+		|| !AggGeom.LevelSetElems.IsEmpty() || !AggGeom.SkinnedLevelSetElems.IsEmpty())
+	{
+		return false;
+	}
+
+	for (const FKConvexElem& Convex : AggGeom.ConvexElems)
+	{
+		if (Convex.IndexData.IsEmpty())
+		{
+			return false;
+		}
+	}
+
+	return !AggGeom.BoxElems.IsEmpty() || !AggGeom.ConvexElems.IsEmpty();
+}
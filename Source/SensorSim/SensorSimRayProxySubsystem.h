@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SensorSimRayProxySubsystem.generated.h"
+
+// Forward declarations
+class ULevel;
+class UPrimitiveComponent;
+class UStaticMeshComponent;
+class USensorSimRayProxyComponent;
+class FSensorSimStaticScene;
+
+/**
+ *  Ray Proxy Subsystem
+ *  Builds the static geometry sensor rays are traced against at level load, and again whenever a level is streamed in or out.
+ *
+ *  By default, every static mesh answering the SensorRay channel is gathered into a static scene: a SIMD BVH
+ *  the LiDAR traverses on its worker threads without going through the physics scene. Complex collision is
+ *  simplified by vertex clustering, boxes and convex hulls are triangulated. The source components then ignore
+ *  the channel, so physics traces only see dynamic actors and the few static shapes the scene cannot hold.
+ *
+ *  A streamed level is taken into account on the next frame: until then, physics traces also cover static actors.
+ *
+ *  Without a static scene, only static meshes whose query collision is their full render mesh (complex as simple,
+ *  such as the track pieces) are simplified, merged per grid cell and cooked into one physics ray proxy per cell.
+ *
+ *  Command line:
+ *    -NoSensorRayStaticScene    builds physics ray proxies instead of the static scene
+ *    -NoSensorRayProxies        traces sensor rays against the level's own collision
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimRayProxySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Builds the proxies on level load */
+	UPROPERTY(Config)
+	bool bBuildProxies{ true };
+
+	/** Gathers every static mesh into a static scene traced outside of the physics scene, rather than physics proxies */
+	UPROPERTY(Config)
+	bool bBuildStaticScene{ true };
+
+	/** Vertices closer than this are merged into one, in cm. Bounds the geometric error of the proxies */
+	UPROPERTY(Config)
+	float VertexClusterSize{ 10.0f };
+
+	/** Edge of the grid cells static geometry is merged over, in cm */
+	UPROPERTY(Config)
+	float CellSize{ 10000.0f };
+
+	/** Actor owning the proxies */
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> ProxyActor{ nullptr };
+
+	/** One proxy per occupied grid cell */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USensorSimRayProxyComponent>> Proxies;
+
+	/** Static scene, if built. Shared with the sweeps tracing it */
+	TSharedPtr<const FSensorSimStaticScene, ESPMode::ThreadSafe> StaticScene;
+
+	/** Number of static components still answering the SensorRay channel through the physics scene */
+	int32 NumPhysicsStaticComponents{ 0 };
+
+	/** Components the proxies or static scene stand in for, which ignore the SensorRay channel until the next rebuild */
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> SourceComponents;
+
+	/** Whether the proxies were built, and as a static scene */
+	bool bProxiesBuilt{ false };
+	bool bStaticSceneBuilt{ false };
+
+	/** Set from a level being streamed in or out until the proxies are rebuilt */
+	bool bRebuildPending{ false };
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+public:
+	/** Returns the number of proxies built */
+	int32 GetNumProxies() const { return Proxies.Num(); }
+
+	/** Returns the static scene, if one was built */
+	TSharedPtr<const FSensorSimStaticScene, ESPMode::ThreadSafe> GetStaticScene() const { return StaticScene; }
+
+	/**
+	 *  Returns true if the static scene holds every static component answering the SensorRay channel, leaving only dynamic ones to the physics scene.
+	 *  False while a streamed level is waiting for the rebuild
+	 */
+	bool IsStaticSceneComplete() const { return StaticScene.IsValid() && NumPhysicsStaticComponents == 0 && !bRebuildPending; }
+
+	// Begin WorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Builds the proxies or static scene of every eligible static mesh in the world */
+	void BuildProxies(UWorld& InWorld, bool bStaticScene);
+
+	/** Schedules a rebuild for the next frame when a level of this world is streamed in or out */
+	void OnLevelChanged(ULevel* Level, UWorld* InWorld);
+
+	/** Hands the SensorRay channel back to the source components and builds the proxies again, over the levels now loaded */
+	void RebuildProxies();
+
+	/** Returns true if the component is static and sensor rays hit it */
+	static bool IsSensorRayStatic(const UPrimitiveComponent* Component);
+
+	/** Returns true if the component's query collision is a triangle mesh */
+	static bool HasComplexCollision(const UStaticMeshComponent* Component);
+
+	/** Returns true if the component's simple collision only has shapes the static scene can triangulate */
+	static bool HasTriangulableCollision(const UStaticMeshComponent* Component);
+};
@@ -0,0 +1,860 @@
+#include "SensorSimRecording.h"
+#include "SensorSim.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/StableSort.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace SensorSimRecording
+{
+	/** Fixed part of a LiDAR sweep payload. Followed by the X, Y, Z, Intensity, Timestamp, Instance, Ring and SemanticClass arrays */
+	struct FLidarSweepHeader
+	{
+		double SweepTime = 0.0;
+		FVector3d Location = FVector3d::ZeroVector;
+		FQuat4f Rotation = FQuat4f::Identity;
+		uint32 Sequence = 0;
+		int32 NumPoints = 0;
+
+		/** Pads the header to a multiple of the Rotation alignment */
+		uint64 Reserved = 0;
+	};
+
+	static_assert(offsetof(FLidarSweepHeader, Rotation) == 32 && offsetof(FLidarSweepHeader, NumPoints) == 52 && sizeof(FLidarSweepHeader) == 64,
+		"LiDAR sweep payload layout changed");
+
+	/** Returns the bytes taken by a LiDAR sweep payload */
+	SIZE_T GetLidarSweepPayloadSize(int32 NumPoints)
+	{
+		return sizeof(FLidarSweepHeader) + NumPoints * SensorSimPointBytes;
+	}
+
+	/** Fixed part of a camera image payload. Followed by the pixels, row-major and tightly packed */
+	struct FCameraImageHeader
+	{
+		double Time = 0.0;
+		FVector3d Location = FVector3d::ZeroVector;
+		FQuat4f Rotation = FQuat4f::Identity;
+		uint32 Sequence = 0;
+		uint16 Width = 0;
+		uint16 Height = 0;
+
+		/** ESensorSimImageType */
+		uint8 Type = 0;
+
+		/** Camera of the vehicle */
+		uint8 Camera = 0;
+
+		uint16 Reserved0 = 0;
+		uint32 Reserved1 = 0;
+	};
+
+	static_assert(offsetof(FCameraImageHeader, Rotation) == 32 && sizeof(FCameraImageHeader) == 64, "Camera image payload layout changed");
+
+	/** Returns the compression format name, or NAME_None */
+	FName GetFormatName(ESensorSimRecordingCompression Compression)
+	{
+		switch (Compression)
+		{
+		case ESensorSimRecordingCompression::LZ4:
+			return NAME_LZ4;
+		case ESensorSimRecordingCompression::Oodle:
+			return NAME_Oodle;
+		default:
+			return NAME_None;
+		}
+	}
+
+	/** Returns the key of the chunks of one type and stream in the seek lists. StreamId -1 stands for every stream */
+	uint32 GetSeekKey(ESensorSimChunkType Type, int32 StreamId)
+	{
+		return (uint32(Type) << 24) | (StreamId < 0 ? 0x10000u : uint32(StreamId & 0xFFFF));
+	}
+
+	/** Appends raw bytes to a payload */
+	void Append(TArray<uint8>& Payload, const void* Source, SIZE_T Bytes)
+	{
+		Payload.Append(static_cast<const uint8*>(Source), Bytes);
+	}
+
+	/** Decodes a chunk holding a run of fixed size samples */
+	template<typename SampleType>
+	bool ReadSamples(const FSensorSimRecordingReader& Reader, int32 ChunkIndex, ESensorSimChunkType Type, TArray<SampleType>& OutSamples)
+	{
+		TArray<uint8> Scratch;
+		TArrayView<const uint8> Payload;
+		if (Reader.GetEntry(ChunkIndex).Type != static_cast<uint8>(Type) || !Reader.ReadChunk(ChunkIndex, Payload, Scratch))
+		{
+			return false;
+		}
+
+		if (Payload.Num() % sizeof(SampleType) != 0)
+		{
+			return false;
+		}
+
+		OutSamples.SetNumUninitialized(Payload.Num() / sizeof(SampleType));
+		FMemory::Memcpy(OutSamples.GetData(), Payload.GetData(), Payload.Num());
+		return true;
+	}
+}
+
+FSensorSimRecordingWriter::FSensorSimRecordingWriter()
+{
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FSensorSimRecordingWriter::~FSensorSimRecordingWriter()
+{
+	Close();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+bool FSensorSimRecordingWriter::Open(const FString& InFilename, ESensorSimRecordingCompression InCompression)
+{
+	check(!IsOpen());
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InFilename));
+
+	File.Reset(PlatformFile.OpenWrite(*InFilename));
+	if (!File)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to create recording '%s'"), *InFilename);
+		return false;
+	}
+
+	Filename = InFilename;
+	Compression = InCompression;
+	Index.Reset();
+	DiscardedStreams.Reset();
+	BytesWritten = 0;
+	bStopRequested = false;
+
+	const FSensorSimRecordingFileHeader Header;
+	File->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	BytesWritten += sizeof(Header);
+
+	Thread = FRunnableThread::Create(this, TEXT("SensorSimRecordingWriter"), 0, TPri_BelowNormal);
+
+	UE_LOG(LogSensorSim, Log, TEXT("Recording to '%s'"), *Filename);
+	return true;
+}
+
+bool FSensorSimRecordingWriter::Connect(const FString& Endpoint, uint32 Job, uint32 Attempt, ESensorSimRecordingCompression InCompression)
+{
+	check(!IsOpen());
+
+	FIPv4Endpoint Address;
+	if (!FIPv4Endpoint::Parse(Endpoint, Address))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Invalid recording stream endpoint '%s'"), *Endpoint);
+		return false;
+	}
+
+	// blocking: the I/O thread is throttled by the receiver rather than buffering without bound
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("SensorSimRecordingStream"), false);
+	if (!Socket || !Socket->Connect(*Address.ToInternetAddr()))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to connect the recording stream to '%s'"), *Endpoint);
+		if (Socket)
+		{
+			SocketSubsystem->DestroySocket(Socket);
+			Socket = nullptr;
+		}
+		return false;
+	}
+
+	Socket->SetNoDelay(true);
+
+	Filename = Endpoint;
+	Compression = InCompression;
+	Index.Reset();
+	DiscardedStreams.Reset();
+	BytesWritten = 0;
+	bSendFailed = false;
+	bStopRequested = false;
+
+	FSensorSimRecordingStreamHeader Header;
+	Header.Job = Job;
+	Header.Attempt = Attempt;
+	if (!WriteBytes(&Header, sizeof(Header)))
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+		return false;
+	}
+
+	Thread = FRunnableThread::Create(this, TEXT("SensorSimRecordingWriter"), 0, TPri_BelowNormal);
+
+	UE_LOG(LogSensorSim, Log, TEXT("Streaming job %u attempt %u to '%s'"), Job, Attempt, *Filename);
+	return true;
+}
+
+void FSensorSimRecordingWriter::Close()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	// let the I/O thread drain the queue and exit
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	if (Socket)
+	{
+		// a stream cut short, by a crash or a failed send, has no end marker and is discarded by the receiver
+		FSensorSimChunkHeader EndHeader;
+		EndHeader.Type = SensorSimRecording::EndOfStream;
+		const bool bComplete = WriteBytes(&EndHeader, sizeof(EndHeader));
+
+		Socket->Shutdown(ESocketShutdownMode::ReadWrite);
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+
+		UE_LOG(LogSensorSim, Log, TEXT("Closed recording stream '%s': %.1f MiB%s"), *Filename, GetBytesWritten() / (1024.0 * 1024.0), bComplete ? TEXT("") : TEXT(", incomplete"));
+		return;
+	}
+
+	if (!DiscardedStreams.IsEmpty())
+	{
+		Index.RemoveAll([this](const FSensorSimChunkIndexEntry& Entry) { return DiscardedStreams.Contains(Entry.StreamId); });
+	}
+
+	// chunks from different streams may have been queued slightly out of order
+	Algo::StableSortBy(Index, &FSensorSimChunkIndexEntry::Timestamp);
+
+	FSensorSimRecordingFooter Footer;
+	Footer.IndexOffset = File->Tell();
+	Footer.NumEntries = Index.Num();
+
+	File->Write(reinterpret_cast<const uint8*>(Index.GetData()), Index.Num() * sizeof(FSensorSimChunkIndexEntry));
+	File->Write(reinterpret_cast<const uint8*>(&Footer), sizeof(Footer));
+	File->Flush();
+	File.Reset();
+
+	BytesWritten += Index.Num() * sizeof(FSensorSimChunkIndexEntry) + sizeof(Footer);
+
+	UE_LOG(LogSensorSim, Log, TEXT("Closed recording '%s': %d chunks, %.1f MiB"), *Filename, Index.Num(), GetBytesWritten() / (1024.0 * 1024.0));
+}
+
+void FSensorSimRecordingWriter::AddStreamInfo(uint16 StreamId, const FString& Description, double Timestamp)
+{
+	FPendingChunk Chunk;
+	Chunk.Type = ESensorSimChunkType::StreamInfo;
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Timestamp;
+
+	const FTCHARToUTF8 Utf8(*Description);
+	SensorSimRecording::Append(Chunk.Payload, Utf8.Get(), Utf8.Length());
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::AddLidarSweep(uint16 StreamId, const FSensorSimPointCloudRef& Frame)
+{
+	FPendingChunk Chunk;
+	Chunk.Type = ESensorSimChunkType::LidarSweep;
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Frame->SweepTime;
+	Chunk.Frame = Frame;
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::AddCameraImage(uint16 StreamId, const FSensorSimImageRef& Image)
+{
+	FPendingChunk Chunk;
+	Chunk.Type = ESensorSimChunkType::CameraImage;
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Image->Time;
+	Chunk.Image = Image;
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::AddVehicleStates(uint16 StreamId, TArray<FSensorSimVehicleStateSample>&& Samples)
+{
+	if (Samples.IsEmpty())
+	{
+		return;
+	}
+
+	FPendingChunk Chunk;
+	Chunk.Type = ESensorSimChunkType::VehicleState;
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Samples[0].Time;
+	SensorSimRecording::Append(Chunk.Payload, Samples.GetData(), Samples.Num() * sizeof(FSensorSimVehicleStateSample));
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::AddVehicleInputs(uint16 StreamId, TArray<FSensorSimPhysicsInputSample>&& Samples, double Timestamp)
+{
+	if (Samples.IsEmpty())
+	{
+		return;
+	}
+
+	FPendingChunk Chunk;
+	Chunk.Type = ESensorSimChunkType::VehicleInputs;
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Timestamp;
+	SensorSimRecording::Append(Chunk.Payload, Samples.GetData(), Samples.Num() * sizeof(FSensorSimPhysicsInputSample));
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::AddImuSamples(uint16 StreamId, TArray<FSensorSimImuSample>&& Samples)
+{
+	if (!Samples.IsEmpty())
+	{
+		AddSampleChunk(ESensorSimChunkType::Imu, StreamId, Samples[0].Time, Samples.GetData(), Samples.Num() * sizeof(FSensorSimImuSample));
+	}
+}
+
+void FSensorSimRecordingWriter::AddWheelEncoderSamples(uint16 StreamId, TArray<FSensorSimWheelEncoderSample>&& Samples)
+{
+	if (!Samples.IsEmpty())
+	{
+		AddSampleChunk(ESensorSimChunkType::WheelEncoder, StreamId, Samples[0].Time, Samples.GetData(), Samples.Num() * sizeof(FSensorSimWheelEncoderSample));
+	}
+}
+
+void FSensorSimRecordingWriter::AddStoredChunk(uint16 StreamId, const FSensorSimChunkHeader& Header, TArray<uint8>&& Payload)
+{
+	check(Payload.Num() == Header.StoredSize);
+
+	FPendingChunk Chunk;
+	Chunk.Type = static_cast<ESensorSimChunkType>(Header.Type);
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Header.Timestamp;
+	Chunk.Payload = MoveTemp(Payload);
+	Chunk.StoredHeader = Header;
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::AddSampleChunk(ESensorSimChunkType Type, uint16 StreamId, double Timestamp, const void* Samples, SIZE_T Bytes)
+{
+	FPendingChunk Chunk;
+	Chunk.Type = Type;
+	Chunk.StreamId = StreamId;
+	Chunk.Timestamp = Timestamp;
+	SensorSimRecording::Append(Chunk.Payload, Samples, Bytes);
+
+	Enqueue(MoveTemp(Chunk));
+}
+
+void FSensorSimRecordingWriter::Enqueue(FPendingChunk&& Chunk)
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	NumPendingChunks.fetch_add(1, std::memory_order_relaxed);
+	Queue.Enqueue(MoveTemp(Chunk));
+	WorkEvent->Trigger();
+}
+
+uint32 FSensorSimRecordingWriter::Run()
+{
+	while (!bStopRequested.load())
+	{
+		WorkEvent->Wait();
+		DrainQueue();
+	}
+
+	// write whatever was queued before the stop request
+	DrainQueue();
+	return 0;
+}
+
+void FSensorSimRecordingWriter::Stop()
+{
+	bStopRequested = true;
+	WorkEvent->Trigger();
+}
+
+void FSensorSimRecordingWriter::DrainQueue()
+{
+	FPendingChunk Chunk;
+	while (Queue.Dequeue(Chunk))
+	{
+		WriteChunk(Chunk);
+		NumPendingChunks.fetch_sub(1, std::memory_order_relaxed);
+
+		// release the frame back to its pool as soon as possible
+		Chunk = FPendingChunk();
+	}
+}
+
+void FSensorSimRecordingWriter::WriteChunk(FPendingChunk& Chunk)
+{
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimRecordingIO);
+
+	using namespace SensorSimRecording;
+
+	// serialize LiDAR frames and camera images here rather than on the producing thread
+	TArray<uint8>& Raw = Chunk.Frame || Chunk.Image ? RawScratch : Chunk.Payload;
+	if (Chunk.Frame)
+	{
+		const FSensorSimPointCloudFrame& Frame = *Chunk.Frame;
+		const int32 NumPoints = Frame.Num();
+
+		FLidarSweepHeader SweepHeader;
+		SweepHeader.SweepTime = Frame.SweepTime;
+		SweepHeader.Location = Frame.SensorTransform.GetLocation();
+		SweepHeader.Rotation = FQuat4f(Frame.SensorTransform.GetRotation());
+		SweepHeader.Sequence = Frame.Sequence;
+		SweepHeader.NumPoints = NumPoints;
+
+		Raw.Reset(GetLidarSweepPayloadSize(NumPoints));
+		Append(Raw, &SweepHeader, sizeof(SweepHeader));
+		Append(Raw, Frame.X.GetData(), NumPoints * sizeof(float));
+		Append(Raw, Frame.Y.GetData(), NumPoints * sizeof(float));
+		Append(Raw, Frame.Z.GetData(), NumPoints * sizeof(float));
+		Append(Raw, Frame.Intensity.GetData(), NumPoints * sizeof(float));
+		Append(Raw, Frame.Timestamp.GetData(), NumPoints * sizeof(float));
+		Append(Raw, Frame.Instance.GetData(), NumPoints * sizeof(uint32));
+		Append(Raw, Frame.Ring.GetData(), NumPoints * sizeof(uint16));
+		Append(Raw, Frame.SemanticClass.GetData(), NumPoints * sizeof(uint8));
+	}
+	else if (Chunk.Image)
+	{
+		const FSensorSimImage& Image = *Chunk.Image;
+
+		FCameraImageHeader ImageHeader;
+		ImageHeader.Time = Image.Time;
+		ImageHeader.Location = Image.SensorTransform.GetLocation();
+		ImageHeader.Rotation = FQuat4f(Image.SensorTransform.GetRotation());
+		ImageHeader.Sequence = Image.Sequence;
+		ImageHeader.Width = static_cast<uint16>(Image.Width);
+		ImageHeader.Height = static_cast<uint16>(Image.Height);
+		ImageHeader.Type = static_cast<uint8>(Image.Type);
+		ImageHeader.Camera = Image.Camera;
+
+		Raw.Reset(sizeof(ImageHeader) + Image.Pixels.Num());
+		Append(Raw, &ImageHeader, sizeof(ImageHeader));
+		Append(Raw, Image.Pixels.GetData(), Image.Pixels.Num());
+	}
+
+	FSensorSimChunkHeader Header;
+	Header.Timestamp = Chunk.Timestamp;
+	Header.StreamId = Chunk.StreamId;
+	Header.Type = static_cast<uint8>(Chunk.Type);
+	Header.RawSize = Raw.Num();
+	Header.StoredSize = Raw.Num();
+	Header.Compression = static_cast<uint8>(ESensorSimRecordingCompression::None);
+
+	const uint8* Stored = Raw.GetData();
+
+	// chunks forwarded from another recording keep their stored payload and compression
+	if (Chunk.StoredHeader.IsSet())
+	{
+		Header.RawSize = Chunk.StoredHeader->RawSize;
+		Header.Compression = Chunk.StoredHeader->Compression;
+	}
+
+	// only keep the compressed payload if it is actually smaller
+	const FName FormatName = GetFormatName(Compression);
+	if (!Chunk.StoredHeader.IsSet() && !FormatName.IsNone() && Raw.Num() > 0)
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(FormatName, Raw.Num());
+		CompressedScratch.SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+
+		if (FCompression::CompressMemory(FormatName, CompressedScratch.GetData(), CompressedSize, Raw.GetData(), Raw.Num())
+			&& CompressedSize < Raw.Num())
+		{
+			Header.StoredSize = CompressedSize;
+			Header.Compression = static_cast<uint8>(Compression);
+			Stored = CompressedScratch.GetData();
+		}
+	}
+
+	// the receiver of a stream indexes and pads the chunks itself
+	if (Socket)
+	{
+		WriteBytes(&Header, sizeof(Header));
+		WriteBytes(Stored, Header.StoredSize);
+		return;
+	}
+
+	FSensorSimChunkIndexEntry& Entry = Index.AddDefaulted_GetRef();
+	Entry.Timestamp = Header.Timestamp;
+	Entry.Offset = File->Tell();
+	Entry.StreamId = Header.StreamId;
+	Entry.Type = Header.Type;
+
+	WriteBytes(&Header, sizeof(Header));
+	WriteBytes(Stored, Header.StoredSize);
+
+	// keep every chunk header, and the index, 8 byte aligned in the mapped file
+	static constexpr uint8 Padding[8] = {};
+	WriteBytes(Padding, Align(Header.StoredSize, 8) - Header.StoredSize);
+}
+
+bool FSensorSimRecordingWriter::WriteBytes(const void* Bytes, int64 Size)
+{
+	if (File)
+	{
+		File->Write(static_cast<const uint8*>(Bytes), Size);
+		BytesWritten.fetch_add(Size, std::memory_order_relaxed);
+		return true;
+	}
+
+	// once a send has failed the stream is incomplete, and every later chunk is dropped
+	if (bSendFailed)
+	{
+		return false;
+	}
+
+	int64 Offset = 0;
+	while (Offset < Size)
+	{
+		int32 Sent = 0;
+		if (!Socket->Send(static_cast<const uint8*>(Bytes) + Offset, static_cast<int32>(FMath::Min<int64>(Size - Offset, MAX_int32)), Sent))
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("Recording stream to '%s' failed after %llu bytes"), *Filename, GetBytesWritten());
+			bSendFailed = true;
+			return false;
+		}
+
+		Offset += Sent;
+	}
+
+	BytesWritten.fetch_add(Size, std::memory_order_relaxed);
+	return true;
+}
+
+FSensorSimRecordingReader::FSensorSimRecordingReader() = default;
+
+FSensorSimRecordingReader::~FSensorSimRecordingReader()
+{
+	Close();
+}
+
+bool FSensorSimRecordingReader::Open(const FString& Filename)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!MappedFile)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to map recording '%s'"), *Filename);
+		return false;
+	}
+
+	const int64 FileSize = MappedFile->GetFileSize();
+	if (FileSize < int64(sizeof(FSensorSimRecordingFileHeader) + sizeof(FSensorSimRecordingFooter)))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Recording '%s' is truncated"), *Filename);
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, FileSize));
+	if (!MappedRegion)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to map recording '%s'"), *Filename);
+		Close();
+		return false;
+	}
+
+	Data = MappedRegion->GetMappedPtr();
+	Size = FileSize;
+
+	const FSensorSimRecordingFileHeader* Header = reinterpret_cast<const FSensorSimRecordingFileHeader*>(Data);
+	const FSensorSimRecordingFooter* Footer = reinterpret_cast<const FSensorSimRecordingFooter*>(Data + Size - sizeof(FSensorSimRecordingFooter));
+
+	// an unfinished recording has no footer
+	if (Header->Magic != SensorSimRecording::FileMagic || Header->Version != SensorSimRecording::Version
+		|| Footer->Magic != SensorSimRecording::FooterMagic
+		|| Footer->IndexOffset + uint64(Footer->NumEntries) * sizeof(FSensorSimChunkIndexEntry) + sizeof(FSensorSimRecordingFooter) != uint64(Size))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Recording '%s' is not a finished version %u recording"), *Filename, SensorSimRecording::Version);
+		Close();
+		return false;
+	}
+
+	Entries = reinterpret_cast<const FSensorSimChunkIndexEntry*>(Data + Footer->IndexOffset);
+	NumEntries = Footer->NumEntries;
+
+	// the index is sorted by time, so each list of chunk indices is too
+	for (int32 ChunkIndex = 0; ChunkIndex < NumEntries; ++ChunkIndex)
+	{
+		const ESensorSimChunkType Type = static_cast<ESensorSimChunkType>(Entries[ChunkIndex].Type);
+		SeekLists.FindOrAdd(SensorSimRecording::GetSeekKey(Type, Entries[ChunkIndex].StreamId)).Add(ChunkIndex);
+		SeekLists.FindOrAdd(SensorSimRecording::GetSeekKey(Type, -1)).Add(ChunkIndex);
+	}
+
+	return true;
+}
+
+void FSensorSimRecordingReader::Close()
+{
+	Entries = nullptr;
+	NumEntries = 0;
+	SeekLists.Reset();
+	Data = nullptr;
+	Size = 0;
+
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+double FSensorSimRecordingReader::GetStartTime() const
+{
+	return NumEntries > 0 ? Entries[0].Timestamp : 0.0;
+}
+
+double FSensorSimRecordingReader::GetEndTime() const
+{
+	return NumEntries > 0 ? Entries[NumEntries - 1].Timestamp : 0.0;
+}
+
+int32 FSensorSimRecordingReader::Seek(double Time, ESensorSimChunkType Type, int32 StreamId) const
+{
+	const TArray<int32>* SeekList = SeekLists.Find(SensorSimRecording::GetSeekKey(Type, StreamId));
+	if (!SeekList)
+	{
+		return INDEX_NONE;
+	}
+
+	// binary search the matching chunks for the first one after Time, and step back to the closest
+	const int32 After = Algo::UpperBoundBy(*SeekList, Time, [this](int32 ChunkIndex) { return Entries[ChunkIndex].Timestamp; });
+	return (*SeekList)[After > 0 ? After - 1 : 0];
+}
+
+bool FSensorSimRecordingReader::ReadChunk(int32 ChunkIndex, TArrayView<const uint8>& OutPayload, TArray<uint8>& Scratch) const
+{
+	if (!Entries || ChunkIndex < 0 || ChunkIndex >= NumEntries)
+	{
+		return false;
+	}
+
+	// the index may point anywhere, so keep the chunk within the mapping before touching it
+	const uint64 Offset = Entries[ChunkIndex].Offset;
+	if (Offset < sizeof(FSensorSimRecordingFileHeader) || Offset > uint64(Size) - sizeof(FSensorSimChunkHeader))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Recording chunk %d lies outside of the file"), ChunkIndex);
+		return false;
+	}
+
+	const FSensorSimChunkHeader* Header = reinterpret_cast<const FSensorSimChunkHeader*>(Data + Offset);
+	const uint8* Stored = Data + Offset + sizeof(FSensorSimChunkHeader);
+	if (Offset + sizeof(FSensorSimChunkHeader) + Header->StoredSize > uint64(Size) || Header->RawSize > uint32(MAX_int32))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Recording chunk %d lies outside of the file"), ChunkIndex);
+		return false;
+	}
+
+	const ESensorSimRecordingCompression ChunkCompression = static_cast<ESensorSimRecordingCompression>(Header->Compression);
+	if (ChunkCompression == ESensorSimRecordingCompression::None)
+	{
+		OutPayload = TArrayView<const uint8>(Stored, Header->StoredSize);
+		return true;
+	}
+
+	Scratch.SetNumUninitialized(Header->RawSize, EAllowShrinking::No);
+	if (!FCompression::UncompressMemory(SensorSimRecording::GetFormatName(ChunkCompression), Scratch.GetData(), Header->RawSize, Stored, Header->StoredSize))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to decompress recording chunk %d"), ChunkIndex);
+		return false;
+	}
+
+	OutPayload = Scratch;
+	return true;
+}
+
+bool FSensorSimRecordingReader::ReadLidarSweep(int32 ChunkIndex, FSensorSimPointCloudFrame& OutFrame) const
+{
+	using namespace SensorSimRecording;
+
+	TArray<uint8> Scratch;
+	TArrayView<const uint8> Payload;
+	if (GetEntry(ChunkIndex).Type != static_cast<uint8>(ESensorSimChunkType::LidarSweep) || !ReadChunk(ChunkIndex, Payload, Scratch))
+	{
+		return false;
+	}
+
+	if (Payload.Num() < sizeof(FLidarSweepHeader))
+	{
+		return false;
+	}
+
+	FLidarSweepHeader SweepHeader;
+	FMemory::Memcpy(&SweepHeader, Payload.GetData(), sizeof(SweepHeader));
+
+	const int32 NumPoints = SweepHeader.NumPoints;
+	if (NumPoints < 0 || NumPoints > OutFrame.GetCapacity() || uint64(Payload.Num()) != GetLidarSweepPayloadSize(NumPoints))
+	{
+		return false;
+	}
+
+	OutFrame.SweepTime = SweepHeader.SweepTime;
+	OutFrame.Sequence = SweepHeader.Sequence;
+	OutFrame.SensorTransform = FTransform(FQuat(SweepHeader.Rotation), SweepHeader.Location);
+	OutFrame.NumPoints = NumPoints;
+
+	const uint8* Cursor = Payload.GetData() + sizeof(SweepHeader);
+	auto ReadArray = [&Cursor, NumPoints](auto& Array)
+	{
+		const SIZE_T Bytes = NumPoints * sizeof(Array[0]);
+		FMemory::Memcpy(Array.GetData(), Cursor, Bytes);
+		Cursor += Bytes;
+	};
+
+	ReadArray(OutFrame.X);
+	ReadArray(OutFrame.Y);
+	ReadArray(OutFrame.Z);
+	ReadArray(OutFrame.Intensity);
+	ReadArray(OutFrame.Timestamp);
+	ReadArray(OutFrame.Instance);
+	ReadArray(OutFrame.Ring);
+	ReadArray(OutFrame.SemanticClass);
+
+	return true;
+}
+
+bool FSensorSimRecordingReader::ReadCameraImage(int32 ChunkIndex, FSensorSimImage& OutImage) const
+{
+	using namespace SensorSimRecording;
+
+	TArray<uint8> Scratch;
+	TArrayView<const uint8> Payload;
+	if (GetEntry(ChunkIndex).Type != static_cast<uint8>(ESensorSimChunkType::CameraImage) || !ReadChunk(ChunkIndex, Payload, Scratch)
+		|| Payload.Num() < sizeof(FCameraImageHeader))
+	{
+		return false;
+	}
+
+	FCameraImageHeader ImageHeader;
+	FMemory::Memcpy(&ImageHeader, Payload.GetData(), sizeof(ImageHeader));
+
+	const ESensorSimImageType Type = static_cast<ESensorSimImageType>(ImageHeader.Type);
+	if (ImageHeader.Type > static_cast<uint8>(ESensorSimImageType::Semantic)
+		|| uint64(Payload.Num()) != sizeof(ImageHeader) + uint64(ImageHeader.Width) * ImageHeader.Height * FSensorSimImage::GetBytesPerPixel(Type))
+	{
+		return false;
+	}
+
+	OutImage.Init(Type, ImageHeader.Width, ImageHeader.Height);
+	OutImage.Camera = ImageHeader.Camera;
+	OutImage.Time = ImageHeader.Time;
+	OutImage.Sequence = ImageHeader.Sequence;
+	OutImage.SensorTransform = FTransform(FQuat(ImageHeader.Rotation), ImageHeader.Location);
+	FMemory::Memcpy(OutImage.Pixels.GetData(), Payload.GetData() + sizeof(ImageHeader), OutImage.Pixels.Num());
+
+	return true;
+}
+
+bool FSensorSimRecordingReader::ReadVehicleStates(int32 ChunkIndex, TArray<FSensorSimVehicleStateSample>& OutSamples) const
+{
+	TArray<uint8> Scratch;
+	TArrayView<const uint8> Payload;
+	if (GetEntry(ChunkIndex).Type != static_cast<uint8>(ESensorSimChunkType::VehicleState) || !ReadChunk(ChunkIndex, Payload, Scratch))
+	{
+		return false;
+	}
+
+	if (Payload.Num() % sizeof(FSensorSimVehicleStateSample) != 0)
+	{
+		return false;
+	}
+
+	OutSamples.SetNumUninitialized(Payload.Num() / sizeof(FSensorSimVehicleStateSample));
+	FMemory::Memcpy(OutSamples.GetData(), Payload.GetData(), Payload.Num());
+	return true;
+}
+
+bool FSensorSimRecordingReader::ReadVehicleInputs(int32 ChunkIndex, TArray<FSensorSimPhysicsInputSample>& OutSamples) const
+{
+	TArray<uint8> Scratch;
+	TArrayView<const uint8> Payload;
+	if (GetEntry(ChunkIndex).Type != static_cast<uint8>(ESensorSimChunkType::VehicleInputs) || !ReadChunk(ChunkIndex, Payload, Scratch))
+	{
+		return false;
+	}
+
+	if (Payload.Num() % sizeof(FSensorSimPhysicsInputSample) != 0)
+	{
+		return false;
+	}
+
+	const int32 FirstSample = OutSamples.Num();
+	OutSamples.AddUninitialized(Payload.Num() / sizeof(FSensorSimPhysicsInputSample));
+	FMemory::Memcpy(OutSamples.GetData() + FirstSample, Payload.GetData(), Payload.Num());
+	return true;
+}
+
+bool FSensorSimRecordingReader::ReadAllVehicleInputs(uint16 StreamId, TArray<FSensorSimPhysicsInputSample>& OutSamples) const
+{
+	OutSamples.Reset();
+
+	// the index is stable sorted, so chunks of one stream keep the order they were written in
+	for (int32 ChunkIndex = 0; ChunkIndex < NumEntries; ++ChunkIndex)
+	{
+		const FSensorSimChunkIndexEntry& Entry = Entries[ChunkIndex];
+		if (Entry.Type == static_cast<uint8>(ESensorSimChunkType::VehicleInputs) && Entry.StreamId == StreamId && !ReadVehicleInputs(ChunkIndex, OutSamples))
+		{
+			return false;
+		}
+	}
+
+	return !OutSamples.IsEmpty();
+}
+
+bool FSensorSimRecordingReader::ReadImuSamples(int32 ChunkIndex, TArray<FSensorSimImuSample>& OutSamples) const
+{
+	return SensorSimRecording::ReadSamples(*this, ChunkIndex, ESensorSimChunkType::Imu, OutSamples);
+}
+
+bool FSensorSimRecordingReader::ReadWheelEncoderSamples(int32 ChunkIndex, TArray<FSensorSimWheelEncoderSample>& OutSamples) const
+{
+	return SensorSimRecording::ReadSamples(*this, ChunkIndex, ESensorSimChunkType::WheelEncoder, OutSamples);
+}
+
+bool FSensorSimRecordingReader::ReadStreamInfo(int32 ChunkIndex, FString& OutDescription) const
+{
+	TArray<uint8> Scratch;
+	TArrayView<const uint8> Payload;
+	if (GetEntry(ChunkIndex).Type != static_cast<uint8>(ESensorSimChunkType::StreamInfo) || !ReadChunk(ChunkIndex, Payload, Scratch))
+	{
+		return false;
+	}
+
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+	OutDescription = FString(Converted.Length(), Converted.Get());
+	return true;
+}
+
+int32 FSensorSimRecordingReader::GetLidarSweepNumPoints(int32 ChunkIndex) const
+{
+	TArray<uint8> Scratch;
+	TArrayView<const uint8> Payload;
+	if (GetEntry(ChunkIndex).Type != static_cast<uint8>(ESensorSimChunkType::LidarSweep) || !ReadChunk(ChunkIndex, Payload, Scratch)
+		|| Payload.Num() < sizeof(SensorSimRecording::FLidarSweepHeader))
+	{
+		return 0;
+	}
+
+	SensorSimRecording::FLidarSweepHeader SweepHeader;
+	FMemory::Memcpy(&SweepHeader, Payload.GetData(), sizeof(SweepHeader));
+	return SweepHeader.NumPoints;
+}
@@ -0,0 +1,502 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "SensorSimPointCloud.h"
+#include "SensorSimImage.h"
+#include "SensorSimRecording.generated.h"
+
+// Forward declarations
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+class FEvent;
+class FSocket;
+class FRunnableThread;
+
+/**
+ *  SensorSim recording (.ssrec) layout
+ *
+ *    FSensorSimRecordingFileHeader
+ *    { FSensorSimChunkHeader, payload } * N    chunks, optionally compressed
+ *    FSensorSimChunkIndexEntry * N             index, sorted by timestamp
+ *    FSensorSimRecordingFooter                 locates the index
+ *
+ *  Every structure is little endian and naturally aligned, so the index can be
+ *  searched in place from a memory mapped file.
+ *
+ *  SensorSim recording stream layout, over a local TCP connection
+ *
+ *    FSensorSimRecordingStreamHeader
+ *    { FSensorSimChunkHeader, payload } * N    chunks as stored in a file, without padding
+ *    FSensorSimChunkHeader                     of type EndOfStream, once the recording is complete
+ *
+ *  The receiver keeps the index.
+ */
+namespace SensorSimRecording
+{
+	constexpr uint32 FileMagic = 0x43455253;	// 'SREC'
+	constexpr uint32 FooterMagic = 0x58444953;	// 'SIDX'
+	constexpr uint32 StreamMagic = 0x52545353;	// 'SSTR'
+	constexpr uint32 Version = 2;
+
+	/** Maximum number of wheels stored per vehicle state sample */
+	constexpr int32 MaxWheels = 4;
+
+	/** Chunk type that ends a recording stream. Never stored in a file */
+	constexpr uint8 EndOfStream = 0xFF;
+}
+
+/** Kind of data a chunk holds */
+enum class ESensorSimChunkType : uint8
+{
+	/** UTF-8 description of a stream */
+	StreamInfo = 0,
+
+	/** One LiDAR sweep */
+	LidarSweep = 1,
+
+	/** A run of vehicle state samples */
+	VehicleState = 2,
+
+	/** A run of per physics step driver inputs */
+	VehicleInputs = 3,
+
+	/** A run of IMU samples */
+	Imu = 4,
+
+	/** A run of wheel encoder samples */
+	WheelEncoder = 5,
+
+	/** One camera image */
+	CameraImage = 6,
+};
+
+/** Chunk compression */
+UENUM()
+enum class ESensorSimRecordingCompression : uint8
+{
+	None,
+	LZ4,
+	Oodle,
+};
+
+struct FSensorSimRecordingFileHeader
+{
+	uint32 Magic = SensorSimRecording::FileMagic;
+	uint32 Version = SensorSimRecording::Version;
+};
+
+/** Opens a recording stream, identifying the job it records */
+struct FSensorSimRecordingStreamHeader
+{
+	uint32 Magic = SensorSimRecording::StreamMagic;
+	uint32 Version = SensorSimRecording::Version;
+
+	/** Job of the receiver the recording belongs to */
+	uint32 Job = 0;
+
+	/** Attempt at the job, counting from 0 */
+	uint32 Attempt = 0;
+};
+
+struct FSensorSimChunkHeader
+{
+	/** Time of the first sample in the chunk, in seconds */
+	double Timestamp = 0.0;
+
+	/** Payload size before compression */
+	uint32 RawSize = 0;
+
+	/** Payload size on disk */
+	uint32 StoredSize = 0;
+
+	/** Stream the chunk belongs to, typically one per vehicle */
+	uint16 StreamId = 0;
+
+	/** ESensorSimChunkType */
+	uint8 Type = 0;
+
+	/** ESensorSimRecordingCompression */
+	uint8 Compression = 0;
+
+	uint32 Reserved = 0;
+};
+
+struct FSensorSimChunkIndexEntry
+{
+	double Timestamp = 0.0;
+
+	/** File offset of the chunk header */
+	uint64 Offset = 0;
+
+	uint16 StreamId = 0;
+	uint8 Type = 0;
+	uint8 Reserved0 = 0;
+	uint32 Reserved1 = 0;
+};
+
+struct FSensorSimRecordingFooter
+{
+	uint64 IndexOffset = 0;
+	uint32 NumEntries = 0;
+	uint32 Magic = SensorSimRecording::FooterMagic;
+};
+
+static_assert(sizeof(FSensorSimRecordingFileHeader) == 8, "Recording header layout changed");
+static_assert(sizeof(FSensorSimChunkHeader) == 24, "Recording chunk header layout changed");
+static_assert(sizeof(FSensorSimChunkIndexEntry) == 24, "Recording index layout changed");
+static_assert(sizeof(FSensorSimRecordingFooter) == 16, "Recording footer layout changed");
+static_assert(sizeof(FSensorSimRecordingStreamHeader) == 16, "Recording stream header layout changed");
+
+/** Per-wheel Chaos state */
+struct FSensorSimWheelStateSample
+{
+	/** Wheel spin, in degrees per second */
+	float AngularVelocity = 0.0f;
+
+	/** Wheel rotation angle, in degrees */
+	float RotationAngle = 0.0f;
+
+	/** Suspension offset from rest, in cm */
+	float SuspensionOffset = 0.0f;
+
+	/** Normalized suspension length, 0 (compressed) to 1 (extended) */
+	float NormalizedSuspensionLength = 0.0f;
+
+	/** Tire slip angle, in degrees */
+	float SlipAngle = 0.0f;
+
+	/** Skid magnitude */
+	float SkidMagnitude = 0.0f;
+};
+
+/** Vehicle pose and Chaos movement state at one instant */
+struct FSensorSimVehicleStateSample
+{
+	/** World time, in seconds */
+	double Time = 0.0;
+
+	/** World location, in cm */
+	FVector3d Location = FVector3d::ZeroVector;
+
+	/** World rotation */
+	FQuat4f Rotation = FQuat4f::Identity;
+
+	/** Linear velocity, in cm/s */
+	FVector3f LinearVelocity = FVector3f::ZeroVector;
+
+	/** Angular velocity, in degrees/s */
+	FVector3f AngularVelocity = FVector3f::ZeroVector;
+
+	/** Forward speed, in cm/s */
+	float ForwardSpeed = 0.0f;
+
+	/** Engine speed, in RPM */
+	float EngineRPM = 0.0f;
+
+	/** Current gear, negative for reverse */
+	int32 Gear = 0;
+
+	/** Applied driver inputs */
+	float Steering = 0.0f;
+	float Throttle = 0.0f;
+	float Brake = 0.0f;
+	float Handbrake = 0.0f;
+
+	/** Number of valid wheel entries */
+	uint8 NumWheels = 0;
+
+	/** Bit per wheel, set if the wheel touches the ground */
+	uint8 WheelContactMask = 0;
+
+	uint16 Reserved = 0;
+
+	/** Wheel states, front left first */
+	FSensorSimWheelStateSample Wheels[SensorSimRecording::MaxWheels];
+
+	/** Pads the sample to a multiple of the Rotation alignment, so that no byte written is left uninitialized */
+	uint64 Reserved1 = 0;
+};
+
+static_assert(sizeof(FSensorSimWheelStateSample) == 24, "Wheel state sample layout changed");
+static_assert(offsetof(FSensorSimVehicleStateSample, Rotation) == 32 && offsetof(FSensorSimVehicleStateSample, NumWheels) == 100
+	&& offsetof(FSensorSimVehicleStateSample, Wheels) == 104 && offsetof(FSensorSimVehicleStateSample, Reserved1) == 200
+	&& sizeof(FSensorSimVehicleStateSample) == 208, "Vehicle state sample layout changed");
+static_assert(TIsTriviallyCopyAssignable<FSensorSimVehicleStateSample>::Value, "Vehicle state samples are written with memcpy");
+
+/** Flags of a physics input sample */
+enum class ESensorSimPhysicsInputFlags : uint8
+{
+	None = 0,
+	GearUp = 1 << 0,
+	GearDown = 1 << 1,
+	Parking = 1 << 2,
+};
+
+ENUM_CLASS_FLAGS(ESensorSimPhysicsInputFlags);
+
+/** Driver inputs Chaos applied on one physics step */
+struct FSensorSimPhysicsInputSample
+{
+	/** Physics steps taken by the vehicle's simulation before this one */
+	uint32 Step = 0;
+
+	/** Physics step length, in seconds */
+	float DeltaTime = 0.0f;
+
+	float Steering = 0.0f;
+	float Throttle = 0.0f;
+	float Brake = 0.0f;
+	float Handbrake = 0.0f;
+
+	/** ESensorSimPhysicsInputFlags */
+	uint8 Flags = 0;
+
+	uint8 Reserved0 = 0;
+	uint16 Reserved1 = 0;
+};
+
+static_assert(sizeof(FSensorSimPhysicsInputSample) == 28, "Physics input sample layout changed");
+
+/** One IMU reading, in the sensor frame */
+struct FSensorSimImuSample
+{
+	/** World time, in seconds */
+	double Time = 0.0;
+
+	/** Specific force (acceleration minus gravity), in m/s^2 */
+	FVector3f LinearAcceleration = FVector3f::ZeroVector;
+
+	/** Angular velocity, in rad/s */
+	FVector3f AngularVelocity = FVector3f::ZeroVector;
+
+	/** Sensor orientation in the world */
+	FQuat4f Orientation = FQuat4f::Identity;
+};
+
+static_assert(sizeof(FSensorSimImuSample) == 48, "IMU sample layout changed");
+
+/** One reading of the wheel encoders */
+struct FSensorSimWheelEncoderSample
+{
+	/** World time, in seconds */
+	double Time = 0.0;
+
+	/** Accumulated encoder ticks, front left first. Negative when rolling backwards */
+	int32 Ticks[SensorSimRecording::MaxWheels] = {};
+
+	/** Wheel angular velocity, in rad/s */
+	float AngularVelocity[SensorSimRecording::MaxWheels] = {};
+
+	/** Number of valid wheel entries */
+	uint8 NumWheels = 0;
+
+	uint8 Reserved0 = 0;
+	uint16 Reserved1 = 0;
+	uint32 Reserved2 = 0;
+};
+
+static_assert(sizeof(FSensorSimWheelEncoderSample) == 48, "Wheel encoder sample layout changed");
+
+/**
+ *  Recording Writer
+ *  Streams chunks to disk, or to a receiver over a local TCP connection, from a background I/O thread. Producers only
+ *  enqueue: LiDAR frames and camera images are passed by reference and serialized on the I/O thread,
+ *  LiDAR frames returning to their pool once written.
+ */
+class SENSORSIM_API FSensorSimRecordingWriter : public FRunnable
+{
+public:
+	FSensorSimRecordingWriter();
+	virtual ~FSensorSimRecordingWriter() override;
+
+	/** Creates the file and starts the I/O thread */
+	bool Open(const FString& InFilename, ESensorSimRecordingCompression InCompression);
+
+	/** Connects to a receiver at <address>:<port> and starts the I/O thread. Chunks are sent rather than written */
+	bool Connect(const FString& Endpoint, uint32 Job, uint32 Attempt, ESensorSimRecordingCompression InCompression);
+
+	/** Flushes every pending chunk, writes the index and closes the file, or ends the stream */
+	void Close();
+
+	/** Returns true between Open and Close */
+	bool IsOpen() const { return Thread != nullptr; }
+
+	/** Returns the file being written, or the endpoint streamed to */
+	const FString& GetFilename() const { return Filename; }
+
+	/** Queues a stream description */
+	void AddStreamInfo(uint16 StreamId, const FString& Description, double Timestamp);
+
+	/** Queues a LiDAR sweep. The frame is held until it has been written */
+	void AddLidarSweep(uint16 StreamId, const FSensorSimPointCloudRef& Frame);
+
+	/** Queues a camera image. The image is held until it has been written */
+	void AddCameraImage(uint16 StreamId, const FSensorSimImageRef& Image);
+
+	/** Queues a run of vehicle state samples */
+	void AddVehicleStates(uint16 StreamId, TArray<FSensorSimVehicleStateSample>&& Samples);
+
+	/** Queues a run of physics step inputs, stamped with the world time they were collected at */
+	void AddVehicleInputs(uint16 StreamId, TArray<FSensorSimPhysicsInputSample>&& Samples, double Timestamp);
+
+	/** Queues a run of IMU samples */
+	void AddImuSamples(uint16 StreamId, TArray<FSensorSimImuSample>&& Samples);
+
+	/** Queues a run of wheel encoder samples */
+	void AddWheelEncoderSamples(uint16 StreamId, TArray<FSensorSimWheelEncoderSample>&& Samples);
+
+	/** Queues a chunk read from another recording, written as stored, without recompressing it. Its stream id is replaced */
+	void AddStoredChunk(uint16 StreamId, const FSensorSimChunkHeader& Header, TArray<uint8>&& Payload);
+
+	/** Leaves every chunk of a stream out of the index written on Close. Game thread only */
+	void DiscardStream(uint16 StreamId) { DiscardedStreams.AddUnique(StreamId); }
+
+	/** Returns the bytes written to disk so far */
+	uint64 GetBytesWritten() const { return BytesWritten.load(std::memory_order_relaxed); }
+
+	/** Returns the number of chunks waiting to be written */
+	int32 GetNumPendingChunks() const { return NumPendingChunks.load(std::memory_order_relaxed); }
+
+	// Begin Runnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// End Runnable interface
+
+private:
+	/** Chunk waiting for the I/O thread */
+	struct FPendingChunk
+	{
+		ESensorSimChunkType Type = ESensorSimChunkType::StreamInfo;
+		uint16 StreamId = 0;
+		double Timestamp = 0.0;
+
+		/** Serialized payload, for everything but LiDAR sweeps and camera images */
+		TArray<uint8> Payload;
+
+		/** LiDAR sweep, serialized on the I/O thread */
+		TSharedPtr<const FSensorSimPointCloudFrame, ESPMode::ThreadSafe> Frame;
+
+		/** Camera image, serialized on the I/O thread */
+		TSharedPtr<const FSensorSimImage, ESPMode::ThreadSafe> Image;
+
+		/** Header of a payload that is already stored, possibly compressed */
+		TOptional<FSensorSimChunkHeader> StoredHeader;
+	};
+
+	/** Queues a run of fixed size samples as one chunk */
+	void AddSampleChunk(ESensorSimChunkType Type, uint16 StreamId, double Timestamp, const void* Samples, SIZE_T Bytes);
+
+	/** Hands a chunk to the I/O thread */
+	void Enqueue(FPendingChunk&& Chunk);
+
+	/** Writes every queued chunk. I/O thread only */
+	void DrainQueue();
+
+	/** Serializes, compresses and writes one chunk. I/O thread only */
+	void WriteChunk(FPendingChunk& Chunk);
+
+	/** Writes bytes to the file, or sends them to the receiver. I/O thread only, after Open or Connect */
+	bool WriteBytes(const void* Bytes, int64 Size);
+
+	FString Filename;
+	ESensorSimRecordingCompression Compression = ESensorSimRecordingCompression::None;
+
+	TQueue<FPendingChunk, EQueueMode::Mpsc> Queue;
+	FEvent* WorkEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopRequested{ false };
+
+	/** Written by the I/O thread only */
+	TUniquePtr<IFileHandle> File;
+	FSocket* Socket = nullptr;
+	bool bSendFailed = false;
+	TArray<FSensorSimChunkIndexEntry> Index;
+	TArray<uint8> RawScratch;
+	TArray<uint8> CompressedScratch;
+
+	std::atomic<uint64> BytesWritten{ 0 };
+	std::atomic<int32> NumPendingChunks{ 0 };
+
+	/** Streams left out of the index */
+	TArray<uint16> DiscardedStreams;
+};
+
+/**
+ *  Recording Reader
+ *  Memory maps a recording and reads chunks in place. Opening groups the index by chunk type and stream,
+ *  so seeking to any timestamp costs O(log n) however sparse the chunks of that type and stream are.
+ */
+class SENSORSIM_API FSensorSimRecordingReader
+{
+public:
+	FSensorSimRecordingReader();
+	~FSensorSimRecordingReader();
+
+	/** Maps the file and validates its header and footer */
+	bool Open(const FString& Filename);
+
+	/** Unmaps the file */
+	void Close();
+
+	/** Returns the number of chunks */
+	int32 GetNumChunks() const { return NumEntries; }
+
+	/** Returns the index entry of a chunk */
+	const FSensorSimChunkIndexEntry& GetEntry(int32 ChunkIndex) const { return Entries[ChunkIndex]; }
+
+	/** Returns the time span covered by the chunks */
+	double GetStartTime() const;
+	double GetEndTime() const;
+
+	/**
+	 *  Returns the last chunk of the given type and stream starting at or before Time,
+	 *  or the first one after it if there is none. StreamId -1 matches every stream. Returns INDEX_NONE if no chunk matches.
+	 */
+	int32 Seek(double Time, ESensorSimChunkType Type, int32 StreamId = -1) const;
+
+	/** Returns the payload of a chunk, decompressing it if needed. Uncompressed payloads point into the mapping */
+	bool ReadChunk(int32 ChunkIndex, TArrayView<const uint8>& OutPayload, TArray<uint8>& Scratch) const;
+
+	/** Decodes a LiDAR sweep chunk into a frame of sufficient capacity */
+	bool ReadLidarSweep(int32 ChunkIndex, FSensorSimPointCloudFrame& OutFrame) const;
+
+	/** Decodes a camera image chunk */
+	bool ReadCameraImage(int32 ChunkIndex, FSensorSimImage& OutImage) const;
+
+	/** Decodes a vehicle state chunk */
+	bool ReadVehicleStates(int32 ChunkIndex, TArray<FSensorSimVehicleStateSample>& OutSamples) const;
+
+	/** Decodes a physics input chunk, appending its samples */
+	bool ReadVehicleInputs(int32 ChunkIndex, TArray<FSensorSimPhysicsInputSample>& OutSamples) const;
+
+	/** Decodes every physics input chunk of a stream, in recording order */
+	bool ReadAllVehicleInputs(uint16 StreamId, TArray<FSensorSimPhysicsInputSample>& OutSamples) const;
+
+	/** Decodes an IMU chunk */
+	bool ReadImuSamples(int32 ChunkIndex, TArray<FSensorSimImuSample>& OutSamples) const;
+
+	/** Decodes a wheel encoder chunk */
+	bool ReadWheelEncoderSamples(int32 ChunkIndex, TArray<FSensorSimWheelEncoderSample>& OutSamples) const;
+
+	/** Decodes a stream info chunk */
+	bool ReadStreamInfo(int32 ChunkIndex, FString& OutDescription) const;
+
+	/** Returns the number of points stored in a LiDAR sweep chunk, to size a frame for ReadLidarSweep */
+	int32 GetLidarSweepNumPoints(int32 ChunkIndex) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+
+	const FSensorSimChunkIndexEntry* Entries = nullptr;
+	int32 NumEntries = 0;
+
+	/** Indices of the chunks of each type and stream, and of each type over every stream, in time order */
+	TMap<uint32, TArray<int32>> SeekLists;
+};
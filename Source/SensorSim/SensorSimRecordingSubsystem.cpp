@@ -0,0 +1,276 @@
+#include "SensorSimRecordingSubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimPawn.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimCameraComponent.h"
+#include "SensorSimImuComponent.h"
+#include "SensorSimWheelEncoderComponent.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdRecordStart(
+	TEXT("SensorSim.Record.Start"),
+	TEXT("Records every vehicle's LiDAR sweeps, camera images and state. Usage: SensorSim.Record.Start [<File>]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimRecordingSubsystem* Recording = World ? World->GetSubsystem<USensorSimRecordingSubsystem>() : nullptr)
+		{
+			Recording->StartRecording(Args.Num() > 0 ? Args[0] : FString());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdRecordStop(
+	TEXT("SensorSim.Record.Stop"),
+	TEXT("Stops the running recording"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimRecordingSubsystem* Recording = World ? World->GetSubsystem<USensorSimRecordingSubsystem>() : nullptr)
+		{
+			Recording->StopRecording();
+		}
+	}));
+
+bool USensorSimRecordingSubsystem::StartRecording(const FString& Filename)
+{
+	if (IsRecording())
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Already recording to '%s'"), *Writer->GetFilename());
+		return false;
+	}
+
+	const FString ResolvedFilename = ResolveFilename(Filename.IsEmpty() ? FString::Printf(TEXT("%s.ssrec"), *FDateTime::Now().ToString()) : Filename);
+
+	Writer = MakeUnique<FSensorSimRecordingWriter>();
+	if (!Writer->Open(ResolvedFilename, Compression))
+	{
+		Writer.Reset();
+		return false;
+	}
+
+	RecordAllVehicles();
+	return true;
+}
+
+bool USensorSimRecordingSubsystem::StartStreaming(const FString& Endpoint, uint32 Job, uint32 Attempt)
+{
+	if (IsRecording())
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Already recording to '%s'"), *Writer->GetFilename());
+		return false;
+	}
+
+	Writer = MakeUnique<FSensorSimRecordingWriter>();
+	if (!Writer->Connect(Endpoint, Job, Attempt, Compression))
+	{
+		Writer.Reset();
+		return false;
+	}
+
+	RecordAllVehicles();
+	return true;
+}
+
+void USensorSimRecordingSubsystem::RecordAllVehicles()
+{
+	ChunkStartTime = GetWorld()->GetTimeSeconds();
+
+	for (TActorIterator<ASensorSimPawn> It(GetWorld()); It; ++It)
+	{
+		RecordVehicle(*It);
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("Recording %d vehicles to '%s'"), Vehicles.Num(), *Writer->GetFilename());
+}
+
+void USensorSimRecordingSubsystem::StopRecording()
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	for (FSensorSimRecordedVehicle& Vehicle : Vehicles)
+	{
+		for (const TPair<TWeakObjectPtr<USensorSimCameraComponent>, FDelegateHandle>& CameraHandle : Vehicle.CameraHandles)
+		{
+			if (USensorSimCameraComponent* Camera = CameraHandle.Key.Get())
+			{
+				Camera->OnImage.Remove(CameraHandle.Value);
+			}
+		}
+
+		if (ASensorSimPawn* Pawn = Vehicle.Pawn.Get())
+		{
+			Pawn->GetLidarScanner()->OnSweep.Remove(Vehicle.SweepHandle);
+			Pawn->GetImu()->OnSamples.Remove(Vehicle.ImuHandle);
+			Pawn->GetWheelEncoders()->OnSamples.Remove(Vehicle.WheelEncoderHandle);
+			Pawn->GetSensorSimMovement()->StopInputRecording();
+			Pawn->GetSensorSimMovement()->ConsumeRecordedInputs(Vehicle.PendingInputs);
+		}
+	}
+
+	FlushChunks();
+
+	Vehicles.Reset();
+
+	// waits for the I/O thread to write everything queued so far
+	Writer->Close();
+
+	UE_LOG(LogSensorSim, Display, TEXT("Recorded %.1f MB to '%s'"), Writer->GetBytesWritten() / (1024.0 * 1024.0), *Writer->GetFilename());
+	Writer.Reset();
+}
+
+void USensorSimRecordingSubsystem::RecordVehicle(ASensorSimPawn* Pawn)
+{
+	if (!IsRecording() || !Pawn || Vehicles.ContainsByPredicate([Pawn](const FSensorSimRecordedVehicle& Vehicle) { return Vehicle.Pawn == Pawn; }))
+	{
+		return;
+	}
+
+	// vehicles stay listed until the recording stops, so stream ids are never reused within a file
+	const uint16 StreamId = static_cast<uint16>(Vehicles.Num());
+
+	FSensorSimRecordedVehicle& Vehicle = Vehicles.AddDefaulted_GetRef();
+	Vehicle.Pawn = Pawn;
+	Vehicle.StreamId = StreamId;
+
+	FSensorSimRecordingWriter* RecordingWriter = Writer.Get();
+	Vehicle.SweepHandle = Pawn->GetLidarScanner()->OnSweep.AddLambda([RecordingWriter, StreamId](const FSensorSimPointCloudRef& Frame)
+	{
+		RecordingWriter->AddLidarSweep(StreamId, Frame);
+	});
+
+	TInlineComponentArray<USensorSimCameraComponent*> Cameras(Pawn);
+	for (USensorSimCameraComponent* Camera : Cameras)
+	{
+		Vehicle.CameraHandles.Emplace(Camera, Camera->OnImage.AddLambda([RecordingWriter, StreamId](const FSensorSimImageRef& Image)
+		{
+			RecordingWriter->AddCameraImage(StreamId, Image);
+		}));
+	}
+
+	// physics rate samples are buffered on the game thread and written in chunks
+	Vehicle.ImuHandle = Pawn->GetImu()->OnSamples.AddWeakLambda(this, [this, StreamId](TConstArrayView<FSensorSimImuSample> Samples)
+	{
+		Vehicles[StreamId].PendingImu.Append(Samples);
+	});
+
+	Vehicle.WheelEncoderHandle = Pawn->GetWheelEncoders()->OnSamples.AddWeakLambda(this, [this, StreamId](TConstArrayView<FSensorSimWheelEncoderSample> Samples)
+	{
+		Vehicles[StreamId].PendingWheelEncoder.Append(Samples);
+	});
+
+	// inputs logged since the vehicle's first physics step, if recording was requested on the command line, are kept
+	Pawn->GetSensorSimMovement()->StartInputRecording();
+
+	Writer->AddStreamInfo(StreamId, FString::Printf(TEXT("%s (%s)"), *Pawn->GetName(), *Pawn->GetClass()->GetName()), GetWorld()->GetTimeSeconds());
+}
+
+void USensorSimRecordingSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bCheckedCommandLine)
+	{
+		bCheckedCommandLine = true;
+
+		// start once every level actor has begun play
+		const TCHAR* CommandLine = FCommandLine::Get();
+		FString Filename;
+		FString Endpoint;
+		if (FParse::Value(CommandLine, TEXT("SensorSimRecord="), Filename))
+		{
+			StartRecording(Filename);
+		}
+		else if (FParse::Value(CommandLine, TEXT("SensorSimRecordStream="), Endpoint))
+		{
+			uint32 Job = 0;
+			uint32 Attempt = 0;
+			FParse::Value(CommandLine, TEXT("SensorSimJob="), Job);
+			FParse::Value(CommandLine, TEXT("SensorSimAttempt="), Attempt);
+
+			// a worker that cannot stream produces nothing; its coordinator retries the job
+			if (!StartStreaming(Endpoint, Job, Attempt))
+			{
+				FPlatformMisc::RequestExitWithStatus(false, 1);
+			}
+		}
+	}
+
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+
+	for (FSensorSimRecordedVehicle& Vehicle : Vehicles)
+	{
+		// parked vehicles are out of the simulation
+		const ASensorSimPawn* Pawn = Vehicle.Pawn.Get();
+		if (Pawn && !Pawn->IsParked())
+		{
+			Pawn->SampleState(WorldTime, Vehicle.PendingStates.AddDefaulted_GetRef());
+			Pawn->GetSensorSimMovement()->ConsumeRecordedInputs(Vehicle.PendingInputs);
+		}
+	}
+
+	if (WorldTime - ChunkStartTime >= ChunkSeconds)
+	{
+		FlushChunks();
+		ChunkStartTime = WorldTime;
+	}
+}
+
+TStatId USensorSimRecordingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USensorSimRecordingSubsystem, STATGROUP_Tickables);
+}
+
+void USensorSimRecordingSubsystem::Deinitialize()
+{
+	StopRecording();
+
+	Super::Deinitialize();
+}
+
+bool USensorSimRecordingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USensorSimRecordingSubsystem::FlushChunks()
+{
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+
+	for (FSensorSimRecordedVehicle& Vehicle : Vehicles)
+	{
+		Writer->AddVehicleStates(Vehicle.StreamId, MoveTemp(Vehicle.PendingStates));
+		Vehicle.PendingStates.Reset();
+
+		Writer->AddVehicleInputs(Vehicle.StreamId, MoveTemp(Vehicle.PendingInputs), WorldTime);
+		Vehicle.PendingInputs.Reset();
+
+		Writer->AddImuSamples(Vehicle.StreamId, MoveTemp(Vehicle.PendingImu));
+		Vehicle.PendingImu.Reset();
+
+		Writer->AddWheelEncoderSamples(Vehicle.StreamId, MoveTemp(Vehicle.PendingWheelEncoder));
+		Vehicle.PendingWheelEncoder.Reset();
+	}
+}
+
+FString USensorSimRecordingSubsystem::ResolveFilename(const FString& Filename) const
+{
+	if (!FPaths::IsRelative(Filename))
+	{
+		return Filename;
+	}
+
+	const FString Directory = OutputDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("Recordings") : OutputDirectory;
+	return FPaths::ConvertRelativePathToFull(Directory / Filename);
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SensorSimRecording.h"
+#include "SensorSimRecordingSubsystem.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+class USensorSimCameraComponent;
+
+/**
+ *  Recorded vehicle bookkeeping
+ *  One stream per vehicle, carrying its LiDAR sweeps, camera images and state samples.
+ */
+USTRUCT()
+struct FSensorSimRecordedVehicle
+{
+	GENERATED_BODY()
+
+	/** Recorded vehicle */
+	TWeakObjectPtr<ASensorSimPawn> Pawn;
+
+	/** Stream the vehicle's chunks are written to */
+	uint16 StreamId{ 0 };
+
+	/** Binding to the vehicle's LiDAR sweeps */
+	FDelegateHandle SweepHandle;
+
+	/** Bindings to the images of each of the vehicle's cameras */
+	TArray<TPair<TWeakObjectPtr<USensorSimCameraComponent>, FDelegateHandle>> CameraHandles;
+
+	/** State samples not yet handed to the writer */
+	TArray<FSensorSimVehicleStateSample> PendingStates;
+
+	/** Physics step inputs not yet handed to the writer */
+	TArray<FSensorSimPhysicsInputSample> PendingInputs;
+
+	/** Binding to the vehicle's IMU samples */
+	FDelegateHandle ImuHandle;
+
+	/** IMU samples not yet handed to the writer */
+	TArray<FSensorSimImuSample> PendingImu;
+
+	/** Binding to the vehicle's wheel encoder samples */
+	FDelegateHandle WheelEncoderHandle;
+
+	/** Wheel encoder samples not yet handed to the writer */
+	TArray<FSensorSimWheelEncoderSample> PendingWheelEncoder;
+};
+
+/**
+ *  Recording Subsystem
+ *  Records every vehicle's LiDAR sweeps, camera images, IMU and wheel encoder samples, Chaos state and physics step inputs
+ *  to a .ssrec file. Sweeps and images are queued by reference as they complete; state is sampled every frame and inputs
+ *  are collected from the physics thread, both written in chunks of ChunkSeconds.
+ *  All disk I/O runs on the writer's own thread.
+ *
+ *  Console commands:
+ *    SensorSim.Record.Start [<File>]
+ *    SensorSim.Record.Stop
+ *
+ *  Command line:
+ *    -SensorSimRecord=<File>    records from the first frame
+ *    -SensorSimRecordStream=<Address:Port> -SensorSimJob=<Id> -SensorSimAttempt=<N>
+ *                               streams the recording of a job to a coordinator, from the first frame
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimRecordingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Chunk compression */
+	UPROPERTY(Config)
+	ESensorSimRecordingCompression Compression{ ESensorSimRecordingCompression::LZ4 };
+
+	/** Simulation seconds of vehicle state per chunk */
+	UPROPERTY(Config)
+	float ChunkSeconds{ 1.0f };
+
+	/** Directory relative file names are resolved against. Defaults to Saved/Recordings */
+	UPROPERTY(Config)
+	FString OutputDirectory;
+
+	/** Recorded vehicles */
+	UPROPERTY(Transient)
+	TArray<FSensorSimRecordedVehicle> Vehicles;
+
+	/** Background writer, valid while recording */
+	TUniquePtr<FSensorSimRecordingWriter> Writer;
+
+	/** Time the pending state chunks started at */
+	double ChunkStartTime{ 0.0 };
+
+	/** True once the command line has been checked for -SensorSimRecord and -SensorSimRecordStream */
+	bool bCheckedCommandLine{ false };
+
+public:
+	/** Starts recording every vehicle in the world. Generates a file name if none is given */
+	bool StartRecording(const FString& Filename = FString());
+
+	/** Starts streaming the recording of every vehicle in the world to a receiver at <address>:<port> */
+	bool StartStreaming(const FString& Endpoint, uint32 Job, uint32 Attempt);
+
+	/** Flushes the pending chunks and closes the file */
+	void StopRecording();
+
+	/** Returns true while recording */
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	/** Adds a vehicle spawned after the recording started */
+	void RecordVehicle(ASensorSimPawn* Pawn);
+
+	// Begin TickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End TickableWorldSubsystem interface
+
+	// Begin WorldSubsystem interface
+	virtual void Deinitialize() override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Records every vehicle in the world, once the writer is open */
+	void RecordAllVehicles();
+
+	/** Hands every vehicle's pending samples and inputs to the writer */
+	void FlushChunks();
+
+	/** Resolves a file name against the output directory */
+	FString ResolveFilename(const FString& Filename) const;
+};
@@ -0,0 +1,309 @@
+#include "SensorSimScenarioSubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimPawn.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdScenarioSnapshot(
+	TEXT("SensorSim.Scenario.Snapshot"),
+	TEXT("Records the vehicles in play and every simulating body as the state scenarios are reset to"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimScenarioSubsystem* Scenario = World ? World->GetSubsystem<USensorSimScenarioSubsystem>() : nullptr)
+		{
+			Scenario->CaptureSnapshot();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdScenarioReset(
+	TEXT("SensorSim.Scenario.Reset"),
+	TEXT("Returns the world to the last snapshot and clears every sensor buffer"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimScenarioSubsystem* Scenario = World ? World->GetSubsystem<USensorSimScenarioSubsystem>() : nullptr)
+		{
+			Scenario->ResetScenario();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdScenarioPrewarm(
+	TEXT("SensorSim.Scenario.Prewarm"),
+	TEXT("Parks <Count> instances of every prewarmed vehicle class. Usage: SensorSim.Scenario.Prewarm <Count>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimScenarioSubsystem* Scenario = World ? World->GetSubsystem<USensorSimScenarioSubsystem>() : nullptr)
+		{
+			Scenario->PrewarmConfiguredClasses(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1);
+		}
+	}));
+
+namespace SensorSimScenario
+{
+	/** Distance between neighbouring parking spots, in cm */
+	constexpr double ParkingSpacing = 1000.0;
+}
+
+ASensorSimPawn* USensorSimScenarioSubsystem::AcquireVehicle(UClass* VehicleClass, const FTransform& Transform, int32 ArchetypeIndex)
+{
+	if (!VehicleClass)
+	{
+		return nullptr;
+	}
+
+	const int32 PoolIndex = PooledVehicles.IndexOfByPredicate([VehicleClass, ArchetypeIndex](const ASensorSimPawn* Pawn)
+	{
+		return IsValid(Pawn) && Pawn->GetClass() == VehicleClass && Pawn->GetArchetypeIndex() == ArchetypeIndex;
+	});
+
+	ASensorSimPawn* Pawn = nullptr;
+	if (PoolIndex != INDEX_NONE)
+	{
+		Pawn = PooledVehicles[PoolIndex];
+		PooledVehicles.RemoveAtSwap(PoolIndex);
+	}
+	else
+	{
+		Pawn = SpawnParkedVehicle(VehicleClass, ArchetypeIndex);
+		if (!Pawn)
+		{
+			return nullptr;
+		}
+	}
+
+	AcquiredVehicles.Add(Pawn);
+
+	Pawn->SetParked(false);
+	Pawn->RestartVehicle(Transform);
+
+	return Pawn;
+}
+
+void USensorSimScenarioSubsystem::ReleaseVehicle(ASensorSimPawn* Pawn)
+{
+	if (!IsValid(Pawn) || AcquiredVehicles.RemoveSingleSwap(Pawn) == 0)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("'%s' was not acquired from the vehicle pool"), *GetNameSafe(Pawn));
+		return;
+	}
+
+	// parked vehicles hold on to no frames or samples
+	Pawn->ResetSensors();
+	Pawn->SetParked(true);
+	Pawn->SetActorTransform(GetParkingTransform(PooledVehicles.Num()), false, nullptr, ETeleportType::ResetPhysics);
+
+	PooledVehicles.Add(Pawn);
+}
+
+void USensorSimScenarioSubsystem::PrewarmPool(UClass* VehicleClass, int32 Count)
+{
+	if (!VehicleClass)
+	{
+		return;
+	}
+
+	int32 NumParked = 0;
+	for (const ASensorSimPawn* Pawn : PooledVehicles)
+	{
+		NumParked += IsValid(Pawn) && Pawn->GetClass() == VehicleClass && Pawn->GetArchetypeIndex() == INDEX_NONE ? 1 : 0;
+	}
+
+	for (; NumParked < Count; ++NumParked)
+	{
+		ASensorSimPawn* Pawn = SpawnParkedVehicle(VehicleClass);
+		if (!Pawn)
+		{
+			return;
+		}
+
+		PooledVehicles.Add(Pawn);
+	}
+}
+
+void USensorSimScenarioSubsystem::PrewarmConfiguredClasses(int32 Count)
+{
+	for (const TSoftClassPtr<ASensorSimPawn>& VehicleClass : PrewarmClasses)
+	{
+		if (UClass* LoadedClass = VehicleClass.LoadSynchronous())
+		{
+			PrewarmPool(LoadedClass, Count);
+		}
+		else
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("Failed to load pooled vehicle class %s"), *VehicleClass.ToString());
+		}
+	}
+
+	UE_LOG(LogSensorSim, Log, TEXT("Vehicle pool: %d parked, %d acquired"), PooledVehicles.Num(), AcquiredVehicles.Num());
+}
+
+void USensorSimScenarioSubsystem::CaptureSnapshot()
+{
+	SnapshotVehicles.Reset();
+	SnapshotBodies.Reset();
+
+	AcquiredVehicles.RemoveAllSwap([](const ASensorSimPawn* Pawn) { return !IsValid(Pawn); });
+
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		if (ASensorSimPawn* Pawn = Cast<ASensorSimPawn>(*It))
+		{
+			if (!Pawn->IsParked())
+			{
+				FSensorSimVehicleSnapshot& Vehicle = SnapshotVehicles.AddDefaulted_GetRef();
+				Vehicle.Pawn = Pawn;
+				Vehicle.Transform = Pawn->GetActorTransform();
+				Vehicle.LinearVelocity = Pawn->GetMesh()->GetPhysicsLinearVelocity();
+				Vehicle.AngularVelocity = Pawn->GetMesh()->GetPhysicsAngularVelocityInDegrees();
+				Vehicle.bPooled = AcquiredVehicles.Contains(Pawn);
+				Pawn->SavePhysicsState(Vehicle.PhysicsState);
+			}
+			continue;
+		}
+
+		// only simulated bodies move on their own; anything else is either static or driven by its owner
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(*It);
+		for (UPrimitiveComponent* Primitive : Primitives)
+		{
+			if (Primitive->IsSimulatingPhysics())
+			{
+				FSensorSimBodySnapshot& Body = SnapshotBodies.AddDefaulted_GetRef();
+				Body.Component = Primitive;
+				Body.Transform = Primitive->GetComponentTransform();
+				Body.LinearVelocity = Primitive->GetPhysicsLinearVelocity();
+				Body.AngularVelocity = Primitive->GetPhysicsAngularVelocityInDegrees();
+			}
+		}
+	}
+
+	bHasSnapshot = true;
+
+	UE_LOG(LogSensorSim, Log, TEXT("Scenario snapshot: %d vehicles, %d bodies"), SnapshotVehicles.Num(), SnapshotBodies.Num());
+	OnSnapshotCaptured.Broadcast();
+}
+
+bool USensorSimScenarioSubsystem::ResetScenario()
+{
+	if (!bHasSnapshot)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("No scenario snapshot to reset to"));
+		return false;
+	}
+
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimScenarioReset);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// vehicles acquired since the snapshot go back to the pool
+	for (int32 Index = AcquiredVehicles.Num() - 1; Index >= 0; --Index)
+	{
+		ASensorSimPawn* Pawn = AcquiredVehicles[Index];
+		if (!IsValid(Pawn))
+		{
+			AcquiredVehicles.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (!SnapshotVehicles.ContainsByPredicate([Pawn](const FSensorSimVehicleSnapshot& Vehicle) { return Vehicle.Pawn == Pawn; }))
+		{
+			ReleaseVehicle(Pawn);
+		}
+	}
+
+	for (const FSensorSimVehicleSnapshot& Vehicle : SnapshotVehicles)
+	{
+		ASensorSimPawn* Pawn = Vehicle.Pawn.Get();
+		if (!IsValid(Pawn))
+		{
+			continue;
+		}
+
+		// released since the snapshot, so take the same instance back out of the pool
+		if (Pawn->IsParked())
+		{
+			PooledVehicles.RemoveSingleSwap(Pawn);
+			if (Vehicle.bPooled)
+			{
+				AcquiredVehicles.Add(Pawn);
+			}
+
+			Pawn->SetParked(false);
+		}
+
+		// wheels, suspension and drivetrain pick up where they were, rather than from rest
+		if (Vehicle.PhysicsState.IsEmpty() || !Pawn->RestorePhysicsState(Vehicle.PhysicsState))
+		{
+			Pawn->RestartVehicle(Vehicle.Transform);
+			Pawn->GetMesh()->SetPhysicsLinearVelocity(Vehicle.LinearVelocity);
+			Pawn->GetMesh()->SetPhysicsAngularVelocityInDegrees(Vehicle.AngularVelocity);
+		}
+	}
+
+	for (const FSensorSimBodySnapshot& Body : SnapshotBodies)
+	{
+		if (UPrimitiveComponent* Component = Body.Component.Get())
+		{
+			Component->SetWorldTransform(Body.Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Component->SetPhysicsLinearVelocity(Body.LinearVelocity);
+			Component->SetPhysicsAngularVelocityInDegrees(Body.AngularVelocity);
+		}
+	}
+
+	LastResetSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	UE_LOG(LogSensorSim, Log, TEXT("Scenario reset: %d vehicles, %d bodies in %.2f ms"), SnapshotVehicles.Num(), SnapshotBodies.Num(), LastResetSeconds * 1000.0);
+	OnScenarioReset.Broadcast();
+	return true;
+}
+
+void USensorSimScenarioSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// command line overrides config
+	int32 Count = PrewarmCount;
+	FParse::Value(FCommandLine::Get(), TEXT("ScenarioPrewarm="), Count);
+
+	if (Count > 0)
+	{
+		PrewarmConfiguredClasses(Count);
+	}
+}
+
+bool USensorSimScenarioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+ASensorSimPawn* USensorSimScenarioSubsystem::SpawnParkedVehicle(UClass* VehicleClass, int32 ArchetypeIndex)
+{
+	const FTransform ParkingTransform = GetParkingTransform(PooledVehicles.Num());
+
+	// deferred, so that the archetype is in place before BeginPlay; the Chaos vehicle it rebuilds was created on registration
+	ASensorSimPawn* Pawn = GetWorld()->SpawnActorDeferred<ASensorSimPawn>(VehicleClass, ParkingTransform, nullptr, nullptr,
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!Pawn)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to spawn pooled vehicle %s"), *GetNameSafe(VehicleClass));
+		return nullptr;
+	}
+
+	if (ArchetypeIndex != INDEX_NONE)
+	{
+		Pawn->SetArchetype(ArchetypeIndex);
+	}
+
+	Pawn->FinishSpawning(ParkingTransform);
+
+	Pawn->SetParked(true);
+	return Pawn;
+}
+
+FTransform USensorSimScenarioSubsystem::GetParkingTransform(int32 Slot) const
+{
+	return FTransform(ParkingLocation + FVector(Slot * SensorSimScenario::ParkingSpacing, 0.0, 0.0));
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SensorSimScenarioSubsystem.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+class UPrimitiveComponent;
+
+/** Pose and velocities of one simulated body, as captured in a scenario snapshot */
+struct FSensorSimBodySnapshot
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	FTransform Transform;
+	FVector LinearVelocity = FVector::ZeroVector;
+
+	/** In degrees per second */
+	FVector AngularVelocity = FVector::ZeroVector;
+};
+
+/** Vehicle taking part in a scenario snapshot */
+struct FSensorSimVehicleSnapshot
+{
+	TWeakObjectPtr<ASensorSimPawn> Pawn;
+
+	FTransform Transform;
+	FVector LinearVelocity = FVector::ZeroVector;
+
+	/** In degrees per second */
+	FVector AngularVelocity = FVector::ZeroVector;
+
+	/** Full simulation state, from ASensorSimPawn::SavePhysicsState. Empty if the vehicle had not stepped yet */
+	TArray<uint8> PhysicsState;
+
+	/** True if the vehicle was acquired from the pool, rather than placed in the level or spawned for a player */
+	bool bPooled = false;
+};
+
+DECLARE_MULTICAST_DELEGATE(FOnSensorSimScenarioEvent);
+
+/**
+ *  Scenario Subsystem
+ *  Restarts episodes in place, without reloading the level.
+ *
+ *  Vehicles are taken from a pool of parked instances whose mesh, Chaos simulation and sensors are built once,
+ *  and returned to it rather than destroyed. A snapshot records every vehicle in play, with its full Chaos state,
+ *  and every body simulating physics. Resetting the scenario parks the pooled vehicles acquired since, restores the
+ *  snapshotted vehicles and bodies, and clears every sensor buffer, so that the next episode starts from the same state
+ *  without reloading the level.
+ *  Actors spawned outside of the pool since the snapshot are left alone.
+ *
+ *  Console commands:
+ *    SensorSim.Scenario.Snapshot
+ *    SensorSim.Scenario.Reset
+ *    SensorSim.Scenario.Prewarm <Count>    parks Count instances of every prewarmed class
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimScenarioSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Vehicle classes to fill the pool with on level load */
+	UPROPERTY(Config)
+	TArray<TSoftClassPtr<ASensorSimPawn>> PrewarmClasses;
+
+	/** Instances of every prewarmed class parked on level load */
+	UPROPERTY(Config)
+	int32 PrewarmCount{ 0 };
+
+	/** Where parked vehicles are held, out of the way of the level. Each is offset along X */
+	UPROPERTY(Config)
+	FVector ParkingLocation{ 0.0, 0.0, -100000.0 };
+
+	/** Parked vehicles, ready to be acquired */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ASensorSimPawn>> PooledVehicles;
+
+	/** Vehicles acquired from the pool and not yet released */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ASensorSimPawn>> AcquiredVehicles;
+
+	/** Vehicles in play when the snapshot was captured */
+	TArray<FSensorSimVehicleSnapshot> SnapshotVehicles;
+
+	/** Bodies simulating physics when the snapshot was captured, vehicles excepted */
+	TArray<FSensorSimBodySnapshot> SnapshotBodies;
+
+	/** True once a snapshot was captured */
+	bool bHasSnapshot{ false };
+
+	/** Wall clock seconds the last reset took */
+	double LastResetSeconds{ 0.0 };
+
+public:
+	/** Broadcast once a snapshot was captured */
+	FOnSensorSimScenarioEvent OnSnapshotCaptured;
+
+	/** Broadcast once the world was returned to the snapshot, so that owners of the restored vehicles can take them back */
+	FOnSensorSimScenarioEvent OnScenarioReset;
+
+	/**
+	 *  Takes a parked vehicle of the class and vehicle catalog archetype out of the pool, or spawns one if none is left,
+	 *  and restarts it at a transform. INDEX_NONE keeps the class defaults
+	 */
+	ASensorSimPawn* AcquireVehicle(UClass* VehicleClass, const FTransform& Transform, int32 ArchetypeIndex = INDEX_NONE);
+
+	/** Parks a vehicle acquired from the pool until it is acquired again */
+	void ReleaseVehicle(ASensorSimPawn* Pawn);
+
+	/** Spawns and parks vehicles until the pool holds at least Count of the class, with its class defaults */
+	void PrewarmPool(UClass* VehicleClass, int32 Count);
+
+	/** Returns the number of parked vehicles */
+	int32 GetNumPooled() const { return PooledVehicles.Num(); }
+
+	/** Returns the number of vehicles acquired from the pool */
+	int32 GetNumAcquired() const { return AcquiredVehicles.Num(); }
+
+	/** Records the vehicles in play and every simulating body as the state scenarios are reset to */
+	void CaptureSnapshot();
+
+	/** Returns true once a snapshot was captured */
+	bool HasSnapshot() const { return bHasSnapshot; }
+
+	/** Returns the world to the snapshot and clears every sensor buffer. Returns false without a snapshot */
+	bool ResetScenario();
+
+	/** Returns the wall clock seconds the last reset took */
+	double GetLastResetSeconds() const { return LastResetSeconds; }
+
+	/** Parks Count instances of every configured prewarm class */
+	void PrewarmConfiguredClasses(int32 Count);
+
+	// Begin WorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Spawns a vehicle straight into the pool, set up from a vehicle catalog archetype unless INDEX_NONE */
+	ASensorSimPawn* SpawnParkedVehicle(UClass* VehicleClass, int32 ArchetypeIndex = INDEX_NONE);
+
+	/** Returns the parking spot of a pool slot */
+	FTransform GetParkingTransform(int32 Slot) const;
+};
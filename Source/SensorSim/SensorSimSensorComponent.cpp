@@ -0,0 +1,88 @@
+#include "SensorSimSensorComponent.h"
+#include "SensorSimSensorSubsystem.h"
+#include "Engine/World.h"
+
+USensorSimSensorComponent::USensorSimSensorComponent()
+{
+	// samples are driven by the sensor subsystem
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void USensorSimSensorComponent::StartSchedule(double WorldTime, float Phase)
+{
+	SchedulePhase = Phase;
+	NextSampleTime = WorldTime + Phase / GetSampleRate();
+}
+
+int32 USensorSimSensorComponent::RunSchedule(double WorldTime)
+{
+	const double Period = 1.0 / GetSampleRate();
+
+	int32 NumSamples = 0;
+	while (NextSampleTime <= WorldTime)
+	{
+		const double SampleTime = NextSampleTime;
+		NextSampleTime += Period;
+
+		// sensors that cannot catch up only take the latest sample they fell behind on
+		if (!CatchesUp() && NextSampleTime <= WorldTime)
+		{
+			++SkippedSamples;
+			continue;
+		}
+
+		if (TakeSample(SampleTime))
+		{
+			++NumSamples;
+		}
+		else
+		{
+			++SkippedSamples;
+		}
+	}
+
+	return NumSamples;
+}
+
+void USensorSimSensorComponent::ResetSensor()
+{
+	StartSchedule(GetWorld()->GetTimeSeconds(), SchedulePhase);
+}
+
+void USensorSimSensorComponent::SetSamplingEnabled(bool bEnabled)
+{
+	USensorSimSensorSubsystem* Sensors = GetWorld()->GetSubsystem<USensorSimSensorSubsystem>();
+	if (!Sensors)
+	{
+		return;
+	}
+
+	if (bEnabled)
+	{
+		Sensors->RegisterSensor(this);
+	}
+	else
+	{
+		Sensors->UnregisterSensor(this);
+	}
+}
+
+void USensorSimSensorComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (USensorSimSensorSubsystem* Sensors = GetWorld()->GetSubsystem<USensorSimSensorSubsystem>())
+	{
+		Sensors->RegisterSensor(this);
+	}
+}
+
+void USensorSimSensorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (USensorSimSensorSubsystem* Sensors = GetWorld()->GetSubsystem<USensorSimSensorSubsystem>())
+	{
+		Sensors->UnregisterSensor(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SensorSimSensorComponent.generated.h"
+
+/** Running totals of a sensor's output since BeginPlay */
+struct FSensorSimSensorCounters
+{
+	/** Samples published */
+	uint64 Samples = 0;
+
+	/** Rays cast, for ray based sensors */
+	uint64 Rays = 0;
+
+	/** Rays that hit, for ray based sensors */
+	uint64 Hits = 0;
+
+	/** Bytes of sample data published */
+	uint64 Bytes = 0;
+};
+
+/**
+ *  Sensor Component
+ *  Base of every sensor run by the sensor subsystem. Each sensor samples at its own rate,
+ *  on a schedule kept in simulation time and advanced after every physics update,
+ *  so its output rate does not depend on the frame rate.
+ */
+UCLASS(Abstract, ClassGroup = (SensorSim))
+class SENSORSIM_API USensorSimSensorComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimSensorComponent();
+
+protected:
+	/** Samples per second */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sensor, meta = (ClampMin = "0.1", ClampMax = "1000.0"))
+	float SampleRate{ 10.0f };
+
+	/** Offsets the schedule so that sensors of the same rate do not all sample on the same frame */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sensor)
+	bool bStagger{ true };
+
+	/** World time at which the next sample is due */
+	double NextSampleTime{ 0.0 };
+
+	/** Fraction of a period the schedule is offset by */
+	float SchedulePhase{ 0.0f };
+
+	/** Number of due samples that were not taken */
+	uint32 SkippedSamples{ 0 };
+
+	/** Output totals since BeginPlay */
+	FSensorSimSensorCounters Counters;
+
+public:
+	/** Returns the samples per second */
+	virtual float GetSampleRate() const { return SampleRate; }
+
+	/** Returns true if the schedule should be offset from other sensors */
+	bool IsStaggered() const { return bStagger; }
+
+	/** Starts the schedule, offset by a fraction of a period */
+	void StartSchedule(double WorldTime, float Phase);
+
+	/** Takes every sample due up to the world time. Returns the number of samples taken. Game thread only */
+	virtual int32 RunSchedule(double WorldTime);
+
+	/** Publishes the results of samples that completed asynchronously. Never blocks. Returns true if any were published */
+	virtual bool CollectSamples() { return false; }
+
+	/** Drops every sample in flight or not yet published and restarts the schedule from the current world time. Game thread only */
+	virtual void ResetSensor();
+
+	/** Adds the sensor to the sensor subsystem's schedule, or removes it, such as while its vehicle is pooled */
+	void SetSamplingEnabled(bool bEnabled);
+
+	/** Returns the number of due samples that were not taken */
+	uint32 GetSkippedSamples() const { return SkippedSamples; }
+
+	/** Returns the output totals since BeginPlay */
+	const FSensorSimSensorCounters& GetCounters() const { return Counters; }
+
+protected:
+	/** Takes one sample at the given world time, at or before the current one. Returns false if it was skipped */
+	virtual bool TakeSample(double SampleTime) PURE_VIRTUAL(USensorSimSensorComponent::TakeSample, return false;);
+
+	/** Returns true if every sample the schedule fell behind on should be taken, rather than only the latest */
+	virtual bool CatchesUp() const { return true; }
+
+	// Begin ActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End ActorComponent interface
+};
@@ -0,0 +1,311 @@
+#include "SensorSimSensorSubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimSensorComponent.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "Algo/Count.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdCounters(
+	TEXT("SensorSim.Counters"),
+	TEXT("Logs every sensor's samples, rays, hits and bytes produced since BeginPlay"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (const USensorSimSensorSubsystem* Sensors = World ? World->GetSubsystem<USensorSimSensorSubsystem>() : nullptr)
+		{
+			Sensors->LogSensorCounters(Ar);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdCountersDump(
+	TEXT("SensorSim.Counters.Dump"),
+	TEXT("Writes every sensor's counters as CSV. Usage: SensorSim.Counters.Dump [<File>]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const USensorSimSensorSubsystem* Sensors = World ? World->GetSubsystem<USensorSimSensorSubsystem>() : nullptr)
+		{
+			Sensors->WriteSensorCounters(Args.Num() > 0 ? Args[0] : FPaths::ProfilingDir() / TEXT("SensorSimCounters.csv"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdLidarBudget(
+	TEXT("SensorSim.Lidar.Budget"),
+	TEXT("Sets the rays per frame shared by every LiDAR, 0 for full patterns. Usage: SensorSim.Lidar.Budget [<Rays>]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimSensorSubsystem* Sensors = World ? World->GetSubsystem<USensorSimSensorSubsystem>() : nullptr)
+		{
+			if (Args.Num() > 0)
+			{
+				Sensors->SetRayBudget(FCString::Atoi(*Args[0]));
+			}
+
+			UE_LOG(LogSensorSim, Display, TEXT("LiDAR ray budget: %d rays per frame"), Sensors->GetRayBudget());
+		}
+	}));
+
+namespace SensorSimSensors
+{
+	/** Golden ratio conjugate. Successive multiples spread phases evenly over a period, however many there are */
+	constexpr double StaggerStep = 0.6180339887498949;
+
+	/** Weight of the latest frame time in the average the ray budget is converted with */
+	constexpr double FrameTimeSmoothing = 0.1;
+
+	/** LiDAR competing for the ray budget */
+	struct FRayDemand
+	{
+		USensorSimLidarComponent* Lidar = nullptr;
+		double Weight = 0.0;
+
+		/** Rays per second of the full pattern */
+		double FullRate = 0.0;
+	};
+}
+
+void USensorSimSensorSubsystem::RegisterSensor(USensorSimSensorComponent* Sensor)
+{
+	if (Sensors.Contains(Sensor))
+	{
+		return;
+	}
+
+	Sensors.Add(Sensor);
+
+	const float Phase = Sensor->IsStaggered() ? static_cast<float>(FMath::Frac(NumRegistrations * SensorSimSensors::StaggerStep)) : 0.0f;
+	Sensor->StartSchedule(GetWorld()->GetTimeSeconds(), Phase);
+
+	++NumRegistrations;
+}
+
+void USensorSimSensorSubsystem::UnregisterSensor(USensorSimSensorComponent* Sensor)
+{
+	// sample listeners may destroy sensors while RunSensors walks the list, so keep its indices valid
+	if (bRunningSensors)
+	{
+		const int32 Index = Sensors.Find(Sensor);
+		if (Index != INDEX_NONE)
+		{
+			Sensors[Index] = nullptr;
+		}
+		return;
+	}
+
+	Sensors.RemoveSingleSwap(Sensor);
+}
+
+int32 USensorSimSensorSubsystem::GetNumLidars() const
+{
+	return Algo::CountIf(Sensors, [](const USensorSimSensorComponent* Sensor) { return Sensor && Sensor->IsA<USensorSimLidarComponent>(); });
+}
+
+void USensorSimSensorSubsystem::ResetCounters()
+{
+	TotalRays = 0;
+	TotalSweepSeconds = 0.0;
+}
+
+void USensorSimSensorSubsystem::SetRayBudget(int32 InRayBudget)
+{
+	RayBudget = FMath::Max(InRayBudget, 0);
+
+	if (RayBudget == 0)
+	{
+		for (USensorSimSensorComponent* Sensor : Sensors)
+		{
+			if (USensorSimLidarComponent* Lidar = Cast<USensorSimLidarComponent>(Sensor))
+			{
+				Lidar->SetRayFraction(1.0f);
+			}
+		}
+	}
+}
+
+float USensorSimSensorSubsystem::GetReflectivity(const UPhysicalMaterial* Material) const
+{
+	// the table is only read once loaded, so worker threads may look it up while tracing
+	const float* Reflectivity = Material ? MaterialReflectivity.Find(Material->GetFName()) : nullptr;
+	return FMath::Clamp(Reflectivity ? *Reflectivity : DefaultReflectivity, 0.0f, 1.0f);
+}
+
+void USensorSimSensorSubsystem::UpdateRayBudget()
+{
+	using namespace SensorSimSensors;
+
+	const double FrameSeconds = GetWorld()->GetDeltaSeconds();
+	if (FrameSeconds > 0.0)
+	{
+		AverageFrameSeconds = AverageFrameSeconds > 0.0 ? FMath::Lerp(AverageFrameSeconds, FrameSeconds, FrameTimeSmoothing) : FrameSeconds;
+	}
+
+	if (RayBudget <= 0 || AverageFrameSeconds <= 0.0)
+	{
+		return;
+	}
+
+	TArray<FRayDemand, TInlineAllocator<64>> Demands;
+	double TotalWeight = 0.0;
+
+	for (USensorSimSensorComponent* Sensor : Sensors)
+	{
+		USensorSimLidarComponent* Lidar = Cast<USensorSimLidarComponent>(Sensor);
+		if (!IsValid(Lidar) || Lidar->GetPatternRays() == 0)
+		{
+			continue;
+		}
+
+		const APawn* Pawn = Cast<APawn>(Lidar->GetOwner());
+		const USensorSimVehicleMovementComponent* Movement = Lidar->GetVehicleMovement();
+		const float Speed = Movement ? FMath::Abs(Movement->GetForwardSpeed()) : 0.0f;
+
+		FRayDemand& Demand = Demands.AddDefaulted_GetRef();
+		Demand.Lidar = Lidar;
+		Demand.Weight = (Pawn && Pawn->IsPlayerControlled() ? EgoWeight : TrafficWeight)
+			* FMath::Lerp(StoppedWeight, 1.0f, FMath::Clamp(Speed / FMath::Max(FullWeightSpeed, 1.0f), 0.0f, 1.0f));
+		Demand.Weight = FMath::Max(Demand.Weight, UE_KINDA_SMALL_NUMBER);
+		Demand.FullRate = static_cast<double>(Lidar->GetPatternRays()) * Lidar->GetSampleRate();
+
+		TotalWeight += Demand.Weight;
+	}
+
+	// share the budget by weight; LiDARs whose full pattern costs less than their share hand the rest over to the others
+	Demands.Sort([](const FRayDemand& A, const FRayDemand& B) { return A.FullRate * B.Weight < B.FullRate * A.Weight; });
+
+	double RemainingRate = RayBudget / AverageFrameSeconds;
+	for (const FRayDemand& Demand : Demands)
+	{
+		const double Rate = FMath::Min(Demand.FullRate, RemainingRate * Demand.Weight / TotalWeight);
+		Demand.Lidar->SetRayFraction(static_cast<float>(Rate / Demand.FullRate));
+
+		RemainingRate = FMath::Max(RemainingRate - Rate, 0.0);
+		TotalWeight -= Demand.Weight;
+	}
+}
+
+void USensorSimSensorSubsystem::LogSensorCounters(FOutputDevice& Ar) const
+{
+	Ar.Logf(TEXT("%-48s %10s %14s %14s %14s"), TEXT("Sensor"), TEXT("Samples"), TEXT("Rays"), TEXT("Hits"), TEXT("Bytes"));
+
+	for (const USensorSimSensorComponent* Sensor : Sensors)
+	{
+		if (IsValid(Sensor))
+		{
+			const FSensorSimSensorCounters& Counters = Sensor->GetCounters();
+			Ar.Logf(TEXT("%-48s %10llu %14llu %14llu %14llu"), *FString::Printf(TEXT("%s.%s"), *GetNameSafe(Sensor->GetOwner()), *Sensor->GetName()),
+				Counters.Samples, Counters.Rays, Counters.Hits, Counters.Bytes);
+		}
+	}
+}
+
+bool USensorSimSensorSubsystem::WriteSensorCounters(const FString& Filename) const
+{
+	TStringBuilder<4096> Csv;
+	Csv << TEXT("Time,Actor,Sensor,Class,Samples,Skipped,Rays,Hits,Bytes\n");
+
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+
+	for (const USensorSimSensorComponent* Sensor : Sensors)
+	{
+		if (IsValid(Sensor))
+		{
+			const FSensorSimSensorCounters& Counters = Sensor->GetCounters();
+			Csv.Appendf(TEXT("%.3f,%s,%s,%s,%llu,%u,%llu,%llu,%llu\n"), WorldTime, *GetNameSafe(Sensor->GetOwner()), *Sensor->GetName(), *Sensor->GetClass()->GetName(),
+				Counters.Samples, Sensor->GetSkippedSamples(), Counters.Rays, Counters.Hits, Counters.Bytes);
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv.ToView(), *Filename))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to write sensor counters to '%s'"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("Sensor counters written to '%s'"), *Filename);
+	return true;
+}
+
+void USensorSimSensorSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	int32 CommandLineBudget = 0;
+	if (FParse::Value(FCommandLine::Get(), TEXT("LidarRayBudget="), CommandLineBudget))
+	{
+		SetRayBudget(CommandLineBudget);
+	}
+
+	if (FPhysScene* PhysicsScene = InWorld.GetPhysicsScene())
+	{
+		PhysicsPostTickHandle = PhysicsScene->OnPhysScenePostTick.AddUObject(this, &USensorSimSensorSubsystem::OnPhysicsPostTick);
+	}
+}
+
+void USensorSimSensorSubsystem::Deinitialize()
+{
+	if (FPhysScene* PhysicsScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsScene->OnPhysScenePostTick.Remove(PhysicsPostTickHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+bool USensorSimSensorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USensorSimSensorSubsystem::RunSensors()
+{
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimRunSensors);
+
+	const double WorldTime = GetWorld()->GetTimeSeconds();
+
+	// shares are set before any sweep of this frame is dispatched
+	UpdateRayBudget();
+
+	// sample listeners may register or unregister sensors: those registered now start on the next run,
+	// those unregistered are cleared in place and removed once done
+	bRunningSensors = true;
+
+	const int32 NumSensors = Sensors.Num();
+	for (int32 Index = 0; Index < NumSensors; ++Index)
+	{
+		USensorSimSensorComponent* Sensor = Sensors[Index];
+		if (!IsValid(Sensor))
+		{
+			continue;
+		}
+
+		// pick up the samples that finished since the last update
+		if (Sensor->CollectSamples())
+		{
+			if (const USensorSimLidarComponent* Lidar = Cast<USensorSimLidarComponent>(Sensor))
+			{
+				TotalRays += Lidar->GetLastSweepRays();
+				TotalSweepSeconds += Lidar->GetLastSweepSeconds();
+			}
+		}
+
+		// schedule the next samples, unless a listener just unregistered the sensor
+		if (Sensors[Index] == Sensor)
+		{
+			Sensor->RunSchedule(WorldTime);
+		}
+	}
+
+	bRunningSensors = false;
+	Sensors.RemoveAllSwap([](const USensorSimSensorComponent* Sensor) { return Sensor == nullptr; });
+}
+
+void USensorSimSensorSubsystem::OnPhysicsPostTick(FChaosScene* Scene)
+{
+	RunSensors();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SensorSimSensorSubsystem.generated.h"
+
+// Forward declarations
+class USensorSimSensorComponent;
+class UPhysicalMaterial;
+class FChaosScene;
+
+/**
+ *  Sensor Subsystem
+ *  Schedules every sensor in the world at its own rate. Runs right after each physics update rather
+ *  than on the frame tick: it collects the samples that completed on the task graph, then takes every
+ *  sample that fell due during the simulated time span, stamped with its scheduled time.
+ *  Sensors are staggered on registration so that their cost is spread over frames.
+ *
+ *  With a ray budget, the LiDARs share a fixed number of rays per frame, however many vehicles are spawned.
+ *  Each gets a share weighted by its priority (the player's vehicle against traffic) and its vehicle's speed,
+ *  capped at its full pattern; the rays it casts are then spread over its channels, densest near the horizon.
+ *
+ *  Console commands:
+ *    SensorSim.Counters                  logs every sensor's samples, rays, hits and bytes produced
+ *    SensorSim.Counters.Dump [<File>]    writes them as CSV, to Saved/Profiling/SensorSimCounters.csv by default
+ *    SensorSim.Lidar.Budget [<Rays>]     sets the rays per frame shared by every LiDAR, 0 for full patterns
+ *
+ *  Command line:
+ *    -LidarRayBudget=<Rays>
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimSensorSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Rays per frame, on average, shared by every LiDAR. 0 casts every pattern in full */
+	UPROPERTY(Config)
+	int32 RayBudget{ 0 };
+
+	/** Budget weight of the LiDARs on player controlled vehicles */
+	UPROPERTY(Config)
+	float EgoWeight{ 4.0f };
+
+	/** Budget weight of the other LiDARs */
+	UPROPERTY(Config)
+	float TrafficWeight{ 1.0f };
+
+	/** Vehicle speed, in cm/s, from which a LiDAR gets its full weight */
+	UPROPERTY(Config)
+	float FullWeightSpeed{ 2500.0f };
+
+	/** Fraction of its weight a LiDAR keeps on a stopped vehicle */
+	UPROPERTY(Config)
+	float StoppedWeight{ 0.25f };
+
+	/** Share of the emitted power surfaces return to the LiDARs, by physical material name */
+	UPROPERTY(Config)
+	TMap<FName, float> MaterialReflectivity;
+
+	/** Reflectivity of surfaces whose physical material is not listed */
+	UPROPERTY(Config)
+	float DefaultReflectivity{ 0.3f };
+
+	/** Registered sensors */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USensorSimSensorComponent>> Sensors;
+
+	/** Number of registrations so far, used to stagger schedules */
+	uint32 NumRegistrations{ 0 };
+
+	/** True while RunSensors walks Sensors. Unregistered sensors are then cleared in place, and removed after */
+	bool bRunningSensors{ false };
+
+	/** Binding to the physics scene's post tick */
+	FDelegateHandle PhysicsPostTickHandle;
+
+	/** Rays cast since the counters were last reset */
+	uint64 TotalRays{ 0 };
+
+	/** Wall clock seconds spent tracing since the counters were last reset, summed over sensors */
+	double TotalSweepSeconds{ 0.0 };
+
+	/** Smoothed world seconds per frame, converting the ray budget into rays per second */
+	double AverageFrameSeconds{ 0.0 };
+
+public:
+	/** Adds a sensor to the schedule */
+	void RegisterSensor(USensorSimSensorComponent* Sensor);
+
+	/** Removes a sensor from the schedule */
+	void UnregisterSensor(USensorSimSensorComponent* Sensor);
+
+	/** Returns the number of registered sensors */
+	int32 GetNumSensors() const { return Sensors.Num(); }
+
+	/** Returns the number of registered LiDARs */
+	int32 GetNumLidars() const;
+
+	/** Returns the rays cast since the counters were last reset */
+	uint64 GetTotalRays() const { return TotalRays; }
+
+	/** Returns the wall clock seconds spent tracing since the counters were last reset */
+	double GetTotalSweepSeconds() const { return TotalSweepSeconds; }
+
+	/** Resets the ray and timing counters */
+	void ResetCounters();
+
+	/** Sets the rays per frame shared by every LiDAR. 0 casts every pattern in full */
+	void SetRayBudget(int32 InRayBudget);
+
+	/** Returns the rays per frame shared by every LiDAR, or 0 */
+	int32 GetRayBudget() const { return RayBudget; }
+
+	/** Returns the LiDAR reflectivity of a physical material, or the default one. Any thread */
+	float GetReflectivity(const UPhysicalMaterial* Material) const;
+
+	/** Logs every sensor's output totals */
+	void LogSensorCounters(FOutputDevice& Ar) const;
+
+	/** Writes every sensor's output totals as CSV */
+	bool WriteSensorCounters(const FString& Filename) const;
+
+	// Begin WorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Runs the sensor schedules up to the current world time */
+	void RunSensors();
+
+	/** Shares the ray budget between the LiDARs, for their next sweeps */
+	void UpdateRayBudget();
+
+	/** Called on the game thread once the physics scene has been stepped for the frame */
+	void OnPhysicsPostTick(FChaosScene* Scene);
+};
@@ -0,0 +1,177 @@
+#include "SensorSimSharedMemory.h"
+#include "SensorSim.h"
+
+FSensorSimShmWriter::~FSensorSimShmWriter()
+{
+	Close();
+}
+
+bool FSensorSimShmWriter::Open(const FString& InName, ESensorSimShmKind Kind, uint32 NumSlots, uint32 DataCapacity, const FString& FrameId,
+	TConstArrayView<FSensorSimShmPointField> Fields, uint32 PointStep)
+{
+	check(!IsOpen());
+	check(NumSlots >= 2 && Fields.Num() <= SensorSimSharedMemory::MaxPointFields);
+
+	const uint64 SlotStride = Align(sizeof(FSensorSimShmSlot) + uint64(DataCapacity), SensorSimSharedMemory::Alignment);
+	const uint64 SegmentSize = sizeof(FSensorSimShmHeader) + NumSlots * SlotStride;
+
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(InName, true, FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, SegmentSize);
+	if (!Region)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to create shared memory segment '%s' of %llu bytes"), *InName, SegmentSize);
+		return false;
+	}
+
+	Name = InName;
+	NextSequence = 1;
+
+	// slots start unlocked and empty
+	uint8* Base = static_cast<uint8*>(Region->GetAddress());
+	for (uint32 SlotIndex = 0; SlotIndex < NumSlots; ++SlotIndex)
+	{
+		new (Base + sizeof(FSensorSimShmHeader) + SlotIndex * SlotStride) FSensorSimShmSlot();
+	}
+
+	Header = new (Base) FSensorSimShmHeader();
+	Header->Kind = Kind;
+	Header->NumSlots = NumSlots;
+	Header->SlotStride = SlotStride;
+	Header->DataCapacity = DataCapacity;
+	Header->SegmentSize = SegmentSize;
+	Header->PointStep = PointStep;
+	Header->NumFields = Fields.Num();
+	FMemory::Memcpy(Header->Fields, Fields.GetData(), Fields.Num() * sizeof(FSensorSimShmPointField));
+	FCStringAnsi::Strncpy(Header->FrameId, TCHAR_TO_ANSI(*FrameId), UE_ARRAY_COUNT(Header->FrameId));
+
+	// readers ignore the segment until the magic is in place
+	Header->Magic.store(SensorSimSharedMemory::Magic, std::memory_order_release);
+
+	return true;
+}
+
+void FSensorSimShmWriter::Close()
+{
+	if (!Region)
+	{
+		return;
+	}
+
+	// readers still mapping the segment keep their view of it
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	Region = nullptr;
+	Header = nullptr;
+}
+
+uint8* FSensorSimShmWriter::BeginWrite()
+{
+	FSensorSimShmSlot& Slot = GetSlot(NextSequence);
+
+	// odd lock: readers that started on the slot's previous message will fail their validation
+	Slot.Lock.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	return reinterpret_cast<uint8*>(&Slot + 1);
+}
+
+void FSensorSimShmWriter::EndWrite(double Time, uint32 DataSize, uint32 Width, uint32 Height, bool bIsDense)
+{
+	FSensorSimShmSlot& Slot = GetSlot(NextSequence);
+	check(Slot.Lock.load(std::memory_order_relaxed) & 1);
+
+	const double Seconds = FMath::FloorToDouble(Time);
+
+	Slot.Sequence = NextSequence;
+	Slot.StampSec = static_cast<int32>(Seconds);
+	Slot.StampNanosec = static_cast<uint32>(FMath::Min((Time - Seconds) * 1e9, 999999999.0));
+	Slot.Height = Height;
+	Slot.Width = Width;
+	Slot.RowStep = Width * Header->PointStep;
+	Slot.DataSize = FMath::Min<uint32>(DataSize, GetDataCapacity());
+	Slot.bIsDense = bIsDense;
+
+	Slot.Lock.fetch_add(1, std::memory_order_release);
+	Header->LatestSequence.store(NextSequence, std::memory_order_release);
+
+	++NextSequence;
+}
+
+FSensorSimShmSlot& FSensorSimShmWriter::GetSlot(uint64 Sequence) const
+{
+	uint8* Base = reinterpret_cast<uint8*>(Header);
+	return *reinterpret_cast<FSensorSimShmSlot*>(Base + sizeof(FSensorSimShmHeader) + ((Sequence - 1) % Header->NumSlots) * Header->SlotStride);
+}
+
+FSensorSimShmReader::~FSensorSimShmReader()
+{
+	Close();
+}
+
+bool FSensorSimShmReader::Open(const FString& InName)
+{
+	Close();
+
+	// map the header alone to learn the size of the segment
+	FPlatformMemory::FSharedMemoryRegion* HeaderRegion = FPlatformMemory::MapNamedSharedMemoryRegion(InName, false, FPlatformMemory::ESharedMemoryAccess::Read, sizeof(FSensorSimShmHeader));
+	if (!HeaderRegion)
+	{
+		return false;
+	}
+
+	const FSensorSimShmHeader* MappedHeader = static_cast<const FSensorSimShmHeader*>(HeaderRegion->GetAddress());
+	const bool bValid = MappedHeader->Magic.load(std::memory_order_acquire) == SensorSimSharedMemory::Magic && MappedHeader->Version == SensorSimSharedMemory::Version;
+	const uint64 SegmentSize = MappedHeader->SegmentSize;
+
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(HeaderRegion);
+
+	if (!bValid)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Shared memory segment '%s' is not a version %u SensorSim segment"), *InName, SensorSimSharedMemory::Version);
+		return false;
+	}
+
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(InName, false, FPlatformMemory::ESharedMemoryAccess::Read, SegmentSize);
+	if (!Region)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Failed to map shared memory segment '%s' of %llu bytes"), *InName, SegmentSize);
+		return false;
+	}
+
+	Header = static_cast<const FSensorSimShmHeader*>(Region->GetAddress());
+	return true;
+}
+
+void FSensorSimShmReader::Close()
+{
+	if (!Region)
+	{
+		return;
+	}
+
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	Region = nullptr;
+	Header = nullptr;
+}
+
+ESensorSimShmRead FSensorSimShmReader::Read(uint64 Sequence, TFunctionRef<void(const FSensorSimShmSlot& Slot, TConstArrayView<uint8> Data)> Visitor) const
+{
+	if (Sequence == 0 || Sequence > GetLatestSequence())
+	{
+		return ESensorSimShmRead::Pending;
+	}
+
+	const uint8* Base = reinterpret_cast<const uint8*>(Header);
+	const FSensorSimShmSlot& Slot = *reinterpret_cast<const FSensorSimShmSlot*>(Base + sizeof(FSensorSimShmHeader) + ((Sequence - 1) % Header->NumSlots) * Header->SlotStride);
+
+	const uint32 Lock = Slot.Lock.load(std::memory_order_acquire);
+	if ((Lock & 1) || Slot.Sequence != Sequence)
+	{
+		return ESensorSimShmRead::Overwritten;
+	}
+
+	const uint32 DataSize = FMath::Min<uint32>(Slot.DataSize, static_cast<uint32>(Header->DataCapacity));
+	Visitor(Slot, TConstArrayView<uint8>(reinterpret_cast<const uint8*>(&Slot + 1), DataSize));
+
+	// the writer may have started on the slot while the visitor was reading it
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Lock.load(std::memory_order_relaxed) == Lock ? ESensorSimShmRead::Ok : ESensorSimShmRead::Overwritten;
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformMemory.h"
+#include <atomic>
+
+/**
+ *  SensorSim shared memory segment layout
+ *
+ *    FSensorSimShmHeader                       describes the slots, and holds the latest sequence
+ *    { FSensorSimShmSlot, payload } * NumSlots   slot i holds message Sequence with (Sequence - 1) % NumSlots == i
+ *
+ *  One writer process, any number of reader processes. Messages are numbered from 1 and written
+ *  round robin into the slots, so a reader has NumSlots - 1 messages of slack before its slot is reused.
+ *  Each slot is guarded by a sequence lock: Lock is odd while the slot is being written, and a read
+ *  is valid only if Lock was even and unchanged across it. Readers never block the writer.
+ *
+ *  Every structure is little endian, naturally aligned and cache line aligned.
+ *  Payloads follow ROS conventions: meters, radians, x forward, y left, z up, quaternions x y z w.
+ */
+namespace SensorSimSharedMemory
+{
+	constexpr uint32 Magic = 0x4D485353;	// 'SSHM'
+
+	/** 2: points grew from 24 to 28 bytes, with label and instance fields */
+	constexpr uint32 Version = 2;
+
+	/** Maximum number of fields described per point */
+	constexpr int32 MaxPointFields = 8;
+
+	/** Alignment of the header, the slots and their payloads */
+	constexpr uint32 Alignment = 64;
+
+	/** sensor_msgs/PointField datatypes */
+	constexpr uint8 Int8 = 1;
+	constexpr uint8 UInt8 = 2;
+	constexpr uint8 Int16 = 3;
+	constexpr uint8 UInt16 = 4;
+	constexpr uint8 Int32 = 5;
+	constexpr uint8 UInt32 = 6;
+	constexpr uint8 Float32 = 7;
+	constexpr uint8 Float64 = 8;
+}
+
+static_assert(std::atomic<uint32>::is_always_lock_free && std::atomic<uint64>::is_always_lock_free, "Shared memory atomics must be address free");
+
+/** Kind of message a segment carries */
+enum class ESensorSimShmKind : uint32
+{
+	/** sensor_msgs/PointCloud2 data, described by the header's fields */
+	PointCloud2 = 0,
+
+	/** One FSensorSimShmImu per message */
+	Imu = 1,
+
+	/** One FSensorSimShmOdometry per message */
+	Odometry = 2,
+};
+
+/** sensor_msgs/PointField */
+struct FSensorSimShmPointField
+{
+	/** Null terminated field name */
+	ANSICHAR Name[16] = {};
+
+	/** Byte offset within a point */
+	uint32 Offset = 0;
+
+	/** One of the SensorSimSharedMemory datatypes */
+	uint8 Datatype = 0;
+
+	uint8 Reserved[3] = {};
+
+	/** Number of elements */
+	uint32 Count = 1;
+};
+
+struct alignas(SensorSimSharedMemory::Alignment) FSensorSimShmHeader
+{
+	/** Written last by the writer, once the rest of the header is valid */
+	std::atomic<uint32> Magic{ 0 };
+	uint32 Version = SensorSimSharedMemory::Version;
+
+	ESensorSimShmKind Kind = ESensorSimShmKind::PointCloud2;
+
+	/** Number of message slots */
+	uint32 NumSlots = 0;
+
+	/** Bytes from one slot to the next */
+	uint64 SlotStride = 0;
+
+	/** Maximum payload bytes per message */
+	uint64 DataCapacity = 0;
+
+	/** Bytes of the whole segment */
+	uint64 SegmentSize = 0;
+
+	/** Bytes per point, for point clouds */
+	uint32 PointStep = 0;
+
+	/** Number of valid Fields */
+	uint32 NumFields = 0;
+
+	/** Point layout, for point clouds */
+	FSensorSimShmPointField Fields[SensorSimSharedMemory::MaxPointFields];
+
+	/** Null terminated frame id of the messages */
+	ANSICHAR FrameId[32] = {};
+
+	/** Sequence of the last complete message, 0 before the first one */
+	alignas(SensorSimSharedMemory::Alignment) std::atomic<uint64> LatestSequence{ 0 };
+};
+
+/** Message slot header, followed by the payload */
+struct alignas(SensorSimSharedMemory::Alignment) FSensorSimShmSlot
+{
+	/** Sequence lock, odd while the slot is being written */
+	std::atomic<uint32> Lock{ 0 };
+	uint32 Reserved = 0;
+
+	/** Sequence of the message in the slot */
+	uint64 Sequence = 0;
+
+	/** Simulation time of the message, as builtin_interfaces/Time */
+	int32 StampSec = 0;
+	uint32 StampNanosec = 0;
+
+	/** Point cloud dimensions, 1 x 1 for other messages */
+	uint32 Height = 0;
+	uint32 Width = 0;
+	uint32 RowStep = 0;
+
+	/** Payload bytes */
+	uint32 DataSize = 0;
+
+	uint8 bIsBigEndian = 0;
+	uint8 bIsDense = 0;
+};
+
+/**
+ *  Point of the published point clouds, 28 bytes (point_step):
+ *  x y z intensity as float32 at 0, 4, 8, 12, ring as uint16 at 16, label as uint8 at 18, time as float32 at 20, instance as uint32 at 24
+ */
+struct FSensorSimShmPoint
+{
+	float X = 0.0f;
+	float Y = 0.0f;
+	float Z = 0.0f;
+	float Intensity = 0.0f;
+	uint16 Ring = 0;
+
+	/** Ground truth ESensorSimSemanticClass */
+	uint8 Label = 0;
+	uint8 Reserved = 0;
+
+	/** Firing time, in seconds relative to the message stamp */
+	float Time = 0.0f;
+
+	/** Ground truth instance, 0 if unlabeled */
+	uint32 Instance = 0;
+};
+
+/** sensor_msgs/Imu payload, without covariances */
+struct FSensorSimShmImu
+{
+	double Orientation[4] = { 0.0, 0.0, 0.0, 1.0 };
+	double AngularVelocity[3] = {};
+	double LinearAcceleration[3] = {};
+};
+
+/** nav_msgs/Odometry payload, without covariances. The pose is in the world frame, the twist in the vehicle frame */
+struct FSensorSimShmOdometry
+{
+	double Position[3] = {};
+	double Orientation[4] = { 0.0, 0.0, 0.0, 1.0 };
+	double LinearVelocity[3] = {};
+	double AngularVelocity[3] = {};
+};
+
+static_assert(sizeof(FSensorSimShmSlot) == SensorSimSharedMemory::Alignment, "Payloads start one cache line into their slot");
+static_assert(sizeof(FSensorSimShmPoint) == 28 && sizeof(FSensorSimShmImu) == 80 && sizeof(FSensorSimShmOdometry) == 104, "Shared memory payloads are a fixed layout");
+static_assert(offsetof(FSensorSimShmPoint, Ring) == 16 && offsetof(FSensorSimShmPoint, Label) == 18 && offsetof(FSensorSimShmPoint, Time) == 20
+	&& offsetof(FSensorSimShmPoint, Instance) == 24, "Shared memory point fields are a fixed layout");
+
+/** Result of reading a message */
+enum class ESensorSimShmRead : uint8
+{
+	/** The message was read intact */
+	Ok,
+
+	/** The message has not been written yet */
+	Pending,
+
+	/** The slot was reused before or while reading; the message is lost */
+	Overwritten,
+};
+
+/**
+ *  Shared Memory Writer
+ *  Creates a named segment and writes messages straight into its slots. One thread at a time.
+ */
+class SENSORSIM_API FSensorSimShmWriter
+{
+public:
+	FSensorSimShmWriter() = default;
+	~FSensorSimShmWriter();
+
+	/** Creates the segment. Point clouds describe their points with Fields and PointStep */
+	bool Open(const FString& InName, ESensorSimShmKind Kind, uint32 NumSlots, uint32 DataCapacity, const FString& FrameId,
+		TConstArrayView<FSensorSimShmPointField> Fields = {}, uint32 PointStep = 0);
+
+	/** Unmaps the segment, removing it once every reader has unmapped it too */
+	void Close();
+
+	/** Returns true between Open and Close */
+	bool IsOpen() const { return Region != nullptr; }
+
+	/** Returns the segment name */
+	const FString& GetName() const { return Name; }
+
+	/** Returns the maximum payload bytes per message */
+	uint32 GetDataCapacity() const { return static_cast<uint32>(Header->DataCapacity); }
+
+	/** Returns the sequence of the last complete message */
+	uint64 GetLatestSequence() const { return NextSequence - 1; }
+
+	/** Locks the next slot and returns its payload, of GetDataCapacity bytes */
+	uint8* BeginWrite();
+
+	/** Stamps and publishes the slot locked by BeginWrite */
+	void EndWrite(double Time, uint32 DataSize, uint32 Width = 1, uint32 Height = 1, bool bIsDense = true);
+
+	/** Writes a fixed size message */
+	template<typename MessageType>
+	void Write(double Time, const MessageType& Message)
+	{
+		check(sizeof(MessageType) <= GetDataCapacity());
+		FMemory::Memcpy(BeginWrite(), &Message, sizeof(MessageType));
+		EndWrite(Time, sizeof(MessageType));
+	}
+
+private:
+	/** Returns the slot of a message */
+	FSensorSimShmSlot& GetSlot(uint64 Sequence) const;
+
+	FPlatformMemory::FSharedMemoryRegion* Region = nullptr;
+	FSensorSimShmHeader* Header = nullptr;
+	FString Name;
+
+	/** Sequence of the message being or next to be written */
+	uint64 NextSequence = 1;
+};
+
+/**
+ *  Shared Memory Reader
+ *  Maps a named segment written by another thread or process and reads messages in place.
+ */
+class SENSORSIM_API FSensorSimShmReader
+{
+public:
+	FSensorSimShmReader() = default;
+	~FSensorSimShmReader();
+
+	/** Maps the segment and validates its header. Fails if the writer has not created it yet */
+	bool Open(const FString& InName);
+
+	/** Unmaps the segment */
+	void Close();
+
+	/** Returns true between Open and Close */
+	bool IsOpen() const { return Region != nullptr; }
+
+	/** Returns the segment header */
+	const FSensorSimShmHeader& GetHeader() const { return *Header; }
+
+	/** Returns the sequence of the last complete message, 0 before the first one */
+	uint64 GetLatestSequence() const { return Header->LatestSequence.load(std::memory_order_acquire); }
+
+	/**
+	 *  Hands a message to the visitor in place, without copying it. The visitor may see a slot that is being
+	 *  overwritten; whatever it derived is only valid if Read returns Ok.
+	 */
+	ESensorSimShmRead Read(uint64 Sequence, TFunctionRef<void(const FSensorSimShmSlot& Slot, TConstArrayView<uint8> Data)> Visitor) const;
+
+	/** Copies a fixed size message and its time */
+	template<typename MessageType>
+	ESensorSimShmRead Read(uint64 Sequence, MessageType& OutMessage, double& OutTime) const
+	{
+		return Read(Sequence, [&OutMessage, &OutTime](const FSensorSimShmSlot& Slot, TConstArrayView<uint8> Data)
+		{
+			OutTime = GetTime(Slot);
+			FMemory::Memcpy(&OutMessage, Data.GetData(), FMath::Min<int32>(Data.Num(), sizeof(MessageType)));
+		});
+	}
+
+	/** Returns the time a slot is stamped with, in seconds */
+	static double GetTime(const FSensorSimShmSlot& Slot) { return Slot.StampSec + Slot.StampNanosec * 1e-9; }
+
+private:
+	FPlatformMemory::FSharedMemoryRegion* Region = nullptr;
+	const FSensorSimShmHeader* Header = nullptr;
+};
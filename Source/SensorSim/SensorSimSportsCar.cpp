@@ -1,6 +1,8 @@
 #include "SensorSimSportsCar.h"
 #include "SensorSimSportsWheelFront.h"
 #include "SensorSimSportsWheelRear.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimVehicleCatalog.h"
 #include "ChaosWheeledVehicleMovementComponent.h"
 
 // UESensors
@@ -12,11 +14,19 @@ ASensorSimSportsCar::ASensorSimSportsCar()
 	// Attach the LiDAR sensor to the root component
 	Lidar->SetupAttachment(RootComponent);
 
+	// Cast the LiDAR rays from the sensor, using a 128-channel, 2048-column pattern at 10 Hz
+	FSensorSimLidarPattern LidarPattern;
+	LidarPattern.Channels = 128;
+	LidarPattern.Columns = 2048;
+	LidarPattern.RotationRate = 10.0f;
+
+	GetLidarScanner()->SetMount(Lidar);
+	GetLidarScanner()->SetPattern(LidarPattern);
+
 	// Note: for faster iteration times, the vehicle setup can be tweaked in the Blueprint instead
 
-	// Set up the chassis
-	GetChaosVehicleMovement()->ChassisHeight = 144.0f;
-	GetChaosVehicleMovement()->DragCoefficient = 0.31f;
+	// Set up the chassis, engine, transmission, differential and steering from the shipped archetype
+	SensorSimVehicleCatalog::SportsCar.ApplyTo(*GetChaosVehicleMovement());
 
 	// Set up the wheels
 	GetChaosVehicleMovement()->bLegacyWheelFrictionPosition = true;
@@ -37,37 +47,4 @@ ASensorSimSportsCar::ASensorSimSportsCar()
 	GetChaosVehicleMovement()->WheelSetups[3].WheelClass = USensorSimSportsWheelRear::StaticClass();
 	GetChaosVehicleMovement()->WheelSetups[3].BoneName = FName("Phys_Wheel_BR");
 	GetChaosVehicleMovement()->WheelSetups[3].AdditionalOffset = FVector(0.0f, 0.0f, 0.0f);
-
-	// Set up the engine
-	// NOTE: Check the Blueprint asset for the Torque Curve
-	GetChaosVehicleMovement()->EngineSetup.MaxTorque = 750.0f;
-	GetChaosVehicleMovement()->EngineSetup.MaxRPM = 7000.0f;
-	GetChaosVehicleMovement()->EngineSetup.EngineIdleRPM = 900.0f;
-	GetChaosVehicleMovement()->EngineSetup.EngineBrakeEffect = 0.2f;
-	GetChaosVehicleMovement()->EngineSetup.EngineRevUpMOI = 5.0f;
-	GetChaosVehicleMovement()->EngineSetup.EngineRevDownRate = 600.0f;
-
-	// Set up the transmission
-	GetChaosVehicleMovement()->TransmissionSetup.bUseAutomaticGears = true;
-	GetChaosVehicleMovement()->TransmissionSetup.bUseAutoReverse = true;
-	GetChaosVehicleMovement()->TransmissionSetup.FinalRatio = 2.81f;
-	GetChaosVehicleMovement()->TransmissionSetup.ChangeUpRPM = 6000.0f;
-	GetChaosVehicleMovement()->TransmissionSetup.ChangeDownRPM = 2000.0f;
-	GetChaosVehicleMovement()->TransmissionSetup.GearChangeTime = 0.2f;
-	GetChaosVehicleMovement()->TransmissionSetup.TransmissionEfficiency = 0.9f;
-
-	GetChaosVehicleMovement()->TransmissionSetup.ForwardGearRatios.SetNum(5);
-	GetChaosVehicleMovement()->TransmissionSetup.ForwardGearRatios[0] = 4.25f;
-	GetChaosVehicleMovement()->TransmissionSetup.ForwardGearRatios[1] = 2.52f;
-	GetChaosVehicleMovement()->TransmissionSetup.ForwardGearRatios[2] = 1.66f;
-	GetChaosVehicleMovement()->TransmissionSetup.ForwardGearRatios[3] = 1.22f;
-	GetChaosVehicleMovement()->TransmissionSetup.ForwardGearRatios[4] = 1.0f;
-
-	GetChaosVehicleMovement()->TransmissionSetup.ReverseGearRatios.SetNum(1);
-	GetChaosVehicleMovement()->TransmissionSetup.ReverseGearRatios[0] = 4.04f;
-
-	// Set up the steering
-	// NOTE: Check the Blueprint asset for the Steering Curve
-	GetChaosVehicleMovement()->SteeringSetup.SteeringType = ESteeringType::Ackermann;
-	GetChaosVehicleMovement()->SteeringSetup.AngleRatio = 0.7f;
 }
\ No newline at end of file
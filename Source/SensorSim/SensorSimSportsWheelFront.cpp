@@ -2,13 +2,9 @@
 
 
 #include "SensorSimSportsWheelFront.h"
+#include "SensorSimVehicleCatalog.h"
 
 USensorSimSportsWheelFront::USensorSimSportsWheelFront()
 {
-	WheelRadius = 39.0f;
-	WheelWidth = 35.0f;
-	FrictionForceMultiplier = 3.0f;
-
-	MaxBrakeTorque = 4500.0f;
-	MaxHandBrakeTorque = 6000.0f;
+	SensorSimVehicleCatalog::SportsCar.Wheels[0].ApplyTo(*this);
 }
\ No newline at end of file
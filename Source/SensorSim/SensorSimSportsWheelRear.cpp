@@ -2,14 +2,9 @@
 
 
 #include "SensorSimSportsWheelRear.h"
+#include "SensorSimVehicleCatalog.h"
 
 USensorSimSportsWheelRear::USensorSimSportsWheelRear()
 {
-	WheelRadius = 40.f;
-	WheelWidth = 40.0f;
-	FrictionForceMultiplier = 4.0f;
-	SlipThreshold = 100.0f;
-	SkidThreshold = 100.0f;
-	MaxSteerAngle = 0.0f;
-	MaxHandBrakeTorque = 6000.0f;
+	SensorSimVehicleCatalog::SportsCar.Wheels[1].ApplyTo(*this);
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ *  Single producer, single consumer ring buffer
+ *  Lock-free and allocation-free once constructed. One thread pushes, one other thread pops.
+ *  Pushing into a full ring fails and is counted, so a stalled consumer never blocks the producer.
+ */
+template<typename ElementType>
+class TSensorSimSpscRing
+{
+	static_assert(TIsTriviallyCopyAssignable<ElementType>::Value, "Ring elements are copied between threads without synchronization beyond the indices");
+
+public:
+	/** Allocates the ring, rounding the capacity up to a power of two */
+	explicit TSensorSimSpscRing(uint32 InCapacity)
+		: Mask{ FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2u)) - 1 }
+	{
+		Elements.SetNumUninitialized(Mask + 1);
+	}
+
+	/** Returns the number of elements the ring can hold */
+	uint32 GetCapacity() const { return Mask + 1; }
+
+	/** Returns the number of elements waiting. Approximate unless called from the consumer */
+	uint32 Num() const { return Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire); }
+
+	/** Returns the number of pushes that failed because the ring was full */
+	uint32 GetNumOverflows() const { return NumOverflows.load(std::memory_order_relaxed); }
+
+	/** Appends an element. Producer only. Returns false if the ring is full */
+	bool Push(const ElementType& Element)
+	{
+		const uint32 CurrentHead = Head.load(std::memory_order_relaxed);
+		if (CurrentHead - Tail.load(std::memory_order_acquire) > Mask)
+		{
+			NumOverflows.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		Elements[CurrentHead & Mask] = Element;
+		Head.store(CurrentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Removes the oldest element. Consumer only. Returns false if the ring is empty */
+	bool Pop(ElementType& OutElement)
+	{
+		const uint32 CurrentTail = Tail.load(std::memory_order_relaxed);
+		if (CurrentTail == Head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		OutElement = Elements[CurrentTail & Mask];
+		Tail.store(CurrentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Appends every waiting element to OutElements, oldest first. Consumer only. Returns the number popped */
+	int32 PopAll(TArray<ElementType>& OutElements)
+	{
+		const uint32 CurrentTail = Tail.load(std::memory_order_relaxed);
+		const uint32 CurrentHead = Head.load(std::memory_order_acquire);
+		const uint32 Count = CurrentHead - CurrentTail;
+
+		OutElements.Reserve(OutElements.Num() + Count);
+		for (uint32 Index = CurrentTail; Index != CurrentHead; ++Index)
+		{
+			OutElements.Add(Elements[Index & Mask]);
+		}
+
+		Tail.store(CurrentHead, std::memory_order_release);
+		return static_cast<int32>(Count);
+	}
+
+private:
+	TArray<ElementType> Elements;
+	const uint32 Mask;
+
+	/** Next slot to write. Written by the producer only */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Head{ 0 };
+
+	/** Next slot to read. Written by the consumer only */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Tail{ 0 };
+
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> NumOverflows{ 0 };
+};
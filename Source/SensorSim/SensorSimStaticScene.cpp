@@ -0,0 +1,353 @@
+#include "SensorSimStaticScene.h"
+#include "SensorSim.h"
+#include "Algo/Sort.h"
+#include "Math/VectorRegister.h"
+
+namespace SensorSimStaticScene
+{
+	/** Triangles per leaf, one per SIMD lane */
+	constexpr int32 LeafSize = 4;
+
+	/** Entries of the traversal stack. Each level pushes at most three more children than it pops */
+	constexpr int32 StackSize = 256;
+
+	/** Determinants below this are rays parallel to the triangle */
+	constexpr float ParallelEpsilon = 1e-9f;
+
+	/** Child code of an unused node slot. Its bounds are a point beyond any ray's reach, so it is never entered */
+	constexpr int32 EmptyChild = MIN_int32;
+
+	/** Returns 1 / Value, kept finite for axis aligned rays */
+	float SafeReciprocal(float Value)
+	{
+		return FMath::Abs(Value) > UE_SMALL_NUMBER ? 1.0f / Value : (Value < 0.0f ? -UE_BIG_NUMBER : UE_BIG_NUMBER);
+	}
+
+	/** Sorts a range along the longest axis of its centroids and returns the index of its median */
+	template<typename BuildTriangleType>
+	int32 SplitAtMedian(TArrayView<BuildTriangleType> Range)
+	{
+		FBox3f CentroidBounds(ForceInit);
+		for (const BuildTriangleType& Triangle : Range)
+		{
+			CentroidBounds += Triangle.Centroid;
+		}
+
+		const FVector3f Extent = CentroidBounds.GetExtent();
+		const int32 Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+
+		Algo::SortBy(Range, [Axis](const BuildTriangleType& Triangle) { return Triangle.Centroid[Axis]; });
+		return Range.Num() / 2;
+	}
+}
+
+void FSensorSimStaticScene::Build(const FVector& InOrigin, TConstArrayView<FVector3f> Vertices, TConstArrayView<FTriIndices> Triangles)
+{
+	Origin = InOrigin;
+	Nodes.Reset();
+	Leaves.Reset();
+	Normals.Reset();
+	TriangleSources.Reset();
+	Sources.Reset();
+	NumTriangles = Triangles.Num();
+	MaxDepth = 0;
+
+	if (Triangles.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FBuildTriangle> BuildTriangles;
+	BuildTriangles.SetNumUninitialized(Triangles.Num());
+	Normals.SetNumUninitialized(Triangles.Num());
+
+	for (int32 Index = 0; Index < Triangles.Num(); ++Index)
+	{
+		const FTriIndices& Triangle = Triangles[Index];
+		const FVector3f& A = Vertices[Triangle.v0];
+		const FVector3f& B = Vertices[Triangle.v1];
+		const FVector3f& C = Vertices[Triangle.v2];
+
+		FBuildTriangle& BuildTriangle = BuildTriangles[Index];
+		BuildTriangle.Bounds = FBox3f(ForceInit);
+		BuildTriangle.Bounds += A;
+		BuildTriangle.Bounds += B;
+		BuildTriangle.Bounds += C;
+		BuildTriangle.Centroid = (A + B + C) / 3.0f;
+		BuildTriangle.Triangle = Index;
+
+		Normals[Index] = ((B - A) ^ (C - A)).GetSafeNormal();
+	}
+
+	// a 4-wide tree has about a third as many nodes as leaves
+	Leaves.Reserve(FMath::DivideAndRoundUp(Triangles.Num(), SensorSimStaticScene::LeafSize));
+	Nodes.Reserve(Leaves.Max() / 3 + 1);
+
+	Root = BuildSubtree(BuildTriangles, Vertices, Triangles, 0);
+
+	Nodes.Shrink();
+	Leaves.Shrink();
+
+	checkf(MaxDepth * 3 + SensorSimStaticScene::LeafSize <= SensorSimStaticScene::StackSize, TEXT("Static scene too deep to trace: %d levels"), MaxDepth);
+}
+
+void FSensorSimStaticScene::SetSources(TArray<FSensorSimStaticSource>&& InSources, TArray<int32>&& InTriangleSources)
+{
+	check(InTriangleSources.Num() == NumTriangles);
+
+	Sources = MoveTemp(InSources);
+	TriangleSources = MoveTemp(InTriangleSources);
+}
+
+int32 FSensorSimStaticScene::BuildSubtree(TArrayView<FBuildTriangle> Range, TConstArrayView<FVector3f> Vertices, TConstArrayView<FTriIndices> Triangles, int32 Depth)
+{
+	using namespace SensorSimStaticScene;
+
+	MaxDepth = FMath::Max(MaxDepth, Depth);
+
+	if (Range.Num() <= LeafSize)
+	{
+		const int32 LeafIndex = Leaves.AddZeroed();
+		FLeaf& Leaf = Leaves[LeafIndex];
+
+		for (int32 Lane = 0; Lane < LeafSize; ++Lane)
+		{
+			if (Lane >= Range.Num())
+			{
+				Leaf.Triangles[Lane] = INDEX_NONE;
+				continue;
+			}
+
+			const FTriIndices& Triangle = Triangles[Range[Lane].Triangle];
+			const FVector3f& V0 = Vertices[Triangle.v0];
+			const FVector3f E1 = Vertices[Triangle.v1] - V0;
+			const FVector3f E2 = Vertices[Triangle.v2] - V0;
+
+			Leaf.V0X[Lane] = V0.X;
+			Leaf.V0Y[Lane] = V0.Y;
+			Leaf.V0Z[Lane] = V0.Z;
+			Leaf.E1X[Lane] = E1.X;
+			Leaf.E1Y[Lane] = E1.Y;
+			Leaf.E1Z[Lane] = E1.Z;
+			Leaf.E2X[Lane] = E2.X;
+			Leaf.E2Y[Lane] = E2.Y;
+			Leaf.E2Z[Lane] = E2.Z;
+			Leaf.Triangles[Lane] = Range[Lane].Triangle;
+		}
+
+		return ~LeafIndex;
+	}
+
+	// split the largest range in two until there are four, or every range fits a leaf
+	TArray<TArrayView<FBuildTriangle>, TInlineAllocator<4>> ChildRanges;
+	ChildRanges.Add(Range);
+
+	while (ChildRanges.Num() < 4)
+	{
+		int32 Largest = 0;
+		for (int32 Index = 1; Index < ChildRanges.Num(); ++Index)
+		{
+			if (ChildRanges[Index].Num() > ChildRanges[Largest].Num())
+			{
+				Largest = Index;
+			}
+		}
+
+		if (ChildRanges[Largest].Num() <= LeafSize)
+		{
+			break;
+		}
+
+		const TArrayView<FBuildTriangle> Split = ChildRanges[Largest];
+		const int32 Median = SplitAtMedian(Split);
+
+		ChildRanges[Largest] = Split.Left(Median);
+		ChildRanges.Insert(Split.RightChop(Median), Largest + 1);
+	}
+
+	// the node is filled in after its children, whose recursion may reallocate the array
+	const int32 NodeIndex = Nodes.AddUninitialized();
+
+	FNode Node;
+	for (int32 Slot = 0; Slot < 4; ++Slot)
+	{
+		FBox3f Bounds(ForceInit);
+		if (Slot < ChildRanges.Num())
+		{
+			for (const FBuildTriangle& Triangle : ChildRanges[Slot])
+			{
+				Bounds += Triangle.Bounds;
+			}
+
+			Node.Children[Slot] = BuildSubtree(ChildRanges[Slot], Vertices, Triangles, Depth + 1);
+		}
+		else
+		{
+			Bounds.Min = FVector3f(UE_BIG_NUMBER);
+			Bounds.Max = FVector3f(UE_BIG_NUMBER);
+			Node.Children[Slot] = EmptyChild;
+		}
+
+		Node.MinX[Slot] = Bounds.Min.X;
+		Node.MinY[Slot] = Bounds.Min.Y;
+		Node.MinZ[Slot] = Bounds.Min.Z;
+		Node.MaxX[Slot] = Bounds.Max.X;
+		Node.MaxY[Slot] = Bounds.Max.Y;
+		Node.MaxZ[Slot] = Bounds.Max.Z;
+	}
+
+	Nodes[NodeIndex] = Node;
+	return NodeIndex;
+}
+
+bool FSensorSimStaticScene::Raycast(const FVector& Start, const FVector3f& Direction, float MinDistance, float MaxDistance, float& OutDistance, int32& OutTriangle) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	const FVector3f LocalStart(Start - Origin);
+
+	const VectorRegister4Float StartX = VectorSetFloat1(LocalStart.X);
+	const VectorRegister4Float StartY = VectorSetFloat1(LocalStart.Y);
+	const VectorRegister4Float StartZ = VectorSetFloat1(LocalStart.Z);
+	const VectorRegister4Float InvDirX = VectorSetFloat1(SensorSimStaticScene::SafeReciprocal(Direction.X));
+	const VectorRegister4Float InvDirY = VectorSetFloat1(SensorSimStaticScene::SafeReciprocal(Direction.Y));
+	const VectorRegister4Float InvDirZ = VectorSetFloat1(SensorSimStaticScene::SafeReciprocal(Direction.Z));
+	const VectorRegister4Float Min = VectorSetFloat1(MinDistance);
+
+	float Closest = MaxDistance;
+	int32 ClosestTriangle = INDEX_NONE;
+
+	int32 Stack[SensorSimStaticScene::StackSize];
+	int32 StackTop = 0;
+	Stack[StackTop++] = Root;
+
+	while (StackTop > 0)
+	{
+		const int32 Child = Stack[--StackTop];
+		if (Child < 0)
+		{
+			IntersectLeaf(Leaves[~Child], LocalStart, Direction, MinDistance, Closest, ClosestTriangle);
+			continue;
+		}
+
+		// slab test of the ray against all four child boxes at once
+		const FNode& Node = Nodes[Child];
+
+		const VectorRegister4Float X0 = VectorMultiply(VectorSubtract(VectorLoadAligned(Node.MinX), StartX), InvDirX);
+		const VectorRegister4Float X1 = VectorMultiply(VectorSubtract(VectorLoadAligned(Node.MaxX), StartX), InvDirX);
+		const VectorRegister4Float Y0 = VectorMultiply(VectorSubtract(VectorLoadAligned(Node.MinY), StartY), InvDirY);
+		const VectorRegister4Float Y1 = VectorMultiply(VectorSubtract(VectorLoadAligned(Node.MaxY), StartY), InvDirY);
+		const VectorRegister4Float Z0 = VectorMultiply(VectorSubtract(VectorLoadAligned(Node.MinZ), StartZ), InvDirZ);
+		const VectorRegister4Float Z1 = VectorMultiply(VectorSubtract(VectorLoadAligned(Node.MaxZ), StartZ), InvDirZ);
+
+		const VectorRegister4Float Near = VectorMax(VectorMax(VectorMin(X0, X1), VectorMin(Y0, Y1)), VectorMax(VectorMin(Z0, Z1), Min));
+		const VectorRegister4Float Far = VectorMin(VectorMin(VectorMax(X0, X1), VectorMax(Y0, Y1)), VectorMin(VectorMax(Z0, Z1), VectorSetFloat1(Closest)));
+
+		const uint32 HitMask = VectorMaskBits(VectorCompareLE(Near, Far));
+		if (HitMask == 0)
+		{
+			continue;
+		}
+
+		alignas(16) float NearDistances[4];
+		VectorStoreAligned(Near, NearDistances);
+
+		// push the farthest child first, so that the nearest is entered first and shortens the ray for the others
+		int32 HitChildren[4];
+		int32 NumHits = 0;
+		for (int32 Slot = 0; Slot < 4; ++Slot)
+		{
+			if (HitMask & (1 << Slot))
+			{
+				int32 Insert = NumHits++;
+				while (Insert > 0 && NearDistances[HitChildren[Insert - 1]] < NearDistances[Slot])
+				{
+					HitChildren[Insert] = HitChildren[Insert - 1];
+					--Insert;
+				}
+				HitChildren[Insert] = Slot;
+			}
+		}
+
+		for (int32 Index = 0; Index < NumHits; ++Index)
+		{
+			Stack[StackTop++] = Node.Children[HitChildren[Index]];
+		}
+	}
+
+	if (ClosestTriangle == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutDistance = Closest;
+	OutTriangle = ClosestTriangle;
+	return true;
+}
+
+void FSensorSimStaticScene::IntersectLeaf(const FLeaf& Leaf, const FVector3f& Start, const FVector3f& Direction, float MinDistance, float& InOutClosest, int32& InOutTriangle) const
+{
+	// Moller-Trumbore against all four triangles at once
+	const VectorRegister4Float DirX = VectorSetFloat1(Direction.X);
+	const VectorRegister4Float DirY = VectorSetFloat1(Direction.Y);
+	const VectorRegister4Float DirZ = VectorSetFloat1(Direction.Z);
+
+	const VectorRegister4Float E1X = VectorLoadAligned(Leaf.E1X);
+	const VectorRegister4Float E1Y = VectorLoadAligned(Leaf.E1Y);
+	const VectorRegister4Float E1Z = VectorLoadAligned(Leaf.E1Z);
+	const VectorRegister4Float E2X = VectorLoadAligned(Leaf.E2X);
+	const VectorRegister4Float E2Y = VectorLoadAligned(Leaf.E2Y);
+	const VectorRegister4Float E2Z = VectorLoadAligned(Leaf.E2Z);
+
+	// P = D x E2
+	const VectorRegister4Float PX = VectorNegateMultiplyAdd(DirZ, E2Y, VectorMultiply(DirY, E2Z));
+	const VectorRegister4Float PY = VectorNegateMultiplyAdd(DirX, E2Z, VectorMultiply(DirZ, E2X));
+	const VectorRegister4Float PZ = VectorNegateMultiplyAdd(DirY, E2X, VectorMultiply(DirX, E2Y));
+
+	const VectorRegister4Float Det = VectorMultiplyAdd(E1X, PX, VectorMultiplyAdd(E1Y, PY, VectorMultiply(E1Z, PZ)));
+	const VectorRegister4Float InvDet = VectorDivide(VectorOneFloat(), Det);
+
+	// S = Start - V0
+	const VectorRegister4Float SX = VectorSubtract(VectorSetFloat1(Start.X), VectorLoadAligned(Leaf.V0X));
+	const VectorRegister4Float SY = VectorSubtract(VectorSetFloat1(Start.Y), VectorLoadAligned(Leaf.V0Y));
+	const VectorRegister4Float SZ = VectorSubtract(VectorSetFloat1(Start.Z), VectorLoadAligned(Leaf.V0Z));
+
+	const VectorRegister4Float U = VectorMultiply(VectorMultiplyAdd(SX, PX, VectorMultiplyAdd(SY, PY, VectorMultiply(SZ, PZ))), InvDet);
+
+	// Q = S x E1
+	const VectorRegister4Float QX = VectorNegateMultiplyAdd(SZ, E1Y, VectorMultiply(SY, E1Z));
+	const VectorRegister4Float QY = VectorNegateMultiplyAdd(SX, E1Z, VectorMultiply(SZ, E1X));
+	const VectorRegister4Float QZ = VectorNegateMultiplyAdd(SY, E1X, VectorMultiply(SX, E1Y));
+
+	const VectorRegister4Float V = VectorMultiply(VectorMultiplyAdd(DirX, QX, VectorMultiplyAdd(DirY, QY, VectorMultiply(DirZ, QZ))), InvDet);
+	const VectorRegister4Float T = VectorMultiply(VectorMultiplyAdd(E2X, QX, VectorMultiplyAdd(E2Y, QY, VectorMultiply(E2Z, QZ))), InvDet);
+
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	VectorRegister4Float Hit = VectorCompareGT(VectorAbs(Det), VectorSetFloat1(SensorSimStaticScene::ParallelEpsilon));
+	Hit = VectorBitwiseAnd(Hit, VectorCompareGE(U, Zero));
+	Hit = VectorBitwiseAnd(Hit, VectorCompareGE(V, Zero));
+	Hit = VectorBitwiseAnd(Hit, VectorCompareLE(VectorAdd(U, V), VectorOneFloat()));
+	Hit = VectorBitwiseAnd(Hit, VectorCompareGE(T, VectorSetFloat1(MinDistance)));
+	Hit = VectorBitwiseAnd(Hit, VectorCompareLT(T, VectorSetFloat1(InOutClosest)));
+
+	const uint32 HitMask = VectorMaskBits(Hit);
+	if (HitMask == 0)
+	{
+		return;
+	}
+
+	alignas(16) float Distances[4];
+	VectorStoreAligned(T, Distances);
+
+	for (int32 Lane = 0; Lane < 4; ++Lane)
+	{
+		if ((HitMask & (1 << Lane)) && Distances[Lane] < InOutClosest)
+		{
+			InOutClosest = Distances[Lane];
+			InOutTriangle = Leaf.Triangles[Lane];
+		}
+	}
+}
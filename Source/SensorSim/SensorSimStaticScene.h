@@ -0,0 +1,130 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "SensorSimLabels.h"
+
+/** Component static scene triangles were gathered from, as sensors see it */
+struct FSensorSimStaticSource
+{
+	/** Share of the emitted power the surface returns, 0 to 1 */
+	float Reflectivity = 0.3f;
+
+	/** CustomDepth stencil value the component renders with, 0 if it does not render custom depth */
+	uint8 Stencil = 0;
+
+	/** Ground truth class and instance of the component */
+	FSensorSimLabel Label;
+};
+
+/**
+ *  Static Scene
+ *  Ray acceleration structure over the static level geometry seen by the sensors, built once at level load.
+ *  A 4-wide BVH: every node stores the bounds of its four children side by side, and every leaf four triangles
+ *  side by side, so that a ray is tested against four boxes or four triangles at a time in SIMD registers.
+ *  Immutable once built, so any number of worker threads may trace it at once.
+ */
+class SENSORSIM_API FSensorSimStaticScene
+{
+public:
+	/** Builds the structure over the given triangles. Vertices are relative to InOrigin */
+	void Build(const FVector& InOrigin, TConstArrayView<FVector3f> Vertices, TConstArrayView<FTriIndices> Triangles);
+
+	/** Sets the source of every triangle, as indices into InSources. Before the scene is shared with any sensor */
+	void SetSources(TArray<FSensorSimStaticSource>&& InSources, TArray<int32>&& InTriangleSources);
+
+	/**
+	 *  Traces a ray from Start along a unit Direction. Returns true if a triangle lies between MinDistance and MaxDistance,
+	 *  with the distance from Start to the closest one and its index in the triangles the scene was built from.
+	 */
+	bool Raycast(const FVector& Start, const FVector3f& Direction, float MinDistance, float MaxDistance, float& OutDistance, int32& OutTriangle) const;
+
+	/** Returns true if the scene holds no geometry */
+	bool IsEmpty() const { return NumTriangles == 0; }
+
+	/** Returns the number of triangles */
+	int32 GetNumTriangles() const { return NumTriangles; }
+
+	/** Returns the unit normal of a triangle, on the side its vertices wind counterclockwise around */
+	const FVector3f& GetTriangleNormal(int32 Triangle) const { return Normals[Triangle]; }
+
+	/** Returns the source a triangle was gathered from */
+	const FSensorSimStaticSource& GetTriangleSource(int32 Triangle) const
+	{
+		return TriangleSources.IsValidIndex(Triangle) ? Sources[TriangleSources[Triangle]] : DefaultSource;
+	}
+
+	/** Returns the number of interior nodes */
+	int32 GetNumNodes() const { return Nodes.Num(); }
+
+	/** Returns the bytes allocated by the scene */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Nodes.GetAllocatedSize() + Leaves.GetAllocatedSize() + Normals.GetAllocatedSize() + Sources.GetAllocatedSize() + TriangleSources.GetAllocatedSize();
+	}
+
+private:
+	/** Four children, bounds as structure of arrays. Children are node indices, or complemented leaf indices when negative */
+	struct alignas(16) FNode
+	{
+		float MinX[4];
+		float MinY[4];
+		float MinZ[4];
+		float MaxX[4];
+		float MaxY[4];
+		float MaxZ[4];
+		int32 Children[4];
+	};
+
+	/** Four triangles as a vertex and two edges, structure of arrays. Unused lanes are degenerate */
+	struct alignas(16) FLeaf
+	{
+		float V0X[4];
+		float V0Y[4];
+		float V0Z[4];
+		float E1X[4];
+		float E1Y[4];
+		float E1Z[4];
+		float E2X[4];
+		float E2Y[4];
+		float E2Z[4];
+		int32 Triangles[4];
+	};
+
+	/** Triangle being sorted into the tree */
+	struct FBuildTriangle
+	{
+		FBox3f Bounds;
+		FVector3f Centroid;
+		int32 Triangle;
+	};
+
+	/** Builds the subtree over a range of triangles. Returns its child code */
+	int32 BuildSubtree(TArrayView<FBuildTriangle> Range, TConstArrayView<FVector3f> Vertices, TConstArrayView<FTriIndices> Triangles, int32 Depth);
+
+	/** Intersects the four triangles of a leaf, shortening the closest hit */
+	void IntersectLeaf(const FLeaf& Leaf, const FVector3f& Start, const FVector3f& Direction, float MinDistance, float& InOutClosest, int32& InOutTriangle) const;
+
+	/** Child code of the root: a node index, or a complemented leaf index */
+	int32 Root = 0;
+
+	/** Position every vertex is stored relative to, keeping them precise in single precision */
+	FVector Origin = FVector::ZeroVector;
+
+	TArray<FNode> Nodes;
+	TArray<FLeaf> Leaves;
+
+	/** Per triangle, in the order the scene was built from */
+	TArray<FVector3f> Normals;
+	TArray<int32> TriangleSources;
+
+	TArray<FSensorSimStaticSource> Sources;
+
+	/** Source of the triangles without one */
+	FSensorSimStaticSource DefaultSource;
+
+	int32 NumTriangles = 0;
+
+	/** Deepest level of the tree, bounding the traversal stack */
+	int32 MaxDepth = 0;
+};
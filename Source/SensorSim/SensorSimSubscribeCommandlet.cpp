@@ -0,0 +1,197 @@
+#include "SensorSimSubscribeCommandlet.h"
+#include "SensorSim.h"
+#include "SensorSimPublisherSubsystem.h"
+#include "SensorSimSharedMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+namespace SensorSimSubscribe
+{
+	/** Seconds between polls of the segments */
+	constexpr float PollInterval = 0.001f;
+
+	/** Tolerance on the norm of published quaternions */
+	constexpr double QuatTolerance = 1e-3;
+
+	/** Subscription to one segment */
+	struct FTopic
+	{
+		const TCHAR* Name = nullptr;
+		FSensorSimShmReader Reader;
+
+		/** Next sequence to read, 0 until the first poll after opening */
+		uint64 NextSequence = 0;
+
+		/** Stamp of the last message read */
+		double LastTime = -UE_DOUBLE_BIG_NUMBER;
+
+		/** Totals since the start */
+		uint64 NumReceived = 0;
+		uint64 NumLost = 0;
+		uint64 NumMalformed = 0;
+		uint64 BytesReceived = 0;
+
+		/** Totals at the last report */
+		uint64 ReportedReceived = 0;
+		uint64 ReportedBytes = 0;
+	};
+
+	bool IsUnitQuat(const double Quat[4])
+	{
+		return FMath::Abs(Quat[0] * Quat[0] + Quat[1] * Quat[1] + Quat[2] * Quat[2] + Quat[3] * Quat[3] - 1.0) < QuatTolerance;
+	}
+
+	/** Checks a point cloud against the layout its header describes, in place */
+	bool ValidatePointCloud(const FSensorSimShmHeader& Header, const FSensorSimShmSlot& Slot, TConstArrayView<uint8> Data)
+	{
+		if (Header.PointStep != sizeof(FSensorSimShmPoint) || Slot.RowStep != Slot.Width * Header.PointStep
+			|| uint64(Slot.Height) * Slot.RowStep != Slot.DataSize || Slot.DataSize != uint32(Data.Num()))
+		{
+			return false;
+		}
+
+		// rays are stored column by column, so firing times never decrease
+		const FSensorSimShmPoint* Points = reinterpret_cast<const FSensorSimShmPoint*>(Data.GetData());
+		float LastTime = 0.0f;
+
+		for (uint32 Index = 0; Index < Slot.Width * Slot.Height; ++Index)
+		{
+			const FSensorSimShmPoint& Point = Points[Index];
+			if (!FMath::IsFinite(Point.X) || !FMath::IsFinite(Point.Y) || !FMath::IsFinite(Point.Z) || Point.Time < LastTime)
+			{
+				return false;
+			}
+
+			LastTime = Point.Time;
+		}
+
+		return true;
+	}
+}
+
+USensorSimSubscribeCommandlet::USensorSimSubscribeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Reads and validates a vehicle's point clouds, IMU and odometry from the shared memory publisher");
+	HelpUsage = TEXT("-run=SensorSimSubscribe [-Stream=0] [-Seconds=10] [-Prefix=SensorSim]");
+}
+
+int32 USensorSimSubscribeCommandlet::Main(const FString& Params)
+{
+	using namespace SensorSimSubscribe;
+
+	int32 StreamId = 0;
+	float Seconds = 10.0f;
+	FString Prefix = TEXT("SensorSim");
+
+	FParse::Value(*Params, TEXT("Stream="), StreamId);
+	FParse::Value(*Params, TEXT("Seconds="), Seconds);
+	FParse::Value(*Params, TEXT("Prefix="), Prefix);
+
+	FTopic Topics[3];
+	Topics[0].Name = TEXT("points");
+	Topics[1].Name = TEXT("imu");
+	Topics[2].Name = TEXT("odom");
+
+	UE_LOG(LogSensorSim, Display, TEXT("Subscribing to %s for %.0fs"), *USensorSimPublisherSubsystem::GetSegmentName(Prefix, StreamId, TEXT("*")), Seconds);
+
+	const double StartTime = FPlatformTime::Seconds();
+	double ReportTime = StartTime;
+
+	while (FPlatformTime::Seconds() - StartTime < Seconds)
+	{
+		for (FTopic& Topic : Topics)
+		{
+			// the publisher may start after the subscriber
+			if (!Topic.Reader.IsOpen() && !Topic.Reader.Open(USensorSimPublisherSubsystem::GetSegmentName(Prefix, StreamId, Topic.Name)))
+			{
+				continue;
+			}
+
+			const FSensorSimShmHeader& Header = Topic.Reader.GetHeader();
+			const uint64 LatestSequence = Topic.Reader.GetLatestSequence();
+
+			// join at the latest message rather than counting the backlog as lost
+			if (Topic.NextSequence == 0)
+			{
+				Topic.NextSequence = FMath::Max<uint64>(LatestSequence, 1);
+			}
+
+			for (; Topic.NextSequence <= LatestSequence; ++Topic.NextSequence)
+			{
+				bool bValid = false;
+				double Time = 0.0;
+				uint32 DataSize = 0;
+
+				const ESensorSimShmRead Result = Topic.Reader.Read(Topic.NextSequence, [&](const FSensorSimShmSlot& Slot, TConstArrayView<uint8> Data)
+				{
+					Time = FSensorSimShmReader::GetTime(Slot);
+					DataSize = Data.Num();
+
+					switch (Header.Kind)
+					{
+					case ESensorSimShmKind::PointCloud2:
+						bValid = ValidatePointCloud(Header, Slot, Data);
+						break;
+
+					case ESensorSimShmKind::Imu:
+						bValid = Data.Num() == sizeof(FSensorSimShmImu) && IsUnitQuat(reinterpret_cast<const FSensorSimShmImu*>(Data.GetData())->Orientation);
+						break;
+
+					case ESensorSimShmKind::Odometry:
+						bValid = Data.Num() == sizeof(FSensorSimShmOdometry) && IsUnitQuat(reinterpret_cast<const FSensorSimShmOdometry*>(Data.GetData())->Orientation);
+						break;
+					}
+				});
+
+				if (Result != ESensorSimShmRead::Ok)
+				{
+					++Topic.NumLost;
+					continue;
+				}
+
+				// stamps are simulation time, and never go back
+				if (!bValid || Time < Topic.LastTime)
+				{
+					++Topic.NumMalformed;
+				}
+
+				Topic.LastTime = Time;
+				++Topic.NumReceived;
+				Topic.BytesReceived += DataSize;
+			}
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now - ReportTime >= 1.0)
+		{
+			for (FTopic& Topic : Topics)
+			{
+				UE_LOG(LogSensorSim, Display, TEXT("  %-6s %7.1f msg/s %8.2f MB/s  lost %llu  malformed %llu"), Topic.Name,
+					(Topic.NumReceived - Topic.ReportedReceived) / (Now - ReportTime),
+					(Topic.BytesReceived - Topic.ReportedBytes) / ((Now - ReportTime) * 1024.0 * 1024.0),
+					Topic.NumLost, Topic.NumMalformed);
+
+				Topic.ReportedReceived = Topic.NumReceived;
+				Topic.ReportedBytes = Topic.BytesReceived;
+			}
+
+			ReportTime = Now;
+		}
+
+		FPlatformProcess::Sleep(PollInterval);
+	}
+
+	bool bPassed = true;
+	for (const FTopic& Topic : Topics)
+	{
+		UE_LOG(LogSensorSim, Display, TEXT("%s: %llu received, %llu lost, %llu malformed"), Topic.Name, Topic.NumReceived, Topic.NumLost, Topic.NumMalformed);
+		bPassed &= Topic.NumReceived > 0 && Topic.NumMalformed == 0;
+	}
+
+	return bPassed ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SensorSimSubscribeCommandlet.generated.h"
+
+/**
+ *  Subscribe Commandlet
+ *  Local test subscriber for the shared memory publisher. Maps one vehicle's segments, reads every message
+ *  in place as it is published, validates its layout and contents, and reports rates and losses every second.
+ *
+ *  Usage:
+ *    UnrealEditor-Cmd SensorSim.uproject -run=SensorSimSubscribe [-Stream=0] [-Seconds=10] [-Prefix=SensorSim]
+ *
+ *  Returns non-zero if no message arrived or any message was malformed.
+ */
+UCLASS()
+class USensorSimSubscribeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimSubscribeCommandlet();
+
+	// Begin Commandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End Commandlet interface
+};
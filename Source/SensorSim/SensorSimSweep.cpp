@@ -0,0 +1,191 @@
+#include "SensorSimSweep.h"
+#include "SensorSim.h"
+#include "SensorSimLidarReturns.h"
+#include "SensorSimSharedMemory.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <limits>
+
+bool FSensorSimSweepSpec::LoadFromCSV(const FString& Filename)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to read sweep spec '%s'"), *Filename);
+		return false;
+	}
+
+	TArray<FSensorSimSweepParameter> NewParameters;
+	TArray<FString> Columns;
+	bool bHeader = false;
+
+	for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+	{
+		const FString Line = Lines[LineIndex].TrimStartAndEnd();
+
+		// skip blanks and comments
+		if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		Line.ParseIntoArray(Columns, TEXT(","), false);
+		for (FString& Column : Columns)
+		{
+			Column.TrimStartAndEndInline();
+		}
+
+		if (!bHeader)
+		{
+			if (Columns.Num() != 3 || Columns[0] != TEXT("Field") || Columns[1] != TEXT("Min") || Columns[2] != TEXT("Max"))
+			{
+				UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected a Field,Min,Max header"), *Filename, LineIndex + 1);
+				return false;
+			}
+
+			bHeader = true;
+			continue;
+		}
+
+		if (Columns.Num() != 3)
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected 3 columns, got %d"), *Filename, LineIndex + 1, Columns.Num());
+			return false;
+		}
+
+		FSensorSimVehicleArchetype Probe;
+		if (!SetParameter(Probe, Columns[0], 0.0f))
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("%s(%d): unknown archetype field '%s'"), *Filename, LineIndex + 1, *Columns[0]);
+			return false;
+		}
+
+		FSensorSimSweepParameter& Parameter = NewParameters.AddDefaulted_GetRef();
+		Parameter.Field = Columns[0];
+		Parameter.Min = FCString::Atof(*Columns[1]);
+		Parameter.Max = FCString::Atof(*Columns[2]);
+	}
+
+	if (NewParameters.IsEmpty())
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Sweep spec '%s' varies no parameter"), *Filename);
+		return false;
+	}
+
+	Parameters = MoveTemp(NewParameters);
+
+	UE_LOG(LogSensorSim, Log, TEXT("Loaded sweep spec '%s': %d parameters"), *Filename, Parameters.Num());
+	return true;
+}
+
+void FSensorSimSweepSpec::MakeRun(int32 Run, const FSensorSimVehicleArchetype& Base, FSensorSimVehicleArchetype& OutArchetype, TArray<float>& OutValues) const
+{
+	// one draw per parameter, keyed on the run only, so that adding runs never changes the earlier ones
+	const uint32 RunKey = HashCombine(GetTypeHash(Seed), GetTypeHash(Run));
+
+	OutArchetype = Base;
+	OutValues.SetNumUninitialized(Parameters.Num());
+
+	for (int32 Index = 0; Index < Parameters.Num(); ++Index)
+	{
+		const FSensorSimSweepParameter& Parameter = Parameters[Index];
+		OutValues[Index] = FMath::Lerp(Parameter.Min, Parameter.Max, SensorSimLidarReturns::Uniform(RunKey, Index));
+		SetParameter(OutArchetype, Parameter.Field, OutValues[Index]);
+	}
+}
+
+bool FSensorSimSweepSpec::SetParameter(FSensorSimVehicleArchetype& Archetype, const FString& Field, float Value)
+{
+	if (float* Member = SensorSimVehicleCatalog::FindField(Archetype, Field))
+	{
+		*Member = Value;
+		return true;
+	}
+
+	// a wheel field without an axle sets both
+	float* FrontMember = SensorSimVehicleCatalog::FindField(Archetype, TEXT("Front") + Field);
+	float* RearMember = SensorSimVehicleCatalog::FindField(Archetype, TEXT("Rear") + Field);
+	if (!FrontMember || !RearMember)
+	{
+		return false;
+	}
+
+	*FrontMember = Value;
+	*RearMember = Value;
+	return true;
+}
+
+FSensorSimSweepResults::FSensorSimSweepResults(int32 NumRows)
+{
+	Runs.SetNumZeroed(NumRows);
+}
+
+int32 FSensorSimSweepResults::AddColumn(const FString& Name)
+{
+	Names.Add(Name);
+
+	TArray<float>& Column = Columns.AddDefaulted_GetRef();
+	Column.Init(std::numeric_limits<float>::quiet_NaN(), Runs.Num());
+
+	return Columns.Num() - 1;
+}
+
+bool FSensorSimSweepResults::Write(const FString& Filename) const
+{
+	using namespace SensorSimColumns;
+
+	const int32 NumColumns = Columns.Num() + 1;
+
+	FSensorSimColumnsHeader Header;
+	Header.NumRows = Runs.Num();
+	Header.NumColumns = NumColumns;
+
+	TArray<FSensorSimColumnEntry> Entries;
+	Entries.SetNum(NumColumns);
+
+	TArray<TConstArrayView<uint8>> Data;
+	Data.Reserve(NumColumns);
+
+	auto SetEntry = [&](int32 Index, const FString& Name, uint8 Datatype, const void* Values, SIZE_T Bytes)
+	{
+		FCStringAnsi::Strncpy(Entries[Index].Name, TCHAR_TO_ANSI(*Name), UE_ARRAY_COUNT(Entries[Index].Name));
+		Entries[Index].Datatype = Datatype;
+		Data.Add(TConstArrayView<uint8>(static_cast<const uint8*>(Values), static_cast<int32>(Bytes)));
+	};
+
+	SetEntry(0, TEXT("Run"), SensorSimSharedMemory::UInt32, Runs.GetData(), Runs.Num() * sizeof(uint32));
+	for (int32 Index = 0; Index < Columns.Num(); ++Index)
+	{
+		SetEntry(Index + 1, Names[Index], SensorSimSharedMemory::Float32, Columns[Index].GetData(), Columns[Index].Num() * sizeof(float));
+	}
+
+	// lay the columns out after the header and entries, each aligned
+	uint64 Offset = sizeof(Header) + NumColumns * sizeof(FSensorSimColumnEntry);
+	for (int32 Index = 0; Index < NumColumns; ++Index)
+	{
+		Offset = Align(Offset, Alignment);
+		Entries[Index].Offset = Offset;
+		Offset += Data[Index].Num();
+	}
+
+	TArray<uint8> File;
+	File.SetNumZeroed(static_cast<int32>(Offset));
+	FMemory::Memcpy(File.GetData(), &Header, sizeof(Header));
+	FMemory::Memcpy(File.GetData() + sizeof(Header), Entries.GetData(), NumColumns * sizeof(FSensorSimColumnEntry));
+
+	for (int32 Index = 0; Index < NumColumns; ++Index)
+	{
+		FMemory::Memcpy(File.GetData() + Entries[Index].Offset, Data[Index].GetData(), Data[Index].Num());
+	}
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+	if (!FFileHelper::SaveArrayToFile(File, *Filename))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to write sweep results '%s'"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("Wrote %d runs x %d columns to '%s'"), Runs.Num(), NumColumns, *Filename);
+	return true;
+}
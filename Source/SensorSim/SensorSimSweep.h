@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimVehicleCatalog.h"
+
+/** One vehicle parameter varied by a sweep */
+struct FSensorSimSweepParameter
+{
+	/** Vehicle catalog column, such as FrontSpringRate. Wheel fields without Front or Rear vary both axles together */
+	FString Field;
+
+	/** Bounds the parameter is drawn between, uniformly */
+	float Min = 0.0f;
+	float Max = 0.0f;
+};
+
+/**
+ *  Sweep Spec
+ *  Vehicle parameters a Monte Carlo sweep varies around a base archetype.
+ *  Every run draws its parameters from a counter-based generator keyed on the seed and the run index,
+ *  so a run gets the same vehicle whichever process, world or order it runs in.
+ *
+ *  Spec files are CSV with a Field,Min,Max header and one row per parameter, e.g.
+ *    Field,Min,Max
+ *    SpringRate,100,400
+ *    RearCorneringStiffness,500,1500
+ *    FrictionForceMultiplier,2,5
+ */
+struct SENSORSIM_API FSensorSimSweepSpec
+{
+	/** Varied parameters, in file order */
+	TArray<FSensorSimSweepParameter> Parameters;
+
+	/** Seed of the draws */
+	int32 Seed = 0;
+
+	/** Reads the parameters of a spec file. Returns false, leaving the spec unchanged, if the file is not valid */
+	bool LoadFromCSV(const FString& Filename);
+
+	/** Draws the parameters of a run into OutValues, one per parameter, and applies them to a copy of the base archetype */
+	void MakeRun(int32 Run, const FSensorSimVehicleArchetype& Base, FSensorSimVehicleArchetype& OutArchetype, TArray<float>& OutValues) const;
+
+	/** Sets a parameter on an archetype. Returns false if the field does not name one */
+	static bool SetParameter(FSensorSimVehicleArchetype& Archetype, const FString& Field, float Value);
+};
+
+/**
+ *  Columnar result file layout
+ *
+ *    FSensorSimColumnsHeader
+ *    FSensorSimColumnEntry[NumColumns]
+ *    column data, back to back, each column starting on an Alignment boundary
+ *
+ *  A column holds one value per row, little endian, of a sensor_msgs/PointField datatype: readers map
+ *  a column straight into an array, e.g. with numpy.frombuffer at its offset.
+ */
+namespace SensorSimColumns
+{
+	constexpr uint32 Magic = 0x4C4F4353;	// 'SCOL'
+	constexpr uint32 Version = 1;
+
+	/** Alignment of every column's data */
+	constexpr uint32 Alignment = 64;
+}
+
+struct FSensorSimColumnsHeader
+{
+	uint32 Magic = SensorSimColumns::Magic;
+	uint32 Version = SensorSimColumns::Version;
+	uint32 NumRows = 0;
+	uint32 NumColumns = 0;
+};
+
+struct FSensorSimColumnEntry
+{
+	/** Null terminated column name */
+	ANSICHAR Name[48] = {};
+
+	/** One of the SensorSimSharedMemory datatypes */
+	uint8 Datatype = 0;
+
+	uint8 Reserved[7] = {};
+
+	/** Byte offset of the column's data from the start of the file */
+	uint64 Offset = 0;
+};
+
+static_assert(sizeof(FSensorSimColumnEntry) == 64, "Column entry layout changed");
+
+/**
+ *  Sweep Results
+ *  One row per run, held column by column: the uint32 run index, then float columns added by name.
+ *  Values of runs that did not complete are NaN.
+ */
+class SENSORSIM_API FSensorSimSweepResults
+{
+public:
+	/** Creates the results of NumRows runs */
+	explicit FSensorSimSweepResults(int32 NumRows);
+
+	/** Adds a float column. Returns its index */
+	int32 AddColumn(const FString& Name);
+
+	/** Returns the number of rows */
+	int32 NumRows() const { return Runs.Num(); }
+
+	/** Sets the run index of a row */
+	void SetRun(int32 Row, uint32 Run) { Runs[Row] = Run; }
+
+	/** Sets a value */
+	void Set(int32 Row, int32 Column, float Value) { Columns[Column][Row] = Value; }
+
+	/** Writes the columnar result file */
+	bool Write(const FString& Filename) const;
+
+private:
+	/** Run index of every row */
+	TArray<uint32> Runs;
+
+	/** Float column names and values, indexed alike */
+	TArray<FString> Names;
+	TArray<TArray<float>> Columns;
+};
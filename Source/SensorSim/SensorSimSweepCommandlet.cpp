@@ -0,0 +1,509 @@
+#include "SensorSimSweepCommandlet.h"
+#include "SensorSim.h"
+#include "SensorSimSweep.h"
+#include "SensorSimPawn.h"
+#include "SensorSimInputTrack.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimImuComponent.h"
+#include "SensorSimRecording.h"
+#include "SensorSimScenarioSubsystem.h"
+#include "SensorSimVehicleCatalog.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "ChaosWheeledVehicleMovementComponent.h"
+#include "Components/WorldPartitionStreamingSourceComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/App.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "UObject/LinkerInstancingContext.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace SensorSimSweep
+{
+	/** Metric columns, in file order, after the parameters */
+	enum EMetric
+	{
+		Distance,
+		MeanSpeed,
+		MaxSpeed,
+		MaxLateralAcceleration,
+		MaxRoll,
+		MaxPitch,
+		MaxSlipAngle,
+		MaxSkid,
+		MinSuspensionLength,
+		AirborneFraction,
+		LidarSweeps,
+		LidarHitsPerSweep,
+		ImuSamples,
+		WallSeconds,
+		NumMetrics
+	};
+
+	const TCHAR* MetricNames[NumMetrics] =
+	{
+		TEXT("Distance"),
+		TEXT("MeanSpeed"),
+		TEXT("MaxSpeed"),
+		TEXT("MaxLateralAcceleration"),
+		TEXT("MaxRoll"),
+		TEXT("MaxPitch"),
+		TEXT("MaxSlipAngle"),
+		TEXT("MaxSkid"),
+		TEXT("MinSuspensionLength"),
+		TEXT("AirborneFraction"),
+		TEXT("LidarSweeps"),
+		TEXT("LidarHitsPerSweep"),
+		TEXT("ImuSamples"),
+		TEXT("WallSeconds"),
+	};
+
+	/** Dynamics of one run, accumulated from a state sample per step */
+	struct FRunMetrics
+	{
+		double Distance = 0.0;
+		double SpeedSum = 0.0;
+		float MaxSpeed = 0.0f;
+		float MaxLateralAcceleration = 0.0f;
+		float MaxRoll = 0.0f;
+		float MaxPitch = 0.0f;
+		float MaxSlipAngle = 0.0f;
+		float MaxSkid = 0.0f;
+		float MinSuspensionLength = 1.0f;
+		int32 NumSamples = 0;
+		int32 NumAirborne = 0;
+		FVector3d LastLocation = FVector3d::ZeroVector;
+
+		void Add(const FSensorSimVehicleStateSample& Sample)
+		{
+			if (NumSamples > 0)
+			{
+				Distance += FVector3d::Dist(Sample.Location, LastLocation);
+			}
+
+			LastLocation = Sample.Location;
+
+			const float Speed = FMath::Abs(Sample.ForwardSpeed);
+			SpeedSum += Speed;
+			MaxSpeed = FMath::Max(MaxSpeed, Speed);
+
+			// centripetal acceleration of the yaw rate at the forward speed, in m/s^2
+			const float LateralAcceleration = FMath::Abs(FMath::DegreesToRadians(Sample.AngularVelocity.Z) * Sample.ForwardSpeed) * 0.01f;
+			MaxLateralAcceleration = FMath::Max(MaxLateralAcceleration, LateralAcceleration);
+
+			const FRotator3f Rotator = Sample.Rotation.Rotator();
+			MaxRoll = FMath::Max(MaxRoll, FMath::Abs(Rotator.Roll));
+			MaxPitch = FMath::Max(MaxPitch, FMath::Abs(Rotator.Pitch));
+
+			for (int32 WheelIndex = 0; WheelIndex < Sample.NumWheels; ++WheelIndex)
+			{
+				const FSensorSimWheelStateSample& Wheel = Sample.Wheels[WheelIndex];
+				MaxSlipAngle = FMath::Max(MaxSlipAngle, FMath::Abs(Wheel.SlipAngle));
+				MaxSkid = FMath::Max(MaxSkid, Wheel.SkidMagnitude);
+				MinSuspensionLength = FMath::Min(MinSuspensionLength, Wheel.NormalizedSuspensionLength);
+			}
+
+			NumAirborne += Sample.NumWheels > 0 && Sample.WheelContactMask == 0 ? 1 : 0;
+			++NumSamples;
+		}
+	};
+
+	/** One world of the process and the run it is driving */
+	struct FSlot
+	{
+		UWorld* World = nullptr;
+
+		/** Where every run of the world starts */
+		FTransform Start;
+
+		/** Vehicle of the run in flight, null while idle */
+		ASensorSimPawn* Pawn = nullptr;
+
+		/** Result row of the run in flight */
+		int32 Row = INDEX_NONE;
+
+		/** Simulation time since the run started */
+		float Time = 0.0f;
+
+		/** Wall clock time the run started at */
+		double WallStartSeconds = 0.0;
+
+		FRunMetrics Metrics;
+	};
+}
+
+USensorSimSweepCommandlet::USensorSimSweepCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Runs a Monte Carlo sweep of headless drives over vehicle parameters and writes their metrics as columns");
+	HelpUsage = TEXT("-run=SensorSimSweep -Spec=<file.csv> [-Runs=1000] [-Seed=0] [-Base=SportsCar] [-Worlds=8] [-Seconds=10] [-Map=<package>] [-InputTrack=<file.csv>] [-Shard=0 -Shards=1] [-Output=<file.sscol>]");
+}
+
+int32 USensorSimSweepCommandlet::Main(const FString& Params)
+{
+	using namespace SensorSimSweep;
+
+	FString SpecFile;
+	int32 NumRuns = 1000;
+	FString BaseName = TEXT("SportsCar");
+	int32 Shard = 0;
+	int32 NumShards = 1;
+	FString Output;
+
+	FSensorSimSweepSpec Spec;
+	FParse::Value(*Params, TEXT("Spec="), SpecFile);
+	FParse::Value(*Params, TEXT("Runs="), NumRuns);
+	FParse::Value(*Params, TEXT("Seed="), Spec.Seed);
+	FParse::Value(*Params, TEXT("Base="), BaseName);
+	FParse::Value(*Params, TEXT("Worlds="), Worlds);
+	FParse::Value(*Params, TEXT("Seconds="), RunSeconds);
+	FParse::Value(*Params, TEXT("Map="), Map);
+	FParse::Value(*Params, TEXT("InputTrack="), InputTrack);
+	FParse::Value(*Params, TEXT("Shard="), Shard);
+	FParse::Value(*Params, TEXT("Shards="), NumShards);
+	FParse::Value(*Params, TEXT("Output="), Output);
+
+	if (SpecFile.IsEmpty() || !Spec.LoadFromCSV(SpecFile))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Usage: %s"), *HelpUsage);
+		return 1;
+	}
+
+	FSensorSimVehicleCatalog& Catalog = FSensorSimVehicleCatalog::Get();
+	const int32 BaseIndex = Catalog.FindArchetype(FName(*BaseName));
+	if (BaseIndex == INDEX_NONE)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Unknown base archetype '%s'"), *BaseName);
+		return 1;
+	}
+
+	const FSensorSimVehicleArchetype Base = Catalog.GetArchetype(BaseIndex);
+	const int32 BodyIndex = static_cast<int32>(Base.Body);
+	UClass* VehicleClass = VehicleClasses.IsValidIndex(BodyIndex) ? VehicleClasses[BodyIndex].LoadSynchronous() : nullptr;
+	if (!VehicleClass)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("No vehicle class for the body of '%s'"), *BaseName);
+		return 1;
+	}
+
+	USensorSimInputTrack* Track = nullptr;
+	if (!InputTrack.IsEmpty())
+	{
+		Track = NewObject<USensorSimInputTrack>(this);
+		if (!Track->LoadFromCSV(FPaths::IsRelative(InputTrack) ? FPaths::ProjectDir() / InputTrack : InputTrack))
+		{
+			return 1;
+		}
+	}
+
+	// this process takes every run of its shard
+	NumShards = FMath::Max(NumShards, 1);
+	FSensorSimSweepResults Results(FMath::DivideAndRoundUp(FMath::Max(NumRuns - Shard, 0), NumShards));
+	for (int32 Row = 0; Row < Results.NumRows(); ++Row)
+	{
+		Results.SetRun(Row, Row * NumShards + Shard);
+	}
+
+	for (const FSensorSimSweepParameter& Parameter : Spec.Parameters)
+	{
+		Results.AddColumn(Parameter.Field);
+	}
+
+	const int32 FirstMetric = Spec.Parameters.Num();
+	for (const TCHAR* MetricName : MetricNames)
+	{
+		Results.AddColumn(MetricName);
+	}
+
+	if (Output.IsEmpty())
+	{
+		Output = FPaths::ProjectSavedDir() / TEXT("Sweeps") / (NumShards > 1 ? FString::Printf(TEXT("Sweep_%d.sscol"), Shard) : FString(TEXT("Sweep.sscol")));
+	}
+
+	// step every world at a fixed delta and never wait on the wall clock
+	const float DeltaTime = FMath::Max(FixedDeltaTime, 0.001f);
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(DeltaTime);
+
+	const FString MapPackage = FPackageName::ObjectPathToPackageName(Map);
+	TArray<FSlot> Slots;
+	Slots.SetNum(FMath::Clamp(Worlds, 1, FMath::Max(Results.NumRows(), 1)));
+
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		FSlot& Slot = Slots[SlotIndex];
+		Slot.World = CreateWorld(MapPackage, SlotIndex);
+		if (!Slot.World)
+		{
+			for (const FSlot& CreatedSlot : Slots)
+			{
+				DestroyWorld(CreatedSlot.World);
+			}
+			return 1;
+		}
+
+		TActorIterator<APlayerStart> PlayerStart(Slot.World);
+		Slot.Start = PlayerStart ? PlayerStart->GetActorTransform() : FTransform(FVector(0.0, 0.0, 100.0));
+		Slot.Start.SetScale3D(FVector::OneVector);
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("Sweeping %d runs of shard %d/%d over %d parameters of %s, %.1fs each, in %d worlds"),
+		Results.NumRows(), Shard, NumShards, Spec.Parameters.Num(), *BaseName, RunSeconds, Slots.Num());
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	int32 NextRow = 0;
+	int32 NumCompleted = 0;
+	int32 NumFailed = 0;
+	int32 NumSinceCollection = 0;
+
+	FSensorSimVehicleArchetype Archetype;
+	TArray<float> Values;
+	FSensorSimVehicleStateSample Sample;
+
+	while (NumCompleted + NumFailed < Results.NumRows() && !IsEngineExitRequested())
+	{
+		// idle worlds take the next runs
+		for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+		{
+			FSlot& Slot = Slots[SlotIndex];
+			if (Slot.Pawn || NextRow >= Results.NumRows())
+			{
+				continue;
+			}
+
+			const int32 Row = NextRow++;
+			Spec.MakeRun(Row * NumShards + Shard, Base, Archetype, Values);
+			for (int32 Index = 0; Index < Values.Num(); ++Index)
+			{
+				Results.Set(Row, Index, Values[Index]);
+			}
+
+			// a run that cannot be reset afterwards would leave its vehicle's traces in the next run of the world
+			if (!Slot.World->GetSubsystem<USensorSimScenarioSubsystem>())
+			{
+				UE_LOG(LogSensorSim, Warning, TEXT("Run %u: no scenario subsystem in world %d"), Row * NumShards + Shard, SlotIndex);
+				++NumFailed;
+				continue;
+			}
+
+			// one catalog entry per world, replaced by every run, so that the catalog does not grow with the sweep
+			const int32 ArchetypeIndex = Catalog.AddArchetype(FName(TEXT("Sweep"), SlotIndex + 1), Archetype);
+
+			// deferred, so that the archetype is in place before BeginPlay; the Chaos vehicle, created on registration, is rebuilt from it
+			ASensorSimPawn* Pawn = Slot.World->SpawnActorDeferred<ASensorSimPawn>(VehicleClass, Slot.Start, nullptr, nullptr,
+				ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (!Pawn)
+			{
+				UE_LOG(LogSensorSim, Warning, TEXT("Run %u: failed to spawn %s"), Row * NumShards + Shard, *GetNameSafe(VehicleClass));
+				++NumFailed;
+				continue;
+			}
+
+			Pawn->SetArchetype(ArchetypeIndex);
+			Pawn->FinishSpawning(Slot.Start);
+
+			// a run whose drawn values never reached the simulation would only measure the base vehicle
+			if (!Pawn->GetSensorSimMovement()->IsSimulatingArchetype(Archetype))
+			{
+				UE_LOG(LogSensorSim, Warning, TEXT("Run %u: the Chaos vehicle was not set up from the drawn archetype"), Row * NumShards + Shard);
+				Pawn->Destroy();
+				++NumFailed;
+				continue;
+			}
+
+			// sweep vehicles are driven without a controller, and stream in a world partition map around them
+			Pawn->GetChaosVehicleMovement()->bRequiresControllerForInputs = false;
+			UWorldPartitionStreamingSourceComponent* StreamingSource = NewObject<UWorldPartitionStreamingSourceComponent>(Pawn);
+			StreamingSource->RegisterComponent();
+
+			Slot.Pawn = Pawn;
+			Slot.Row = Row;
+			Slot.Time = 0.0f;
+			Slot.WallStartSeconds = FPlatformTime::Seconds();
+			Slot.Metrics = FRunMetrics();
+		}
+
+		// step the worlds in turn; each one's physics and sensor tasks overlap with the next one's game thread work
+		for (FSlot& Slot : Slots)
+		{
+			if (!Slot.Pawn)
+			{
+				continue;
+			}
+
+			if (Track)
+			{
+				Slot.Pawn->ApplyVehicleInput(Track->Evaluate(Slot.Time));
+			}
+
+			Slot.World->Tick(LEVELTICK_All, DeltaTime);
+		}
+
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+		FTSTicker::GetCoreTicker().Tick(DeltaTime);
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		++GFrameCounter;
+
+		for (FSlot& Slot : Slots)
+		{
+			if (!Slot.Pawn)
+			{
+				continue;
+			}
+
+			Slot.Pawn->SampleState(Slot.World->GetTimeSeconds(), Sample);
+			Slot.Metrics.Add(Sample);
+			Slot.Time += DeltaTime;
+
+			if (Slot.Time < RunSeconds)
+			{
+				continue;
+			}
+
+			const FRunMetrics& Metrics = Slot.Metrics;
+			const FSensorSimSensorCounters& LidarCounters = Slot.Pawn->GetLidarScanner()->GetCounters();
+			const int32 Row = Slot.Row;
+
+			Results.Set(Row, FirstMetric + Distance, float(Metrics.Distance));
+			Results.Set(Row, FirstMetric + MeanSpeed, Metrics.NumSamples > 0 ? float(Metrics.SpeedSum / Metrics.NumSamples) : 0.0f);
+			Results.Set(Row, FirstMetric + MaxSpeed, Metrics.MaxSpeed);
+			Results.Set(Row, FirstMetric + MaxLateralAcceleration, Metrics.MaxLateralAcceleration);
+			Results.Set(Row, FirstMetric + MaxRoll, Metrics.MaxRoll);
+			Results.Set(Row, FirstMetric + MaxPitch, Metrics.MaxPitch);
+			Results.Set(Row, FirstMetric + MaxSlipAngle, Metrics.MaxSlipAngle);
+			Results.Set(Row, FirstMetric + MaxSkid, Metrics.MaxSkid);
+			Results.Set(Row, FirstMetric + MinSuspensionLength, Metrics.MinSuspensionLength);
+			Results.Set(Row, FirstMetric + AirborneFraction, Metrics.NumSamples > 0 ? float(Metrics.NumAirborne) / Metrics.NumSamples : 0.0f);
+			Results.Set(Row, FirstMetric + LidarSweeps, float(LidarCounters.Samples));
+			Results.Set(Row, FirstMetric + LidarHitsPerSweep, LidarCounters.Samples > 0 ? float(double(LidarCounters.Hits) / LidarCounters.Samples) : 0.0f);
+			Results.Set(Row, FirstMetric + ImuSamples, float(Slot.Pawn->GetImu()->GetCounters().Samples));
+			Results.Set(Row, FirstMetric + WallSeconds, float(FPlatformTime::Seconds() - Slot.WallStartSeconds));
+
+			// the next run starts from the level as it was loaded
+			Slot.Pawn->Destroy();
+			Slot.Pawn = nullptr;
+			if (USensorSimScenarioSubsystem* Scenario = Slot.World->GetSubsystem<USensorSimScenarioSubsystem>())
+			{
+				Scenario->ResetScenario();
+			}
+
+			++NumCompleted;
+			++NumSinceCollection;
+
+			if (NumCompleted % 100 == 0)
+			{
+				const double Elapsed = FPlatformTime::Seconds() - StartSeconds;
+				UE_LOG(LogSensorSim, Display, TEXT("Sweep: %d/%d runs in %.1fs (%.2f runs/s)"), NumCompleted, Results.NumRows(), Elapsed, NumCompleted / Elapsed);
+			}
+		}
+
+		// destroyed vehicles are only freed by a collection
+		if (NumSinceCollection >= GarbageCollectionInterval)
+		{
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			NumSinceCollection = 0;
+		}
+	}
+
+	for (FSlot& Slot : Slots)
+	{
+		DestroyWorld(Slot.World);
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	const double Elapsed = FPlatformTime::Seconds() - StartSeconds;
+	UE_LOG(LogSensorSim, Display, TEXT("Sweep complete: %d runs, %d failed, %.1fs (%.2f runs/s, %.1f sim s / wall s)"),
+		NumCompleted, NumFailed, Elapsed, NumCompleted / FMath::Max(Elapsed, UE_SMALL_NUMBER), NumCompleted * RunSeconds / FMath::Max(Elapsed, UE_SMALL_NUMBER));
+
+	if (!Results.Write(Output))
+	{
+		return 1;
+	}
+
+	return NumCompleted == Results.NumRows() ? 0 : 1;
+}
+
+UWorld* USensorSimSweepCommandlet::CreateWorld(const FString& MapPackage, int32 Slot) const
+{
+	// every world loads its own instance of the map package, so that worlds share no actor, body or subsystem
+	const FString InstanceName = FString::Printf(TEXT("/Temp/SensorSimSweep%d/%s"), Slot, *FPackageName::GetShortName(MapPackage));
+
+	FLinkerInstancingContext InstancingContext;
+	InstancingContext.AddPackageMapping(FName(*MapPackage), FName(*InstanceName));
+
+	UPackage* Package = CreatePackage(*InstanceName);
+	Package = LoadPackage(Package, *MapPackage, LOAD_None, nullptr, &InstancingContext);
+
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to load map '%s'"), *MapPackage);
+		return nullptr;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	FWorldContext& Context = GEngine->CreateNewWorldContext(EWorldType::Game);
+	Context.SetCurrentWorld(World);
+
+	World->InitWorld(UWorld::InitializationValues()
+		.AllowAudioPlayback(false)
+		.RequiresHitProxies(false)
+		.CreateFXSystem(false)
+		.ShouldSimulatePhysics(true)
+		.EnableTraceCollision(true)
+		.SetTransactional(false));
+
+	World->UpdateWorldComponents(true, false);
+	World->InitializeActorsForPlay(FURL());
+
+	// without a game mode, the world settings start play themselves
+	World->BeginPlay();
+	World->GetWorldSettings()->NotifyBeginPlay();
+	World->GetWorldSettings()->NotifyMatchStarted();
+
+	// bodies settle for a step before the scenario snapshot every run is reset to
+	World->Tick(LEVELTICK_All, FApp::GetFixedDeltaTime());
+
+	// every run is reset to the snapshot, a world that cannot take one cannot run a sweep
+	USensorSimScenarioSubsystem* Scenario = World->GetSubsystem<USensorSimScenarioSubsystem>();
+	if (!Scenario)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("No scenario subsystem in '%s'"), *MapPackage);
+		DestroyWorld(World);
+		return nullptr;
+	}
+	Scenario->CaptureSnapshot();
+
+	return World;
+}
+
+void USensorSimSweepCommandlet::DestroyWorld(UWorld* World) const
+{
+	if (!World)
+	{
+		return;
+	}
+
+	for (FActorIterator It(World); It; ++It)
+	{
+		It->RouteEndPlay(EEndPlayReason::Quit);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+}
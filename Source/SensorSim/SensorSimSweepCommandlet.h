@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SensorSimSweepCommandlet.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+
+/**
+ *  Sweep Commandlet
+ *  Runs a Monte Carlo sweep of short headless drives over vehicle parameters, such as spring rates, cornering stiffness
+ *  and tire friction, and writes every run's parameters and sensor and dynamics metrics into one columnar result file.
+ *
+ *  Each run spawns a vehicle from the base archetype with its drawn parameters, drives it from the input track for
+ *  RunSeconds at a fixed time step, then removes it and resets the scenario. Several runs are in flight at once, each
+ *  in its own world loaded from its own instance of the map, so that runs never see each other and engine startup and
+ *  map loading are paid once per world rather than once per run. The worlds are stepped in turn; their physics,
+ *  sweeps and sensor tasks overlap on the task graph. Shards split the runs between processes.
+ *
+ *  Metrics, per run: Distance (cm), MeanSpeed and MaxSpeed (cm/s), MaxLateralAcceleration (m/s^2), MaxRoll and MaxPitch
+ *  (degrees), MaxSlipAngle (degrees), MaxSkid, MinSuspensionLength (0 compressed to 1 extended), AirborneFraction,
+ *  LidarSweeps, LidarHitsPerSweep, ImuSamples and WallSeconds.
+ *
+ *  Usage:
+ *    UnrealEditor-Cmd SensorSim.uproject -run=SensorSimSweep -Spec=<file.csv> [-Runs=1000] [-Seed=0] [-Base=SportsCar]
+ *      [-Worlds=8] [-Seconds=10] [-Map=<package>] [-InputTrack=<file.csv>] [-Shard=0 -Shards=1] [-Output=<file.sscol>] -nullrhi
+ *
+ *  Returns non-zero if the spec or map could not be loaded, or any run did not complete.
+ */
+UCLASS(Config = Game)
+class USensorSimSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimSweepCommandlet();
+
+protected:
+	/** Map the runs drive on */
+	UPROPERTY(Config)
+	FString Map;
+
+	/** Vehicle class of every archetype body, indexed by ESensorSimVehicleBody */
+	UPROPERTY(Config)
+	TArray<TSoftClassPtr<ASensorSimPawn>> VehicleClasses;
+
+	/** Input track CSV the vehicles are driven from, relative to the project directory */
+	UPROPERTY(Config)
+	FString InputTrack;
+
+	/** Worlds loaded per process, each running one run at a time */
+	UPROPERTY(Config)
+	int32 Worlds{ 8 };
+
+	/** Simulation time of one run, in seconds */
+	UPROPERTY(Config)
+	float RunSeconds{ 10.0f };
+
+	/** Fixed simulation step, in seconds */
+	UPROPERTY(Config)
+	float FixedDeltaTime{ 1.0f / 60.0f };
+
+	/** Runs between garbage collections */
+	UPROPERTY(Config)
+	int32 GarbageCollectionInterval{ 64 };
+
+public:
+	// Begin Commandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End Commandlet interface
+
+protected:
+	/** Loads an instance of the map into a world of its own and begins play. Returns null if the map could not be loaded */
+	UWorld* CreateWorld(const FString& MapPackage, int32 Slot) const;
+
+	/** Ends play and destroys a world created by CreateWorld */
+	void DestroyWorld(UWorld* World) const;
+};
@@ -0,0 +1,871 @@
+#include "SensorSimTelemetryServer.h"
+#include "SensorSim.h"
+#include "SensorSimPointCloud.h"
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/RunnableThread.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/Base64.h"
+#include "Misc/SecureHash.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace SensorSimTelemetry
+{
+	/** Seconds the server thread sleeps when there is nothing to send */
+	constexpr float PollInterval = 0.005f;
+
+	/** Largest HTTP request or client WebSocket frame accepted, in bytes */
+	constexpr int32 MaxRequestSize = 16 * 1024;
+
+	/** Appended to Sec-WebSocket-Key before hashing, RFC 6455 */
+	constexpr const TCHAR* WebSocketGuid = TEXT("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+
+	/** WebSocket opcodes */
+	constexpr uint8 OpBinary = 0x2;
+	constexpr uint8 OpClose = 0x8;
+	constexpr uint8 OpPing = 0x9;
+	constexpr uint8 OpPong = 0xA;
+
+	/** Dashboard page: draws the point cloud of one vehicle from above, and lists vehicles and sensors */
+	static const ANSICHAR DashboardHtml[] = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>SensorSim telemetry</title>
+<style>
+body{font:13px monospace;background:#111;color:#ddd;margin:0;display:flex}
+#view{flex:1}canvas{background:#000;display:block}
+#side{width:560px;padding:8px;overflow:auto;height:100vh;box-sizing:border-box}
+table{border-collapse:collapse;width:100%;margin-bottom:12px}td,th{padding:1px 6px;text-align:right}
+th{color:#8cf}tr.sel{background:#234}
+</style></head><body>
+<div id="view"><canvas id="cloud"></canvas></div>
+<div id="side"><div id="status">connecting</div>
+<table id="vehicles"></table><table id="sensors"></table></div>
+<script>
+const canvas=document.getElementById('cloud'),ctx=canvas.getContext('2d');
+let stream=0,range=60;
+function resize(){canvas.width=canvas.parentElement.clientWidth;canvas.height=window.innerHeight;}
+window.onresize=resize;resize();
+canvas.onwheel=e=>{range=Math.max(5,range*(e.deltaY>0?1.2:1/1.2));e.preventDefault();};
+function zigzag(v){return (v>>>1)^-(v&1);}
+function drawCloud(dv,off,count){
+  const scale=dv.getFloat32(off+28,true),n=dv.getUint32(off+32,true);
+  const img=ctx.createImageData(canvas.width,canvas.height),px=img.data;
+  const s=Math.min(canvas.width,canvas.height)/(2*range),cx=canvas.width/2,cy=canvas.height/2;
+  let p=off+40,x=0,y=0,z=0;
+  function varint(){let r=0,sh=0,b;do{b=dv.getUint8(p++);r|=(b&127)<<sh;sh+=7;}while(b&128);return zigzag(r);}
+  for(let i=0;i<n;i++){
+    x+=varint();y+=varint();z+=varint();const it=dv.getUint8(p++);
+    const u=Math.round(cx+y*scale*s),v=Math.round(cy-x*scale*s);
+    if(u<0||v<0||u>=canvas.width||v>=canvas.height)continue;
+    const k=(v*canvas.width+u)*4,h=Math.min(1,Math.max(0,(z*scale+2)/6));
+    px[k]=255*h;px[k+1]=128+127*(it/255);px[k+2]=255*(1-h);px[k+3]=255;
+  }
+  ctx.putImageData(img,0,0);
+}
+function row(cells,tag){return '<tr>'+cells.map(c=>'<'+(tag||'td')+'>'+c+'</'+(tag||'td')+'>').join('')+'</tr>';}
+function connect(){
+  const ws=new WebSocket('ws://'+location.host+'/ws');ws.binaryType='arraybuffer';
+  ws.onopen=()=>document.getElementById('status').textContent='connected';
+  ws.onclose=()=>{document.getElementById('status').textContent='disconnected, retrying';setTimeout(connect,1000);};
+  ws.onmessage=e=>{
+    const dv=new DataView(e.data),type=dv.getUint8(0),count=dv.getUint16(2,true),time=dv.getFloat64(8,true);
+    if(type==1&&count==stream){drawCloud(dv,16,count);}
+    else if(type==2){
+      let h=row(['stream','x m','y m','yaw','km/h','gear','rpm','steer','thr','brk'],'th');
+      for(let i=0,o=16;i<count;i++,o+=40){
+        const st=dv.getUint16(o,true),f=k=>dv.getFloat32(o+4+k*4,true);
+        h+=row([st,f(0).toFixed(1),f(1).toFixed(1),f(3).toFixed(0),f(4).toFixed(0),dv.getInt8(o+2),f(5).toFixed(0),f(6).toFixed(2),f(7).toFixed(2),f(8).toFixed(2)])
+          .replace('<tr>','<tr onclick="stream='+st+'"'+(st==stream?' class="sel"':'')+'>');
+      }
+      document.getElementById('vehicles').innerHTML=h;
+      document.getElementById('status').textContent='t='+time.toFixed(2)+'s, watching stream '+stream+' (click a vehicle, scroll to zoom)';
+    }
+    else if(type==3){
+      const kinds=['other','lidar','imu','wheels'];
+      let h=row(['clients '+dv.getUint32(16,true),'dropped msgs '+dv.getUint32(20,true),'skipped clouds '+dv.getUint32(24,true)],'th');
+      h+=row(['stream','sensor','Hz','target','skipped','samples'],'th');
+      for(let i=0,o=32;i<count;i++,o+=20){
+        h+=row([dv.getUint16(o,true),kinds[dv.getUint8(o+2)]||'?',dv.getFloat32(o+4,true).toFixed(1),dv.getFloat32(o+8,true).toFixed(1),dv.getUint32(o+12,true),dv.getUint32(o+16,true)]);
+      }
+      document.getElementById('sensors').innerHTML=h;
+    }
+  };
+}
+connect();
+</script></body></html>
+)HTML";
+
+	void Append(TArray<uint8>& Buffer, const void* Data, int32 Size)
+	{
+		Buffer.Append(static_cast<const uint8*>(Data), Size);
+	}
+
+	void AppendString(TArray<uint8>& Buffer, const FString& String)
+	{
+		const FTCHARToUTF8 Utf8(*String);
+		Append(Buffer, Utf8.Get(), Utf8.Length());
+	}
+
+	/** Appends an unmasked WebSocket frame header for a payload of the given size */
+	void AppendFrameHeader(TArray<uint8>& Buffer, uint8 Opcode, uint64 Size)
+	{
+		Buffer.Add(0x80 | Opcode);
+
+		if (Size < 126)
+		{
+			Buffer.Add(static_cast<uint8>(Size));
+		}
+		else if (Size <= MAX_uint16)
+		{
+			Buffer.Add(126);
+			Buffer.Add(static_cast<uint8>(Size >> 8));
+			Buffer.Add(static_cast<uint8>(Size));
+		}
+		else
+		{
+			Buffer.Add(127);
+			for (int32 Shift = 56; Shift >= 0; Shift -= 8)
+			{
+				Buffer.Add(static_cast<uint8>(Size >> Shift));
+			}
+		}
+	}
+
+	void AppendVarint(TArray<uint8>& Buffer, int32 Value)
+	{
+		// zigzag, so that small negative deltas stay small
+		uint32 Encoded = (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+		while (Encoded >= 0x80)
+		{
+			Buffer.Add(static_cast<uint8>(Encoded | 0x80));
+			Encoded >>= 7;
+		}
+		Buffer.Add(static_cast<uint8>(Encoded));
+	}
+
+	bool ReadVarint(TConstArrayView<uint8> Buffer, int32& Offset, int32& OutValue)
+	{
+		uint32 Encoded = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			if (Offset >= Buffer.Num())
+			{
+				return false;
+			}
+
+			const uint8 Byte = Buffer[Offset++];
+			Encoded |= static_cast<uint32>(Byte & 0x7F) << Shift;
+			if (!(Byte & 0x80))
+			{
+				OutValue = static_cast<int32>(Encoded >> 1) ^ -static_cast<int32>(Encoded & 1);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/** Returns the value of an HTTP header, or an empty string */
+	FString FindHeader(const FString& Request, const TCHAR* Name)
+	{
+		TArray<FString> Lines;
+		Request.ParseIntoArrayLines(Lines);
+
+		for (const FString& Line : Lines)
+		{
+			FString Key, Value;
+			if (Line.Split(TEXT(":"), &Key, &Value) && Key.TrimStartAndEnd().Equals(Name, ESearchCase::IgnoreCase))
+			{
+				return Value.TrimStartAndEnd();
+			}
+		}
+
+		return FString();
+	}
+
+	/** Returns the index just past the end of the HTTP headers, or INDEX_NONE if they are not complete */
+	int32 FindHeadersEnd(TConstArrayView<uint8> Buffer)
+	{
+		for (int32 Index = 3; Index < Buffer.Num(); ++Index)
+		{
+			if (Buffer[Index - 3] == '\r' && Buffer[Index - 2] == '\n' && Buffer[Index - 1] == '\r' && Buffer[Index] == '\n')
+			{
+				return Index + 1;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+}
+
+void SensorSimTelemetry::EncodePointCloud(const FSensorSimPointCloudFrame& Frame, uint16 Stream, uint32 Sequence, int32 MaxPoints, float Scale, TArray<uint8>& OutMessage)
+{
+	SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimTelemetry);
+
+	const int32 NumSource = Frame.Num();
+	const int32 Stride = FMath::Max(1, FMath::DivideAndRoundUp(NumSource, FMath::Max(MaxPoints, 1)));
+	const int32 NumPoints = NumSource > 0 ? (NumSource - 1) / Stride + 1 : 0;
+
+	FSensorSimTelemetryHeader Header;
+	Header.Type = ESensorSimTelemetryType::PointCloud;
+	Header.Count = Stream;
+	Header.Sequence = Sequence;
+	Header.Time = Frame.SweepTime;
+
+	FSensorSimTelemetryCloud Cloud;
+	const FVector Location = Frame.SensorTransform.GetLocation() * 0.01;
+	const FQuat Rotation = Frame.SensorTransform.GetRotation();
+	Cloud.Location[0] = static_cast<float>(Location.X);
+	Cloud.Location[1] = static_cast<float>(Location.Y);
+	Cloud.Location[2] = static_cast<float>(Location.Z);
+	Cloud.Rotation[0] = static_cast<float>(Rotation.X);
+	Cloud.Rotation[1] = static_cast<float>(Rotation.Y);
+	Cloud.Rotation[2] = static_cast<float>(Rotation.Z);
+	Cloud.Rotation[3] = static_cast<float>(Rotation.W);
+	Cloud.Scale = Scale;
+	Cloud.NumPoints = NumPoints;
+	Cloud.SourcePoints = NumSource;
+
+	// at most 5 bytes per coordinate, typically 1 or 2 since rays are fired in order
+	OutMessage.Reset(sizeof(Header) + sizeof(Cloud) + NumPoints * 8);
+	Append(OutMessage, &Header, sizeof(Header));
+	Append(OutMessage, &Cloud, sizeof(Cloud));
+
+	// frames are in cm
+	const float UnitsPerCm = 0.01f / Scale;
+	int32 Previous[3] = {};
+
+	for (int32 Index = 0; Index < NumSource; Index += Stride)
+	{
+		const int32 Quantized[3] =
+		{
+			FMath::RoundToInt32(Frame.X[Index] * UnitsPerCm),
+			FMath::RoundToInt32(Frame.Y[Index] * UnitsPerCm),
+			FMath::RoundToInt32(Frame.Z[Index] * UnitsPerCm),
+		};
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			AppendVarint(OutMessage, Quantized[Axis] - Previous[Axis]);
+			Previous[Axis] = Quantized[Axis];
+		}
+
+		OutMessage.Add(static_cast<uint8>(FMath::Clamp(Frame.Intensity[Index], 0.0f, 1.0f) * 255.0f + 0.5f));
+	}
+}
+
+bool SensorSimTelemetry::DecodePointCloud(TConstArrayView<uint8> Message, FSensorSimTelemetryCloud& OutCloud, TArray<FVector3f>& OutPoints, TArray<uint8>& OutIntensities)
+{
+	FSensorSimTelemetryHeader Header;
+	if (!ReadHeader(Message, Header) || Header.Type != ESensorSimTelemetryType::PointCloud || Message.Num() < int32(sizeof(Header) + sizeof(OutCloud)))
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&OutCloud, Message.GetData() + sizeof(Header), sizeof(OutCloud));
+	if (!(OutCloud.Scale > 0.0f) || OutCloud.NumPoints > OutCloud.SourcePoints)
+	{
+		return false;
+	}
+
+	OutPoints.Reset(OutCloud.NumPoints);
+	OutIntensities.Reset(OutCloud.NumPoints);
+
+	int32 Offset = sizeof(Header) + sizeof(OutCloud);
+	int32 Position[3] = {};
+
+	for (uint32 Index = 0; Index < OutCloud.NumPoints; ++Index)
+	{
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			int32 Delta = 0;
+			if (!ReadVarint(Message, Offset, Delta))
+			{
+				return false;
+			}
+			Position[Axis] += Delta;
+		}
+
+		if (Offset >= Message.Num())
+		{
+			return false;
+		}
+
+		OutPoints.Emplace(Position[0] * OutCloud.Scale, Position[1] * OutCloud.Scale, Position[2] * OutCloud.Scale);
+		OutIntensities.Add(Message[Offset++]);
+	}
+
+	// nothing may trail the last point
+	return Offset == Message.Num();
+}
+
+bool SensorSimTelemetry::ReadHeader(TConstArrayView<uint8> Message, FSensorSimTelemetryHeader& OutHeader)
+{
+	if (Message.Num() < int32(sizeof(OutHeader)))
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&OutHeader, Message.GetData(), sizeof(OutHeader));
+	return OutHeader.Version == Version;
+}
+
+FString SensorSimTelemetry::ComputeAcceptKey(const FString& Key)
+{
+	const FTCHARToUTF8 Utf8(*(Key + WebSocketGuid));
+
+	uint8 Hash[FSHA1::DigestSize];
+	FSHA1::HashBuffer(Utf8.Get(), Utf8.Length(), Hash);
+
+	return FBase64::Encode(Hash, FSHA1::DigestSize);
+}
+
+FSensorSimTelemetryServer::FSensorSimTelemetryServer()
+{
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FSensorSimTelemetryServer::~FSensorSimTelemetryServer()
+{
+	Shutdown();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+bool FSensorSimTelemetryServer::Start(uint16 InPort, int32 InMaxClientBacklog)
+{
+	check(!IsRunning());
+
+	// loopback only: the dashboard is for the operator station the simulation runs on
+	Listener = FTcpSocketBuilder(TEXT("SensorSimTelemetry"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address(127, 0, 0, 1), InPort))
+		.Listening(8)
+		.Build();
+
+	if (!Listener)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to listen on 127.0.0.1:%d for telemetry"), InPort);
+		return false;
+	}
+
+	Port = InPort;
+	MaxClientBacklog = InMaxClientBacklog;
+	bStopRequested = false;
+	DroppedMessages = 0;
+	BytesSent = 0;
+
+	Thread = FRunnableThread::Create(this, TEXT("SensorSimTelemetryServer"), 0, TPri_BelowNormal);
+	bRunning.store(true, std::memory_order_release);
+
+	UE_LOG(LogSensorSim, Display, TEXT("Telemetry dashboard on http://127.0.0.1:%d/"), Port);
+	return true;
+}
+
+void FSensorSimTelemetryServer::Shutdown()
+{
+	// producers stop queueing before the thread goes away
+	if (!bRunning.exchange(false, std::memory_order_acq_rel))
+	{
+		return;
+	}
+
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FSensorSimTelemetryMessage Message = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>();
+	while (Queue.Dequeue(Message))
+	{
+	}
+}
+
+void FSensorSimTelemetryServer::Broadcast(const FSensorSimTelemetryMessage& Message)
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	Queue.Enqueue(Message);
+	WorkEvent->Trigger();
+}
+
+uint32 FSensorSimTelemetryServer::Run()
+{
+	while (!bStopRequested.load())
+	{
+		WorkEvent->Wait(FTimespan::FromSeconds(SensorSimTelemetry::PollInterval));
+
+		AcceptConnections();
+		DrainQueue();
+
+		for (int32 Index = Connections.Num() - 1; Index >= 0; --Index)
+		{
+			if (!ReadConnection(Connections[Index]) || !FlushConnection(Connections[Index]))
+			{
+				CloseConnection(Index);
+			}
+		}
+	}
+
+	while (!Connections.IsEmpty())
+	{
+		CloseConnection(Connections.Num() - 1);
+	}
+
+	Listener->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+	Listener = nullptr;
+
+	return 0;
+}
+
+void FSensorSimTelemetryServer::Stop()
+{
+	bStopRequested = true;
+	WorkEvent->Trigger();
+}
+
+void FSensorSimTelemetryServer::AcceptConnections()
+{
+	bool bPending = false;
+	while (Listener->HasPendingConnection(bPending) && bPending)
+	{
+		FSocket* Socket = Listener->Accept(TEXT("SensorSimTelemetryClient"));
+		if (!Socket)
+		{
+			return;
+		}
+
+		Socket->SetNonBlocking(true);
+		Socket->SetNoDelay(true);
+
+		FConnection& Connection = Connections.AddDefaulted_GetRef();
+		Connection.Socket = Socket;
+	}
+}
+
+bool FSensorSimTelemetryServer::ReadConnection(FConnection& Connection)
+{
+	uint8 Buffer[4096];
+	int32 BytesRead = 0;
+
+	// a graceful close reads as a failure
+	do
+	{
+		if (!Connection.Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+		{
+			return false;
+		}
+
+		Connection.Received.Append(Buffer, BytesRead);
+	}
+	while (BytesRead == sizeof(Buffer));
+
+	if (Connection.Received.Num() > SensorSimTelemetry::MaxRequestSize)
+	{
+		return false;
+	}
+
+	if (Connection.bWebSocket)
+	{
+		HandleFrames(Connection);
+		return true;
+	}
+
+	const int32 HeadersEnd = SensorSimTelemetry::FindHeadersEnd(Connection.Received);
+	if (HeadersEnd != INDEX_NONE && !Connection.bClosing)
+	{
+		const FString Request(HeadersEnd, reinterpret_cast<const ANSICHAR*>(Connection.Received.GetData()));
+		Connection.Received.RemoveAt(0, HeadersEnd);
+
+		HandleRequest(Connection, Request);
+	}
+
+	return true;
+}
+
+void FSensorSimTelemetryServer::HandleRequest(FConnection& Connection, const FString& Request)
+{
+	using namespace SensorSimTelemetry;
+
+	TArray<FString> RequestLine;
+	Request.Left(Request.Find(TEXT("\r\n"))).ParseIntoArrayWS(RequestLine);
+
+	const FString Path = RequestLine.Num() >= 2 ? RequestLine[1] : FString();
+	const FString Key = FindHeader(Request, TEXT("Sec-WebSocket-Key"));
+
+	if (RequestLine.Num() < 2 || RequestLine[0] != TEXT("GET"))
+	{
+		AppendString(Connection.Pending, TEXT("HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"));
+		Connection.bClosing = true;
+	}
+	else if (Path == ANSI_TO_TCHAR(WebSocketPath) && FindHeader(Request, TEXT("Upgrade")).Equals(TEXT("websocket"), ESearchCase::IgnoreCase) && !Key.IsEmpty())
+	{
+		AppendString(Connection.Pending, FString::Printf(
+			TEXT("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n"), *ComputeAcceptKey(Key)));
+
+		Connection.bWebSocket = true;
+		NumClients.fetch_add(1, std::memory_order_relaxed);
+	}
+	else if (Path == TEXT("/") || Path == TEXT("/index.html"))
+	{
+		const int32 PageSize = UE_ARRAY_COUNT(DashboardHtml) - 1;
+		AppendString(Connection.Pending, FString::Printf(
+			TEXT("HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: %d\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n"), PageSize));
+		Append(Connection.Pending, DashboardHtml, PageSize);
+		Connection.bClosing = true;
+	}
+	else
+	{
+		AppendString(Connection.Pending, TEXT("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"));
+		Connection.bClosing = true;
+	}
+}
+
+void FSensorSimTelemetryServer::HandleFrames(FConnection& Connection)
+{
+	using namespace SensorSimTelemetry;
+
+	TArray<uint8>& Received = Connection.Received;
+
+	while (Received.Num() >= 2 && !Connection.bClosing)
+	{
+		const uint8 Opcode = Received[0] & 0x0F;
+		const bool bMasked = (Received[1] & 0x80) != 0;
+		uint64 Size = Received[1] & 0x7F;
+		int32 Offset = 2;
+
+		if (Size == 126 || Size == 127)
+		{
+			const int32 NumBytes = Size == 126 ? 2 : 8;
+			if (Received.Num() < Offset + NumBytes)
+			{
+				return;
+			}
+
+			Size = 0;
+			for (int32 Index = 0; Index < NumBytes; ++Index)
+			{
+				Size = (Size << 8) | Received[Offset++];
+			}
+		}
+
+		// clients always mask their frames, and only send small control frames here
+		if (!bMasked || Size > MaxRequestSize)
+		{
+			Connection.bClosing = true;
+			return;
+		}
+
+		if (Received.Num() < Offset + 4 + int32(Size))
+		{
+			return;
+		}
+
+		const uint8* Mask = &Received[Offset];
+		uint8* Payload = &Received[Offset + 4];
+		for (uint64 Index = 0; Index < Size; ++Index)
+		{
+			Payload[Index] ^= Mask[Index % 4];
+		}
+
+		if (Opcode == OpPing)
+		{
+			AppendFrameHeader(Connection.Pending, OpPong, Size);
+			Append(Connection.Pending, Payload, int32(Size));
+		}
+		else if (Opcode == OpClose)
+		{
+			AppendFrameHeader(Connection.Pending, OpClose, 0);
+			Connection.bClosing = true;
+		}
+
+		Received.RemoveAt(0, Offset + 4 + int32(Size));
+	}
+}
+
+bool FSensorSimTelemetryServer::FlushConnection(FConnection& Connection)
+{
+	if (Connection.GetPendingBytes() == 0)
+	{
+		return !Connection.bClosing;
+	}
+
+	int32 Sent = 0;
+	if (!Connection.Socket->Send(Connection.Pending.GetData() + Connection.PendingOffset, Connection.GetPendingBytes(), Sent))
+	{
+		// a full send buffer is not an error
+		if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+		{
+			return false;
+		}
+		Sent = 0;
+	}
+
+	if (Sent > 0)
+	{
+		Connection.PendingOffset += Sent;
+		BytesSent.fetch_add(Sent, std::memory_order_relaxed);
+	}
+
+	// drop what has been sent once it is the bulk of the buffer
+	if (Connection.PendingOffset == Connection.Pending.Num())
+	{
+		Connection.Pending.Reset();
+		Connection.PendingOffset = 0;
+	}
+	else if (Connection.PendingOffset >= Connection.Pending.Num() / 2)
+	{
+		Connection.Pending.RemoveAt(0, Connection.PendingOffset, EAllowShrinking::No);
+		Connection.PendingOffset = 0;
+	}
+
+	return true;
+}
+
+void FSensorSimTelemetryServer::DrainQueue()
+{
+	FSensorSimTelemetryMessage Message = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>();
+	while (Queue.Dequeue(Message))
+	{
+		for (FConnection& Connection : Connections)
+		{
+			if (!Connection.bWebSocket || Connection.bClosing)
+			{
+				continue;
+			}
+
+			// a client that cannot keep up misses whole messages, the simulation never waits for it
+			if (Connection.GetPendingBytes() > MaxClientBacklog)
+			{
+				DroppedMessages.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+
+			SensorSimTelemetry::AppendFrameHeader(Connection.Pending, SensorSimTelemetry::OpBinary, Message->Num());
+			Connection.Pending.Append(*Message);
+		}
+	}
+}
+
+void FSensorSimTelemetryServer::CloseConnection(int32 Index)
+{
+	FConnection& Connection = Connections[Index];
+	if (Connection.bWebSocket)
+	{
+		NumClients.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	Connection.Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connection.Socket);
+
+	Connections.RemoveAtSwap(Index);
+}
+
+FSensorSimTelemetryClient::~FSensorSimTelemetryClient()
+{
+	Close();
+}
+
+bool FSensorSimTelemetryClient::SendRequest(uint16 Port, const FString& Path, bool bUpgrade)
+{
+	Close();
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("SensorSimTelemetryClient"), false);
+	if (!Socket)
+	{
+		return false;
+	}
+
+	const TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+	Address->SetIp(FIPv4Address(127, 0, 0, 1).Value);
+	Address->SetPort(Port);
+
+	if (!Socket->Connect(*Address))
+	{
+		Close();
+		return false;
+	}
+
+	FString Request = FString::Printf(TEXT("GET %s HTTP/1.1\r\nHost: 127.0.0.1:%d\r\n"), *Path, Port);
+	if (bUpgrade)
+	{
+		uint8 Nonce[16];
+		for (uint8& Byte : Nonce)
+		{
+			Byte = static_cast<uint8>(FMath::Rand());
+		}
+		Key = FBase64::Encode(Nonce, sizeof(Nonce));
+
+		Request += FString::Printf(TEXT("Upgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n"), *Key);
+	}
+	Request += TEXT("\r\n");
+
+	TArray<uint8> Bytes;
+	SensorSimTelemetry::AppendString(Bytes, Request);
+
+	int32 Offset = 0;
+	while (Offset < Bytes.Num())
+	{
+		int32 Sent = 0;
+		if (!Socket->Send(Bytes.GetData() + Offset, Bytes.Num() - Offset, Sent))
+		{
+			Close();
+			return false;
+		}
+		Offset += Sent;
+	}
+
+	return true;
+}
+
+int32 FSensorSimTelemetryClient::ReadResponse(FString& OutHeaders, float TimeoutSeconds)
+{
+	const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+
+	int32 HeadersEnd = INDEX_NONE;
+	while ((HeadersEnd = SensorSimTelemetry::FindHeadersEnd(Buffered)) == INDEX_NONE)
+	{
+		uint8 Byte = 0;
+		if (!ReadExactly(&Byte, 1, Deadline))
+		{
+			return 0;
+		}
+		Buffered.Add(Byte);
+	}
+
+	OutHeaders = FString(HeadersEnd, reinterpret_cast<const ANSICHAR*>(Buffered.GetData()));
+	Buffered.RemoveAt(0, HeadersEnd);
+
+	// HTTP/1.1 <Status> <Reason>
+	TArray<FString> StatusLine;
+	OutHeaders.Left(OutHeaders.Find(TEXT("\r\n"))).ParseIntoArrayWS(StatusLine);
+	return StatusLine.Num() >= 2 ? FCString::Atoi(*StatusLine[1]) : 0;
+}
+
+bool FSensorSimTelemetryClient::ConnectWebSocket(uint16 Port, float TimeoutSeconds)
+{
+	if (!SendRequest(Port, ANSI_TO_TCHAR(SensorSimTelemetry::WebSocketPath), true))
+	{
+		return false;
+	}
+
+	FString Headers;
+	return ReadResponse(Headers, TimeoutSeconds) == 101
+		&& SensorSimTelemetry::FindHeader(Headers, TEXT("Sec-WebSocket-Accept")) == SensorSimTelemetry::ComputeAcceptKey(Key);
+}
+
+bool FSensorSimTelemetryClient::ReadMessage(TArray<uint8>& OutMessage, float TimeoutSeconds)
+{
+	const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+
+	while (true)
+	{
+		uint8 Head[2];
+		if (!ReadExactly(Head, 2, Deadline))
+		{
+			return false;
+		}
+
+		const uint8 Opcode = Head[0] & 0x0F;
+		uint64 Size = Head[1] & 0x7F;
+
+		// the server never fragments or masks its frames
+		if (!(Head[0] & 0x80) || (Head[1] & 0x80))
+		{
+			return false;
+		}
+
+		if (Size == 126 || Size == 127)
+		{
+			uint8 Extended[8];
+			const int32 NumBytes = Size == 126 ? 2 : 8;
+			if (!ReadExactly(Extended, NumBytes, Deadline))
+			{
+				return false;
+			}
+
+			Size = 0;
+			for (int32 Index = 0; Index < NumBytes; ++Index)
+			{
+				Size = (Size << 8) | Extended[Index];
+			}
+		}
+
+		if (Size > MAX_int32)
+		{
+			return false;
+		}
+
+		OutMessage.SetNumUninitialized(int32(Size));
+		if (!ReadExactly(OutMessage.GetData(), int32(Size), Deadline))
+		{
+			return false;
+		}
+
+		if (Opcode == SensorSimTelemetry::OpBinary)
+		{
+			return true;
+		}
+
+		if (Opcode == SensorSimTelemetry::OpClose)
+		{
+			return false;
+		}
+	}
+}
+
+bool FSensorSimTelemetryClient::ReadBody(TArray<uint8>& OutBody, int32 Count, float TimeoutSeconds)
+{
+	OutBody.SetNumUninitialized(Count);
+	return ReadExactly(OutBody.GetData(), Count, FPlatformTime::Seconds() + TimeoutSeconds);
+}
+
+void FSensorSimTelemetryClient::Close()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	Buffered.Reset();
+}
+
+bool FSensorSimTelemetryClient::ReadExactly(uint8* Out, int32 Count, double Deadline)
+{
+	if (!Socket)
+	{
+		return false;
+	}
+
+	// serve what was read past the HTTP headers first
+	const int32 NumBuffered = FMath::Min(Count, Buffered.Num());
+	FMemory::Memcpy(Out, Buffered.GetData(), NumBuffered);
+	Buffered.RemoveAt(0, NumBuffered);
+
+	int32 Offset = NumBuffered;
+	while (Offset < Count)
+	{
+		const double Remaining = Deadline - FPlatformTime::Seconds();
+		if (Remaining <= 0.0 || !Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(Remaining)))
+		{
+			return false;
+		}
+
+		int32 BytesRead = 0;
+		if (!Socket->Recv(Out + Offset, Count - Offset, BytesRead))
+		{
+			return false;
+		}
+		Offset += BytesRead;
+	}
+
+	return true;
+}
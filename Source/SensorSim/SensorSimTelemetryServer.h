@@ -0,0 +1,300 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+// Forward declarations
+class FEvent;
+class FRunnableThread;
+class FSocket;
+struct FSensorSimPointCloudFrame;
+
+/**
+ *  SensorSim telemetry wire format
+ *  Every message is one binary WebSocket frame: an FSensorSimTelemetryHeader followed by its payload.
+ *  Little endian, packed, meters and degrees in Unreal axes (x forward, y right, z up).
+ *
+ *    PointCloud  header.Count is the vehicle stream. FSensorSimTelemetryCloud, then NumPoints points, each
+ *                three zigzag varints (x, y, z in Scale units, relative to the previous point, or to 0 for
+ *                the first) and a uint8 intensity. Sensor frame coordinates.
+ *    Vehicles    header.Count FSensorSimTelemetryVehicle
+ *    Sensors     FSensorSimTelemetryServerStats, then header.Count FSensorSimTelemetrySensor
+ */
+namespace SensorSimTelemetry
+{
+	constexpr uint8 Version = 1;
+
+	/** Bound to the loopback interface only */
+	constexpr uint16 DefaultPort = 8787;
+
+	/** Path the dashboard connects its WebSocket to */
+	constexpr const ANSICHAR* WebSocketPath = "/ws";
+}
+
+enum class ESensorSimTelemetryType : uint8
+{
+	PointCloud = 1,
+	Vehicles = 2,
+	Sensors = 3,
+};
+
+enum class ESensorSimTelemetrySensorKind : uint8
+{
+	Other = 0,
+	Lidar = 1,
+	Imu = 2,
+	WheelEncoder = 3,
+};
+
+#pragma pack(push, 1)
+
+struct FSensorSimTelemetryHeader
+{
+	ESensorSimTelemetryType Type = ESensorSimTelemetryType::Vehicles;
+	uint8 Version = SensorSimTelemetry::Version;
+
+	/** Vehicle stream for point clouds, number of entries otherwise */
+	uint16 Count = 0;
+
+	/** Messages of this type sent so far */
+	uint32 Sequence = 0;
+
+	/** World time, in seconds */
+	double Time = 0.0;
+};
+
+struct FSensorSimTelemetryCloud
+{
+	/** Sensor pose at the start of the sweep, world, in m */
+	float Location[3] = {};
+
+	/** Sensor rotation, x y z w */
+	float Rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	/** Meters per coordinate unit */
+	float Scale = 0.0f;
+
+	/** Points sent, and points in the sweep they were taken from */
+	uint32 NumPoints = 0;
+	uint32 SourcePoints = 0;
+};
+
+struct FSensorSimTelemetryVehicle
+{
+	uint16 Stream = 0;
+
+	/** Negative for reverse */
+	int8 Gear = 0;
+
+	uint8 Reserved = 0;
+
+	/** World location, in m */
+	float Location[3] = {};
+
+	/** In degrees */
+	float Yaw = 0.0f;
+
+	/** Forward speed, in km/h */
+	float Speed = 0.0f;
+
+	float EngineRPM = 0.0f;
+	float Steering = 0.0f;
+	float Throttle = 0.0f;
+	float Brake = 0.0f;
+};
+
+struct FSensorSimTelemetryServerStats
+{
+	/** Dashboards connected */
+	uint32 NumClients = 0;
+
+	/** Messages not sent to a dashboard that fell behind, since the server started */
+	uint32 DroppedMessages = 0;
+
+	/** Sweeps not streamed because the previous one of the vehicle was still being encoded */
+	uint32 SkippedClouds = 0;
+
+	uint32 Reserved = 0;
+};
+
+struct FSensorSimTelemetrySensor
+{
+	uint16 Stream = 0;
+	ESensorSimTelemetrySensorKind Kind = ESensorSimTelemetrySensorKind::Other;
+	uint8 Reserved = 0;
+
+	/** Samples per second, measured since the last message, and configured */
+	float Rate = 0.0f;
+	float TargetRate = 0.0f;
+
+	/** Due samples that were not taken, and samples published, since BeginPlay */
+	uint32 SkippedSamples = 0;
+	uint32 Samples = 0;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FSensorSimTelemetryHeader) == 16, "Telemetry header layout changed");
+static_assert(sizeof(FSensorSimTelemetryCloud) == 40, "Telemetry cloud layout changed");
+static_assert(sizeof(FSensorSimTelemetryVehicle) == 40, "Telemetry vehicle layout changed");
+static_assert(sizeof(FSensorSimTelemetrySensor) == 20, "Telemetry sensor layout changed");
+
+namespace SensorSimTelemetry
+{
+	/** Encodes at most MaxPoints evenly spread points of a sweep as a point cloud message */
+	SENSORSIM_API void EncodePointCloud(const FSensorSimPointCloudFrame& Frame, uint16 Stream, uint32 Sequence, int32 MaxPoints, float Scale, TArray<uint8>& OutMessage);
+
+	/** Decodes a point cloud message into sensor frame positions, in m, and intensities. Returns false if it is malformed */
+	SENSORSIM_API bool DecodePointCloud(TConstArrayView<uint8> Message, FSensorSimTelemetryCloud& OutCloud, TArray<FVector3f>& OutPoints, TArray<uint8>& OutIntensities);
+
+	/** Returns the header of a message, or false if it is too short or of another version */
+	SENSORSIM_API bool ReadHeader(TConstArrayView<uint8> Message, FSensorSimTelemetryHeader& OutHeader);
+
+	/** Returns the WebSocket handshake answer to a Sec-WebSocket-Key */
+	SENSORSIM_API FString ComputeAcceptKey(const FString& Key);
+}
+
+/** Message shared by every client it is sent to */
+using FSensorSimTelemetryMessage = TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>;
+
+/**
+ *  Telemetry Server
+ *  Minimal HTTP and WebSocket server on the loopback interface, running on its own thread. Serves the dashboard
+ *  page on / and streams binary messages to every WebSocket client on /ws. Producers only enqueue; a client
+ *  that falls more than MaxClientBacklog bytes behind misses whole messages rather than slowing anyone down.
+ */
+class SENSORSIM_API FSensorSimTelemetryServer : public FRunnable
+{
+public:
+	FSensorSimTelemetryServer();
+	virtual ~FSensorSimTelemetryServer() override;
+
+	/** Listens on 127.0.0.1:Port and starts the server thread */
+	bool Start(uint16 InPort, int32 InMaxClientBacklog);
+
+	/** Closes every connection and stops the server thread */
+	void Shutdown();
+
+	/** Returns true between Start and Shutdown. Any thread */
+	bool IsRunning() const { return bRunning.load(std::memory_order_acquire); }
+
+	/** Queues a message for every WebSocket client. Any thread */
+	void Broadcast(const FSensorSimTelemetryMessage& Message);
+
+	/** Returns the number of WebSocket clients */
+	int32 GetNumClients() const { return NumClients.load(std::memory_order_relaxed); }
+
+	/** Returns the messages dropped for clients that fell behind */
+	uint32 GetDroppedMessages() const { return DroppedMessages.load(std::memory_order_relaxed); }
+
+	/** Returns the bytes sent so far */
+	uint64 GetBytesSent() const { return BytesSent.load(std::memory_order_relaxed); }
+
+	// Begin Runnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// End Runnable interface
+
+private:
+	/** Connection, HTTP until upgraded to a WebSocket. Server thread only */
+	struct FConnection
+	{
+		FSocket* Socket = nullptr;
+
+		/** Bytes received and not yet parsed */
+		TArray<uint8> Received;
+
+		/** Bytes waiting for the socket, from PendingOffset on */
+		TArray<uint8> Pending;
+
+		/** Bytes at the front of Pending already sent. Compacted once they are the bulk of it, so sends never shift the backlog */
+		int32 PendingOffset = 0;
+
+		bool bWebSocket = false;
+
+		/** Set once the connection should close after Pending is sent */
+		bool bClosing = false;
+
+		/** Returns the bytes waiting for the socket */
+		int32 GetPendingBytes() const { return Pending.Num() - PendingOffset; }
+	};
+
+	/** Accepts the connections waiting on the listener */
+	void AcceptConnections();
+
+	/** Reads and handles what a connection sent. Returns false once it should be dropped */
+	bool ReadConnection(FConnection& Connection);
+
+	/** Answers an HTTP request, upgrading the connection when asked to */
+	void HandleRequest(FConnection& Connection, const FString& Request);
+
+	/** Handles client WebSocket frames: pings and close */
+	void HandleFrames(FConnection& Connection);
+
+	/** Sends as much of Pending as the socket takes. Returns false once the connection should be dropped */
+	bool FlushConnection(FConnection& Connection);
+
+	/** Appends the queued messages to every WebSocket client with room for them */
+	void DrainQueue();
+
+	/** Closes and forgets a connection */
+	void CloseConnection(int32 Index);
+
+	uint16 Port = SensorSimTelemetry::DefaultPort;
+	int32 MaxClientBacklog = 0;
+
+	TQueue<FSensorSimTelemetryMessage, EQueueMode::Mpsc> Queue;
+	FEvent* WorkEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bRunning{ false };
+	std::atomic<bool> bStopRequested{ false };
+
+	/** Server thread only */
+	FSocket* Listener = nullptr;
+	TArray<FConnection> Connections;
+
+	std::atomic<int32> NumClients{ 0 };
+	std::atomic<uint32> DroppedMessages{ 0 };
+	std::atomic<uint64> BytesSent{ 0 };
+};
+
+/**
+ *  Telemetry Client
+ *  Blocking WebSocket client for local testing, as a browser would connect to the dashboard.
+ */
+class SENSORSIM_API FSensorSimTelemetryClient
+{
+public:
+	~FSensorSimTelemetryClient();
+
+	/** Connects to 127.0.0.1:Port and sends an HTTP request. Returns false if it could not connect */
+	bool SendRequest(uint16 Port, const FString& Path, bool bUpgrade);
+
+	/** Reads the HTTP response headers and returns the status code, or 0 on failure */
+	int32 ReadResponse(FString& OutHeaders, float TimeoutSeconds);
+
+	/** Performs the WebSocket handshake. Returns false unless the server accepted it with the right key */
+	bool ConnectWebSocket(uint16 Port, float TimeoutSeconds);
+
+	/** Reads one binary WebSocket message. Returns false on timeout, close or a protocol error */
+	bool ReadMessage(TArray<uint8>& OutMessage, float TimeoutSeconds);
+
+	/** Reads up to Count bytes of an HTTP body */
+	bool ReadBody(TArray<uint8>& OutBody, int32 Count, float TimeoutSeconds);
+
+	void Close();
+
+private:
+	/** Reads exactly Count bytes into Out. Returns false on timeout or disconnection */
+	bool ReadExactly(uint8* Out, int32 Count, double Deadline);
+
+	FSocket* Socket = nullptr;
+
+	/** Bytes received past the last read */
+	TArray<uint8> Buffered;
+
+	/** Key sent with the handshake */
+	FString Key;
+};
@@ -0,0 +1,305 @@
+#include "SensorSimTelemetrySubsystem.h"
+#include "SensorSim.h"
+#include "SensorSimPawn.h"
+#include "SensorSimLidarComponent.h"
+#include "SensorSimImuComponent.h"
+#include "SensorSimWheelEncoderComponent.h"
+#include "SensorSimRecording.h"
+#include "SensorSimTelemetryServer.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTelemetryStart(
+	TEXT("SensorSim.Telemetry.Start"),
+	TEXT("Serves the telemetry dashboard on http://127.0.0.1:<Port>/. Usage: SensorSim.Telemetry.Start [Port]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimTelemetrySubsystem* Telemetry = World ? World->GetSubsystem<USensorSimTelemetrySubsystem>() : nullptr)
+		{
+			Telemetry->StartServer(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTelemetryStop(
+	TEXT("SensorSim.Telemetry.Stop"),
+	TEXT("Stops serving the telemetry dashboard"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USensorSimTelemetrySubsystem* Telemetry = World ? World->GetSubsystem<USensorSimTelemetrySubsystem>() : nullptr)
+		{
+			Telemetry->StopServer();
+		}
+	}));
+
+namespace SensorSimTelemetry
+{
+	template<typename PayloadType>
+	void AppendPayload(TArray<uint8>& Message, const PayloadType& Payload)
+	{
+		Message.Append(reinterpret_cast<const uint8*>(&Payload), sizeof(Payload));
+	}
+}
+
+bool USensorSimTelemetrySubsystem::StartServer(int32 InPort)
+{
+	if (IsServing())
+	{
+		return true;
+	}
+
+	if (InPort > 0)
+	{
+		Port = InPort;
+	}
+
+	if (Port <= 0 || Port > MAX_uint16)
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Invalid telemetry port %d"), Port);
+		return false;
+	}
+
+	TSharedPtr<FSensorSimTelemetryServer, ESPMode::ThreadSafe> NewServer = MakeShared<FSensorSimTelemetryServer, ESPMode::ThreadSafe>();
+	if (!NewServer->Start(static_cast<uint16>(Port), MaxClientBacklog))
+	{
+		return false;
+	}
+
+	Server = NewServer;
+	LastUpdateTime = 0.0;
+	LastSensorsTime = 0.0;
+
+	for (TActorIterator<ASensorSimPawn> It(GetWorld()); It; ++It)
+	{
+		StreamVehicle(*It);
+	}
+
+	return true;
+}
+
+void USensorSimTelemetrySubsystem::StopServer()
+{
+	if (!IsServing())
+	{
+		return;
+	}
+
+	for (FSensorSimTelemetryStream& Stream : Streams)
+	{
+		if (ASensorSimPawn* Pawn = Stream.Pawn.Get())
+		{
+			Pawn->GetLidarScanner()->OnSweep.Remove(Stream.SweepHandle);
+		}
+
+		Stream.CloudTask.Wait();
+	}
+
+	Streams.Reset();
+
+	Server->Shutdown();
+	Server.Reset();
+}
+
+void USensorSimTelemetrySubsystem::StreamVehicle(ASensorSimPawn* Pawn)
+{
+	if (!IsServing() || !Pawn || Streams.ContainsByPredicate([Pawn](const FSensorSimTelemetryStream& Stream) { return Stream.Pawn == Pawn; }))
+	{
+		return;
+	}
+
+	// vehicles stay listed until the server stops, so a stream is never reused by another vehicle
+	const uint16 StreamId = static_cast<uint16>(Streams.Num());
+
+	FSensorSimTelemetryStream& Stream = Streams.AddDefaulted_GetRef();
+	Stream.Pawn = Pawn;
+	Stream.StreamId = StreamId;
+
+	// sweeps are thinned to PointCloudRate and encoded on the task graph while the published frame is held by reference
+	Stream.SweepHandle = Pawn->GetLidarScanner()->OnSweep.AddWeakLambda(this, [this, StreamId](const FSensorSimPointCloudRef& Frame)
+	{
+		if (Server->GetNumClients() == 0)
+		{
+			return;
+		}
+
+		FSensorSimTelemetryStream& StreamedVehicle = Streams[StreamId];
+
+		const double WallTime = FPlatformTime::Seconds();
+		if (WallTime - StreamedVehicle.LastCloudTime < 1.0 / FMath::Max(PointCloudRate, 0.1f))
+		{
+			return;
+		}
+
+		if (!StreamedVehicle.CloudTask.IsCompleted())
+		{
+			++SkippedClouds;
+			return;
+		}
+
+		StreamedVehicle.LastCloudTime = WallTime;
+		StreamedVehicle.CloudTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+			[TelemetryServer = Server, Frame, StreamId, Sequence = CloudSequence++, MaxPoints = MaxPoints, Scale = PointScale]()
+		{
+			TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Message = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+			SensorSimTelemetry::EncodePointCloud(*Frame, StreamId, Sequence, MaxPoints, Scale, *Message);
+			TelemetryServer->Broadcast(Message);
+		});
+	});
+}
+
+void USensorSimTelemetrySubsystem::BroadcastUpdate(double WallTime)
+{
+	using namespace SensorSimTelemetry;
+
+	const UWorld* World = GetWorld();
+	const double WorldTime = World->GetTimeSeconds();
+	const double Elapsed = LastSensorsTime > 0.0 ? WallTime - LastSensorsTime : 0.0;
+
+	FSensorSimTelemetryHeader VehiclesHeader;
+	VehiclesHeader.Type = ESensorSimTelemetryType::Vehicles;
+	VehiclesHeader.Sequence = UpdateSequence;
+	VehiclesHeader.Time = WorldTime;
+
+	FSensorSimTelemetryHeader SensorsHeader = VehiclesHeader;
+	SensorsHeader.Type = ESensorSimTelemetryType::Sensors;
+
+	FSensorSimTelemetryServerStats Stats;
+	Stats.NumClients = Server->GetNumClients();
+	Stats.DroppedMessages = Server->GetDroppedMessages();
+	Stats.SkippedClouds = SkippedClouds;
+
+	TArray<FSensorSimTelemetryVehicle, TInlineAllocator<64>> VehicleEntries;
+	TArray<FSensorSimTelemetrySensor, TInlineAllocator<192>> SensorEntries;
+
+	for (FSensorSimTelemetryStream& Stream : Streams)
+	{
+		const ASensorSimPawn* Pawn = Stream.Pawn.Get();
+		if (!Pawn || Pawn->IsParked())
+		{
+			continue;
+		}
+
+		FSensorSimVehicleStateSample State;
+		Pawn->SampleState(WorldTime, State);
+
+		FSensorSimTelemetryVehicle& Vehicle = VehicleEntries.AddDefaulted_GetRef();
+		Vehicle.Stream = Stream.StreamId;
+		Vehicle.Gear = static_cast<int8>(State.Gear);
+		Vehicle.Location[0] = static_cast<float>(State.Location.X * 0.01);
+		Vehicle.Location[1] = static_cast<float>(State.Location.Y * 0.01);
+		Vehicle.Location[2] = static_cast<float>(State.Location.Z * 0.01);
+		Vehicle.Yaw = State.Rotation.Rotator().Yaw;
+		Vehicle.Speed = State.ForwardSpeed * 0.036f;
+		Vehicle.EngineRPM = State.EngineRPM;
+		Vehicle.Steering = State.Steering;
+		Vehicle.Throttle = State.Throttle;
+		Vehicle.Brake = State.Brake;
+
+		const USensorSimSensorComponent* Sensors[] = { Pawn->GetLidarScanner(), Pawn->GetImu(), Pawn->GetWheelEncoders() };
+		const ESensorSimTelemetrySensorKind Kinds[] = { ESensorSimTelemetrySensorKind::Lidar, ESensorSimTelemetrySensorKind::Imu, ESensorSimTelemetrySensorKind::WheelEncoder };
+
+		for (int32 Index = 0; Index < int32(UE_ARRAY_COUNT(Sensors)); ++Index)
+		{
+			if (!Sensors[Index])
+			{
+				continue;
+			}
+
+			const uint64 Samples = Sensors[Index]->GetCounters().Samples;
+
+			FSensorSimTelemetrySensor& Sensor = SensorEntries.AddDefaulted_GetRef();
+			Sensor.Stream = Stream.StreamId;
+			Sensor.Kind = Kinds[Index];
+			Sensor.Rate = Elapsed > 0.0 && Samples >= Stream.LastSamples[Index] ? static_cast<float>((Samples - Stream.LastSamples[Index]) / Elapsed) : 0.0f;
+			Sensor.TargetRate = Sensors[Index]->GetSampleRate();
+			Sensor.SkippedSamples = Sensors[Index]->GetSkippedSamples();
+			Sensor.Samples = static_cast<uint32>(Samples);
+
+			Stream.LastSamples[Index] = Samples;
+		}
+	}
+
+	VehiclesHeader.Count = static_cast<uint16>(FMath::Min(VehicleEntries.Num(), int32(MAX_uint16)));
+	SensorsHeader.Count = static_cast<uint16>(FMath::Min(SensorEntries.Num(), int32(MAX_uint16)));
+
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> VehiclesMessage = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+	VehiclesMessage->Reserve(sizeof(VehiclesHeader) + VehiclesHeader.Count * sizeof(FSensorSimTelemetryVehicle));
+	AppendPayload(*VehiclesMessage, VehiclesHeader);
+	VehiclesMessage->Append(reinterpret_cast<const uint8*>(VehicleEntries.GetData()), VehiclesHeader.Count * sizeof(FSensorSimTelemetryVehicle));
+
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> SensorsMessage = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+	SensorsMessage->Reserve(sizeof(SensorsHeader) + sizeof(Stats) + SensorsHeader.Count * sizeof(FSensorSimTelemetrySensor));
+	AppendPayload(*SensorsMessage, SensorsHeader);
+	AppendPayload(*SensorsMessage, Stats);
+	SensorsMessage->Append(reinterpret_cast<const uint8*>(SensorEntries.GetData()), SensorsHeader.Count * sizeof(FSensorSimTelemetrySensor));
+
+	Server->Broadcast(VehiclesMessage);
+	Server->Broadcast(SensorsMessage);
+
+	++UpdateSequence;
+	LastSensorsTime = WallTime;
+}
+
+void USensorSimTelemetrySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bCheckedCommandLine)
+	{
+		bCheckedCommandLine = true;
+
+		// start once every level actor has begun play
+		int32 CommandLinePort = 0;
+		if (FParse::Value(FCommandLine::Get(), TEXT("SensorSimTelemetry="), CommandLinePort) || FParse::Param(FCommandLine::Get(), TEXT("SensorSimTelemetry")))
+		{
+			StartServer(CommandLinePort);
+		}
+	}
+
+	if (!IsServing())
+	{
+		return;
+	}
+
+	const double WallTime = FPlatformTime::Seconds();
+	if (WallTime - LastUpdateTime < 1.0 / FMath::Max(UpdateRate, 0.1f))
+	{
+		return;
+	}
+
+	LastUpdateTime = WallTime;
+
+	// vehicles spawned since, such as by the fleet or the scenario pool
+	for (TActorIterator<ASensorSimPawn> It(GetWorld()); It; ++It)
+	{
+		StreamVehicle(*It);
+	}
+
+	// nothing is built for nobody; rates are measured from the first update a dashboard sees
+	if (Server->GetNumClients() > 0)
+	{
+		BroadcastUpdate(WallTime);
+	}
+	else
+	{
+		LastSensorsTime = 0.0;
+	}
+}
+
+TStatId USensorSimTelemetrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USensorSimTelemetrySubsystem, STATGROUP_Tickables);
+}
+
+void USensorSimTelemetrySubsystem::Deinitialize()
+{
+	StopServer();
+
+	Super::Deinitialize();
+}
+
+bool USensorSimTelemetrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "SensorSimTelemetrySubsystem.generated.h"
+
+// Forward declarations
+class ASensorSimPawn;
+class FSensorSimTelemetryServer;
+
+/**
+ *  Streamed vehicle bookkeeping
+ *  One stream per vehicle: downsampled point clouds, state and sensor rates.
+ */
+USTRUCT()
+struct FSensorSimTelemetryStream
+{
+	GENERATED_BODY()
+
+	/** Streamed vehicle */
+	TWeakObjectPtr<ASensorSimPawn> Pawn;
+
+	/** Stream the vehicle is listed as on the dashboard */
+	uint16 StreamId{ 0 };
+
+	/** Binding to the vehicle's LiDAR sweeps */
+	FDelegateHandle SweepHandle;
+
+	/** Wall clock time of the last point cloud sent */
+	double LastCloudTime{ 0.0 };
+
+	/** Last point cloud encode. A sweep arriving before it completes is skipped rather than queued */
+	UE::Tasks::FTask CloudTask;
+
+	/** Samples published by the LiDAR, IMU and wheel encoders at the last sensors message */
+	uint64 LastSamples[3]{};
+};
+
+/**
+ *  Telemetry Subsystem
+ *  Streams every vehicle's state, sensor rates and downsampled point clouds to browser dashboards on
+ *  http://127.0.0.1:<Port>/, through FSensorSimTelemetryServer. Messages are only built while a dashboard
+ *  is connected; point clouds are encoded on the task graph and everything is sent from the server thread,
+ *  so the game thread never waits on a socket. Works in headless and batch runs.
+ *
+ *  Console commands:
+ *    SensorSim.Telemetry.Start [Port]
+ *    SensorSim.Telemetry.Stop
+ *
+ *  Command line:
+ *    -SensorSimTelemetry[=Port]    serves from the first frame
+ */
+UCLASS(Config = Game)
+class SENSORSIM_API USensorSimTelemetrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	/** Loopback port the dashboard is served on */
+	UPROPERTY(Config)
+	int32 Port{ 8787 };
+
+	/** Points sent per sweep at most, evenly spread over it */
+	UPROPERTY(Config)
+	int32 MaxPoints{ 8192 };
+
+	/** Point cloud resolution, in m */
+	UPROPERTY(Config)
+	float PointScale{ 0.02f };
+
+	/** Vehicle and sensor messages per wall clock second */
+	UPROPERTY(Config)
+	float UpdateRate{ 10.0f };
+
+	/** Point clouds per vehicle and wall clock second at most */
+	UPROPERTY(Config)
+	float PointCloudRate{ 5.0f };
+
+	/** Bytes a dashboard may fall behind by before it misses messages */
+	UPROPERTY(Config)
+	int32 MaxClientBacklog{ 4 * 1024 * 1024 };
+
+	/** Streamed vehicles */
+	UPROPERTY(Transient)
+	TArray<FSensorSimTelemetryStream> Streams;
+
+	/** Server, shared with the point cloud encodes in flight */
+	TSharedPtr<FSensorSimTelemetryServer, ESPMode::ThreadSafe> Server;
+
+	/** Wall clock time of the last update, and of the last vehicle and sensor messages, 0 while no dashboard is connected */
+	double LastUpdateTime{ 0.0 };
+	double LastSensorsTime{ 0.0 };
+
+	/** Messages of each type sent so far */
+	uint32 CloudSequence{ 0 };
+	uint32 UpdateSequence{ 0 };
+
+	/** Sweeps skipped while the previous one of the vehicle was being encoded */
+	uint32 SkippedClouds{ 0 };
+
+	/** True once the command line has been checked for -SensorSimTelemetry */
+	bool bCheckedCommandLine{ false };
+
+public:
+	/** Starts serving the dashboard. Returns false if the port could not be bound */
+	bool StartServer(int32 InPort);
+
+	/** Waits for the encodes in flight and stops the server */
+	void StopServer();
+
+	/** Returns true while serving */
+	bool IsServing() const { return Server.IsValid(); }
+
+	// Begin TickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End TickableWorldSubsystem interface
+
+	// Begin WorldSubsystem interface
+	virtual void Deinitialize() override;
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	// End WorldSubsystem interface
+
+	/** Adds a vehicle not streamed yet */
+	void StreamVehicle(ASensorSimPawn* Pawn);
+
+	/** Queues the vehicles and sensors messages */
+	void BroadcastUpdate(double WallTime);
+};
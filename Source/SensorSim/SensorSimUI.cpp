@@ -2,18 +2,43 @@
 
 
 #include "SensorSimUI.h"
+#include "SensorSim.h"
 
 void USensorSimUI::UpdateSpeed(float NewSpeed)
 {
-	// format the speed to KPH or MPH
-	float FormattedSpeed = FMath::Abs(NewSpeed) * (bIsMPH ? 0.022f : 0.036f);
+	// format the speed to KPH or MPH, rounded to what is displayed
+	const int32 FormattedSpeed = FMath::RoundToInt32(FMath::Abs(NewSpeed) * (bIsMPH ? 0.022f : 0.036f));
+
+	if (bHasSpeed && FormattedSpeed == DisplayedSpeed)
+	{
+		return;
+	}
+
+	DisplayedSpeed = FormattedSpeed;
+	bHasSpeed = true;
+	INC_DWORD_STAT(STAT_SensorSimHudChanges);
 
 	// call the Blueprint handler
-	OnSpeedUpdate(FormattedSpeed);
+	OnSpeedUpdate(static_cast<float>(FormattedSpeed));
 }
 
 void USensorSimUI::UpdateGear(int32 NewGear)
 {
+	if (bHasGear && NewGear == DisplayedGear)
+	{
+		return;
+	}
+
+	DisplayedGear = NewGear;
+	bHasGear = true;
+	INC_DWORD_STAT(STAT_SensorSimHudChanges);
+
 	// call the Blueprint handler
 	OnGearUpdate(NewGear);
-}
\ No newline at end of file
+}
+
+void USensorSimUI::ResetDisplay()
+{
+	bHasSpeed = false;
+	bHasGear = false;
+}
@@ -10,6 +10,8 @@
  *  Simple Vehicle HUD class
  *  Displays the current speed and gear.
  *  Widget setup is handled in a Blueprint subclass.
+ *  Updates are change-driven: the Blueprint handlers only run, and the widget is only invalidated,
+ *  when the displayed whole speed or the gear changes.
  */
 UCLASS(abstract)
 class SENSORSIM_API USensorSimUI : public UUserWidget
@@ -22,14 +24,27 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Vehicle)
 	bool bIsMPH = false;
 
+	/** Speed on display, in whole Km/h or MPH */
+	int32 DisplayedSpeed = 0;
+
+	/** Gear on display */
+	int32 DisplayedGear = 0;
+
+	/** False until the first update, or after ResetDisplay */
+	bool bHasSpeed = false;
+	bool bHasGear = false;
+
 public:
 
-	/** Called to update the speed display */
+	/** Called to update the speed display. Ignored unless the displayed whole speed changes */
 	void UpdateSpeed(float NewSpeed);
 
-	/** Called to update the gear display */
+	/** Called to update the gear display. Ignored unless the gear changes */
 	void UpdateGear(int32 NewGear);
 
+	/** Forgets the displayed values, so that the next updates reach the Blueprint handlers */
+	void ResetDisplay();
+
 protected:
 
 	/** Implemented in Blueprint to display the new speed */
@@ -0,0 +1,303 @@
+#include "SensorSimVehicleCatalog.h"
+#include "SensorSim.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+
+static FAutoConsoleCommand CmdCatalogLoad(
+	TEXT("SensorSim.Catalog.Load"),
+	TEXT("Adds the vehicle variants of a catalog file. Usage: SensorSim.Catalog.Load <File>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.IsEmpty())
+		{
+			UE_LOG(LogSensorSim, Warning, TEXT("Usage: SensorSim.Catalog.Load <File>"));
+			return;
+		}
+
+		FSensorSimVehicleCatalog::Get().LoadFromCSV(Args[0]);
+	}));
+
+static FAutoConsoleCommand CmdCatalogList(
+	TEXT("SensorSim.Catalog.List"),
+	TEXT("Logs every vehicle archetype in the catalog"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const FSensorSimVehicleCatalog& Catalog = FSensorSimVehicleCatalog::Get();
+		for (int32 Index = 0; Index < Catalog.Num(); ++Index)
+		{
+			const FSensorSimVehicleArchetype& Archetype = Catalog.GetArchetype(Index);
+			UE_LOG(LogSensorSim, Display, TEXT("%d: %s, body %d, %.0f Nm, springs %.0f/%.0f"), Index, *Catalog.GetName(Index).ToString(),
+				static_cast<int32>(Archetype.Body), Archetype.MaxTorque, Archetype.Wheels[0].SpringRate, Archetype.Wheels[1].SpringRate);
+		}
+	}));
+
+namespace SensorSimVehicleCatalog
+{
+	/** Vehicle fields that catalog files may override */
+	struct FVehicleField
+	{
+		const TCHAR* Name;
+		float FSensorSimVehicleArchetype::* Member;
+	};
+
+	/** Wheel fields that catalog files may override, prefixed with Front or Rear */
+	struct FWheelField
+	{
+		const TCHAR* Name;
+		float FSensorSimWheelArchetype::* Member;
+	};
+
+	static constexpr FVehicleField VehicleFields[] =
+	{
+		{ TEXT("ChassisHeight"), &FSensorSimVehicleArchetype::ChassisHeight },
+		{ TEXT("DragCoefficient"), &FSensorSimVehicleArchetype::DragCoefficient },
+		{ TEXT("DownforceCoefficient"), &FSensorSimVehicleArchetype::DownforceCoefficient },
+		{ TEXT("CenterOfMassHeight"), &FSensorSimVehicleArchetype::CenterOfMassHeight },
+		{ TEXT("MaxTorque"), &FSensorSimVehicleArchetype::MaxTorque },
+		{ TEXT("MaxRPM"), &FSensorSimVehicleArchetype::MaxRPM },
+		{ TEXT("EngineIdleRPM"), &FSensorSimVehicleArchetype::EngineIdleRPM },
+		{ TEXT("EngineBrakeEffect"), &FSensorSimVehicleArchetype::EngineBrakeEffect },
+		{ TEXT("EngineRevUpMOI"), &FSensorSimVehicleArchetype::EngineRevUpMOI },
+		{ TEXT("EngineRevDownRate"), &FSensorSimVehicleArchetype::EngineRevDownRate },
+		{ TEXT("FinalRatio"), &FSensorSimVehicleArchetype::FinalRatio },
+		{ TEXT("ChangeUpRPM"), &FSensorSimVehicleArchetype::ChangeUpRPM },
+		{ TEXT("ChangeDownRPM"), &FSensorSimVehicleArchetype::ChangeDownRPM },
+		{ TEXT("GearChangeTime"), &FSensorSimVehicleArchetype::GearChangeTime },
+		{ TEXT("TransmissionEfficiency"), &FSensorSimVehicleArchetype::TransmissionEfficiency },
+		{ TEXT("ReverseGearRatio"), &FSensorSimVehicleArchetype::ReverseGearRatio },
+		{ TEXT("FrontRearSplit"), &FSensorSimVehicleArchetype::FrontRearSplit },
+		{ TEXT("SteeringAngleRatio"), &FSensorSimVehicleArchetype::SteeringAngleRatio },
+	};
+
+	static constexpr FWheelField WheelFields[] =
+	{
+		{ TEXT("WheelRadius"), &FSensorSimWheelArchetype::WheelRadius },
+		{ TEXT("WheelWidth"), &FSensorSimWheelArchetype::WheelWidth },
+		{ TEXT("CorneringStiffness"), &FSensorSimWheelArchetype::CorneringStiffness },
+		{ TEXT("FrictionForceMultiplier"), &FSensorSimWheelArchetype::FrictionForceMultiplier },
+		{ TEXT("SlipThreshold"), &FSensorSimWheelArchetype::SlipThreshold },
+		{ TEXT("SkidThreshold"), &FSensorSimWheelArchetype::SkidThreshold },
+		{ TEXT("MaxSteerAngle"), &FSensorSimWheelArchetype::MaxSteerAngle },
+		{ TEXT("SuspensionMaxRaise"), &FSensorSimWheelArchetype::SuspensionMaxRaise },
+		{ TEXT("SuspensionMaxDrop"), &FSensorSimWheelArchetype::SuspensionMaxDrop },
+		{ TEXT("WheelLoadRatio"), &FSensorSimWheelArchetype::WheelLoadRatio },
+		{ TEXT("SpringRate"), &FSensorSimWheelArchetype::SpringRate },
+		{ TEXT("SpringPreload"), &FSensorSimWheelArchetype::SpringPreload },
+		{ TEXT("MaxBrakeTorque"), &FSensorSimWheelArchetype::MaxBrakeTorque },
+		{ TEXT("MaxHandBrakeTorque"), &FSensorSimWheelArchetype::MaxHandBrakeTorque },
+	};
+
+	float* FindField(FSensorSimVehicleArchetype& Archetype, const FString& Column)
+	{
+		for (const FVehicleField& Field : VehicleFields)
+		{
+			if (Column.Equals(Field.Name, ESearchCase::IgnoreCase))
+			{
+				return &(Archetype.*Field.Member);
+			}
+		}
+
+		const bool bFront = Column.StartsWith(TEXT("Front"));
+		if (!bFront && !Column.StartsWith(TEXT("Rear")))
+		{
+			return nullptr;
+		}
+
+		const FString WheelColumn = Column.RightChop(bFront ? 5 : 4);
+		for (const FWheelField& Field : WheelFields)
+		{
+			if (WheelColumn.Equals(Field.Name, ESearchCase::IgnoreCase))
+			{
+				return &(Archetype.Wheels[bFront ? 0 : 1].*Field.Member);
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+void FSensorSimWheelArchetype::ApplyTo(UChaosVehicleWheel& Wheel) const
+{
+	Wheel.AxleType = AxleType;
+	Wheel.SweepShape = SweepShape;
+	Wheel.bAffectedBySteering = bAffectedBySteering;
+	Wheel.bAffectedByEngine = bAffectedByEngine;
+	Wheel.bAffectedByHandbrake = bAffectedByHandbrake;
+
+	Wheel.WheelRadius = WheelRadius;
+	Wheel.WheelWidth = WheelWidth;
+	Wheel.CorneringStiffness = CorneringStiffness;
+	Wheel.FrictionForceMultiplier = FrictionForceMultiplier;
+	Wheel.SlipThreshold = SlipThreshold;
+	Wheel.SkidThreshold = SkidThreshold;
+	Wheel.MaxSteerAngle = MaxSteerAngle;
+
+	Wheel.SuspensionMaxRaise = SuspensionMaxRaise;
+	Wheel.SuspensionMaxDrop = SuspensionMaxDrop;
+	Wheel.WheelLoadRatio = WheelLoadRatio;
+	Wheel.SpringRate = SpringRate;
+	Wheel.SpringPreload = SpringPreload;
+
+	Wheel.MaxBrakeTorque = MaxBrakeTorque;
+	Wheel.MaxHandBrakeTorque = MaxHandBrakeTorque;
+}
+
+void FSensorSimVehicleArchetype::ApplyTo(UChaosWheeledVehicleMovementComponent& Movement) const
+{
+	Movement.ChassisHeight = ChassisHeight;
+	Movement.DragCoefficient = DragCoefficient;
+	Movement.DownforceCoefficient = DownforceCoefficient;
+	Movement.bEnableCenterOfMassOverride = bEnableCenterOfMassOverride;
+	Movement.CenterOfMassOverride = FVector(0.0f, 0.0f, CenterOfMassHeight);
+
+	// NOTE: the torque curve is left to the Blueprint asset
+	Movement.EngineSetup.MaxTorque = MaxTorque;
+	Movement.EngineSetup.MaxRPM = MaxRPM;
+	Movement.EngineSetup.EngineIdleRPM = EngineIdleRPM;
+	Movement.EngineSetup.EngineBrakeEffect = EngineBrakeEffect;
+	Movement.EngineSetup.EngineRevUpMOI = EngineRevUpMOI;
+	Movement.EngineSetup.EngineRevDownRate = EngineRevDownRate;
+
+	Movement.TransmissionSetup.bUseAutomaticGears = bUseAutomaticGears;
+	Movement.TransmissionSetup.bUseAutoReverse = bUseAutoReverse;
+	Movement.TransmissionSetup.FinalRatio = FinalRatio;
+	Movement.TransmissionSetup.ChangeUpRPM = ChangeUpRPM;
+	Movement.TransmissionSetup.ChangeDownRPM = ChangeDownRPM;
+	Movement.TransmissionSetup.GearChangeTime = GearChangeTime;
+	Movement.TransmissionSetup.TransmissionEfficiency = TransmissionEfficiency;
+	Movement.TransmissionSetup.ForwardGearRatios = TArray<float>(ForwardGearRatios, FMath::Clamp(NumForwardGears, 1, MaxForwardGears));
+	Movement.TransmissionSetup.ReverseGearRatios = TArray<float>(&ReverseGearRatio, 1);
+
+	Movement.DifferentialSetup.DifferentialType = DifferentialType;
+	Movement.DifferentialSetup.FrontRearSplit = FrontRearSplit;
+
+	// NOTE: the steering curve is left to the Blueprint asset
+	Movement.SteeringSetup.SteeringType = SteeringType;
+	Movement.SteeringSetup.AngleRatio = SteeringAngleRatio;
+}
+
+FSensorSimVehicleCatalog& FSensorSimVehicleCatalog::Get()
+{
+	check(IsInGameThread());
+
+	static FSensorSimVehicleCatalog Catalog;
+	return Catalog;
+}
+
+FSensorSimVehicleCatalog::FSensorSimVehicleCatalog()
+{
+	AddArchetype(TEXT("SportsCar"), SensorSimVehicleCatalog::SportsCar);
+	AddArchetype(TEXT("OffroadCar"), SensorSimVehicleCatalog::OffroadCar);
+
+	FString Filename;
+	if (FParse::Value(FCommandLine::Get(), TEXT("VehicleCatalog="), Filename))
+	{
+		LoadFromCSV(Filename);
+	}
+}
+
+int32 FSensorSimVehicleCatalog::AddArchetype(FName Name, const FSensorSimVehicleArchetype& Archetype)
+{
+	int32 Index = FindArchetype(Name);
+	if (Index == INDEX_NONE)
+	{
+		Index = Archetypes.Add(Archetype);
+		Names.Add(Name);
+	}
+	else
+	{
+		Archetypes[Index] = Archetype;
+	}
+
+	return Index;
+}
+
+bool FSensorSimVehicleCatalog::LoadFromCSV(const FString& Filename)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		UE_LOG(LogSensorSim, Error, TEXT("Failed to read vehicle catalog '%s'"), *Filename);
+		return false;
+	}
+
+	TArray<FString> Header;
+	TArray<FString> Columns;
+
+	// variants may build on earlier rows, so they are resolved against the table as it grows
+	TArray<FSensorSimVehicleArchetype> NewArchetypes;
+	TArray<FName> NewNames;
+
+	for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+	{
+		const FString Line = Lines[LineIndex].TrimStartAndEnd();
+
+		// skip blanks and comments
+		if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		if (Header.IsEmpty())
+		{
+			Line.ParseIntoArray(Header, TEXT(","), false);
+			if (Header.Num() < 2 || Header[0] != TEXT("Name") || Header[1] != TEXT("Base"))
+			{
+				UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected a header starting with Name,Base"), *Filename, LineIndex + 1);
+				return false;
+			}
+
+			FSensorSimVehicleArchetype Probe;
+			for (int32 ColumnIndex = 2; ColumnIndex < Header.Num(); ++ColumnIndex)
+			{
+				Header[ColumnIndex].TrimStartAndEndInline();
+				if (!SensorSimVehicleCatalog::FindField(Probe, Header[ColumnIndex]))
+				{
+					UE_LOG(LogSensorSim, Error, TEXT("%s(%d): unknown archetype field '%s'"), *Filename, LineIndex + 1, *Header[ColumnIndex]);
+					return false;
+				}
+			}
+			continue;
+		}
+
+		Line.ParseIntoArray(Columns, TEXT(","), false);
+		if (Columns.Num() != Header.Num())
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("%s(%d): expected %d columns, got %d"), *Filename, LineIndex + 1, Header.Num(), Columns.Num());
+			return false;
+		}
+
+		const FName BaseName(*Columns[1].TrimStartAndEnd());
+		const int32 NewBaseIndex = NewNames.IndexOfByKey(BaseName);
+		const int32 BaseIndex = FindArchetype(BaseName);
+		if (NewBaseIndex == INDEX_NONE && BaseIndex == INDEX_NONE)
+		{
+			UE_LOG(LogSensorSim, Error, TEXT("%s(%d): unknown base archetype '%s'"), *Filename, LineIndex + 1, *BaseName.ToString());
+			return false;
+		}
+
+		FSensorSimVehicleArchetype Archetype = NewBaseIndex != INDEX_NONE ? NewArchetypes[NewBaseIndex] : Archetypes[BaseIndex];
+		for (int32 ColumnIndex = 2; ColumnIndex < Columns.Num(); ++ColumnIndex)
+		{
+			// empty cells keep the base value
+			const FString Cell = Columns[ColumnIndex].TrimStartAndEnd();
+			if (!Cell.IsEmpty())
+			{
+				*SensorSimVehicleCatalog::FindField(Archetype, Header[ColumnIndex]) = FCString::Atof(*Cell);
+			}
+		}
+
+		NewArchetypes.Add(Archetype);
+		NewNames.Add(FName(*Columns[0].TrimStartAndEnd()));
+	}
+
+	for (int32 Index = 0; Index < NewArchetypes.Num(); ++Index)
+	{
+		AddArchetype(NewNames[Index], NewArchetypes[Index]);
+	}
+
+	UE_LOG(LogSensorSim, Log, TEXT("Loaded vehicle catalog '%s': %d variants, %d archetypes"), *Filename, NewArchetypes.Num(), Archetypes.Num());
+	return true;
+}
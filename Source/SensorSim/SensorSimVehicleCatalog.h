@@ -0,0 +1,310 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChaosVehicleWheel.h"
+#include "ChaosWheeledVehicleMovementComponent.h"
+
+/** Vehicle body an archetype is built on. Indexes the fleet's vehicle classes */
+enum class ESensorSimVehicleBody : uint8
+{
+	Sports,
+	Offroad,
+};
+
+/**
+ *  Wheel archetype
+ *  Every wheel parameter the vehicle setup changes, with the Chaos defaults for the rest.
+ */
+struct FSensorSimWheelArchetype
+{
+	EAxleType AxleType = EAxleType::Undefined;
+	ESweepShape SweepShape = ESweepShape::Raycast;
+	bool bAffectedBySteering = false;
+	bool bAffectedByEngine = false;
+	bool bAffectedByHandbrake = false;
+
+	/** In cm */
+	float WheelRadius = 32.0f;
+	float WheelWidth = 20.0f;
+
+	float CorneringStiffness = 1000.0f;
+	float FrictionForceMultiplier = 2.0f;
+	float SlipThreshold = 20.0f;
+	float SkidThreshold = 20.0f;
+
+	/** In degrees */
+	float MaxSteerAngle = 50.0f;
+
+	/** In cm */
+	float SuspensionMaxRaise = 10.0f;
+	float SuspensionMaxDrop = 10.0f;
+
+	float WheelLoadRatio = 0.5f;
+	float SpringRate = 250.0f;
+	float SpringPreload = 50.0f;
+
+	/** In Nm */
+	float MaxBrakeTorque = 1500.0f;
+	float MaxHandBrakeTorque = 3000.0f;
+
+	/** Writes the archetype into a wheel. Wheels read their properties when the Chaos vehicle is set up */
+	void ApplyTo(UChaosVehicleWheel& Wheel) const;
+};
+
+/**
+ *  Vehicle archetype
+ *  Chassis, engine, transmission, differential, steering and wheel setup of one vehicle variant, as plain data.
+ *  Front wheels use Wheels[0], rear wheels Wheels[1].
+ */
+struct FSensorSimVehicleArchetype
+{
+	static constexpr int32 MaxForwardGears = 8;
+
+	ESensorSimVehicleBody Body = ESensorSimVehicleBody::Sports;
+	EVehicleDifferential DifferentialType = EVehicleDifferential::RearWheelDrive;
+	ESteeringType SteeringType = ESteeringType::AngleRatio;
+	bool bEnableCenterOfMassOverride = false;
+	bool bUseAutomaticGears = true;
+	bool bUseAutoReverse = true;
+
+	/** In cm */
+	float ChassisHeight = 140.0f;
+	float DragCoefficient = 0.3f;
+	float DownforceCoefficient = 0.3f;
+
+	/** Center of mass height above the mesh origin, in cm. Used with bEnableCenterOfMassOverride */
+	float CenterOfMassHeight = 0.0f;
+
+	/** In Nm */
+	float MaxTorque = 300.0f;
+	float MaxRPM = 4500.0f;
+	float EngineIdleRPM = 1200.0f;
+	float EngineBrakeEffect = 0.05f;
+	float EngineRevUpMOI = 5.0f;
+	float EngineRevDownRate = 600.0f;
+
+	float FinalRatio = 3.08f;
+	float ChangeUpRPM = 4500.0f;
+	float ChangeDownRPM = 2000.0f;
+
+	/** In seconds */
+	float GearChangeTime = 0.4f;
+	float TransmissionEfficiency = 0.9f;
+
+	int32 NumForwardGears = 4;
+	float ForwardGearRatios[MaxForwardGears] = { 2.85f, 2.02f, 1.35f, 1.0f };
+	float ReverseGearRatio = 2.86f;
+
+	float FrontRearSplit = 0.5f;
+	float SteeringAngleRatio = 0.7f;
+
+	FSensorSimWheelArchetype Wheels[2];
+
+	/** Returns the wheel archetype of an axle */
+	const FSensorSimWheelArchetype& GetWheel(EAxleType Axle) const { return Wheels[Axle == EAxleType::Rear ? 1 : 0]; }
+
+	/** Writes the chassis, engine, transmission, differential and steering into a movement component, before its physics state is created */
+	void ApplyTo(UChaosWheeledVehicleMovementComponent& Movement) const;
+};
+
+/**
+ *  Shipped archetypes
+ *  Evaluated at compile time; the car and wheel classes are constructed from these.
+ */
+namespace SensorSimVehicleCatalog
+{
+	constexpr FSensorSimWheelArchetype MakeFrontWheel()
+	{
+		FSensorSimWheelArchetype Wheel;
+		Wheel.AxleType = EAxleType::Front;
+		Wheel.bAffectedBySteering = true;
+		Wheel.MaxSteerAngle = 40.0f;
+		return Wheel;
+	}
+
+	constexpr FSensorSimWheelArchetype MakeRearWheel()
+	{
+		FSensorSimWheelArchetype Wheel;
+		Wheel.AxleType = EAxleType::Rear;
+		Wheel.bAffectedByHandbrake = true;
+		Wheel.bAffectedByEngine = true;
+		return Wheel;
+	}
+
+	constexpr FSensorSimWheelArchetype MakeSportsFrontWheel()
+	{
+		FSensorSimWheelArchetype Wheel = MakeFrontWheel();
+		Wheel.WheelRadius = 39.0f;
+		Wheel.WheelWidth = 35.0f;
+		Wheel.FrictionForceMultiplier = 3.0f;
+		Wheel.MaxBrakeTorque = 4500.0f;
+		Wheel.MaxHandBrakeTorque = 6000.0f;
+		return Wheel;
+	}
+
+	constexpr FSensorSimWheelArchetype MakeSportsRearWheel()
+	{
+		FSensorSimWheelArchetype Wheel = MakeRearWheel();
+		Wheel.WheelRadius = 40.0f;
+		Wheel.WheelWidth = 40.0f;
+		Wheel.FrictionForceMultiplier = 4.0f;
+		Wheel.SlipThreshold = 100.0f;
+		Wheel.SkidThreshold = 100.0f;
+		Wheel.MaxSteerAngle = 0.0f;
+		Wheel.MaxHandBrakeTorque = 6000.0f;
+		return Wheel;
+	}
+
+	/** Both offroad axles share their tires and suspension */
+	constexpr FSensorSimWheelArchetype MakeOffroadWheel(FSensorSimWheelArchetype Wheel)
+	{
+		Wheel.WheelRadius = 50.0f;
+		Wheel.CorneringStiffness = 750.0f;
+		Wheel.FrictionForceMultiplier = 4.0f;
+		Wheel.SuspensionMaxRaise = 20.0f;
+		Wheel.SuspensionMaxDrop = 20.0f;
+		Wheel.WheelLoadRatio = 1.0f;
+		Wheel.SpringRate = 100.0f;
+		Wheel.SpringPreload = 100.0f;
+		Wheel.SweepShape = ESweepShape::Shapecast;
+		Wheel.MaxBrakeTorque = 3000.0f;
+		Wheel.MaxHandBrakeTorque = 6000.0f;
+		return Wheel;
+	}
+
+	constexpr FSensorSimWheelArchetype MakeOffroadFrontWheel()
+	{
+		FSensorSimWheelArchetype Wheel = MakeOffroadWheel(MakeFrontWheel());
+		Wheel.bAffectedByEngine = true;
+		return Wheel;
+	}
+
+	constexpr FSensorSimVehicleArchetype MakeSportsCar()
+	{
+		FSensorSimVehicleArchetype Vehicle;
+		Vehicle.Body = ESensorSimVehicleBody::Sports;
+
+		Vehicle.ChassisHeight = 144.0f;
+		Vehicle.DragCoefficient = 0.31f;
+
+		Vehicle.MaxTorque = 750.0f;
+		Vehicle.MaxRPM = 7000.0f;
+		Vehicle.EngineIdleRPM = 900.0f;
+		Vehicle.EngineBrakeEffect = 0.2f;
+		Vehicle.EngineRevUpMOI = 5.0f;
+		Vehicle.EngineRevDownRate = 600.0f;
+
+		Vehicle.FinalRatio = 2.81f;
+		Vehicle.ChangeUpRPM = 6000.0f;
+		Vehicle.ChangeDownRPM = 2000.0f;
+		Vehicle.GearChangeTime = 0.2f;
+		Vehicle.TransmissionEfficiency = 0.9f;
+		Vehicle.NumForwardGears = 5;
+		Vehicle.ForwardGearRatios[0] = 4.25f;
+		Vehicle.ForwardGearRatios[1] = 2.52f;
+		Vehicle.ForwardGearRatios[2] = 1.66f;
+		Vehicle.ForwardGearRatios[3] = 1.22f;
+		Vehicle.ForwardGearRatios[4] = 1.0f;
+		Vehicle.ReverseGearRatio = 4.04f;
+
+		Vehicle.SteeringType = ESteeringType::Ackermann;
+		Vehicle.SteeringAngleRatio = 0.7f;
+
+		Vehicle.Wheels[0] = MakeSportsFrontWheel();
+		Vehicle.Wheels[1] = MakeSportsRearWheel();
+		return Vehicle;
+	}
+
+	constexpr FSensorSimVehicleArchetype MakeOffroadCar()
+	{
+		FSensorSimVehicleArchetype Vehicle;
+		Vehicle.Body = ESensorSimVehicleBody::Offroad;
+
+		Vehicle.ChassisHeight = 160.0f;
+		Vehicle.DragCoefficient = 0.1f;
+		Vehicle.DownforceCoefficient = 0.1f;
+		Vehicle.bEnableCenterOfMassOverride = true;
+		Vehicle.CenterOfMassHeight = 75.0f;
+
+		Vehicle.MaxTorque = 600.0f;
+		Vehicle.MaxRPM = 5000.0f;
+		Vehicle.EngineIdleRPM = 1200.0f;
+		Vehicle.EngineBrakeEffect = 0.05f;
+		Vehicle.EngineRevUpMOI = 5.0f;
+		Vehicle.EngineRevDownRate = 600.0f;
+
+		Vehicle.DifferentialType = EVehicleDifferential::AllWheelDrive;
+		Vehicle.FrontRearSplit = 0.5f;
+
+		Vehicle.SteeringType = ESteeringType::AngleRatio;
+		Vehicle.SteeringAngleRatio = 0.7f;
+
+		Vehicle.Wheels[0] = MakeOffroadFrontWheel();
+		Vehicle.Wheels[1] = MakeOffroadWheel(MakeRearWheel());
+		return Vehicle;
+	}
+
+	inline constexpr FSensorSimWheelArchetype FrontWheel = MakeFrontWheel();
+	inline constexpr FSensorSimWheelArchetype RearWheel = MakeRearWheel();
+	inline constexpr FSensorSimVehicleArchetype SportsCar = MakeSportsCar();
+	inline constexpr FSensorSimVehicleArchetype OffroadCar = MakeOffroadCar();
+
+	/** Returns the field a catalog column overrides, such as MaxTorque or FrontSpringRate, or nullptr if there is none */
+	SENSORSIM_API float* FindField(FSensorSimVehicleArchetype& Archetype, const FString& Column);
+}
+
+/**
+ *  Vehicle Catalog
+ *  Flat table of vehicle archetypes, built once per process: the shipped cars first, then the variants of the
+ *  file given with -VehicleCatalog=<File>. Vehicles are spawned from an archetype index; applying one is a few
+ *  plain copies into the movement component and its wheels, then a rebuild of the Chaos vehicle from them.
+ *  Game thread only.
+ *
+ *  Catalog files are CSV. The header row names the columns: Name, Base, then any archetype fields, with Front or
+ *  Rear in front of wheel fields, e.g. Name,Base,MaxTorque,FrontSpringRate,RearCorneringStiffness
+ *  Each row starts from the archetype named in Base and overrides the listed fields.
+ *
+ *  Console commands:
+ *    SensorSim.Catalog.Load <File>
+ *    SensorSim.Catalog.List
+ */
+class SENSORSIM_API FSensorSimVehicleCatalog
+{
+public:
+	/** Index of the shipped archetypes */
+	static constexpr int32 SportsCarIndex = 0;
+	static constexpr int32 OffroadCarIndex = 1;
+
+	/** Returns the process-wide catalog, building it on first use */
+	static FSensorSimVehicleCatalog& Get();
+
+	/** Returns the number of archetypes */
+	int32 Num() const { return Archetypes.Num(); }
+
+	/** Returns true if the index names an archetype */
+	bool IsValidIndex(int32 Index) const { return Archetypes.IsValidIndex(Index); }
+
+	/** Returns an archetype by index */
+	const FSensorSimVehicleArchetype& GetArchetype(int32 Index) const { return Archetypes[Index]; }
+
+	/** Returns the name of an archetype */
+	FName GetName(int32 Index) const { return Names[Index]; }
+
+	/** Returns the index of a named archetype, or INDEX_NONE */
+	int32 FindArchetype(FName Name) const { return Names.IndexOfByKey(Name); }
+
+	/** Adds an archetype, or replaces the one of the same name. Returns its index */
+	int32 AddArchetype(FName Name, const FSensorSimVehicleArchetype& Archetype);
+
+	/** Adds the variants of a catalog file. Returns false, having added none, if the file is not valid */
+	bool LoadFromCSV(const FString& Filename);
+
+private:
+	FSensorSimVehicleCatalog();
+
+	/** Archetypes, indexed like Names */
+	TArray<FSensorSimVehicleArchetype> Archetypes;
+
+	/** Archetype names */
+	TArray<FName> Names;
+};
@@ -0,0 +1,412 @@
+#include "SensorSimVehicleMovementComponent.h"
+#include "SensorSim.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/ScopeLock.h"
+#include "Algo/BinarySearch.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+#include "VehicleUtility.h"
+
+/**
+ *  Wheeled vehicle simulation that logs or overrides the inputs of every physics step.
+ *  Runs on the physics thread; only talks to the game thread through the input channel.
+ */
+class FSensorSimVehicleSimulation : public UChaosWheeledVehicleSimulation
+{
+public:
+	explicit FSensorSimVehicleSimulation(const TSharedRef<FSensorSimVehicleInputChannel, ESPMode::ThreadSafe>& InChannel)
+		: Channel{ InChannel }
+	{
+	}
+
+	virtual void TickVehicle(UWorld* WorldIn, float DeltaTime, const FChaosVehicleAsyncInput& InputData, FChaosVehicleAsyncOutput& OutputData, Chaos::FRigidBodyHandle_Internal* Handle) override
+	{
+		// a restored state replaces whatever the vehicle ended the last step with
+		if (PVehicle && Channel->bStatePending.load(std::memory_order_acquire))
+		{
+			FScopeLock Lock(&Channel->StateLock);
+			Channel->PendingState.ApplyVehicle(*PVehicle);
+			Channel->bStatePending.store(false, std::memory_order_relaxed);
+		}
+
+		// the pose before this step moves the body
+		const double StepStartTime = Channel->PhysicsTime.load(std::memory_order_relaxed);
+		if (Handle)
+		{
+			FSensorSimPhysicsPose Pose;
+			Pose.Time = StepStartTime;
+			Pose.Location = Handle->X();
+			Pose.Rotation = Handle->R();
+			Channel->Poses.Enqueue(Pose);
+
+			FSensorSimPhysicsStepContext Context;
+			Context.Time = StepStartTime;
+			Context.DeltaTime = DeltaTime;
+			Context.Body = Handle;
+			Context.Vehicle = PVehicle.Get();
+
+			SENSORSIM_SCOPE_CYCLE_COUNTER(STAT_SensorSimPhysicsSensors);
+
+			FScopeLock Lock(&Channel->SensorsLock);
+
+			// the vehicle was teleported since the last step
+			const bool bReset = Channel->bResetSensors.exchange(false, std::memory_order_acquire);
+			for (const TSharedRef<ISensorSimPhysicsSensor, ESPMode::ThreadSafe>& Sensor : Channel->PhysicsSensors)
+			{
+				if (bReset)
+				{
+					Sensor->OnReset();
+				}
+
+				Sensor->OnPhysicsStep(Context);
+			}
+		}
+
+		UChaosWheeledVehicleSimulation::TickVehicle(WorldIn, DeltaTime, InputData, OutputData, Handle);
+
+		// wheels, suspension and drivetrain are integrated by now; the body is moved by the solver later in the step
+		if (PVehicle)
+		{
+			FSensorSimVehiclePhysicsState State;
+			State.CaptureVehicle(*PVehicle);
+
+			FScopeLock Lock(&Channel->StateLock);
+			Channel->LatestState = State;
+			Channel->bHasLatestState = true;
+		}
+
+		Channel->PhysicsTime.store(StepStartTime + DeltaTime, std::memory_order_relaxed);
+	}
+
+	virtual void ApplyInput(const FControlInputs& ControlInputs, float DeltaTime) override
+	{
+		const uint32 CurrentStep = Step++;
+
+		FControlInputs Inputs = ControlInputs;
+		ReplayStep(CurrentStep, DeltaTime, Inputs);
+
+		if (Channel->bRecording.load(std::memory_order_relaxed))
+		{
+			FSensorSimPhysicsInputSample Sample;
+			Sample.Step = CurrentStep;
+			Sample.DeltaTime = DeltaTime;
+			Sample.Steering = Inputs.SteeringInput;
+			Sample.Throttle = Inputs.ThrottleInput;
+			Sample.Brake = Inputs.BrakeInput;
+			Sample.Handbrake = Inputs.HandbrakeInput;
+
+			ESensorSimPhysicsInputFlags Flags = ESensorSimPhysicsInputFlags::None;
+			if (Inputs.GearUpInput)
+			{
+				Flags |= ESensorSimPhysicsInputFlags::GearUp;
+			}
+			if (Inputs.GearDownInput)
+			{
+				Flags |= ESensorSimPhysicsInputFlags::GearDown;
+			}
+			if (Inputs.ParkingEnabled)
+			{
+				Flags |= ESensorSimPhysicsInputFlags::Parking;
+			}
+			Sample.Flags = static_cast<uint8>(Flags);
+
+			Channel->RecordedInputs.Enqueue(Sample);
+		}
+
+		UChaosWheeledVehicleSimulation::ApplyInput(Inputs, DeltaTime);
+	}
+
+private:
+	/** Overwrites the live inputs with the logged ones for this step, if a replay covers it */
+	void ReplayStep(uint32 CurrentStep, float DeltaTime, FControlInputs& Inputs)
+	{
+		TSharedPtr<const TArray<FSensorSimPhysicsInputSample>, ESPMode::ThreadSafe> Replay;
+		{
+			FScopeLock Lock(&Channel->ReplayLock);
+			Replay = Channel->ReplayInputs;
+		}
+
+		if (!Replay)
+		{
+			return;
+		}
+
+		// logs are contiguous, so the step maps straight to a sample
+		const int64 SampleIndex = int64(CurrentStep) - int64((*Replay)[0].Step);
+		if (SampleIndex >= Replay->Num())
+		{
+			Channel->bReplayFinished = true;
+			return;
+		}
+
+		if (SampleIndex < 0)
+		{
+			return;
+		}
+
+		const FSensorSimPhysicsInputSample& Sample = (*Replay)[SampleIndex];
+		if (Sample.Step != CurrentStep || Sample.DeltaTime != DeltaTime)
+		{
+			Channel->DesyncedSteps.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		const ESensorSimPhysicsInputFlags Flags = static_cast<ESensorSimPhysicsInputFlags>(Sample.Flags);
+		Inputs.SteeringInput = Sample.Steering;
+		Inputs.ThrottleInput = Sample.Throttle;
+		Inputs.BrakeInput = Sample.Brake;
+		Inputs.HandbrakeInput = Sample.Handbrake;
+		Inputs.GearUpInput = EnumHasAnyFlags(Flags, ESensorSimPhysicsInputFlags::GearUp);
+		Inputs.GearDownInput = EnumHasAnyFlags(Flags, ESensorSimPhysicsInputFlags::GearDown);
+		Inputs.ParkingEnabled = EnumHasAnyFlags(Flags, ESensorSimPhysicsInputFlags::Parking);
+	}
+
+	TSharedRef<FSensorSimVehicleInputChannel, ESPMode::ThreadSafe> Channel;
+
+	/** Physics steps taken since the simulation was created */
+	uint32 Step = 0;
+};
+
+void USensorSimVehicleMovementComponent::StartInputRecording()
+{
+	InputChannel->bRecording = true;
+}
+
+void USensorSimVehicleMovementComponent::StopInputRecording()
+{
+	InputChannel->bRecording = false;
+}
+
+void USensorSimVehicleMovementComponent::ConsumeRecordedInputs(TArray<FSensorSimPhysicsInputSample>& OutSamples)
+{
+	FSensorSimPhysicsInputSample Sample;
+	while (InputChannel->RecordedInputs.Dequeue(Sample))
+	{
+		OutSamples.Add(Sample);
+	}
+}
+
+void USensorSimVehicleMovementComponent::StartInputReplay(TArray<FSensorSimPhysicsInputSample>&& Samples)
+{
+	if (Samples.IsEmpty())
+	{
+		StopInputReplay();
+		return;
+	}
+
+	InputChannel->bReplayFinished = false;
+	InputChannel->DesyncedSteps = 0;
+
+	FScopeLock Lock(&InputChannel->ReplayLock);
+	InputChannel->ReplayInputs = MakeShared<TArray<FSensorSimPhysicsInputSample>, ESPMode::ThreadSafe>(MoveTemp(Samples));
+}
+
+void USensorSimVehicleMovementComponent::StopInputReplay()
+{
+	FScopeLock Lock(&InputChannel->ReplayLock);
+	InputChannel->ReplayInputs.Reset();
+}
+
+void USensorSimVehicleMovementComponent::UpdatePoseHistory(double WorldTime)
+{
+	DrainPoses();
+
+	// physics has caught up with the world, so the current body pose ends the last step
+	const double PhysicsTime = InputChannel->PhysicsTime.load();
+	PhysicsTimeOffset = WorldTime - PhysicsTime;
+
+	if (!PoseHistory.IsEmpty() && PoseHistory.Last().Time >= PhysicsTime)
+	{
+		PoseHistory.Pop(EAllowShrinking::No);
+	}
+
+	const FTransform& Transform = GetOwner()->GetActorTransform();
+
+	FSensorSimPhysicsPose& Pose = PoseHistory.AddDefaulted_GetRef();
+	Pose.Time = PhysicsTime;
+	Pose.Location = Transform.GetLocation();
+	Pose.Rotation = Transform.GetRotation();
+}
+
+void USensorSimVehicleMovementComponent::GetPoseHistory(double StartTime, double EndTime, TArray<FSensorSimPhysicsPose>& OutPoses) const
+{
+	OutPoses.Reset();
+
+	if (PoseHistory.IsEmpty())
+	{
+		return;
+	}
+
+	// widen the span to the poses bracketing it
+	const double PhysicsStartTime = StartTime - PhysicsTimeOffset;
+	const double PhysicsEndTime = EndTime - PhysicsTimeOffset;
+
+	const int32 First = FMath::Max(Algo::UpperBoundBy(PoseHistory, PhysicsStartTime, &FSensorSimPhysicsPose::Time) - 1, 0);
+	const int32 Last = FMath::Min(Algo::LowerBoundBy(PoseHistory, PhysicsEndTime, &FSensorSimPhysicsPose::Time), PoseHistory.Num() - 1);
+
+	OutPoses.Reserve(Last - First + 1);
+	for (int32 Index = First; Index <= Last; ++Index)
+	{
+		FSensorSimPhysicsPose& Pose = OutPoses.Add_GetRef(PoseHistory[Index]);
+		Pose.Time += PhysicsTimeOffset;
+	}
+}
+
+bool USensorSimVehicleMovementComponent::GetLatestPhysicsState(FSensorSimVehiclePhysicsState& OutState) const
+{
+	FScopeLock Lock(&InputChannel->StateLock);
+	if (!InputChannel->bHasLatestState)
+	{
+		return false;
+	}
+
+	OutState = InputChannel->LatestState;
+	return true;
+}
+
+void USensorSimVehicleMovementComponent::QueuePhysicsState(const FSensorSimVehiclePhysicsState& State)
+{
+	FScopeLock Lock(&InputChannel->StateLock);
+	InputChannel->PendingState = State;
+	InputChannel->bStatePending.store(true, std::memory_order_release);
+
+	// saving again before the next step returns the state just restored
+	InputChannel->LatestState = State;
+	InputChannel->bHasLatestState = true;
+}
+
+void USensorSimVehicleMovementComponent::ResetHistory()
+{
+	// poses queued before the teleport are dropped along with the history
+	FSensorSimPhysicsPose Pose;
+	while (InputChannel->Poses.Dequeue(Pose))
+	{
+	}
+
+	PoseHistory.Reset();
+
+	InputChannel->bResetSensors.store(true, std::memory_order_release);
+}
+
+void USensorSimVehicleMovementComponent::AddPhysicsSensor(const TSharedRef<ISensorSimPhysicsSensor, ESPMode::ThreadSafe>& Sensor)
+{
+	FScopeLock Lock(&InputChannel->SensorsLock);
+	InputChannel->PhysicsSensors.AddUnique(Sensor);
+}
+
+void USensorSimVehicleMovementComponent::RemovePhysicsSensor(const TSharedRef<ISensorSimPhysicsSensor, ESPMode::ThreadSafe>& Sensor)
+{
+	FScopeLock Lock(&InputChannel->SensorsLock);
+	InputChannel->PhysicsSensors.Remove(Sensor);
+}
+
+void USensorSimVehicleMovementComponent::DrainPoses()
+{
+	FSensorSimPhysicsPose Pose;
+	while (InputChannel->Poses.Dequeue(Pose))
+	{
+		// a step starting where the last anchored pose was taken replaces it
+		if (!PoseHistory.IsEmpty() && PoseHistory.Last().Time >= Pose.Time)
+		{
+			PoseHistory.Last() = Pose;
+			continue;
+		}
+
+		PoseHistory.Add(Pose);
+	}
+
+	// keep one pose older than the window, so that its start can still be interpolated
+	const double OldestTime = InputChannel->PhysicsTime.load() - PoseHistorySeconds;
+	const int32 NumExpired = Algo::UpperBoundBy(PoseHistory, OldestTime, &FSensorSimPhysicsPose::Time) - 1;
+	if (NumExpired > 0)
+	{
+		PoseHistory.RemoveAt(0, NumExpired, EAllowShrinking::No);
+	}
+}
+
+void USensorSimVehicleMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// runs recorded from the command line log inputs from the very first physics step, so they can be replayed exactly
+	FString RecordingFile;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SensorSimRecord="), RecordingFile))
+	{
+		StartInputRecording();
+	}
+}
+
+void USensorSimVehicleMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// keep the queue bounded even when no sensor reads the poses
+	DrainPoses();
+}
+
+void USensorSimVehicleMovementComponent::ApplyArchetype(const FSensorSimVehicleArchetype& InArchetype)
+{
+	InArchetype.ApplyTo(*this);
+	Archetype = InArchetype;
+
+	// registration creates the Chaos vehicle and its wheels from the class defaults, even on a deferred spawn;
+	// rebuild them, with CreateWheels applying the archetype's wheels
+	if (PVehicleOutput)
+	{
+		RecreatePhysicsState();
+	}
+}
+
+bool USensorSimVehicleMovementComponent::IsSimulatingArchetype(const FSensorSimVehicleArchetype& InArchetype) const
+{
+	const Chaos::FSimpleWheeledVehicle* PhysicsVehicle = VehicleSimulationPT ? VehicleSimulationPT->PVehicle.Get() : nullptr;
+	if (!PhysicsVehicle || PhysicsVehicle->Suspension.Num() != Wheels.Num())
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("%s: no Chaos vehicle set up"), *GetPathName());
+		return false;
+	}
+
+	for (int32 WheelIndex = 0; WheelIndex < Wheels.Num(); ++WheelIndex)
+	{
+		if (!Wheels[WheelIndex])
+		{
+			return false;
+		}
+
+		// the Chaos suspension setup is in cm
+		const float Expected = InArchetype.GetWheel(Wheels[WheelIndex]->AxleType).SpringRate;
+		const float Simulated = Chaos::CmToM(PhysicsVehicle->Suspension[WheelIndex].Setup().SpringRate);
+		if (!FMath::IsNearlyEqual(Simulated, Expected, FMath::Max(FMath::Abs(Expected) * 1.0e-3f, UE_KINDA_SMALL_NUMBER)))
+		{
+			UE_LOG(LogSensorSim, Warning, TEXT("%s: wheel %d simulates a spring rate of %g rather than %g"), *GetPathName(), WheelIndex, Simulated, Expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+TUniquePtr<Chaos::FSimpleWheeledVehicle> USensorSimVehicleMovementComponent::CreatePhysicsVehicle()
+{
+	// replaces the simulation created by the wheeled component, which is then updated from the physics thread
+	TUniquePtr<Chaos::FSimpleWheeledVehicle> PhysicsVehicle = Super::CreatePhysicsVehicle();
+	VehicleSimulationPT = MakeUnique<FSensorSimVehicleSimulation>(InputChannel);
+
+	return PhysicsVehicle;
+}
+
+void USensorSimVehicleMovementComponent::CreateWheels()
+{
+	Super::CreateWheels();
+
+	// wheels are instanced from their class defaults, and only read into the Chaos vehicle once all are created
+	if (Archetype.IsSet())
+	{
+		for (UChaosVehicleWheel* Wheel : Wheels)
+		{
+			if (Wheel)
+			{
+				Archetype->GetWheel(Wheel->AxleType).ApplyTo(*Wheel);
+			}
+		}
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChaosWheeledVehicleMovementComponent.h"
+#include "Containers/Queue.h"
+#include "SensorSimRecording.h"
+#include "SensorSimPhysicsSensor.h"
+#include "SensorSimPhysicsState.h"
+#include "SensorSimVehicleCatalog.h"
+#include "SensorSimVehicleMovementComponent.generated.h"
+
+/** Vehicle pose at the start of one physics step */
+struct FSensorSimPhysicsPose
+{
+	/** Physics time, in seconds. Converted to world time by the movement component */
+	double Time = 0.0;
+
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+};
+
+/**
+ *  Physics step channel
+ *  Carries inputs, poses and physics sensors between a movement component on the game thread and its vehicle simulation
+ *  on the physics thread. Shared, so that either side may outlive the other.
+ */
+struct FSensorSimVehicleInputChannel
+{
+	/** Set while the simulation should queue every input it applies */
+	std::atomic<bool> bRecording{ false };
+
+	/** Inputs applied by the simulation, oldest first. Produced on the physics thread, consumed on the game thread */
+	TQueue<FSensorSimPhysicsInputSample, EQueueMode::Spsc> RecordedInputs;
+
+	/** Guards ReplayInputs */
+	FCriticalSection ReplayLock;
+
+	/** Inputs to apply instead of the live ones, indexed by physics step */
+	TSharedPtr<const TArray<FSensorSimPhysicsInputSample>, ESPMode::ThreadSafe> ReplayInputs;
+
+	/** Set once the simulation has stepped past the last replayed input */
+	std::atomic<bool> bReplayFinished{ false };
+
+	/** Replayed steps whose step index or length differed from the recording */
+	std::atomic<int32> DesyncedSteps{ 0 };
+
+	/** Pose of every physics step, oldest first. Produced on the physics thread, consumed on the game thread */
+	TQueue<FSensorSimPhysicsPose, EQueueMode::Spsc> Poses;
+
+	/** Physics time at the end of the last step, in seconds */
+	std::atomic<double> PhysicsTime{ 0.0 };
+
+	/** Guards PhysicsSensors */
+	FCriticalSection SensorsLock;
+
+	/** Sensors sampled on every physics step */
+	TArray<TSharedRef<ISensorSimPhysicsSensor, ESPMode::ThreadSafe>> PhysicsSensors;
+
+	/** Set by the game thread to have the physics sensors drop their state before the next step */
+	std::atomic<bool> bResetSensors{ false };
+
+	/** Guards LatestState and PendingState */
+	FCriticalSection StateLock;
+
+	/** Wheel, suspension, engine and transmission state at the end of the last physics step */
+	FSensorSimVehiclePhysicsState LatestState;
+
+	/** True once LatestState holds a step */
+	bool bHasLatestState = false;
+
+	/** State written into the vehicle before the next physics step */
+	FSensorSimVehiclePhysicsState PendingState;
+
+	/** Set while PendingState is waiting for the next step */
+	std::atomic<bool> bStatePending{ false };
+};
+
+/**
+ *  SensorSim Vehicle Movement Component
+ *  Chaos wheeled movement that can log the inputs applied on every physics step,
+ *  and replay such a log in place of the live inputs. Replaying a log under the
+ *  same fixed time step and substepping reproduces the recorded run.
+ *  Also keeps a short history of the poses of every physics step, for sensors that
+ *  need the vehicle pose between frames, and samples physics sensors on every step.
+ */
+UCLASS()
+class SENSORSIM_API USensorSimVehicleMovementComponent : public UChaosWheeledVehicleMovementComponent
+{
+	GENERATED_BODY()
+
+protected:
+	/** Input channel to the physics thread simulation */
+	TSharedRef<FSensorSimVehicleInputChannel, ESPMode::ThreadSafe> InputChannel{ MakeShared<FSensorSimVehicleInputChannel, ESPMode::ThreadSafe>() };
+
+	/** Seconds of physics step poses kept */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Sensors, meta = (ClampMin = "0.1"))
+	float PoseHistorySeconds{ 1.0f };
+
+	/** Physics step poses, oldest first, in physics time */
+	TArray<FSensorSimPhysicsPose> PoseHistory;
+
+	/** World time minus physics time, measured after the last physics step */
+	double PhysicsTimeOffset{ 0.0 };
+
+	/** Archetype the vehicle was set up from, if any. Its wheels are written into the wheel objects as they are created */
+	TOptional<FSensorSimVehicleArchetype> Archetype;
+
+public:
+	/** Starts logging the inputs applied on every physics step */
+	void StartInputRecording();
+
+	/** Stops logging inputs. Inputs already logged can still be consumed */
+	void StopInputRecording();
+
+	/** Returns true while inputs are being logged */
+	bool IsRecordingInputs() const { return InputChannel->bRecording.load(); }
+
+	/** Appends the inputs logged since the last call */
+	void ConsumeRecordedInputs(TArray<FSensorSimPhysicsInputSample>& OutSamples);
+
+	/** Replaces the live inputs with the logged ones, from the physics step of the first sample onwards */
+	void StartInputReplay(TArray<FSensorSimPhysicsInputSample>&& Samples);
+
+	/** Returns control to the live inputs */
+	void StopInputReplay();
+
+	/** Returns true once every replayed input has been applied */
+	bool IsInputReplayFinished() const { return InputChannel->bReplayFinished.load(); }
+
+	/** Returns the number of replayed steps that did not line up with the recording */
+	int32 GetDesyncedSteps() const { return InputChannel->DesyncedSteps.load(); }
+
+	/** Collects the poses of the physics steps taken so far. Call after physics has run, to anchor them to the world time */
+	void UpdatePoseHistory(double WorldTime);
+
+	/** Returns the poses covering a world time span, in world time, including the closest ones on either side */
+	void GetPoseHistory(double StartTime, double EndTime, TArray<FSensorSimPhysicsPose>& OutPoses) const;
+
+	/** Returns the wheel, suspension, engine and transmission state as of the end of the last physics step. False before the first step */
+	bool GetLatestPhysicsState(FSensorSimVehiclePhysicsState& OutState) const;
+
+	/** Writes wheel, suspension, engine and transmission state into the vehicle before the next physics step */
+	void QueuePhysicsState(const FSensorSimVehiclePhysicsState& State);
+
+	/** Forgets the poses and physics sensor state accumulated so far, so that nothing spans a teleport */
+	void ResetHistory();
+
+	/** Converts a physics time to world time, as of the last UpdatePoseHistory */
+	double PhysicsToWorldTime(double PhysicsTime) const { return PhysicsTime + PhysicsTimeOffset; }
+
+	/** Sets the vehicle up from an archetype. Rebuilds the Chaos vehicle and its wheels if they were already created */
+	void ApplyArchetype(const FSensorSimVehicleArchetype& InArchetype);
+
+	/** Returns true if the Chaos vehicle's suspension was set up with the spring rates of an archetype. Logs the first mismatch */
+	bool IsSimulatingArchetype(const FSensorSimVehicleArchetype& InArchetype) const;
+
+	/** Adds a sensor sampled on every physics step */
+	void AddPhysicsSensor(const TSharedRef<ISensorSimPhysicsSensor, ESPMode::ThreadSafe>& Sensor);
+
+	/** Removes a sensor sampled on every physics step */
+	void RemovePhysicsSensor(const TSharedRef<ISensorSimPhysicsSensor, ESPMode::ThreadSafe>& Sensor);
+
+	// Begin ActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	// End ActorComponent interface
+
+protected:
+	/** Moves the queued physics step poses into the history and trims it */
+	void DrainPoses();
+
+	// Begin ChaosVehicleMovementComponent interface
+	virtual TUniquePtr<Chaos::FSimpleWheeledVehicle> CreatePhysicsVehicle() override;
+	// End ChaosVehicleMovementComponent interface
+
+	// Begin ChaosWheeledVehicleMovementComponent interface
+	virtual void CreateWheels() override;
+	// End ChaosWheeledVehicleMovementComponent interface
+};
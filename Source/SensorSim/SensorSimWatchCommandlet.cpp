@@ -0,0 +1,208 @@
+#include "SensorSimWatchCommandlet.h"
+#include "SensorSim.h"
+#include "SensorSimTelemetryServer.h"
+#include "Algo/Find.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+namespace SensorSimWatch
+{
+	/** Seconds to wait for the server before trying again */
+	constexpr float RetryInterval = 0.5f;
+
+	/** Seconds to wait for an HTTP response */
+	constexpr float ResponseTimeout = 2.0f;
+
+	/** Tolerance on the norm of sensor rotations */
+	constexpr float QuatTolerance = 1e-3f;
+
+	/** Statistics of one message type */
+	struct FTopic
+	{
+		const TCHAR* Name = nullptr;
+		ESensorSimTelemetryType Type = ESensorSimTelemetryType::Vehicles;
+
+		/** Time of the last message, which never goes back */
+		double LastTime = -UE_DOUBLE_BIG_NUMBER;
+
+		/** Totals since the start */
+		uint64 NumReceived = 0;
+		uint64 NumMalformed = 0;
+		uint64 BytesReceived = 0;
+
+		/** Totals at the last report */
+		uint64 ReportedReceived = 0;
+		uint64 ReportedBytes = 0;
+	};
+
+	/** Fetches the dashboard page. Returns false unless it was served */
+	bool FetchPage(uint16 Port)
+	{
+		FSensorSimTelemetryClient Client;
+		if (!Client.SendRequest(Port, TEXT("/"), false))
+		{
+			return false;
+		}
+
+		FString Headers;
+		if (Client.ReadResponse(Headers, ResponseTimeout) != 200)
+		{
+			return false;
+		}
+
+		int32 ContentLength = 0;
+		FParse::Value(*Headers, TEXT("Content-Length:"), ContentLength);
+
+		TArray<uint8> Body;
+		if (ContentLength <= 0 || !Client.ReadBody(Body, ContentLength, ResponseTimeout))
+		{
+			return false;
+		}
+
+		Body.Add(0);
+		return FCStringAnsi::Strstr(reinterpret_cast<const ANSICHAR*>(Body.GetData()), "<html") != nullptr;
+	}
+
+	/** Checks a message against the layout of its type */
+	bool ValidateMessage(const FSensorSimTelemetryHeader& Header, TConstArrayView<uint8> Message)
+	{
+		switch (Header.Type)
+		{
+		case ESensorSimTelemetryType::PointCloud:
+		{
+			FSensorSimTelemetryCloud Cloud;
+			TArray<FVector3f> Points;
+			TArray<uint8> Intensities;
+			if (!SensorSimTelemetry::DecodePointCloud(Message, Cloud, Points, Intensities))
+			{
+				return false;
+			}
+
+			const FQuat4f Rotation(Cloud.Rotation[0], Cloud.Rotation[1], Cloud.Rotation[2], Cloud.Rotation[3]);
+			return FMath::Abs(Rotation.SizeSquared() - 1.0f) < QuatTolerance && Points.Num() == int32(Cloud.NumPoints);
+		}
+
+		case ESensorSimTelemetryType::Vehicles:
+			return Message.Num() == int32(sizeof(FSensorSimTelemetryHeader) + Header.Count * sizeof(FSensorSimTelemetryVehicle));
+
+		case ESensorSimTelemetryType::Sensors:
+			return Message.Num() == int32(sizeof(FSensorSimTelemetryHeader) + sizeof(FSensorSimTelemetryServerStats) + Header.Count * sizeof(FSensorSimTelemetrySensor));
+		}
+
+		return false;
+	}
+}
+
+USensorSimWatchCommandlet::USensorSimWatchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Connects to the telemetry dashboard as a browser would, and validates every message");
+	HelpUsage = TEXT("-run=SensorSimWatch [-Port=8787] [-Seconds=10]");
+}
+
+int32 USensorSimWatchCommandlet::Main(const FString& Params)
+{
+	using namespace SensorSimWatch;
+
+	int32 Port = SensorSimTelemetry::DefaultPort;
+	float Seconds = 10.0f;
+
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Seconds="), Seconds);
+
+	FTopic Topics[3];
+	Topics[0].Name = TEXT("cloud");
+	Topics[0].Type = ESensorSimTelemetryType::PointCloud;
+	Topics[1].Name = TEXT("vehicle");
+	Topics[1].Type = ESensorSimTelemetryType::Vehicles;
+	Topics[2].Name = TEXT("sensor");
+	Topics[2].Type = ESensorSimTelemetryType::Sensors;
+
+	UE_LOG(LogSensorSim, Display, TEXT("Watching http://127.0.0.1:%d/ for %.0fs"), Port, Seconds);
+
+	const double StartTime = FPlatformTime::Seconds();
+	double ReportTime = StartTime;
+
+	bool bPageServed = false;
+	FSensorSimTelemetryClient Client;
+	bool bConnected = false;
+	TArray<uint8> Message;
+
+	while (FPlatformTime::Seconds() - StartTime < Seconds)
+	{
+		// the simulation may start after the client, or restart
+		if (!bConnected)
+		{
+			bPageServed |= FetchPage(static_cast<uint16>(Port));
+			bConnected = Client.ConnectWebSocket(static_cast<uint16>(Port), ResponseTimeout);
+			if (!bConnected)
+			{
+				FPlatformProcess::Sleep(RetryInterval);
+				continue;
+			}
+		}
+
+		if (!Client.ReadMessage(Message, 1.0f))
+		{
+			// the simulation stopped or stalled; reconnect, since the frame being read may be incomplete
+			Client.Close();
+			bConnected = false;
+		}
+		else
+		{
+			FSensorSimTelemetryHeader Header;
+			FTopic* Topic = SensorSimTelemetry::ReadHeader(Message, Header)
+				? Algo::FindByPredicate(Topics, [&Header](const FTopic& Candidate) { return Candidate.Type == Header.Type; })
+				: nullptr;
+
+			if (!Topic)
+			{
+				++Topics[0].NumMalformed;
+			}
+			else
+			{
+				// point clouds are encoded in parallel, and may arrive out of order across vehicles
+				if (!ValidateMessage(Header, Message) || (Topic->Type != ESensorSimTelemetryType::PointCloud && Header.Time < Topic->LastTime))
+				{
+					++Topic->NumMalformed;
+				}
+
+				Topic->LastTime = FMath::Max(Topic->LastTime, Header.Time);
+				++Topic->NumReceived;
+				Topic->BytesReceived += Message.Num();
+			}
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now - ReportTime >= 1.0)
+		{
+			for (FTopic& Topic : Topics)
+			{
+				UE_LOG(LogSensorSim, Display, TEXT("  %-7s %7.1f msg/s %8.3f MB/s  malformed %llu"), Topic.Name,
+					(Topic.NumReceived - Topic.ReportedReceived) / (Now - ReportTime),
+					(Topic.BytesReceived - Topic.ReportedBytes) / ((Now - ReportTime) * 1024.0 * 1024.0),
+					Topic.NumMalformed);
+
+				Topic.ReportedReceived = Topic.NumReceived;
+				Topic.ReportedBytes = Topic.BytesReceived;
+			}
+
+			ReportTime = Now;
+		}
+	}
+
+	UE_LOG(LogSensorSim, Display, TEXT("page: %s"), bPageServed ? TEXT("served") : TEXT("not served"));
+
+	bool bPassed = bPageServed;
+	for (const FTopic& Topic : Topics)
+	{
+		UE_LOG(LogSensorSim, Display, TEXT("%s: %llu received, %llu malformed"), Topic.Name, Topic.NumReceived, Topic.NumMalformed);
+		bPassed &= Topic.NumReceived > 0 && Topic.NumMalformed == 0;
+	}
+
+	return bPassed ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SensorSimWatchCommandlet.generated.h"
+
+/**
+ *  Watch Commandlet
+ *  Local test client for the telemetry dashboard. Fetches the dashboard page, connects to its WebSocket as a browser
+ *  would, decodes and validates every message, and reports rates and sizes every second.
+ *
+ *  Usage:
+ *    UnrealEditor-Cmd SensorSim.uproject -run=SensorSimWatch [-Port=8787] [-Seconds=10]
+ *
+ *  Returns non-zero if the page was not served, no vehicle or point cloud message arrived, or any message was malformed.
+ */
+UCLASS()
+class USensorSimWatchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimWatchCommandlet();
+
+	// Begin Commandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End Commandlet interface
+};
@@ -0,0 +1,169 @@
+#include "SensorSimWheelEncoderComponent.h"
+#include "SensorSim.h"
+#include "SensorSimPhysicsSensor.h"
+#include "SensorSimSpscRing.h"
+#include "SensorSimVehicleMovementComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "SimpleVehicle.h"
+
+/**
+ *  Physics thread side of the wheel encoders
+ *  Integrates the wheel spin of every step and pushes samples, stamped in physics time, into a ring.
+ */
+class FSensorSimWheelEncoderSimulation : public ISensorSimPhysicsSensor
+{
+public:
+	FSensorSimWheelEncoderSimulation(uint32 RingCapacity, float InPeriod, float InPhase, int32 InTicksPerRevolution)
+		: Ring{ RingCapacity }
+		, Period{ InPeriod }
+		, Phase{ InPhase }
+		, TicksPerRadian{ InTicksPerRevolution / UE_DOUBLE_TWO_PI }
+	{
+	}
+
+	/** Samples waiting for the game thread, in physics time */
+	TSensorSimSpscRing<FSensorSimWheelEncoderSample> Ring;
+
+	virtual void OnPhysicsStep(const FSensorSimPhysicsStepContext& Context) override
+	{
+		if (!bStarted)
+		{
+			bStarted = true;
+			NextSampleTime = Context.Time + Phase * Period;
+		}
+
+		FSensorSimWheelEncoderSample Sample;
+		Sample.NumWheels = static_cast<uint8>(FMath::Min(Context.Vehicle->Wheels.Num(), SensorSimRecording::MaxWheels));
+
+		// the encoders count the spin up to the start of this step
+		for (int32 WheelIndex = 0; WheelIndex < Sample.NumWheels; ++WheelIndex)
+		{
+			const float AngularVelocity = Context.Vehicle->Wheels[WheelIndex].GetAngularVelocity();
+
+			Sample.Ticks[WheelIndex] = FMath::FloorToInt32(WheelAngles[WheelIndex] * TicksPerRadian);
+			Sample.AngularVelocity[WheelIndex] = AngularVelocity;
+
+			WheelAngles[WheelIndex] += AngularVelocity * Context.DeltaTime;
+		}
+
+		while (NextSampleTime <= Context.Time)
+		{
+			Sample.Time = NextSampleTime;
+			Ring.Push(Sample);
+
+			NextSampleTime += Period;
+		}
+	}
+
+	virtual void OnReset() override
+	{
+		// encoders count from zero again, on a schedule starting at the next step
+		bStarted = false;
+		FMemory::Memzero(WheelAngles);
+	}
+
+private:
+	/** Seconds between samples */
+	const double Period;
+
+	/** Fraction of a period the schedule is offset by */
+	const float Phase;
+
+	/** Encoder resolution */
+	const double TicksPerRadian;
+
+	/** Physics time at which the next sample is due */
+	double NextSampleTime = 0.0;
+
+	/** Wheel rotation since the first step, in radians */
+	double WheelAngles[SensorSimRecording::MaxWheels] = {};
+
+	bool bStarted = false;
+};
+
+USensorSimWheelEncoderComponent::USensorSimWheelEncoderComponent()
+{
+	SampleRate = 100.0f;
+}
+
+int32 USensorSimWheelEncoderComponent::RunSchedule(double WorldTime)
+{
+	// sampled on the physics thread
+	return 0;
+}
+
+bool USensorSimWheelEncoderComponent::CollectSamples()
+{
+	if (!Simulation)
+	{
+		return false;
+	}
+
+	// anchor the physics clock to the world clock, so that the samples line up with the LiDAR sweeps
+	PhysicsSource->UpdatePoseHistory(GetWorld()->GetTimeSeconds());
+
+	CollectedSamples.Reset();
+	if (Simulation->Ring.PopAll(CollectedSamples) == 0)
+	{
+		return false;
+	}
+
+	for (FSensorSimWheelEncoderSample& Sample : CollectedSamples)
+	{
+		Sample.Time = PhysicsSource->PhysicsToWorldTime(Sample.Time);
+	}
+
+	LatestSample = CollectedSamples.Last();
+
+	Counters.Samples += CollectedSamples.Num();
+	Counters.Bytes += CollectedSamples.NumBytes();
+	INC_DWORD_STAT_BY(STAT_SensorSimBytes, CollectedSamples.NumBytes());
+	SkippedSamples = Simulation->Ring.GetNumOverflows();
+
+	OnSamples.Broadcast(CollectedSamples);
+
+	return true;
+}
+
+void USensorSimWheelEncoderComponent::ResetSensor()
+{
+	// samples already queued were taken before the reset. The simulation drops its own state on the next step
+	if (Simulation)
+	{
+		CollectedSamples.Reset();
+		Simulation->Ring.PopAll(CollectedSamples);
+		CollectedSamples.Reset();
+	}
+
+	LatestSample = FSensorSimWheelEncoderSample();
+
+	Super::ResetSensor();
+}
+
+void USensorSimWheelEncoderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PhysicsSource = GetOwner()->FindComponentByClass<USensorSimVehicleMovementComponent>();
+	if (!PhysicsSource)
+	{
+		UE_LOG(LogSensorSim, Warning, TEXT("Wheel encoders '%s' have no SensorSim vehicle movement to sample"), *GetPathName());
+		return;
+	}
+
+	Simulation = MakeShared<FSensorSimWheelEncoderSimulation, ESPMode::ThreadSafe>(RingCapacity, 1.0f / GetSampleRate(), SchedulePhase, TicksPerRevolution);
+	PhysicsSource->AddPhysicsSensor(Simulation.ToSharedRef());
+}
+
+void USensorSimWheelEncoderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (PhysicsSource && Simulation)
+	{
+		PhysicsSource->RemovePhysicsSensor(Simulation.ToSharedRef());
+	}
+
+	Simulation.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
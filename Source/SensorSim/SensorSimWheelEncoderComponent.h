@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SensorSimSensorComponent.h"
+#include "SensorSimRecording.h"
+#include "SensorSimWheelEncoderComponent.generated.h"
+
+// Forward declarations
+class USensorSimVehicleMovementComponent;
+class FSensorSimWheelEncoderSimulation;
+
+/** Broadcast on the game thread with the wheel encoder samples collected since the last broadcast, oldest first */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSensorSimWheelEncoderSamples, TConstArrayView<FSensorSimWheelEncoderSample> /*Samples*/);
+
+/**
+ *  Wheel Encoder Component
+ *  Incremental encoders on every wheel, integrated from the Chaos wheel spin on the physics thread
+ *  and sampled at SampleRate. Samples are stamped in world time, on the same clock as the LiDAR sweeps.
+ *  The rate is bounded by the physics substep rate; faster sample rates repeat the last step.
+ */
+UCLASS(ClassGroup = (SensorSim), meta = (BlueprintSpawnableComponent))
+class SENSORSIM_API USensorSimWheelEncoderComponent : public USensorSimSensorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USensorSimWheelEncoderComponent();
+
+protected:
+	/** Encoder ticks per wheel revolution */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Encoder, meta = (ClampMin = "1"))
+	int32 TicksPerRevolution{ 1024 };
+
+	/** Number of samples buffered between the physics and game threads */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Encoder, meta = (ClampMin = "16"))
+	int32 RingCapacity{ 1024 };
+
+	/** Movement component sampling the encoders */
+	UPROPERTY(Transient)
+	TObjectPtr<USensorSimVehicleMovementComponent> PhysicsSource{ nullptr };
+
+	/** Physics thread side of the encoders */
+	TSharedPtr<FSensorSimWheelEncoderSimulation, ESPMode::ThreadSafe> Simulation;
+
+	/** Samples collected on the last update */
+	TArray<FSensorSimWheelEncoderSample> CollectedSamples;
+
+	/** Last collected sample */
+	FSensorSimWheelEncoderSample LatestSample;
+
+public:
+	/** Broadcast on the game thread with every batch of collected samples */
+	FOnSensorSimWheelEncoderSamples OnSamples;
+
+	/** Returns the last collected sample */
+	const FSensorSimWheelEncoderSample& GetLatestSample() const { return LatestSample; }
+
+	// Begin SensorSimSensorComponent interface
+	virtual int32 RunSchedule(double WorldTime) override;
+	virtual bool CollectSamples() override;
+	virtual void ResetSensor() override;
+protected:
+	virtual bool TakeSample(double SampleTime) override { return false; }
+	// End SensorSimSensorComponent interface
+
+	// Begin ActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End ActorComponent interface
+};
@@ -1,11 +1,10 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SensorSimWheelFront.h"
+#include "SensorSimVehicleCatalog.h"
 #include "UObject/ConstructorHelpers.h"
 
 USensorSimWheelFront::USensorSimWheelFront()
 {
-	AxleType = EAxleType::Front;
-	bAffectedBySteering = true;
-	MaxSteerAngle = 40.f;
+	SensorSimVehicleCatalog::FrontWheel.ApplyTo(*this);
 }
\ No newline at end of file
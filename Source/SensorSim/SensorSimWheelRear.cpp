@@ -1,11 +1,10 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SensorSimWheelRear.h"
+#include "SensorSimVehicleCatalog.h"
 #include "UObject/ConstructorHelpers.h"
 
 USensorSimWheelRear::USensorSimWheelRear()
 {
-	AxleType = EAxleType::Rear;
-	bAffectedByHandbrake = true;
-	bAffectedByEngine = true;
+	SensorSimVehicleCatalog::RearWheel.ApplyTo(*this);
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "SensorSimLidarReturns.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSensorSimLidarSensorKeyTest, "SensorSim.Lidar.SensorKey",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::ProductFilter)
+
+bool FSensorSimLidarSensorKeyTest::RunTest(const FString& Parameters)
+{
+	using namespace SensorSimLidarReturns;
+
+	// the key only depends on the name text, however the strings were built
+	const uint32 Key = GetSensorKey(TEXT("SensorSimSportsCar_C_0"), TEXT("Lidar"));
+	TestEqual(TEXT("Key from the name strings"), Key, HashCombine(FCrc::StrCrc32(TEXT("SensorSimSportsCar_C_0")), FCrc::StrCrc32(TEXT("Lidar"))));
+	TestEqual(TEXT("Key from built strings"), GetSensorKey(FString::Printf(TEXT("SensorSimSportsCar_C_%d"), 0), FString(TEXT("Lid")) + TEXT("ar")), Key);
+
+	// names created in another order in another process must not change the key
+	const FName Unrelated(*FString::Printf(TEXT("SensorSimKeyTest_%u"), FPlatformTime::Cycles()));
+	TestFalse(TEXT("Created a name"), Unrelated.IsNone());
+	TestEqual(TEXT("Key after creating names"), GetSensorKey(FName(TEXT("SensorSimSportsCar_C_0")).ToString(), FName(TEXT("Lidar")).ToString()), Key);
+
+	TestNotEqual(TEXT("Key of another vehicle"), GetSensorKey(TEXT("SensorSimSportsCar_C_1"), TEXT("Lidar")), Key);
+	TestNotEqual(TEXT("Key of another sensor"), GetSensorKey(TEXT("SensorSimSportsCar_C_0"), TEXT("RoofLidar")), Key);
+
+	return true;
+}
+
+#endif
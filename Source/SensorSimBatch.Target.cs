@@ -0,0 +1,18 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class SensorSimBatchTarget : TargetRules
+{
+	public SensorSimBatchTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Game;
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_5;
+		ExtraModuleNames.Add("SensorSim");
+
+		// headless dataset runs never show a HUD
+		ProjectDefinitions.Add("SENSORSIM_WITH_HUD=0");
+	}
+}